@@ -43,6 +43,26 @@ struct __can_recv;
 typedef struct __can_recv can_recv_t;
 #endif
 
+/**
+ * A CAN acceptance filter, computed by a CAN network interface from its active
+ * receivers (see can_net_set_filter_func()).
+ */
+struct can_net_filter {
+	/// The (11- or 29-bit) identifier.
+	uint_least32_t id;
+	/**
+	 * The acceptance mask. A CAN frame matches the filter if
+	 * `(msg->id & mask) == (id & mask)`.
+	 */
+	uint_least32_t mask;
+	/**
+	 * The flags (any combination of #CAN_FLAG_IDE and #CAN_FLAG_RTR). A CAN
+	 * frame only matches if its IDE and RTR flags are equal to #flags. All
+	 * other flags are ignored.
+	 */
+	uint_least8_t flags;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -87,6 +107,23 @@ typedef int can_recv_func_t(const struct can_msg *msg, void *data);
  */
 typedef int can_send_func_t(const struct can_msg *msg, void *data);
 
+/**
+ * The type of a CAN filter callback function, invoked by a CAN network
+ * interface when the set of acceptance filters needed by its receivers changes.
+ *
+ * @param filters a pointer to an array of acceptance filters. A CAN frame
+ *                SHOULD be passed to can_net_recv() if it matches at least one
+ *                of the filters.
+ * @param n       the number of filters in <b>filters</b>. If <b>n</b> is 0,
+ *                there are no active receivers.
+ * @param data    a pointer to user-specified data.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, implementations
+ * SHOULD set the error number with `set_errnum()`.
+ */
+typedef int can_filter_func_t(
+		const struct can_net_filter *filters, size_t n, void *data);
+
 void *__can_net_alloc(void);
 void __can_net_free(void *ptr);
 struct __can_net *__can_net_init(struct __can_net *net);
@@ -204,6 +241,50 @@ void can_net_get_send_func(
  */
 void can_net_set_send_func(can_net_t *net, can_send_func_t *func, void *data);
 
+/**
+ * Retrieves the callback function invoked when the acceptance filters of a CAN
+ * network interface change.
+ *
+ * @param net   a pointer to a CAN network interface.
+ * @param pfunc the address at which to store a pointer to the callback function
+ *              (can be NULL).
+ * @param pdata the address at which to store a pointer to user-specified data
+ *              (can be NULL).
+ *
+ * @see can_net_set_filter_func()
+ */
+void can_net_get_filter_func(
+		const can_net_t *net, can_filter_func_t **pfunc, void **pdata);
+
+/**
+ * Sets the callback function invoked when the acceptance filters of a CAN
+ * network interface change. The filters are computed from the identifiers and
+ * flags of the active receivers, and can be used to let a CAN controller or
+ * driver drop frames for which there is no receiver. At most
+ * #LELY_CAN_NET_NFILTER filters are generated; if there are more distinct
+ * identifiers, filters for nearby identifiers are merged into filters with a
+ * wider mask.
+ *
+ * The callback is invoked immediately, and whenever can_recv_start() registers
+ * a receiver for a CAN frame not accepted by the current filters. To avoid
+ * excessive updates, filters are not narrowed every time the last receiver for
+ * an identifier is stopped, but only after this has happened
+ * #LELY_CAN_NET_FILTER_HYST times. If the callback function returns an error,
+ * it is retried on the next change.
+ *
+ * @param net  a pointer to a CAN network interface.
+ * @param func a pointer to the function to be invoked. If <b>func</b> is NULL,
+ *             filter updates are disabled.
+ * @param data a pointer to user-specified data (can be NULL). <b>data</b> is
+ *             passed as the last parameter to <b>func</b>.
+ *
+ * @returns the result of <b>func</b>, or 0 if <b>func</b> is NULL.
+ *
+ * @see can_net_get_filter_func()
+ */
+int can_net_set_filter_func(
+		can_net_t *net, can_filter_func_t *func, void *data);
+
 void *__can_timer_alloc(void);
 void __can_timer_free(void *ptr);
 struct __can_timer *__can_timer_init(struct __can_timer *timer);
@@ -53,6 +53,23 @@ typedef void co_emcy_ind_t(co_emcy_t *emcy, co_unsigned8_t id,
 		co_unsigned16_t eec, co_unsigned8_t er, co_unsigned8_t msef[5],
 		void *data);
 
+/// An EMCY message received from a remote node (see co_emcy_read_log()).
+struct co_emcy_rec {
+	/// The time at which the message was received.
+	struct timespec time;
+	/// The emergency error code.
+	co_unsigned16_t eec;
+	/// The error register.
+	co_unsigned8_t er;
+	/// The manufacturer-specific error code.
+	co_unsigned8_t msef[5];
+	/**
+	 * The number of messages from the same node that were discarded
+	 * immediately before this one because the log was full.
+	 */
+	co_unsigned32_t nlost;
+};
+
 void *__co_emcy_alloc(void);
 void __co_emcy_free(void *ptr);
 struct __co_emcy *__co_emcy_init(
@@ -112,6 +129,51 @@ can_net_t *co_emcy_get_net(const co_emcy_t *emcy);
  */
 co_dev_t *co_emcy_get_dev(const co_emcy_t *emcy);
 
+/**
+ * Returns the maximum number of messages in the EMCY message stack of an EMCY
+ * producer service, or 0 if the number is unlimited.
+ *
+ * @see co_emcy_set_depth()
+ */
+size_t co_emcy_get_depth(const co_emcy_t *emcy);
+
+/**
+ * Sets the maximum number of messages in the EMCY message stack of an EMCY
+ * producer service. Once the stack is full, co_emcy_push() discards the oldest
+ * message. If the stack currently contains more messages, the oldest ones are
+ * discarded immediately.
+ *
+ * @param emcy  a pointer to an EMCY producer service.
+ * @param depth the maximum number of messages, or 0 if the number is unlimited
+ *              (the default).
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see co_emcy_get_depth()
+ */
+int co_emcy_set_depth(co_emcy_t *emcy, size_t depth);
+
+/**
+ * Returns 1 if an EMCY producer service coalesces repeated EMCY messages during
+ * the inhibit time, and 0 if not.
+ *
+ * @see co_emcy_set_coalesce()
+ */
+int co_emcy_get_coalesce(const co_emcy_t *emcy);
+
+/**
+ * Enables or disables the coalescing of repeated EMCY messages by an EMCY
+ * producer service. If enabled, and an EMCY message with the same emergency
+ * error code as the last message waiting for the inhibit time (object 1015) to
+ * elapse is sent, the waiting message is updated with the new error register
+ * and manufacturer-specific error code instead of queueing another message.
+ * The EMCY message stack and the pre-defined error field are not affected.
+ *
+ * @see co_emcy_get_coalesce()
+ */
+void co_emcy_set_coalesce(co_emcy_t *emcy, int coalesce);
+
 /**
  * Pushes a CANopen EMCY message to the stack and broadcasts it if the EMCY
  * producer service is active.
@@ -225,6 +287,50 @@ void co_emcy_get_ind(const co_emcy_t *emcy, co_emcy_ind_t **pind, void **pdata);
  */
 void co_emcy_set_ind(co_emcy_t *emcy, co_emcy_ind_t *ind, void *data);
 
+#if !LELY_NO_MALLOC
+
+/**
+ * Sets the size of the per-node logs of received EMCY messages of an EMCY
+ * consumer service. Once set, each EMCY message received from a node in object
+ * 1028 (Emergency consumer object) is appended to the log of that node, in
+ * addition to invoking the indication function. Appending a message does not
+ * allocate memory; if the log is full, the message is discarded (see
+ * #co_emcy_rec.nlost).
+ *
+ * This function allocates (or frees) the logs and MUST NOT be invoked while
+ * another thread is reading a log with co_emcy_read_log(). Any messages in the
+ * existing logs are discarded.
+ *
+ * @param emcy a pointer to an EMCY consumer service.
+ * @param size the maximum number of messages in the log of each node, or 0 to
+ *             disable the logs (the default).
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int co_emcy_set_log_size(co_emcy_t *emcy, size_t size);
+
+/**
+ * Reads, and removes, the oldest EMCY messages from the log of the specified
+ * node (see co_emcy_set_log_size()).
+ *
+ * The logs are single-producer, single-consumer ring buffers. This function is
+ * lock-free and MAY be invoked from a different thread than the one processing
+ * the CAN frames, but MUST NOT be invoked concurrently for the same node.
+ *
+ * @param emcy a pointer to an EMCY consumer service.
+ * @param id   the node-ID (in the range [1..127]).
+ * @param recs the address at which to store the messages.
+ * @param n    the maximum number of messages to read.
+ *
+ * @returns the number of messages read, or 0 if the log of the node is empty
+ * or does not exist.
+ */
+size_t co_emcy_read_log(co_emcy_t *emcy, co_unsigned8_t id,
+		struct co_emcy_rec *recs, size_t n);
+
+#endif // !LELY_NO_MALLOC
+
 #ifdef __cplusplus
 }
 #endif
@@ -120,6 +120,26 @@ class COEmcy : public incomplete_c_type<__co_emcy> {
     return co_emcy_clear(this);
   }
 
+  size_t
+  getDepth() const noexcept {
+    return co_emcy_get_depth(this);
+  }
+
+  int
+  setDepth(size_t depth) noexcept {
+    return co_emcy_set_depth(this, depth);
+  }
+
+  bool
+  getCoalesce() const noexcept {
+    return co_emcy_get_coalesce(this) != 0;
+  }
+
+  void
+  setCoalesce(bool coalesce) noexcept {
+    co_emcy_set_coalesce(this, coalesce);
+  }
+
   void
   getInd(co_emcy_ind_t** pind, void** pdata) const noexcept {
     co_emcy_get_ind(this, pind, pdata);
@@ -143,6 +163,18 @@ class COEmcy : public incomplete_c_type<__co_emcy> {
            static_cast<void*>(obj));
   }
 
+#if !LELY_NO_MALLOC
+  int
+  setLogSize(size_t size) noexcept {
+    return co_emcy_set_log_size(this, size);
+  }
+
+  size_t
+  readLog(co_unsigned8_t id, co_emcy_rec* recs, size_t n) noexcept {
+    return co_emcy_read_log(this, id, recs, n);
+  }
+#endif
+
  protected:
   ~COEmcy() = default;
 };
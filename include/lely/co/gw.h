@@ -28,6 +28,14 @@
 /// The maximum number of networks in a CANopen gateway.
 #define CO_GW_NUM_NET 127
 
+#ifndef LELY_CO_GW_SDO_QUEUE
+/**
+ * The default maximum number of SDO requests per node waiting for a free
+ * Client-SDO channel (see co_gw_set_sdo_queue()).
+ */
+#define LELY_CO_GW_SDO_QUEUE 8
+#endif
+
 /// The high number of the version of CiA 309-1 implemented by this gateway.
 #define CO_GW_PROT_HI 2
 
@@ -1097,6 +1105,30 @@ void co_gw_get_rate_func(
  */
 void co_gw_set_rate_func(co_gw_t *gw, co_gw_rate_func_t *func, void *data);
 
+/**
+ * Returns the maximum number of SDO requests per node waiting for a free
+ * Client-SDO channel.
+ *
+ * @see co_gw_set_sdo_queue()
+ */
+size_t co_gw_get_sdo_queue(const co_gw_t *gw);
+
+/**
+ * Sets the maximum number of SDO upload/download requests per node waiting for
+ * a free Client-SDO channel. If all channels to a node are busy and the queue
+ * is full, new requests for that node are rejected. If <b>depth</b> is 0,
+ * requests are never queued. The default is #LELY_CO_GW_SDO_QUEUE.
+ *
+ * Besides the default SDO channel of a node, the gateway uses every idle
+ * Client-SDO service of the NMT service (see co_nmt_get_csdo()) whose server
+ * node-ID (sub-index 03 of objects 1280..12FF) matches the node and whose
+ * COB-IDs differ from the default ones. This allows multiple requests to a
+ * node supporting more than one Server-SDO to be processed concurrently.
+ *
+ * @see co_gw_get_sdo_queue()
+ */
+void co_gw_set_sdo_queue(co_gw_t *gw, size_t depth);
+
 #ifdef __cplusplus
 }
 #endif
@@ -136,6 +136,16 @@ class COGW : public incomplete_c_type<__co_gw> {
                 static_cast<void*>(obj));
   }
 
+  ::std::size_t
+  getSdoQueue() const noexcept {
+    return co_gw_get_sdo_queue(this);
+  }
+
+  void
+  setSdoQueue(::std::size_t depth) noexcept {
+    co_gw_set_sdo_queue(this, depth);
+  }
+
  protected:
   ~COGW() = default;
 };
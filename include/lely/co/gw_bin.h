@@ -0,0 +1,297 @@
+/**@file
+ * This header file is part of the CANopen library; it contains the binary
+ * gateway declarations.
+ *
+ * The binary gateway exchanges the gateway service structs (see
+ * <lely/co/gw.h>) with local clients as-is, without converting them to text.
+ * The structs are stored in single-producer, single-consumer ring buffers,
+ * which can be placed in shared memory, so a client in another process can
+ * read indications and confirmations in place (without copying or parsing)
+ * and write requests directly into the buffer.
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_CO_GW_BIN_H_
+#define LELY_CO_GW_BIN_H_
+
+#include <lely/co/gw.h>
+
+/**
+ * The alignment (in bytes) of the records in a binary gateway ring buffer. The
+ * size of each record is rounded up to a multiple of this value.
+ */
+#define CO_GW_BIN_ALIGN 8
+
+#ifndef LELY_CO_GW_BIN_BATCH
+/**
+ * The default maximum number of indications written to a binary gateway ring
+ * buffer before the user is notified (see co_gw_bin_set_batch()).
+ */
+#define LELY_CO_GW_BIN_BATCH 64
+#endif
+
+struct __co_gw_bin;
+#if !defined(__cplusplus) || LELY_NO_CXX
+/// An opaque CANopen binary gateway type.
+typedef struct __co_gw_bin co_gw_bin_t;
+#endif
+
+/**
+ * A single-producer, single-consumer ring buffer containing CANopen gateway
+ * service records.
+ */
+struct co_gw_bin_ring;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The type of a CANopen binary gateway send callback function, invoked when a
+ * request has been written to the request ring buffer by the user and needs to
+ * be sent to a gateway.
+ *
+ * @param req  a pointer to the parameters of the request to be sent. The
+ *             request resides in the ring buffer and is only valid for the
+ *             duration of the call.
+ * @param data a pointer to user-specified data.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, implementations
+ * SHOULD set the error number with `set_errnum()`.
+ */
+typedef int co_gw_bin_send_func_t(const struct co_gw_req *req, void *data);
+
+/**
+ * The type of a CANopen binary gateway notification function, invoked when one
+ * or more indications or confirmations have been written to the ring buffer
+ * and the user needs to be notified, e.g., by writing to a pipe or eventfd.
+ *
+ * @param data a pointer to user-specified data.
+ */
+typedef void co_gw_bin_notify_func_t(void *data);
+
+/**
+ * Returns the number of bytes required for a binary gateway ring buffer with
+ * room for <b>size</b> bytes of records. The result is a multiple of the cache
+ * line size.
+ */
+size_t co_gw_bin_ring_sizeof(size_t size);
+
+/**
+ * Initializes a binary gateway ring buffer in the specified region of memory,
+ * which can be (a part of) a shared memory object.
+ *
+ * @param ptr  a pointer to the memory region, which MUST be aligned to the
+ *             cache line size.
+ * @param size the number of bytes available for records. This value is rounded
+ *             down to a multiple of #CO_GW_BIN_ALIGN. The memory region MUST
+ *             be at least co_gw_bin_ring_sizeof(<b>size</b>) bytes.
+ *
+ * @returns a pointer to the ring buffer (i.e., <b>ptr</b>).
+ */
+struct co_gw_bin_ring *co_gw_bin_ring_init(void *ptr, size_t size);
+
+/**
+ * Creates a new binary gateway ring buffer in dynamically allocated memory.
+ *
+ * @returns a pointer to the ring buffer, or NULL on error. In the latter case,
+ * the error number can be obtained with get_errc().
+ *
+ * @see co_gw_bin_ring_destroy()
+ */
+struct co_gw_bin_ring *co_gw_bin_ring_create(size_t size);
+
+/// Destroys a binary gateway ring buffer. @see co_gw_bin_ring_create()
+void co_gw_bin_ring_destroy(struct co_gw_bin_ring *ring);
+
+/**
+ * Writes a CANopen gateway service record to a ring buffer. This function can
+ * be used by the client to write requests. It MUST NOT be invoked concurrently
+ * with another call to this function for the same ring buffer.
+ *
+ * @param ring a pointer to a binary gateway ring buffer.
+ * @param srv  a pointer to the service parameters. The number of bytes copied
+ *             is given by the <b>size</b> member.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc(). The error number is #ERRNUM_AGAIN if the
+ * ring buffer is full, and #ERRNUM_MSGSIZE if the record can never fit.
+ */
+int co_gw_bin_ring_write(
+		struct co_gw_bin_ring *ring, const struct co_gw_srv *srv);
+
+/**
+ * Returns a pointer to the oldest service record in a ring buffer, or NULL if
+ * the buffer is empty. The record is not copied; it remains valid until it is
+ * removed with co_gw_bin_ring_pop(). This function MUST NOT be invoked
+ * concurrently with another call to this function or co_gw_bin_ring_pop() for
+ * the same ring buffer.
+ */
+const struct co_gw_srv *co_gw_bin_ring_peek(struct co_gw_bin_ring *ring);
+
+/**
+ * Removes the oldest service record from a ring buffer, making room for the
+ * producer.
+ *
+ * @see co_gw_bin_ring_peek()
+ */
+void co_gw_bin_ring_pop(struct co_gw_bin_ring *ring);
+
+void *__co_gw_bin_alloc(void);
+void __co_gw_bin_free(void *ptr);
+struct __co_gw_bin *__co_gw_bin_init(struct __co_gw_bin *gw,
+		struct co_gw_bin_ring *req, struct co_gw_bin_ring *ind);
+void __co_gw_bin_fini(struct __co_gw_bin *gw);
+
+/**
+ * Creates a new CANopen binary gateway.
+ *
+ * @param req a pointer to the ring buffer from which requests are read.
+ * @param ind a pointer to the ring buffer to which indications and
+ *            confirmations are written.
+ *
+ * @returns a pointer to a new binary gateway, or NULL on error. In the latter
+ * case, the error number can be obtained with get_errc().
+ *
+ * @see co_gw_bin_destroy()
+ */
+co_gw_bin_t *co_gw_bin_create(
+		struct co_gw_bin_ring *req, struct co_gw_bin_ring *ind);
+
+/// Destroys a CANopen binary gateway. @see co_gw_bin_create()
+void co_gw_bin_destroy(co_gw_bin_t *gw);
+
+/**
+ * Receives an indication or confirmation from a CANopen gateway and writes it
+ * to the ring buffer. Confirmations are signaled to the user immediately (see
+ * co_gw_bin_set_notify_func()), while indications are batched (see
+ * co_gw_bin_set_batch()). This function can be invoked directly from the send
+ * function of the gateway.
+ *
+ * @param gw  a pointer to a CANopen binary gateway.
+ * @param srv a pointer to the service parameters.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc(). If the ring buffer is full, the record is
+ * dropped (see co_gw_bin_get_lost()).
+ */
+int co_gw_bin_recv(co_gw_bin_t *gw, const struct co_gw_srv *srv);
+
+/**
+ * Notifies the user if any indications have been written to the ring buffer
+ * since the last notification. This function SHOULD be invoked after a batch of
+ * CAN frames has been processed, to bound the latency of indications.
+ */
+void co_gw_bin_flush(co_gw_bin_t *gw);
+
+/**
+ * Returns the maximum number of indications written to the ring buffer before
+ * the user is notified.
+ *
+ * @see co_gw_bin_set_batch()
+ */
+size_t co_gw_bin_get_batch(const co_gw_bin_t *gw);
+
+/**
+ * Sets the maximum number of indications written to the ring buffer before the
+ * user is notified. If <b>batch</b> is 0 or 1, the user is notified after each
+ * indication. The default is #LELY_CO_GW_BIN_BATCH.
+ *
+ * @see co_gw_bin_get_batch()
+ */
+void co_gw_bin_set_batch(co_gw_bin_t *gw, size_t batch);
+
+/**
+ * Returns the number of indications and confirmations that were dropped
+ * because the ring buffer was full.
+ */
+size_t co_gw_bin_get_lost(const co_gw_bin_t *gw);
+
+/**
+ * Reads all requests from the ring buffer and forwards them to the gateway
+ * with the send function (see co_gw_bin_set_send_func()). The requests are not
+ * copied; they are passed to the send function in place.
+ *
+ * @returns the number of requests read.
+ */
+size_t co_gw_bin_send(co_gw_bin_t *gw);
+
+/**
+ * Retrieves the callback function used to send requests from the user to a
+ * CANopen gateway.
+ *
+ * @param gw    a pointer to a CANopen binary gateway.
+ * @param pfunc the address at which to store a pointer to the callback function
+ *              (can be NULL).
+ * @param pdata the address at which to store a pointer to user-specified data
+ *              (can be NULL).
+ *
+ * @see co_gw_bin_set_send_func()
+ */
+void co_gw_bin_get_send_func(const co_gw_bin_t *gw,
+		co_gw_bin_send_func_t **pfunc, void **pdata);
+
+/**
+ * Sets the callback function used to send requests from the user to a CANopen
+ * gateway.
+ *
+ * @param gw   a pointer to a CANopen binary gateway.
+ * @param func a pointer to the function invoked by co_gw_bin_send().
+ * @param data a pointer to user-specified data (can be NULL). <b>data</b> is
+ *             passed as the last parameter to <b>func</b>.
+ *
+ * @see co_gw_bin_get_send_func()
+ */
+void co_gw_bin_set_send_func(
+		co_gw_bin_t *gw, co_gw_bin_send_func_t *func, void *data);
+
+/**
+ * Retrieves the function used to notify the user of new indications and
+ * confirmations.
+ *
+ * @param gw    a pointer to a CANopen binary gateway.
+ * @param pfunc the address at which to store a pointer to the notification
+ *              function (can be NULL).
+ * @param pdata the address at which to store a pointer to user-specified data
+ *              (can be NULL).
+ *
+ * @see co_gw_bin_set_notify_func()
+ */
+void co_gw_bin_get_notify_func(const co_gw_bin_t *gw,
+		co_gw_bin_notify_func_t **pfunc, void **pdata);
+
+/**
+ * Sets the function used to notify the user of new indications and
+ * confirmations.
+ *
+ * @param gw   a pointer to a CANopen binary gateway.
+ * @param func a pointer to the function invoked by co_gw_bin_recv() and
+ *             co_gw_bin_flush().
+ * @param data a pointer to user-specified data (can be NULL). <b>data</b> is
+ *             passed as the last parameter to <b>func</b>.
+ *
+ * @see co_gw_bin_get_notify_func()
+ */
+void co_gw_bin_set_notify_func(
+		co_gw_bin_t *gw, co_gw_bin_notify_func_t *func, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !LELY_CO_GW_BIN_H_
@@ -0,0 +1,163 @@
+/**@file
+ * This header file is part of the CANopen library; it contains the C++
+ * interface of the binary gateway declarations. See lely/co/gw_bin.h for the C
+ * interface.
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_CO_GW_BIN_HPP_
+#define LELY_CO_GW_BIN_HPP_
+
+#if !defined(__cplusplus) || LELY_NO_CXX
+#error "include <lely/co/gw_bin.h> for the C interface"
+#endif
+
+#include <lely/util/c_call.hpp>
+#include <lely/util/c_type.hpp>
+
+namespace lely {
+class COGWBin;
+}
+/// An opaque CANopen binary gateway type.
+typedef lely::COGWBin co_gw_bin_t;
+
+#include <lely/co/gw.hpp>
+#include <lely/co/gw_bin.h>
+
+namespace lely {
+
+/// The attributes of #co_gw_bin_t required by #lely::COGWBin.
+template <>
+struct c_type_traits<__co_gw_bin> {
+  typedef __co_gw_bin value_type;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+  typedef value_type* pointer;
+  typedef const value_type* const_pointer;
+
+  static void*
+  alloc() noexcept {
+    return __co_gw_bin_alloc();
+  }
+  static void
+  free(void* ptr) noexcept {
+    __co_gw_bin_free(ptr);
+  }
+
+  static pointer
+  init(pointer p, co_gw_bin_ring* req, co_gw_bin_ring* ind) noexcept {
+    return __co_gw_bin_init(p, req, ind);
+  }
+  static void
+  fini(pointer p) noexcept {
+    __co_gw_bin_fini(p);
+  }
+};
+
+/// An opaque CANopen binary gateway type.
+class COGWBin : public incomplete_c_type<__co_gw_bin> {
+  typedef incomplete_c_type<__co_gw_bin> c_base;
+
+ public:
+  COGWBin(co_gw_bin_ring* req, co_gw_bin_ring* ind) : c_base(req, ind) {}
+
+  int
+  recv(const co_gw_srv* srv) noexcept {
+    return co_gw_bin_recv(this, srv);
+  }
+
+  void
+  flush() noexcept {
+    co_gw_bin_flush(this);
+  }
+
+  ::std::size_t
+  getBatch() const noexcept {
+    return co_gw_bin_get_batch(this);
+  }
+
+  void
+  setBatch(::std::size_t batch) noexcept {
+    co_gw_bin_set_batch(this, batch);
+  }
+
+  ::std::size_t
+  getLost() const noexcept {
+    return co_gw_bin_get_lost(this);
+  }
+
+  ::std::size_t
+  send() noexcept {
+    return co_gw_bin_send(this);
+  }
+
+  void
+  getSendFunc(co_gw_bin_send_func_t** pfunc, void** pdata) const noexcept {
+    co_gw_bin_get_send_func(this, pfunc, pdata);
+  }
+
+  void
+  setSendFunc(co_gw_bin_send_func_t* func, void* data) noexcept {
+    co_gw_bin_set_send_func(this, func, data);
+  }
+
+  template <class F>
+  void
+  setSendFunc(F* f) noexcept {
+    setSendFunc(&c_obj_call<co_gw_bin_send_func_t*, F>::function,
+                static_cast<void*>(f));
+  }
+
+  template <class C, typename c_mem_fn<co_gw_bin_send_func_t*, C>::type M>
+  void
+  setSendFunc(C* obj) noexcept {
+    setSendFunc(&c_mem_call<co_gw_bin_send_func_t*, C, M>::function,
+                static_cast<void*>(obj));
+  }
+
+  void
+  getNotifyFunc(co_gw_bin_notify_func_t** pfunc, void** pdata) const noexcept {
+    co_gw_bin_get_notify_func(this, pfunc, pdata);
+  }
+
+  void
+  setNotifyFunc(co_gw_bin_notify_func_t* func, void* data) noexcept {
+    co_gw_bin_set_notify_func(this, func, data);
+  }
+
+  template <class F>
+  void
+  setNotifyFunc(F* f) noexcept {
+    setNotifyFunc(&c_obj_call<co_gw_bin_notify_func_t*, F>::function,
+                  static_cast<void*>(f));
+  }
+
+  template <class C, typename c_mem_fn<co_gw_bin_notify_func_t*, C>::type M>
+  void
+  setNotifyFunc(C* obj) noexcept {
+    setNotifyFunc(&c_mem_call<co_gw_bin_notify_func_t*, C, M>::function,
+                  static_cast<void*>(obj));
+  }
+
+ protected:
+  ~COGWBin() = default;
+};
+
+}  // namespace lely
+
+#endif  // !LELY_CO_GW_BIN_HPP_
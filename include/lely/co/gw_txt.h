@@ -143,6 +143,26 @@ void co_gw_txt_set_recv_func(
 size_t co_gw_txt_send(co_gw_txt_t *gw, const char *begin, const char *end,
 		struct floc *at);
 
+/**
+ * Sends all user requests in a buffer to a CANopen gateway, e.g., the contents
+ * of a script. This function is equivalent to invoking co_gw_txt_send() until
+ * the end of the buffer is reached. Requests that cannot be parsed are skipped
+ * (see co_gw_txt_iec()).
+ *
+ * @param gw    a pointer to a CANopen ASCII gateway.
+ * @param begin a pointer to the start of the buffer containing the requests,
+ *              separated by line breaks.
+ * @param end   a pointer to one past the last character in the buffer (can be
+ *              NULL if the buffer is null-terminated).
+ * @param at    an optional pointer to the file location of <b>begin</b> (used
+ *              for diagnostic purposes). On exit, if `at != NULL`, *<b>at</b>
+ *              points to one past the last character parsed.
+ *
+ * @returns the number of characters read.
+ */
+size_t co_gw_txt_send_batch(co_gw_txt_t *gw, const char *begin,
+		const char *end, struct floc *at);
+
 /**
  * Retrieves the callback function used to send requests from the user to a
  * CANopen gateway.
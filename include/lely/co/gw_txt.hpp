@@ -118,6 +118,11 @@ class COGWTxt : public incomplete_c_type<__co_gw_txt> {
     return co_gw_txt_send(this, begin, end, at);
   }
 
+  ::std::size_t
+  sendBatch(const char* begin, const char* end = 0, floc* at = 0) noexcept {
+    return co_gw_txt_send_batch(this, begin, end, at);
+  }
+
   void
   getSendFunc(co_gw_txt_send_func_t** pfunc, void** pdata) const noexcept {
     co_gw_txt_get_send_func(this, pfunc, pdata);
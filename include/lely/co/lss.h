@@ -35,6 +35,24 @@
 #define LELY_CO_LSS_TIMEOUT 100
 #endif
 
+#ifndef LELY_CO_LSS_DISCOVER_FACTOR
+/**
+ * The factor by which the largest observed response latency is multiplied to
+ * obtain the timeout of a 'Fastscan' request during LSS discovery. If a slave
+ * responds later than this, the search falls back to the LSS timeout once the
+ * late response is detected (see co_lss_discover_req()).
+ */
+#define LELY_CO_LSS_DISCOVER_FACTOR 4
+#endif
+
+#ifndef LELY_CO_LSS_DISCOVER_MIN_TIMEOUT
+/**
+ * The minimum timeout (in microseconds) of a 'Fastscan' request during LSS
+ * discovery.
+ */
+#define LELY_CO_LSS_DISCOVER_MIN_TIMEOUT 1000
+#endif
+
 /// The CAN identifier used for LSS by the master (1) or the slave (0).
 #define CO_LSS_CANID(master) (0x7e4 + !!(master))
 
@@ -140,6 +158,64 @@ typedef void co_lss_nid_ind_t(co_lss_t *lss, co_unsigned8_t cs,
 typedef void co_lss_scan_ind_t(co_lss_t *lss, co_unsigned8_t cs,
 		const struct co_id *id, void *data);
 
+/// The statistics of an LSS discovery session (see co_lss_discover_req()).
+struct co_lss_discover_stats {
+	/// The number of LSS addresses found.
+	int nfound;
+	/// The number of slaves that accepted the node-ID assigned to them.
+	int nconf;
+	/// The number of 'Fastscan' requests sent during the identification.
+	int nreq;
+	/// The duration (in microseconds) of the identification.
+	uint_least64_t scan_time;
+	/**
+	 * The total duration (in microseconds) of the session, including the
+	 * assignment of the node-IDs.
+	 */
+	uint_least64_t total_time;
+	/**
+	 * The largest observed response latency (in microseconds) of a slave, or
+	 * 0 if no slave responded.
+	 */
+	uint_least64_t latency;
+	/// The timeout (in microseconds) of the last 'Fastscan' request.
+	uint_least64_t timeout;
+};
+
+/// The static initializer for #co_lss_discover_stats.
+#define CO_LSS_DISCOVER_STATS_INIT \
+	{ \
+		0, 0, 0, 0, 0, 0, 0 \
+	}
+
+/**
+ * The type of a CANopen LSS discovery indication function, invoked for each LSS
+ * address found by co_lss_discover_req() before a node-ID is assigned.
+ *
+ * @param lss  a pointer to an LSS master service.
+ * @param id   a pointer to the LSS address of the slave.
+ * @param nid  the node-ID suggested by the master, based on the expected
+ *             identity of the slaves in objects 1F85..1F88 (in the range
+ *             [1..127], or 255 if no suitable node-ID was found).
+ * @param data a pointer to user-specified data.
+ *
+ * @returns the node-ID to be assigned to the slave, or 255 if the slave
+ * should remain unconfigured.
+ */
+typedef co_unsigned8_t co_lss_discover_ind_t(co_lss_t *lss,
+		const struct co_id *id, co_unsigned8_t nid, void *data);
+
+/**
+ * The type of a CANopen LSS discovery confirmation function, invoked when a
+ * session started by co_lss_discover_req() completes.
+ *
+ * @param lss   a pointer to an LSS master service.
+ * @param stats a pointer to the statistics of the session.
+ * @param data  a pointer to user-specified data.
+ */
+typedef void co_lss_discover_con_t(co_lss_t *lss,
+		const struct co_lss_discover_stats *stats, void *data);
+
 void *__co_lss_alloc(void);
 void __co_lss_free(void *ptr);
 struct __co_lss *__co_lss_init(struct __co_lss *lss, co_nmt_t *nmt);
@@ -571,6 +647,43 @@ int co_lss_slowscan_req(co_lss_t *lss, const struct co_id *lo,
 int co_lss_fastscan_req(co_lss_t *lss, const struct co_id *id,
 		const struct co_id *mask, co_lss_scan_ind_t *ind, void *data);
 
+/**
+ * Requests the LSS discovery service. This service identifies _all_ slaves in
+ * the LSS waiting state with a depth-first search over the bits probed by the
+ * 'LSS Fastscan' service, and then assigns a node-ID to each of them with the
+ * 'switch state selective', 'configure node-ID' and 'switch state global'
+ * services. Unlike co_lss_fastscan_req(), no slave enters the LSS
+ * configuration state during the identification, so slaves with identical
+ * prefixes do not hide each other.
+ *
+ * The timeout of each 'Fastscan' request is adapted to the largest observed
+ * response latency (see #LELY_CO_LSS_DISCOVER_FACTOR and
+ * #LELY_CO_LSS_DISCOVER_MIN_TIMEOUT), but never exceeds the LSS timeout (see
+ * co_lss_set_timeout()). Since a response arriving after the adaptive timeout
+ * may be attributed to the next request, each LSS number found is verified
+ * once all earlier requests have timed out. If the verification fails, or a
+ * late response is received while waiting for it, the service falls back to
+ * the LSS timeout and restarts the search of that LSS number. The assigned
+ * node-IDs are not stored; this can be done afterwards with
+ * co_lss_switch_sel_req() and co_lss_store_req().
+ *
+ * @param lss   a pointer to an LSS master service.
+ * @param prune a flag specifying whether to restrict the search to the
+ *              expected identities of the slaves in the network list (objects
+ *              1F81 and 1F85..1F88). An LSS number is only restricted if all
+ *              slaves specify an expected value for it.
+ * @param ind   a pointer to the indication function (can be NULL). If NULL,
+ *              each slave is assigned the node-ID suggested by the master.
+ * @param con   a pointer to the confirmation function (can be NULL).
+ * @param data  a pointer to user-specified data (can be NULL). <b>data</b> is
+ *              passed as the last parameter to <b>ind</b> and <b>con</b>.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int co_lss_discover_req(co_lss_t *lss, int prune, co_lss_discover_ind_t *ind,
+		co_lss_discover_con_t *con, void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -428,6 +428,12 @@ class COLSS : public incomplete_c_type<__co_lss> {
                        static_cast<void*>(obj));
   }
 
+  int
+  discoverReq(bool prune, co_lss_discover_ind_t* ind,
+              co_lss_discover_con_t* con, void* data) noexcept {
+    return co_lss_discover_req(this, prune, ind, con, data);
+  }
+
  protected:
   ~COLSS() = default;
 };
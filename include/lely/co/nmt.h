@@ -33,6 +33,14 @@
 #define LELY_CO_NMT_TIMEOUT 100
 #endif
 
+#ifndef LELY_CO_NMT_BOOT_MAX
+/**
+ * The default maximum number of concurrent NMT 'boot slave' processes (0 for no
+ * limit).
+ */
+#define LELY_CO_NMT_BOOT_MAX 0
+#endif
+
 /// The CAN identifier used for NMT commands.
 #define CO_NMT_CS_CANID 0x000
 
@@ -89,6 +97,77 @@ enum {
 	CO_NMT_EC_STATE
 };
 
+/// The phases of the NMT 'boot slave' process.
+enum co_nmt_boot_phase {
+	/// Waiting for the start of the process (see co_nmt_set_boot_max()).
+	CO_NMT_BOOT_PHASE_QUEUE,
+	/// Checking the device type and identity (objects 1000 and 1018).
+	CO_NMT_BOOT_PHASE_ID,
+	/// Checking the NMT state, including the 'reset communication' command.
+	CO_NMT_BOOT_PHASE_NODE,
+	/// Checking and updating the software version.
+	CO_NMT_BOOT_PHASE_SW,
+	/// Checking and updating the configuration.
+	CO_NMT_BOOT_PHASE_CFG,
+	/// Starting the error control service.
+	CO_NMT_BOOT_PHASE_EC,
+	/// The number of phases.
+	CO_NMT_BOOT_NUM_PHASE
+};
+
+/// The durations of the phases of the last NMT 'boot slave' process of a node.
+struct co_nmt_boot_times {
+	/**
+	 * The time spent in each phase (in microseconds), indexed by
+	 * #co_nmt_boot_phase. If the process is retried, the durations of the
+	 * attempts are accumulated.
+	 */
+	uint_least64_t phase[CO_NMT_BOOT_NUM_PHASE];
+	/**
+	 * The total duration of the process (in microseconds), from the request
+	 * until the completion. This includes the time spent waiting between
+	 * attempts.
+	 */
+	uint_least64_t total;
+	/// The number of attempts.
+	unsigned int attempts;
+};
+
+/// The static initializer for #co_nmt_boot_times.
+#define CO_NMT_BOOT_TIMES_INIT \
+	{ \
+		{ 0, 0, 0, 0, 0, 0 }, 0, 0 \
+	}
+
+/**
+ * A record in the boot cache of an NMT master, describing the identity and
+ * configuration of a node after its last successful NMT 'boot slave' process
+ * (see co_nmt_set_boot_cache()). A record is valid if both the configuration
+ * date and time are non-zero.
+ */
+struct co_nmt_boot_rec {
+	/// The device type (object 1000).
+	co_unsigned32_t device_type;
+	/// The vendor-ID (sub-object 1018:01), or 0 if not checked.
+	co_unsigned32_t vendor_id;
+	/// The product code (sub-object 1018:02), or 0 if not checked.
+	co_unsigned32_t product_code;
+	/// The revision number (sub-object 1018:03), or 0 if not checked.
+	co_unsigned32_t revision;
+	/// The serial number (sub-object 1018:04), or 0 if not checked.
+	co_unsigned32_t serial_nr;
+	/// The configuration date (sub-object 1F26:ID) of the node.
+	co_unsigned32_t cfg_date;
+	/// The configuration time (sub-object 1F27:ID) of the node.
+	co_unsigned32_t cfg_time;
+};
+
+/// The static initializer for #co_nmt_boot_rec.
+#define CO_NMT_BOOT_REC_INIT \
+	{ \
+		0, 0, 0, 0, 0, 0, 0 \
+	}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -806,6 +885,133 @@ int co_nmt_boot_req(co_nmt_t *nmt, co_unsigned8_t id, int timeout);
  */
 int co_nmt_is_booting(const co_nmt_t *nmt, co_unsigned8_t id);
 
+/**
+ * Returns the maximum number of concurrent NMT 'boot slave' processes (0 for
+ * no limit).
+ *
+ * @see co_nmt_set_boot_max()
+ */
+int co_nmt_get_boot_max(const co_nmt_t *nmt);
+
+/**
+ * Sets the maximum number of concurrent NMT 'boot slave' processes. Since each
+ * process performs a series of SDO requests, this limits the bus load during
+ * the network boot-up. Requests exceeding the limit are queued (in the order of
+ * submission) and started when a running process completes. Queued nodes are
+ * considered to be booting (see co_nmt_is_booting()).
+ *
+ * @param nmt a pointer to an NMT master service.
+ * @param max the maximum number of processes (0 for no limit).
+ *
+ * @see co_nmt_get_boot_max()
+ */
+void co_nmt_set_boot_max(co_nmt_t *nmt, int max);
+
+/**
+ * Retrieves the durations of the phases of the last completed NMT 'boot slave'
+ * process of the specified node.
+ *
+ * @param nmt    a pointer to an NMT master service.
+ * @param id     the node-ID (in the range [1..127]).
+ * @param ptimes the address at which to store the durations.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int co_nmt_get_boot_times(const co_nmt_t *nmt, co_unsigned8_t id,
+		struct co_nmt_boot_times *ptimes);
+
+/**
+ * Returns 1 if the boot cache of an NMT master is enabled, and 0 if not.
+ *
+ * @see co_nmt_set_boot_cache()
+ */
+int co_nmt_get_boot_cache(const co_nmt_t *nmt);
+
+/**
+ * Enables or disables the boot cache of an NMT master. If enabled, the NMT
+ * 'boot slave' process records the device type and the checked identity
+ * (1018:01..04) of a slave after a successful boot, together with the expected
+ * configuration date and time (1F26:ID and 1F27:ID). During the next process,
+ * if the device type, the expected identity (1F85..1F88:ID) and the expected
+ * configuration date and time match the record, the identity object of the
+ * slave is not read.
+ *
+ * The configuration check (1020:01 and 1020:02) is always performed. If it
+ * fails after the identity check was skipped, the record is invalidated and the
+ * identity of the slave is checked before its configuration is updated. The
+ * records are not affected by an NMT reset and can be preserved across
+ * restarts with co_nmt_save_boot_cache() and co_nmt_load_boot_cache().
+ *
+ * @param nmt   a pointer to an NMT master service.
+ * @param cache a flag specifying whether the boot cache is enabled.
+ *
+ * @see co_nmt_get_boot_cache()
+ */
+void co_nmt_set_boot_cache(co_nmt_t *nmt, int cache);
+
+/**
+ * Retrieves the boot cache record of the specified node.
+ *
+ * @param nmt  a pointer to an NMT master service.
+ * @param id   the node-ID (in the range [1..127]).
+ * @param prec the address at which to store the record (can be NULL).
+ *
+ * @returns 1 if a valid record exists, 0 if not, or -1 on error. In the latter
+ * case, the error number can be obtained with get_errc().
+ *
+ * @see co_nmt_set_boot_rec()
+ */
+int co_nmt_get_boot_rec(const co_nmt_t *nmt, co_unsigned8_t id,
+		struct co_nmt_boot_rec *prec);
+
+/**
+ * Sets the boot cache record of the specified node.
+ *
+ * @param nmt a pointer to an NMT master service.
+ * @param id  the node-ID (in the range [1..127]).
+ * @param rec a pointer to the record, or NULL to invalidate the record.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see co_nmt_get_boot_rec()
+ */
+int co_nmt_set_boot_rec(co_nmt_t *nmt, co_unsigned8_t id,
+		const struct co_nmt_boot_rec *rec);
+
+#if !LELY_NO_STDIO
+
+/**
+ * Loads the boot cache records of an NMT master from a file. All existing
+ * records are invalidated, even if the file does not exist.
+ *
+ * @param nmt      a pointer to an NMT master service.
+ * @param filename a pointer to the name of the file.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see co_nmt_save_boot_cache()
+ */
+int co_nmt_load_boot_cache(co_nmt_t *nmt, const char *filename);
+
+/**
+ * Stores the valid boot cache records of an NMT master in a file. The file is
+ * replaced atomically.
+ *
+ * @param nmt      a pointer to an NMT master service.
+ * @param filename a pointer to the name of the file.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see co_nmt_load_boot_cache()
+ */
+int co_nmt_save_boot_cache(const co_nmt_t *nmt, const char *filename);
+
+#endif // !LELY_NO_STDIO
+
 /**
  * Checks if a boot-up message has been received from the specified node(s).
  *
@@ -439,6 +439,53 @@ class CONMT : public incomplete_c_type<__co_nmt> {
     return !!co_nmt_is_booting(this, id);
   }
 
+  int
+  getBootMax() const noexcept {
+    return co_nmt_get_boot_max(this);
+  }
+
+  void
+  setBootMax(int max) noexcept {
+    co_nmt_set_boot_max(this, max);
+  }
+
+  int
+  getBootTimes(co_unsigned8_t id, co_nmt_boot_times* ptimes) const noexcept {
+    return co_nmt_get_boot_times(this, id, ptimes);
+  }
+
+  bool
+  getBootCache() const noexcept {
+    return !!co_nmt_get_boot_cache(this);
+  }
+
+  void
+  setBootCache(bool cache) noexcept {
+    co_nmt_set_boot_cache(this, cache);
+  }
+
+  int
+  getBootRec(co_unsigned8_t id, co_nmt_boot_rec* prec) const noexcept {
+    return co_nmt_get_boot_rec(this, id, prec);
+  }
+
+  int
+  setBootRec(co_unsigned8_t id, const co_nmt_boot_rec* rec) noexcept {
+    return co_nmt_set_boot_rec(this, id, rec);
+  }
+
+#if !LELY_NO_STDIO
+  int
+  loadBootCache(const char* filename) noexcept {
+    return co_nmt_load_boot_cache(this, filename);
+  }
+
+  int
+  saveBootCache(const char* filename) const noexcept {
+    return co_nmt_save_boot_cache(this, filename);
+  }
+#endif
+
   int
   cfgReq(co_unsigned8_t id, int timeout, co_nmt_cfg_con_t* con,
          void* data) noexcept {
@@ -60,6 +60,32 @@ typedef void co_sync_ind_t(co_sync_t *sync, co_unsigned8_t cnt, void *data);
 typedef void co_sync_err_t(co_sync_t *sync, co_unsigned16_t eec,
 		co_unsigned8_t er, void *data);
 
+/**
+ * The type of a CANopen SYNC scheduling function, invoked when an active SYNC
+ * producer is started, reconfigured or stopped. The function replaces the CAN
+ * timer of the producer, which allows SYNC messages to be transmitted by an
+ * external, more accurate, time source. That time source MUST obtain each SYNC
+ * message with co_sync_stage() and report its transmission with
+ * co_sync_sent().
+ *
+ * The function is invoked from within the CANopen stack, i.e., with the CAN
+ * network locked if it is shared between threads (see io_can_net_lock()). The
+ * time source, however, typically runs in a different context (such as the
+ * completion of a timer or write operation). Since the SYNC service is not
+ * thread-safe, that context MUST hold the same lock while it invokes
+ * co_sync_stage() and co_sync_sent().
+ *
+ * @param sync     a pointer to a SYNC producer service.
+ * @param start    a pointer to the absolute time (in the time base of the CAN
+ *                 network) of the first SYNC message, or NULL if the producer
+ *                 is stopped.
+ * @param interval a pointer to the communication cycle period, or NULL if the
+ *                 producer is stopped.
+ * @param data     a pointer to user-specified data.
+ */
+typedef void co_sync_sched_t(co_sync_t *sync, const struct timespec *start,
+		const struct timespec *interval, void *data);
+
 void *__co_sync_alloc(void);
 void __co_sync_free(void *ptr);
 struct __co_sync *__co_sync_init(
@@ -169,6 +195,61 @@ void co_sync_get_err(const co_sync_t *sync, co_sync_err_t **perr, void **pdata);
  */
 void co_sync_set_err(co_sync_t *sync, co_sync_err_t *err, void *data);
 
+/**
+ * Retrieves the scheduling function of a SYNC producer service.
+ *
+ * @param sync   a pointer to a SYNC producer service.
+ * @param psched the address at which to store a pointer to the scheduling
+ *               function (can be NULL).
+ * @param pdata  the address at which to store a pointer to user-specified data
+ *               (can be NULL).
+ *
+ * @see co_sync_set_sched()
+ */
+void co_sync_get_sched(const co_sync_t *sync, co_sync_sched_t **psched,
+		void **pdata);
+
+/**
+ * Sets the scheduling function of a SYNC producer service. If set, the
+ * producer does not transmit SYNC messages itself. If the service is running,
+ * the previous scheduling function (if any) is invoked to stop the producer,
+ * and <b>sched</b> is invoked with the current schedule.
+ *
+ * @param sync  a pointer to a SYNC producer service.
+ * @param sched a pointer to the function to be invoked. If <b>sched</b> is
+ *              NULL, the producer uses its own CAN timer.
+ * @param data  a pointer to user-specified data (can be NULL). <b>data</b> is
+ *              passed as the last parameter to <b>sched</b>.
+ *
+ * @see co_sync_get_sched()
+ */
+void co_sync_set_sched(co_sync_t *sync, co_sync_sched_t *sched, void *data);
+
+/**
+ * Generates the next SYNC message of a producer and advances the counter. This
+ * function is meant to be used by external time sources (see
+ * co_sync_set_sched()), which can stage the message well before it is due.
+ * Unless it is invoked from within the CANopen stack, the caller MUST hold the
+ * lock of the CAN network (see io_can_net_lock()) while staging, as well as
+ * while invoking co_sync_sent().
+ *
+ * @param sync a pointer to a SYNC producer service.
+ * @param msg  the address at which to store the SYNC message.
+ *
+ * @see co_sync_sent()
+ */
+void co_sync_stage(co_sync_t *sync, struct can_msg *msg);
+
+/**
+ * Notifies a SYNC producer service that a message obtained with
+ * co_sync_stage() has been transmitted. This function invokes the indication
+ * function (see co_sync_set_ind()).
+ *
+ * @param sync a pointer to a SYNC producer service.
+ * @param msg  a pointer to the SYNC message.
+ */
+void co_sync_sent(co_sync_t *sync, const struct can_msg *msg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -135,6 +135,26 @@ class COSync : public incomplete_c_type<__co_sync> {
            static_cast<void*>(obj));
   }
 
+  void
+  getSched(co_sync_sched_t** psched, void** pdata) const noexcept {
+    co_sync_get_sched(this, psched, pdata);
+  }
+
+  void
+  setSched(co_sync_sched_t* sched, void* data) noexcept {
+    co_sync_set_sched(this, sched, data);
+  }
+
+  void
+  stage(can_msg& msg) noexcept {
+    co_sync_stage(this, &msg);
+  }
+
+  void
+  sent(const can_msg& msg) noexcept {
+    co_sync_sent(this, &msg);
+  }
+
  protected:
   ~COSync() = default;
 };
@@ -37,6 +37,55 @@
  */
 #define CO_TIME_COBID_FRAME UINT32_C(0x20000000)
 
+#ifndef LELY_CO_TIME_KP_SHIFT
+/**
+ * The gain of the offset correction of the TIME consumer clock discipline
+ * filter, expressed as a negative power of two (i.e., the gain is 2^-n).
+ */
+#define LELY_CO_TIME_KP_SHIFT 2
+#endif
+
+#ifndef LELY_CO_TIME_KI_SHIFT
+/**
+ * The gain of the drift correction of the TIME consumer clock discipline
+ * filter, expressed as a negative power of two (i.e., the gain is 2^-n).
+ */
+#define LELY_CO_TIME_KI_SHIFT 5
+#endif
+
+#ifndef LELY_CO_TIME_MAX_DRIFT
+/**
+ * The maximum drift (in ppm) between the clocks of a TIME producer and
+ * consumer. The estimated drift is limited to this value.
+ */
+#define LELY_CO_TIME_MAX_DRIFT 500
+#endif
+
+#ifndef LELY_CO_TIME_DRIFT_ERR
+/**
+ * The assumed error (in ppm) of the estimated drift, used to bound the error of
+ * the disciplined clock in between time stamps.
+ */
+#define LELY_CO_TIME_DRIFT_ERR 10
+#endif
+
+#ifndef LELY_CO_TIME_STEP
+/**
+ * The threshold (in milliseconds) beyond which a deviation of a received time
+ * stamp from the disciplined clock is considered to be a step of the producer
+ * clock, in which case the clock discipline filter is restarted.
+ */
+#define LELY_CO_TIME_STEP 100
+#endif
+
+#ifndef LELY_CO_TIME_MIN_SAMPLES
+/**
+ * The number of time stamps that have to be received before the disciplined
+ * clock of a TIME consumer is considered to be synchronized.
+ */
+#define LELY_CO_TIME_MIN_SAMPLES 4
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,6 +101,44 @@ extern "C" {
 typedef void co_time_ind_t(
 		co_time_t *time, const struct timespec *tp, void *data);
 
+/// The statistics of the clock discipline of a TIME producer/consumer service.
+struct co_time_clock_stats {
+	/**
+	 * The number of time stamps processed by the clock discipline filter
+	 * since it was last (re)started.
+	 */
+	size_t n;
+	/**
+	 * The number of times the filter was restarted because a time stamp
+	 * deviated more than #LELY_CO_TIME_STEP from the disciplined clock.
+	 */
+	size_t nstep;
+	/**
+	 * The estimated offset (in nanoseconds) of the producer clock with
+	 * respect to the local clock at the time the last time stamp was
+	 * received.
+	 */
+	int_least64_t offset;
+	/// The estimated drift (in ppb) of the producer clock.
+	int_least32_t drift;
+	/**
+	 * The difference (in nanoseconds) between the last time stamp and the
+	 * disciplined clock.
+	 */
+	int_least64_t residual;
+	/**
+	 * The estimated delay (in nanoseconds) between the queueing and the
+	 * transmission of a time stamp by the producer.
+	 */
+	int_least64_t txdelay;
+};
+
+/// The static initializer for #co_time_clock_stats.
+#define CO_TIME_CLOCK_STATS_INIT \
+	{ \
+		0, 0, 0, 0, 0, 0 \
+	}
+
 /**
  * Loads the absolute time from a CANopen TIME_OF_DAY value.
  *
@@ -186,6 +273,76 @@ void co_time_start_prod(co_time_t *time, const struct timespec *start,
 /// Stops a CANopen TIME producer. @see co_time_start_prod()
 void co_time_stop_prod(co_time_t *time);
 
+/**
+ * Notifies a CANopen TIME producer that a CAN frame has been transmitted. If
+ * the frame is the last time stamp sent by the producer, the difference between
+ * <b>tp</b> and the time at which the time stamp was queued is used to update
+ * the estimated transmit delay. Subsequent time stamps are advanced by this
+ * delay, so they reflect the time at which they are actually transmitted.
+ *
+ * This function is typically invoked from a write confirmation, such as the
+ * function set with io_can_net_set_on_write_func().
+ *
+ * @param time a pointer to a TIME producer service.
+ * @param msg  a pointer to the CAN frame that was transmitted.
+ * @param tp   a pointer to the time at which the frame was transmitted,
+ *             according to the clock of the CAN network.
+ *
+ * @returns 1 if <b>msg</b> is the last time stamp sent by the producer, and 0
+ * if not.
+ */
+int co_time_tx_con(co_time_t *time, const struct can_msg *msg,
+		const struct timespec *tp);
+
+/**
+ * Returns 1 if the local clock of the specified TIME consumer is disciplined by
+ * the received time stamps, and 0 if not.
+ *
+ * @see co_time_set_discipline()
+ */
+int co_time_get_discipline(const co_time_t *time);
+
+/**
+ * Enables or disables the discipline of the local clock of a TIME consumer. If
+ * enabled, the offset and drift of the producer clock with respect to the
+ * clock of the CAN network are estimated from the received time stamps with a
+ * proportional-integral filter. The resulting disciplined clock can be read
+ * with co_time_get_clock(). This function (re)starts the filter.
+ *
+ * Note that time stamps have a resolution of one millisecond. The filter
+ * averages the truncation error over multiple time stamps.
+ *
+ * @see co_time_get_discipline()
+ */
+void co_time_set_discipline(co_time_t *time, int discipline);
+
+/**
+ * Converts a local time to the disciplined clock of a TIME consumer, i.e., the
+ * estimated time of the producer clock.
+ *
+ * @param time  a pointer to a TIME consumer service.
+ * @param local a pointer to the local time, according to the clock of the CAN
+ *              network. If <b>local</b> is NULL, the current time, as obtained
+ *              with can_net_get_time(), is used.
+ * @param tp    the address at which to store the disciplined time.
+ * @param perr  the address at which to store the bound (in nanoseconds) of the
+ *              error of the disciplined time (can be NULL).
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc(). The error number is #ERRNUM_AGAIN if less
+ * than #LELY_CO_TIME_MIN_SAMPLES time stamps have been received since the
+ * filter was (re)started.
+ */
+int co_time_get_clock(const co_time_t *time, const struct timespec *local,
+		struct timespec *tp, uint_least64_t *perr);
+
+/**
+ * Retrieves the statistics of the clock discipline of a TIME producer/consumer
+ * service.
+ */
+void co_time_get_clock_stats(
+		const co_time_t *time, struct co_time_clock_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
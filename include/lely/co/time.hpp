@@ -122,6 +122,32 @@ class COTime : public incomplete_c_type<__co_time> {
     co_time_stop_prod(this);
   }
 
+  int
+  txCon(const can_msg& msg, const timespec& tp) noexcept {
+    return co_time_tx_con(this, &msg, &tp);
+  }
+
+  bool
+  getDiscipline() const noexcept {
+    return co_time_get_discipline(this) != 0;
+  }
+
+  void
+  setDiscipline(bool discipline) noexcept {
+    co_time_set_discipline(this, discipline);
+  }
+
+  int
+  getClock(const timespec* local, timespec* tp,
+           uint_least64_t* perr = 0) const noexcept {
+    return co_time_get_clock(this, local, tp, perr);
+  }
+
+  void
+  getClockStats(co_time_clock_stats* stats) const noexcept {
+    co_time_get_clock_stats(this, stats);
+  }
+
  protected:
   ~COTime() = default;
 };
@@ -0,0 +1,198 @@
+/**@file
+ * This header file is part of the C++ CANopen application library; it contains
+ * the declarations for the per-bus real-time runtime.
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_COAPP_BUS_RUNTIME_HPP_
+#define LELY_COAPP_BUS_RUNTIME_HPP_
+
+#include <lely/ev/loop.hpp>
+#include <lely/io2/linux/can.hpp>
+#include <lely/io2/posix/poll.hpp>
+#include <lely/io2/sys/timer.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <sched.h>
+
+namespace lely {
+
+namespace canopen {
+
+/**
+ * The attributes of the thread running the event loop of a
+ * #lely::canopen::BusRuntime.
+ */
+struct BusRuntimeAttributes {
+  /**
+   * The CPUs on which the thread is allowed to run. If empty, the affinity is
+   * inherited from the calling thread.
+   */
+  ::std::vector<int> cpus;
+  /**
+   * The scheduling policy of the thread (`SCHED_OTHER`, `SCHED_FIFO` or
+   * `SCHED_RR`). A real-time policy typically requires the `CAP_SYS_NICE`
+   * capability.
+   */
+  int policy{SCHED_OTHER};
+  /// The static scheduling priority of the thread (ignored for `SCHED_OTHER`).
+  int priority{0};
+  /// The size (in bytes) of the stack of the thread (0 for the default size).
+  ::std::size_t stack_size{0};
+  /**
+   * The number of bytes of the stack to touch before the event loop is
+   * started, so the page faults do not occur during operation. This value MUST
+   * be smaller than the stack size; otherwise the constructor of the runtime
+   * throws std::system_error (`EINVAL`). The number of bytes touched is
+   * limited to the part of the stack that is available to the event loop.
+   */
+  ::std::size_t prefault_stack{0};
+  /**
+   * A flag specifying whether all current and future pages of the process
+   * should be locked in memory (see `mlockall()`). Note that this affects the
+   * entire process, not only the thread of the runtime.
+   */
+  bool lock_memory{false};
+  /**
+   * The period of the timer used to measure the latency of the event loop. If
+   * zero, the latency is not measured.
+   */
+  ::std::chrono::nanoseconds latency_period{0};
+};
+
+/// The latency statistics of the event loop of a #lely::canopen::BusRuntime.
+struct BusRuntimeStats {
+  /// The number of latency measurements.
+  ::std::size_t n{0};
+  /**
+   * The number of timer expirations that were missed because the event loop
+   * did not process the previous expiration in time.
+   */
+  ::std::size_t nmissed{0};
+  /// The minimum latency.
+  ::std::chrono::nanoseconds min{0};
+  /// The maximum latency.
+  ::std::chrono::nanoseconds max{0};
+  /// The sum of all latencies.
+  ::std::chrono::nanoseconds sum{0};
+};
+
+/**
+ * A runtime for a single CAN bus. It owns an I/O polling instance, an event
+ * loop, a monotonic timer and a CAN channel, and runs the event loop in a
+ * dedicated thread with configurable CPU affinity and scheduling policy. A
+ * CANopen master or slave created with the timer and channel of the runtime
+ * (and the executor of its event loop) then runs entirely in that thread, so
+ * multiple buses can be served in parallel without interfering with each
+ * other.
+ *
+ * The latency of the event loop is measured by a periodic timer: each time the
+ * timer expires, the difference between the current time and the expected
+ * expiration time is recorded (see GetStats()).
+ */
+class BusRuntime {
+ public:
+  /**
+   * Creates a new bus runtime and starts the thread running its event loop.
+   * The CAN channel is not opened until Open() is invoked.
+   *
+   * @param ctx  the I/O context with which the polling instance and the
+   *             runtime are registered.
+   * @param attr the attributes of the thread.
+   *
+   * @throws std::system_error if the thread could not be created with the
+   * requested attributes (including a #BusRuntimeAttributes::prefault_stack
+   * value that is not smaller than the stack size), or if the memory could not
+   * be locked.
+   */
+  explicit BusRuntime(io::ContextBase ctx,
+                      const BusRuntimeAttributes& attr = {});
+
+  /**
+   * Creates a new bus runtime, opens the CAN channel on the network interface
+   * with the specified name and starts the thread running its event loop.
+   *
+   * @throws std::system_error if the CAN channel could not be opened or the
+   * thread could not be created.
+   */
+  BusRuntime(io::ContextBase ctx, const char* ifname,
+             const BusRuntimeAttributes& attr = {});
+
+  BusRuntime(const BusRuntime&) = delete;
+  BusRuntime& operator=(const BusRuntime&) = delete;
+
+  /**
+   * Stops the event loop and terminates the thread in which it was running
+   * before destroying the runtime.
+   */
+  ~BusRuntime();
+
+  /// Returns a reference to the I/O polling instance of the runtime.
+  io::Poll& GetPoll() noexcept;
+
+  /// Returns a reference to the event loop of the runtime.
+  ev::Loop& GetLoop() noexcept;
+
+  /// Returns the executor of the event loop of the runtime.
+  ev::Executor GetExecutor() const noexcept;
+
+  /**
+   * Returns a reference to the `CLOCK_MONOTONIC` timer of the runtime. This
+   * timer is intended to be used by a CANopen master or slave.
+   */
+  io::Timer& GetTimer() noexcept;
+
+  /// Returns a reference to the CAN channel of the runtime.
+  io::CanChannel& GetChannel() noexcept;
+
+  /**
+   * Opens the CAN channel on the network interface with the specified name.
+   *
+   * @throws std::system_error if the CAN controller or channel could not be
+   * opened.
+   */
+  void Open(const char* ifname);
+
+  /// Returns the latency statistics of the event loop.
+  BusRuntimeStats GetStats() const;
+
+  /// Resets the latency statistics of the event loop.
+  void ResetStats() noexcept;
+
+  /**
+   * Stops the event loop and waits until the thread running the event loop
+   * finishes its execution.
+   *
+   * This function can be called more than once and from multiple threads, but
+   * only the first invocation waits for the thread to finish.
+   */
+  void Join();
+
+ private:
+  struct Impl_;
+  ::std::unique_ptr<Impl_> impl_;
+};
+
+}  // namespace canopen
+
+}  // namespace lely
+
+#endif  // LELY_COAPP_BUS_RUNTIME_HPP_
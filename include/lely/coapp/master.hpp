@@ -1709,7 +1709,7 @@ class BasicMaster : public Node, protected ::std::map<uint8_t, DriverBase*> {
    *
    * @see Insert()
    */
-  void Erase(DriverBase& driver);
+  virtual void Erase(DriverBase& driver);
 
   /// @see Node::OnCanState()
   void
@@ -2008,10 +2008,59 @@ class BasicMaster : public Node, protected ::std::map<uint8_t, DriverBase*> {
  * An asynchronous CANopen master. When a CANopen event occurs, this master
  * queues a notification to (the executor of) each registered driver. The master
  * itself does not block waiting for events to be handled.
+ *
+ * Notifications are stored in a preallocated mailbox for each driver. A single
+ * task is submitted to the executor of a driver for each batch of pending
+ * notifications, so no memory is allocated once the mailboxes have reached
+ * their steady-state size. If the driver has not yet handled a SYNC
+ * notification when the next one arrives, the two are coalesced and only the
+ * most recent counter and time stamp are delivered. Similarly, multiple pending
+ * RPDO write notifications for the same sub-object are delivered only once.
+ * Notifications that have not been delivered when a driver is unregistered are
+ * discarded.
  */
 class AsyncMaster : public BasicMaster {
  public:
-  using BasicMaster::BasicMaster;
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                       io::CanChannelBase& chan, __co_dev* dev,
+                       uint8_t id = 0xff);
+
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(io::TimerBase& timer, io::CanChannelBase& chan,
+                       __co_dev* dev, uint8_t id = 0xff)
+      : AsyncMaster(nullptr, timer, chan, dev, id) {}
+
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                       io::CanChannelBase& chan, const ::std::string& dcf_txt,
+                       const ::std::string& dcf_bin = "", uint8_t id = 0xff);
+
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(io::TimerBase& timer, io::CanChannelBase& chan,
+                       const ::std::string& dcf_txt,
+                       const ::std::string& dcf_bin = "", uint8_t id = 0xff)
+      : AsyncMaster(nullptr, timer, chan, dcf_txt, dcf_bin, id) {}
+
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                       io::CanChannelBase& chan, const co_sdev* sdev,
+                       uint8_t id = 0xff);
+
+  /// @see BasicMaster::BasicMaster()
+  explicit AsyncMaster(io::TimerBase& timer, io::CanChannelBase& chan,
+                       const co_sdev* sdev, uint8_t id = 0xff)
+      : AsyncMaster(nullptr, timer, chan, sdev, id) {}
+
+  ~AsyncMaster();
+
+  /**
+   * Unregisters a driver for a remote CANopen node and discards the
+   * notifications that have not yet been delivered to it.
+   *
+   * @see BasicMaster::Erase()
+   */
+  void Erase(DriverBase& driver) override;
 
   /// @see Node::OnCanState()
   void
@@ -2198,6 +2247,10 @@ class AsyncMaster : public BasicMaster {
    * @see BasicMaster::OnConfig(), DriverBase::OnConfig()
    */
   void OnConfig(uint8_t id) noexcept override;
+
+ private:
+  struct Impl_;
+  ::std::unique_ptr<Impl_> impl_;
 };
 
 }  // namespace canopen
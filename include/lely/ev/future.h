@@ -54,6 +54,48 @@ extern "C" {
  */
 typedef void ev_promise_dtor_t(void *ptr);
 
+/// The promise allocation statistics of a thread.
+struct ev_promise_stats {
+	/// The number of promises allocated on the heap by this thread.
+	size_t nalloc;
+	/// The number of promises reusing a cached memory block.
+	size_t nreused;
+	/// The number of unused memory blocks cached by this thread.
+	size_t nunused;
+};
+
+/**
+ * Enables the cache of unused promises for the calling thread. Once enabled,
+ * the memory of a promise destroyed by this thread is kept for reuse by
+ * subsequent calls to ev_promise_create() from the same thread, instead of
+ * being freed, as long as the shared state is small enough and the cache holds
+ * fewer than <b>max_unused</b> promises. In the steady state, this allows
+ * asynchronous operations and their continuations to complete without any heap
+ * allocation. This function can be invoked more than once by the same thread.
+ * Only the first invocation initializes the cache.
+ *
+ * @param max_unused the maximum number of unused promises kept alive for future
+ *                   use. If 0, the default number
+ *                   (#LELY_EV_PROMISE_MAX_UNUSED) is used.
+ *
+ * @returns 1 if the cache of the calling thread is already enabled, and 0 if
+ * not.
+ */
+int ev_promise_thrd_init(size_t max_unused);
+
+/**
+ * Disables the cache of unused promises for the calling thread and frees the
+ * cached memory. This function MUST be called once for each call to
+ * ev_promise_thrd_init(). Only the last invocation finalizes the cache.
+ */
+void ev_promise_thrd_fini(void);
+
+/**
+ * Stores the promise allocation statistics of the calling thread in
+ * *<b>stats</b>. The statistics are tracked even if the cache is not enabled.
+ */
+void ev_promise_thrd_get_stats(struct ev_promise_stats *stats);
+
 /**
  * Constructs a new promise with an optional empty shared state. The promise is
  * destroyed once the last reference to it is released.
@@ -49,6 +49,47 @@ class future_not_ready : public ::std::runtime_error {
 template <class, class = ::std::error_code>
 class Future;
 
+/**
+ * Convenience class providing a RAII-style mechanism to enable the cache of
+ * unused promises for the calling thread for the duration of a scoped block.
+ */
+class PromiseThread {
+ public:
+  /**
+   * Enables the cache of unused promises for the calling thread, if it was not
+   * already enabled.
+   *
+   * @param max_unused the maximum number of unused promises kept alive for
+   *                   future use. If 0, the default number
+   *                   (#LELY_EV_PROMISE_MAX_UNUSED) is used.
+   *
+   * @see ev_promise_thrd_init()
+   */
+  explicit PromiseThread(::std::size_t max_unused = 0) noexcept {
+    ev_promise_thrd_init(max_unused);
+  }
+
+  PromiseThread(const PromiseThread&) = delete;
+  PromiseThread(PromiseThread&&) = delete;
+
+  PromiseThread& operator=(const PromiseThread&) = delete;
+  PromiseThread& operator=(PromiseThread&&) = delete;
+
+  /**
+   * Disables the cache of unused promises for the calling thread, unless
+   * another instance of this class is still in scope.
+   */
+  ~PromiseThread() { ev_promise_thrd_fini(); }
+
+  /// @see ev_promise_thrd_get_stats()
+  static ev_promise_stats
+  get_stats() noexcept {
+    ev_promise_stats stats;
+    ev_promise_thrd_get_stats(&stats);
+    return stats;
+  }
+};
+
 /**
  * A promise. <b>T</b> and <b>E</b> should be nothrow default-constructible. Any
  * exceptions thrown during the default construction of the shared state will
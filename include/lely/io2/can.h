@@ -132,6 +132,94 @@ struct io_can_chan_write {
 		(msg), EV_TASK_INIT(exec, func), 0 \
 	}
 
+/// The result of a vectored CAN channel read or write operation.
+struct io_can_chan_vec_result {
+	/// The number of CAN frames read or written.
+	size_t n;
+	/**
+	 * The error number, obtained as if by get_errc(), if an error occurred
+	 * or the operation was canceled, or 0 on success.
+	 */
+	int errc;
+};
+
+/**
+ * A vectored CAN channel read operation. The operation completes as soon as at
+ * least one CAN frame is received, and stores as many of the CAN frames
+ * available at that time as fit in the buffer. CAN error frames are discarded;
+ * use io_can_chan_submit_read() to receive those.
+ */
+struct io_can_chan_readv {
+	/**
+	 * The array of at least #n elements at which to store the CAN frames.
+	 * It is the responsibility of the user to ensure the buffer remains
+	 * valid until the read operation completes.
+	 */
+	struct can_msg *msgs;
+	/**
+	 * The array of at least #n elements at which to store the system times
+	 * at which the CAN frames were received (can be NULL). If not NULL, it
+	 * is the responsibility of the user to ensure the buffer remains valid
+	 * until the read operation completes.
+	 */
+	struct timespec *tps;
+	/// The maximum number of CAN frames to be read.
+	size_t n;
+	/**
+	 * The task (to be) submitted upon completion (or cancellation) of the
+	 * read operation.
+	 */
+	struct ev_task task;
+	/**
+	 * The result of the read operation. On success, `r.n` is at least 1
+	 * and at most #n. On error, `r.n` is 0.
+	 */
+	struct io_can_chan_vec_result r;
+};
+
+/// The static initializer for #io_can_chan_readv.
+#define IO_CAN_CHAN_READV_INIT(msgs, tps, n, exec, func) \
+	{ \
+		(msgs), (tps), (n), EV_TASK_INIT(exec, func), { 0, 0 } \
+	}
+
+/**
+ * A vectored CAN channel write operation. The CAN frames are written in order.
+ * The operation completes once all frames are written, or when an error occurs.
+ */
+struct io_can_chan_writev {
+	/**
+	 * A pointer to the array of #n CAN frames to be written. It is the
+	 * responsibility of the user to ensure the buffer remains valid until
+	 * the write operation completes.
+	 */
+	const struct can_msg *msgs;
+	/// The number of CAN frames to be written.
+	size_t n;
+	/**
+	 * The task (to be) submitted upon completion (or cancellation) of the
+	 * write operation.
+	 */
+	struct ev_task task;
+	/**
+	 * The result of the write operation. On success, `r.n` equals #n. On
+	 * error, `r.n` contains the number of frames written before the error
+	 * occurred.
+	 */
+	struct io_can_chan_vec_result r;
+	/**
+	 * The number of frames for which a write confirmation has been
+	 * received (used internally by channels waiting for confirmations).
+	 */
+	size_t _nconfirm;
+};
+
+/// The static initializer for #io_can_chan_writev.
+#define IO_CAN_CHAN_WRITEV_INIT(msgs, n, exec, func) \
+	{ \
+		(msgs), (n), EV_TASK_INIT(exec, func), { 0, 0 }, 0 \
+	}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -156,6 +244,12 @@ struct io_can_chan_vtbl {
 			int timeout);
 	void (*submit_write)(
 			io_can_chan_t *chan, struct io_can_chan_write *write);
+	// The vectored operations were added last, so implementations that
+	// predate them can leave these members NULL (not supported).
+	void (*submit_readv)(
+			io_can_chan_t *chan, struct io_can_chan_readv *readv);
+	void (*submit_writev)(
+			io_can_chan_t *chan, struct io_can_chan_writev *writev);
 };
 
 /**
@@ -393,6 +487,75 @@ static inline size_t io_can_chan_abort_write(
 ev_future_t *io_can_chan_async_write(io_can_chan_t *chan, ev_exec_t *exec,
 		const struct can_msg *msg, struct io_can_chan_write **pwrite);
 
+/**
+ * Submits a vectored read operation to a CAN channel. The completion task is
+ * submitted for execution once at least one CAN frame is received or a read
+ * error occurs. Compared to submitting <b>readv->n</b> read operations, this
+ * requires only a single completion task for a burst of frames.
+ *
+ * If the channel does not support vectored operations, the completion task is
+ * submitted for execution with <b>r.errc</b> = #errnum2c(#ERRNUM_NOTSUP).
+ */
+void io_can_chan_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+
+/**
+ * Cancels the specified vectored CAN channel read operation if it is pending.
+ * The completion task is submitted for execution with <b>errc</b> =
+ * #errnum2c(#ERRNUM_CANCELED).
+ *
+ * @returns 1 if the operation was canceled, and 0 if it was not pending.
+ *
+ * @see io_dev_cancel()
+ */
+static inline size_t io_can_chan_cancel_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+
+/**
+ * Aborts the specified vectored CAN channel read operation if it is pending. If
+ * aborted, the completion task is _not_ submitted for execution.
+ *
+ * @returns 1 if the operation was aborted, and 0 if it was not pending.
+ *
+ * @see io_dev_abort()
+ */
+static inline size_t io_can_chan_abort_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+
+/**
+ * Submits a vectored write operation to a CAN channel. The completion task is
+ * submitted for execution once all CAN frames are written or a write error
+ * occurs.
+ *
+ * If the channel does not support vectored operations, the completion task is
+ * submitted for execution with <b>r.errc</b> = #errnum2c(#ERRNUM_NOTSUP).
+ */
+void io_can_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
+
+/**
+ * Cancels the specified vectored CAN channel write operation if it is pending.
+ * The completion task is submitted for execution with <b>errc</b> =
+ * #errnum2c(#ERRNUM_CANCELED).
+ *
+ * @returns 1 if the operation was canceled, and 0 if it was not pending.
+ *
+ * @see io_dev_cancel()
+ */
+static inline size_t io_can_chan_cancel_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
+
+/**
+ * Aborts the specified vectored CAN channel write operation if it is pending.
+ * If aborted, the completion task is _not_ submitted for execution.
+ *
+ * @returns 1 if the operation was aborted, and 0 if it was not pending.
+ *
+ * @see io_dev_abort()
+ */
+static inline size_t io_can_chan_abort_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
+
 /**
  * Obtains a pointer to a CAN channel read operation from a pointer to its
  * completion task.
@@ -405,6 +568,18 @@ struct io_can_chan_read *io_can_chan_read_from_task(struct ev_task *task);
  */
 struct io_can_chan_write *io_can_chan_write_from_task(struct ev_task *task);
 
+/**
+ * Obtains a pointer to a vectored CAN channel read operation from a pointer to
+ * its completion task.
+ */
+struct io_can_chan_readv *io_can_chan_readv_from_task(struct ev_task *task);
+
+/**
+ * Obtains a pointer to a vectored CAN channel write operation from a pointer to
+ * its completion task.
+ */
+struct io_can_chan_writev *io_can_chan_writev_from_task(struct ev_task *task);
+
 inline int
 io_can_ctrl_stop(io_can_ctrl_t *ctrl)
 {
@@ -487,6 +662,8 @@ io_can_chan_read(io_can_chan_t *chan, struct can_msg *msg, struct can_err *err,
 inline void
 io_can_chan_submit_read(io_can_chan_t *chan, struct io_can_chan_read *read)
 {
+	// Mark the task as belonging to a single read operation.
+	read->task._data = NULL;
 	(*chan)->submit_read(chan, read);
 }
 
@@ -511,6 +688,8 @@ io_can_chan_write(io_can_chan_t *chan, const struct can_msg *msg, int timeout)
 inline void
 io_can_chan_submit_write(io_can_chan_t *chan, struct io_can_chan_write *write)
 {
+	// Mark the task as belonging to a single write operation.
+	write->task._data = NULL;
 	(*chan)->submit_write(chan, write);
 }
 
@@ -526,6 +705,31 @@ io_can_chan_abort_write(io_can_chan_t *chan, struct io_can_chan_write *write)
 	return io_can_chan_abort(chan, &write->task);
 }
 
+static inline size_t
+io_can_chan_cancel_readv(io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	return io_can_chan_cancel(chan, &readv->task);
+}
+
+static inline size_t
+io_can_chan_abort_readv(io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	return io_can_chan_abort(chan, &readv->task);
+}
+
+static inline size_t
+io_can_chan_cancel_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	return io_can_chan_cancel(chan, &writev->task);
+}
+
+static inline size_t
+io_can_chan_abort_writev(io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	return io_can_chan_abort(chan, &writev->task);
+}
+
 #ifdef __cplusplus
 }
 #endif
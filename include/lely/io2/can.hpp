@@ -590,6 +590,42 @@ class CanChannelBase : public Device {
     return async_write(nullptr, msg, pwrite);
   }
 
+  /// @see io_can_chan_submit_readv()
+  void
+  submit_readv(struct io_can_chan_readv& readv) noexcept {
+    io_can_chan_submit_readv(*this, &readv);
+  }
+
+  /// @see io_can_chan_cancel_readv()
+  bool
+  cancel_readv(struct io_can_chan_readv& readv) noexcept {
+    return io_can_chan_cancel_readv(*this, &readv) != 0;
+  }
+
+  /// @see io_can_chan_abort_readv()
+  bool
+  abort_readv(struct io_can_chan_readv& readv) noexcept {
+    return io_can_chan_abort_readv(*this, &readv) != 0;
+  }
+
+  /// @see io_can_chan_submit_writev()
+  void
+  submit_writev(struct io_can_chan_writev& writev) noexcept {
+    io_can_chan_submit_writev(*this, &writev);
+  }
+
+  /// @see io_can_chan_cancel_writev()
+  bool
+  cancel_writev(struct io_can_chan_writev& writev) noexcept {
+    return io_can_chan_cancel_writev(*this, &writev) != 0;
+  }
+
+  /// @see io_can_chan_abort_writev()
+  bool
+  abort_writev(struct io_can_chan_writev& writev) noexcept {
+    return io_can_chan_abort_writev(*this, &writev) != 0;
+  }
+
  protected:
   io_can_chan_t* chan{nullptr};
 };
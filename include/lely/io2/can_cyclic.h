@@ -0,0 +1,199 @@
+/**@file
+ * This header file is part of the I/O library; it contains the cyclic CAN frame
+ * transmitter declarations.
+ *
+ * A cyclic transmitter writes a CAN frame at fixed, absolute times, such as the
+ * SYNC message of a CANopen SYNC producer (see co_sync_set_sched()). Unlike a
+ * CAN timer of a CAN network interface, which is re-armed after every
+ * expiration, the transmitter programs its I/O timer once with an absolute
+ * start time and a period, so the transmission times do not drift under load.
+ * The frame for the next cycle is staged as soon as the previous frame has been
+ * written, so at the deadline only the write operation remains to be
+ * submitted. The transmitter bypasses the transmit queue of the CAN network
+ * interface, if any.
+ *
+ * The time at which each write operation completes is compared to its
+ * deadline, and the latency is recorded in a histogram (see
+ * io_can_cyclic_get_stats()).
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_IO2_CAN_CYCLIC_H_
+#define LELY_IO2_CAN_CYCLIC_H_
+
+#include <lely/io2/can.h>
+#include <lely/io2/timer.h>
+
+/**
+ * The number of bins in the latency histogram of a cyclic CAN frame
+ * transmitter. Bin 0 counts latencies below 1 us, bin <i>i</i> (0 < <i>i</i>
+ * < #IO_CAN_CYCLIC_NBIN - 1) latencies in the range [2^(<i>i</i> - 1),
+ * 2^<i>i</i>) us, and the last bin all longer latencies.
+ */
+#define IO_CAN_CYCLIC_NBIN 16
+
+/// A cyclic CAN frame transmitter.
+typedef struct io_can_cyclic io_can_cyclic_t;
+
+/// The statistics of a cyclic CAN frame transmitter.
+struct io_can_cyclic_stats {
+	/// The number of CAN frames successfully written.
+	size_t nwrite;
+	/// The number of failed write operations.
+	size_t nerror;
+	/**
+	 * The number of cycles in which no frame was written, because the timer
+	 * expired more than once before the expiration was processed, or
+	 * because the previous write operation had not yet completed.
+	 */
+	size_t nmissed;
+	/// The minimum latency (in nanoseconds).
+	int_least64_t min;
+	/// The maximum latency (in nanoseconds).
+	int_least64_t max;
+	/// The sum of all latencies (in nanoseconds).
+	int_least64_t sum;
+	/// The latency histogram.
+	size_t hist[IO_CAN_CYCLIC_NBIN];
+};
+
+/// The static initializer for #io_can_cyclic_stats.
+#define IO_CAN_CYCLIC_STATS_INIT \
+	{ \
+		0, 0, 0, 0, 0, 0, { 0 } \
+	}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The type of function invoked by a cyclic CAN frame transmitter to stage the
+ * CAN frame for the next cycle. This function is invoked without any locks
+ * held, and never from io_can_cyclic_start().
+ *
+ * @param msg the address at which to store the CAN frame.
+ * @param arg the user-specified argument.
+ */
+typedef void io_can_cyclic_func_t(struct can_msg *msg, void *arg);
+
+/**
+ * The type of function invoked by a cyclic CAN frame transmitter when a write
+ * operation completes. This function is invoked without any locks held.
+ *
+ * @param msg  a pointer to the CAN frame.
+ * @param tp   a pointer to the time at which the operation completed.
+ * @param errc the error number (0 on success).
+ * @param arg  the user-specified argument.
+ */
+typedef void io_can_cyclic_on_write_func_t(const struct can_msg *msg,
+		const struct timespec *tp, int errc, void *arg);
+
+void *io_can_cyclic_alloc(void);
+void io_can_cyclic_free(void *ptr);
+io_can_cyclic_t *io_can_cyclic_init(io_can_cyclic_t *cyc, ev_exec_t *exec,
+		io_timer_t *timer, io_can_chan_t *chan);
+void io_can_cyclic_fini(io_can_cyclic_t *cyc);
+
+/**
+ * Creates a new cyclic CAN frame transmitter.
+ *
+ * @param exec  a pointer to the executor used to execute asynchronous tasks.
+ *              If <b>exec</b> is NULL, the CAN channel executor is used.
+ * @param timer a pointer to a timer. This timer MUST NOT be used for any other
+ *              purpose. The period and deadlines are measured with the clock
+ *              of this timer.
+ * @param chan  a pointer to a CAN channel. The channel MAY be shared with a CAN
+ *              network interface.
+ *
+ * @returns a pointer to a new transmitter, or NULL on error. In the latter
+ * case, the error number can be obtained with get_errc().
+ */
+io_can_cyclic_t *io_can_cyclic_create(
+		ev_exec_t *exec, io_timer_t *timer, io_can_chan_t *chan);
+
+/// Destroys a cyclic CAN frame transmitter. @see io_can_cyclic_create()
+void io_can_cyclic_destroy(io_can_cyclic_t *cyc);
+
+/**
+ * Sets the function used to stage the CAN frame for each cycle.
+ *
+ * @param cyc  a pointer to a cyclic CAN frame transmitter.
+ * @param func a pointer to the function to be invoked. If <b>func</b> is NULL,
+ *             the frame last staged is written every cycle.
+ * @param arg  the user-specified argument (can be NULL). <b>arg</b> is passed
+ *             as the last argument to <b>func</b>.
+ */
+void io_can_cyclic_set_func(
+		io_can_cyclic_t *cyc, io_can_cyclic_func_t *func, void *arg);
+
+/**
+ * Sets the function invoked when a write operation of a cyclic CAN frame
+ * transmitter completes.
+ *
+ * @param cyc  a pointer to a cyclic CAN frame transmitter.
+ * @param func a pointer to the function to be invoked (can be NULL).
+ * @param arg  the user-specified argument (can be NULL). <b>arg</b> is passed
+ *             as the last argument to <b>func</b>.
+ */
+void io_can_cyclic_set_on_write_func(io_can_cyclic_t *cyc,
+		io_can_cyclic_on_write_func_t *func, void *arg);
+
+/**
+ * Starts, or restarts, a cyclic CAN frame transmitter. The frame staged for a
+ * previous schedule (if any) is discarded.
+ *
+ * @param cyc      a pointer to a cyclic CAN frame transmitter.
+ * @param start    a pointer to the absolute time of the first transmission.
+ * @param interval a pointer to the period (MUST be positive).
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see io_can_cyclic_stop()
+ */
+int io_can_cyclic_start(io_can_cyclic_t *cyc, const struct timespec *start,
+		const struct timespec *interval);
+
+/**
+ * Stops a cyclic CAN frame transmitter. A write operation in progress is not
+ * canceled.
+ *
+ * @see io_can_cyclic_start()
+ */
+void io_can_cyclic_stop(io_can_cyclic_t *cyc);
+
+/**
+ * Retrieves the statistics of a cyclic CAN frame transmitter.
+ *
+ * @param cyc   a pointer to a cyclic CAN frame transmitter.
+ * @param stats the address at which to store the statistics.
+ *
+ * @see io_can_cyclic_reset_stats()
+ */
+void io_can_cyclic_get_stats(
+		const io_can_cyclic_t *cyc, struct io_can_cyclic_stats *stats);
+
+/// Resets the statistics of a cyclic CAN frame transmitter.
+void io_can_cyclic_reset_stats(io_can_cyclic_t *cyc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !LELY_IO2_CAN_CYCLIC_H_
@@ -0,0 +1,102 @@
+/**@file
+ * This header file is part of the I/O library; it contains the C++ interface
+ * for the cyclic CAN frame transmitter.
+ *
+ * @see lely/io2/can_cyclic.h
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_IO2_CAN_CYCLIC_HPP_
+#define LELY_IO2_CAN_CYCLIC_HPP_
+
+#include <lely/io2/can.hpp>
+#include <lely/io2/can_cyclic.h>
+#include <lely/io2/timer.hpp>
+
+namespace lely {
+namespace io {
+
+/// A cyclic CAN frame transmitter.
+class CanCyclic {
+ public:
+  /// @see io_can_cyclic_create()
+  CanCyclic(ev_exec_t* exec, io_timer_t* timer, io_can_chan_t* chan)
+      : cyc_(io_can_cyclic_create(exec, timer, chan)) {
+    if (!cyc_) util::throw_errc("CanCyclic");
+  }
+
+  /// @see io_can_cyclic_create()
+  CanCyclic(io_timer_t* timer, io_can_chan_t* chan)
+      : CanCyclic(nullptr, timer, chan) {}
+
+  CanCyclic(const CanCyclic&) = delete;
+  CanCyclic& operator=(const CanCyclic&) = delete;
+
+  /// @see io_can_cyclic_destroy()
+  ~CanCyclic() { io_can_cyclic_destroy(*this); }
+
+  operator io_can_cyclic_t*() const noexcept { return cyc_; }
+
+  /// @see io_can_cyclic_set_func()
+  void
+  set_func(io_can_cyclic_func_t* func, void* arg = nullptr) noexcept {
+    io_can_cyclic_set_func(*this, func, arg);
+  }
+
+  /// @see io_can_cyclic_set_on_write_func()
+  void
+  set_on_write_func(io_can_cyclic_on_write_func_t* func,
+                    void* arg = nullptr) noexcept {
+    io_can_cyclic_set_on_write_func(*this, func, arg);
+  }
+
+  /// @see io_can_cyclic_start()
+  void
+  start(const timespec& start, const timespec& interval) {
+    if (io_can_cyclic_start(*this, &start, &interval) == -1)
+      util::throw_errc("start");
+  }
+
+  /// @see io_can_cyclic_stop()
+  void
+  stop() noexcept {
+    io_can_cyclic_stop(*this);
+  }
+
+  /// @see io_can_cyclic_get_stats()
+  io_can_cyclic_stats
+  get_stats() const noexcept {
+    io_can_cyclic_stats stats IO_CAN_CYCLIC_STATS_INIT;
+    io_can_cyclic_get_stats(*this, &stats);
+    return stats;
+  }
+
+  /// @see io_can_cyclic_reset_stats()
+  void
+  reset_stats() noexcept {
+    io_can_cyclic_reset_stats(*this);
+  }
+
+ private:
+  io_can_cyclic_t* cyc_{nullptr};
+};
+
+}  // namespace io
+}  // namespace lely
+
+#endif  // !LELY_IO2_CAN_CYCLIC_HPP_
@@ -36,6 +36,59 @@ typedef struct io_can_net io_can_net_t;
 
 // Avoid including <lely/can/net.h>.
 struct __can_net;
+struct can_net_filter;
+
+/// The number of transmit traffic classes of a CAN network interface.
+#define IO_CAN_NET_NTXCLASS 4
+
+/**
+ * The number of bins in the latency histograms of a CAN network interface (see
+ * #io_can_net_stats). Latencies are recorded in microseconds. Bins 0 to 3 each
+ * contain a single value; every subsequent power of two is divided into 4 bins
+ * of equal width, so the relative resolution is at least 25%. The last bin
+ * also contains all latencies that exceed its range. Use
+ * io_can_net_stats_bin_min() to obtain the lower bound of a bin.
+ */
+#define IO_CAN_NET_STATS_NBIN 64
+
+/**
+ * The statistics of a CAN network interface. All counters are cumulative; rates
+ * (frames/s or bytes/s) and the bus load are obtained by sampling the
+ * statistics periodically and dividing the difference by the sampling interval
+ * (and, for the bus load, the bitrate).
+ */
+struct io_can_net_stats {
+	/// The number of CAN frames received.
+	uint_least64_t rx_frames;
+	/// The number of data bytes in the CAN frames received.
+	uint_least64_t rx_bytes;
+	/**
+	 * The number of bits occupied on the CAN bus by the CAN frames
+	 * received, excluding stuff bits.
+	 */
+	uint_least64_t rx_bits;
+	/// The number of CAN frames successfully written.
+	uint_least64_t tx_frames;
+	/// The number of data bytes in the CAN frames written.
+	uint_least64_t tx_bytes;
+	/**
+	 * The number of bits occupied on the CAN bus by the CAN frames written,
+	 * excluding stuff bits.
+	 */
+	uint_least64_t tx_bits;
+	/// The maximum number of frames in the transmit queue.
+	uint_least64_t tx_hwm;
+	/**
+	 * The histogram of the times between the queueing of a CAN frame with
+	 * can_net_send() and the completion of its write operation.
+	 */
+	uint_least64_t tx_latency[IO_CAN_NET_STATS_NBIN];
+	/**
+	 * The histogram of the times needed to dispatch a received CAN frame to
+	 * the receivers of the CAN network interface.
+	 */
+	uint_least64_t rx_latency[IO_CAN_NET_STATS_NBIN];
+};
 
 #ifdef __cplusplus
 extern "C" {
@@ -86,6 +139,58 @@ typedef void io_can_net_on_can_state_func_t(
  */
 typedef void io_can_net_on_can_error_func_t(int error, void *arg);
 
+/**
+ * The type of function invoked when a CAN frame has been written successfully
+ * by a CAN network interface (a write confirmation). This function can be used
+ * to obtain the time at which a frame was actually transmitted, which may
+ * differ significantly from the time it was queued with can_net_send().
+ *
+ * The mutex protecting the CAN network interface will be locked when this
+ * function is called.
+ *
+ * @param msg a pointer to the CAN frame that was written.
+ * @param tp  a pointer to the time (according to the clock of the CAN network
+ *            interface) at which the write operation completed.
+ * @param arg the user-specifed argument.
+ */
+typedef void io_can_net_on_write_func_t(const struct can_msg *msg,
+		const struct timespec *tp, void *arg);
+
+/**
+ * The type of function invoked by a CAN network interface to install the
+ * acceptance filters needed by its receivers on a CAN channel.
+ *
+ * The mutex protecting the CAN network interface will be locked when this
+ * function is called.
+ *
+ * @param chan    a pointer to the CAN channel of the CAN network interface.
+ * @param filters a pointer to an array of acceptance filters, or NULL if all
+ *                CAN frames should be accepted.
+ * @param n       the number of filters in <b>filters</b>.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * SHOULD be set with set_errc().
+ *
+ * @see can_filter_func_t, io_can_chan_set_filter()
+ */
+typedef int io_can_net_filter_func_t(io_can_chan_t *chan,
+		const struct can_net_filter *filters, size_t n);
+
+/**
+ * The type of function invoked by a CAN network interface to determine the
+ * traffic class of a CAN frame before it is added to the transmit queue. Frames
+ * in a lower class are always sent before frames in a higher class.
+ *
+ * The mutex protecting the CAN network interface will be locked when this
+ * function is called.
+ *
+ * @param msg a pointer to the CAN frame to be sent.
+ * @param arg the user-specified argument.
+ *
+ * @returns the traffic class, in the range [0, #IO_CAN_NET_NTXCLASS).
+ */
+typedef int io_can_net_txclass_func_t(const struct can_msg *msg, void *arg);
+
 void *io_can_net_alloc(void);
 void io_can_net_free(void *ptr);
 io_can_net_t *io_can_net_init(io_can_net_t *net, ev_exec_t *exec,
@@ -236,6 +341,35 @@ void io_can_net_get_on_write_error_func(const io_can_net_t *net,
 void io_can_net_set_on_write_error_func(
 		io_can_net_t *net, io_can_net_on_error_func_t *func, void *arg);
 
+/**
+ * Retrieves the function invoked when a CAN frame has been written
+ * successfully.
+ *
+ * @param net   a pointer to a CAN network interface.
+ * @param pfunc the address at which to store a pointer to the function (can be
+ *              NULL).
+ * @param parg  the address at which to store the user-specified argument (can
+ *              be NULL).
+ *
+ * @see io_can_net_set_on_write_func()
+ */
+void io_can_net_get_on_write_func(const io_can_net_t *net,
+		io_can_net_on_write_func_t **pfunc, void **parg);
+
+/**
+ * Sets the function invoked when a CAN frame has been written successfully.
+ *
+ * @param net  a pointer to a CAN network interface.
+ * @param func a pointer to the function to be invoked. If <b>func</b> is NULL,
+ *             no function is invoked.
+ * @param arg  the user-specified argument (can be NULL). <b>arg</b> is passed
+ *             as the last argument to <b>func</b>.
+ *
+ * @see io_can_net_get_on_write_func()
+ */
+void io_can_net_set_on_write_func(
+		io_can_net_t *net, io_can_net_on_write_func_t *func, void *arg);
+
 /**
  * Retrieves the function invoked when a CAN bus state change is detected.
  *
@@ -292,6 +426,162 @@ void io_can_net_get_on_can_error_func(const io_can_net_t *net,
 void io_can_net_set_on_can_error_func(io_can_net_t *net,
 		io_can_net_on_can_error_func_t *func, void *arg);
 
+/**
+ * Retrieves the function used to install acceptance filters on the CAN channel
+ * of a CAN network interface.
+ *
+ * @returns a pointer to the function, or NULL if no filters are installed.
+ *
+ * @see io_can_net_set_filter_func()
+ */
+io_can_net_filter_func_t *io_can_net_get_filter_func(const io_can_net_t *net);
+
+/**
+ * Sets the function used to install acceptance filters on the CAN channel of a
+ * CAN network interface. The filters are derived from the active receivers of
+ * the internal CAN network interface, so the CAN channel can drop the frames
+ * nobody is interested in (see can_net_set_filter_func()). <b>func</b> is
+ * invoked immediately, and whenever the filters need to change.
+ *
+ * On Linux, io_can_chan_set_filter() can be used to install the filters in the
+ * kernel.
+ *
+ * @param net  a pointer to a CAN network interface.
+ * @param func a pointer to the function to be invoked. If <b>func</b> is NULL,
+ *             the previous function (if any) is invoked with a NULL pointer to
+ *             accept all CAN frames, and filtering is disabled.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see io_can_net_get_filter_func()
+ */
+int io_can_net_set_filter_func(
+		io_can_net_t *net, io_can_net_filter_func_t *func);
+
+/**
+ * Retrieves the function used to determine the traffic class of the CAN frames
+ * in the transmit queue of a CAN network interface.
+ *
+ * @param net   a pointer to a CAN network interface.
+ * @param pfunc the address at which to store a pointer to the function (can be
+ *              NULL).
+ * @param parg  the address at which to store the user-specified argument (can
+ *              be NULL).
+ *
+ * @see io_can_net_set_txclass_func()
+ */
+void io_can_net_get_txclass_func(const io_can_net_t *net,
+		io_can_net_txclass_func_t **pfunc, void **parg);
+
+/**
+ * Sets the function used to determine the traffic class of the CAN frames in
+ * the transmit queue of a CAN network interface. Frames are sent in order of
+ * their traffic class. Within a class, frames are sent in the order in which
+ * they were queued, unless identifier ordering is enabled with
+ * io_can_net_set_txprio(). The function only applies to frames queued after
+ * this call.
+ *
+ * @param net  a pointer to a CAN network interface.
+ * @param func a pointer to the function to be invoked. If <b>func</b> is NULL,
+ *             all frames are assigned to class 0.
+ * @param arg  the user-specified argument (can be NULL). <b>arg</b> is passed
+ *             as the last argument to <b>func</b>.
+ *
+ * @see io_can_net_get_txclass_func()
+ */
+void io_can_net_set_txclass_func(io_can_net_t *net,
+		io_can_net_txclass_func_t *func, void *arg);
+
+/**
+ * Returns 1 if the CAN frames in each traffic class of the transmit queue of a
+ * CAN network interface are sent in order of their identifier, and 0 if they
+ * are sent in the order in which they were queued.
+ *
+ * @see io_can_net_set_txprio()
+ */
+int io_can_net_get_txprio(const io_can_net_t *net);
+
+/**
+ * Enables or disables identifier ordering of the CAN frames in each traffic
+ * class of the transmit queue of a CAN network interface. If enabled, frames
+ * are sent in the order in which they would win arbitration on the CAN bus,
+ * i.e., lowest identifier first, base frames before extended frames with the
+ * same base identifier, and data frames before remote frames. Frames with the
+ * same identifier are always sent in the order in which they were queued.
+ * Identifier ordering is disabled by default.
+ *
+ * Note that enabling identifier ordering changes the relative order of frames
+ * with different identifiers. For example, a SYNC message overtakes any PDOs
+ * queued before it.
+ *
+ * @see io_can_net_get_txprio()
+ */
+void io_can_net_set_txprio(io_can_net_t *net, int txprio);
+
+/**
+ * Returns the maximum number of CAN frames of the specified traffic class in
+ * the transmit queue of a CAN network interface, or 0 if the class is only
+ * limited by the length of the transmit queue.
+ *
+ * @see io_can_net_set_txdepth()
+ */
+size_t io_can_net_get_txdepth(const io_can_net_t *net, int txclass);
+
+/**
+ * Sets the maximum number of CAN frames of the specified traffic class in the
+ * transmit queue of a CAN network interface. Frames that do not fit are
+ * dropped, and counted (see io_can_net_get_txdropped()). This prevents a burst
+ * of low-priority frames from occupying the entire queue.
+ *
+ * @param net     a pointer to a CAN network interface.
+ * @param txclass the traffic class, in the range [0, #IO_CAN_NET_NTXCLASS).
+ * @param depth   the maximum number of frames. If <b>depth</b> is 0, the class
+ *                is only limited by the length of the transmit queue.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see io_can_net_get_txdepth()
+ */
+int io_can_net_set_txdepth(io_can_net_t *net, int txclass, size_t depth);
+
+/**
+ * Returns the number of CAN frames of the specified traffic class dropped
+ * because the transmit queue of a CAN network interface, or the class, was
+ * full. Frames discarded after a canceled write operation are not counted.
+ */
+size_t io_can_net_get_txdropped(const io_can_net_t *net, int txclass);
+
+/**
+ * Retrieves the statistics of a CAN network interface. The statistics are
+ * updated without locking and can be sampled from any thread without taking the
+ * mutex of the CAN network interface (if the platform supports atomic
+ * operations). Consequently, the counters are not guaranteed to form a
+ * consistent snapshot.
+ *
+ * @param net   a pointer to a CAN network interface.
+ * @param stats the address at which to store the statistics.
+ *
+ * @see io_can_net_reset_stats()
+ */
+void io_can_net_get_stats(
+		const io_can_net_t *net, struct io_can_net_stats *stats);
+
+/**
+ * Resets the statistics of a CAN network interface. The transmit queue
+ * high-water mark is reset to the current number of queued frames.
+ */
+void io_can_net_reset_stats(io_can_net_t *net);
+
+/**
+ * Returns the lower bound (in microseconds) of the specified bin of a latency
+ * histogram of a CAN network interface, or 0 if <b>bin</b> is invalid.
+ *
+ * @see IO_CAN_NET_STATS_NBIN
+ */
+uint_least64_t io_can_net_stats_bin_min(int bin);
+
 /**
  * Locks the mutex protecting the CAN network interface.
  *
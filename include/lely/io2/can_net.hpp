@@ -99,6 +99,78 @@ class CanNet : protected util::BasicLockable {
     return Clock(io_can_net_get_clock(*this));
   }
 
+  /// @see io_can_net_get_filter_func()
+  io_can_net_filter_func_t*
+  get_filter_func() const noexcept {
+    return io_can_net_get_filter_func(*this);
+  }
+
+  /// @see io_can_net_set_filter_func()
+  void
+  set_filter_func(io_can_net_filter_func_t* func) {
+    if (io_can_net_set_filter_func(*this, func) == -1)
+      util::throw_errc("set_filter_func");
+  }
+
+  /// @see io_can_net_set_txclass_func()
+  void
+  set_txclass_func(io_can_net_txclass_func_t* func,
+                   void* arg = nullptr) noexcept {
+    io_can_net_set_txclass_func(*this, func, arg);
+  }
+
+  /// @see io_can_net_set_on_write_func()
+  void
+  set_on_write_func(io_can_net_on_write_func_t* func,
+                    void* arg = nullptr) noexcept {
+    io_can_net_set_on_write_func(*this, func, arg);
+  }
+
+  /// @see io_can_net_get_txprio()
+  bool
+  get_txprio() const noexcept {
+    return io_can_net_get_txprio(*this) != 0;
+  }
+
+  /// @see io_can_net_set_txprio()
+  void
+  set_txprio(bool txprio) noexcept {
+    io_can_net_set_txprio(*this, txprio);
+  }
+
+  /// @see io_can_net_get_txdepth()
+  ::std::size_t
+  get_txdepth(int txclass) const noexcept {
+    return io_can_net_get_txdepth(*this, txclass);
+  }
+
+  /// @see io_can_net_set_txdepth()
+  void
+  set_txdepth(int txclass, ::std::size_t depth) {
+    if (io_can_net_set_txdepth(*this, txclass, depth) == -1)
+      util::throw_errc("set_txdepth");
+  }
+
+  /// @see io_can_net_get_txdropped()
+  ::std::size_t
+  get_txdropped(int txclass) const noexcept {
+    return io_can_net_get_txdropped(*this, txclass);
+  }
+
+  /// @see io_can_net_get_stats()
+  io_can_net_stats
+  get_stats() const noexcept {
+    io_can_net_stats stats;
+    io_can_net_get_stats(*this, &stats);
+    return stats;
+  }
+
+  /// @see io_can_net_reset_stats()
+  void
+  reset_stats() noexcept {
+    io_can_net_reset_stats(*this);
+  }
+
  protected:
   void
   lock() final {
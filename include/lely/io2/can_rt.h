@@ -7,7 +7,13 @@
  * readers can receive the same frame. To avoid copying CAN (error) frames, all
  * operations are executed on a strand executor created by the CAN frame router.
  * The completion tasks of all matching readers are guaranteed to have finished
- * executing before the next frame is read.
+ * executing before the next frame is read. Frames without matching readers
+ * are discarded as a burst, without yielding to the executor in between.
+ *
+ * Readers for a specific identifier are looked up in constant time: a direct
+ * table is used for 11-bit identifiers and a hash table for 29-bit
+ * identifiers. Readers for a range of identifiers (see #io_can_rt_read_filter)
+ * are tested one by one.
  *
  * @copyright 2015-2019 Lely Industries N.V.
  *
@@ -30,7 +36,7 @@
 #define LELY_IO2_CAN_RT_H_
 
 #include <lely/io2/can.h>
-#include <lely/util/rbtree.h>
+#include <lely/util/dllist.h>
 
 /// A CAN frame router.
 typedef struct io_can_rt io_can_rt_t;
@@ -69,7 +75,7 @@ struct io_can_rt_read_msg {
 	struct ev_task task;
 	/// The result of the read operation.
 	struct io_can_rt_read_msg_result r;
-	struct rbnode _node;
+	struct dlnode _node;
 	struct sllist _queue;
 };
 
@@ -77,12 +83,54 @@ struct io_can_rt_read_msg {
 #define IO_CAN_RT_READ_MSG_INIT(id, flags, func) \
 	{ \
 		(id), (flags), EV_TASK_INIT(NULL, func), { NULL, 0 }, \
-				RBNODE_INIT, \
+				DLNODE_INIT, \
 		{ \
 			NULL, NULL \
 		} \
 	}
 
+/**
+ * A CAN frame read operation accepting a range of identifiers, suitable for use
+ * with a CAN frame router. A CAN frame matches if its flags are equal to
+ * #flags and its identifier, after applying #mask, lies in the closed interval
+ * [#first, #last]. To receive the CAN frames accepted by an acceptance filter
+ * with identifier `id`, set <b>first</b> and <b>last</b> to `id & mask`. To
+ * receive a range of identifiers, set <b>mask</b> to #CAN_MASK_EID.
+ *
+ * Contrary to #io_can_rt_read_msg, whose lookup takes constant time, the
+ * pending filter read operations are tested one by one for each received CAN
+ * frame.
+ */
+struct io_can_rt_read_filter {
+	/// The lowest (masked) identifier of the CAN frame to be received.
+	uint_least32_t first;
+	/// The highest (masked) identifier of the CAN frame to be received.
+	uint_least32_t last;
+	/// The acceptance mask applied to the identifier of each CAN frame.
+	uint_least32_t mask;
+	/**
+	 * The flags of the CAN frame to be received (see
+	 * io_can_rt_read_msg::flags).
+	 */
+	uint_least8_t flags;
+	/**
+	 * The task (to be) submitted upon completion (or cancellation) of the
+	 * read operation.
+	 */
+	struct ev_task task;
+	/// The result of the read operation.
+	struct io_can_rt_read_msg_result r;
+};
+
+/// The static initializer for #io_can_rt_read_filter.
+#define IO_CAN_RT_READ_FILTER_INIT(first, last, mask, flags, func) \
+	{ \
+		(first), (last), (mask), (flags), EV_TASK_INIT(NULL, func), \
+		{ \
+			NULL, 0 \
+		} \
+	}
+
 /// The result of a CAN error frame read operation.
 struct io_can_rt_read_err_result {
 	/**
@@ -205,6 +253,64 @@ size_t io_can_rt_abort_read_msg(
 ev_future_t *io_can_rt_async_read_msg(io_can_rt_t *rt, uint_least32_t id,
 		uint_least8_t flags, struct io_can_rt_read_msg **pread_msg);
 
+/**
+ * Submits a CAN frame filter read operation to a CAN frame router. Once a CAN
+ * frame matching the filter is received (or a read error occurs), the
+ * completion task is submitted for execution to the strand executor of the CAN
+ * frame router. A CAN frame completes all matching filter read operations as
+ * well as the matching io_can_rt_read_msg operations.
+ */
+void io_can_rt_submit_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter);
+
+/**
+ * Cancels the specified CAN frame filter read operation if it is pending. The
+ * completion task is submitted for execution with
+ * <b>errc</b> = #errnum2c(#ERRNUM_CANCELED).
+ *
+ * @returns 1 if the operation was canceled, and 0 if it was not pending.
+ *
+ * @see io_dev_cancel()
+ */
+size_t io_can_rt_cancel_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter);
+
+/**
+ * Aborts the specified CAN frame filter read operation if it is pending. If
+ * aborted, the completion task is _not_ submitted for execution.
+ *
+ * @returns 1 if the operation was aborted, and 0 if it was not pending.
+ *
+ * @see io_dev_abort()
+ */
+size_t io_can_rt_abort_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter);
+
+/**
+ * Submits an asynchronous CAN frame filter read operation to a CAN frame router
+ * and creates a future which becomes ready once the read operation completes
+ * (or is canceled). The result of the future has type
+ * #io_can_rt_read_msg_result.
+ *
+ * @param rt           a pointer to a CAN frame router.
+ * @param first        the lowest (masked) identifier of the CAN frame to be
+ *                     received.
+ * @param last         the highest (masked) identifier of the CAN frame to be
+ *                     received.
+ * @param mask         the acceptance mask.
+ * @param flags        the flags of the CAN frame to be received.
+ * @param pread_filter the address at which to store a pointer to the read
+ *                     operation (can be NULL).
+ *
+ * @returns a pointer to a future, or NULL on error. In the latter case, the
+ * error number can be obtained with get_errc().
+ *
+ * @see io_can_rt_read_filter
+ */
+ev_future_t *io_can_rt_async_read_filter(io_can_rt_t *rt, uint_least32_t first,
+		uint_least32_t last, uint_least32_t mask, uint_least8_t flags,
+		struct io_can_rt_read_filter **pread_filter);
+
 /**
  * Submits a CAN error frame read operation to a CAN frame router. Once a CAN
  * error frame is received (or a read error occurs), the completion task is
@@ -269,6 +375,13 @@ ev_future_t *io_can_rt_async_shutdown(io_can_rt_t *rt);
  */
 struct io_can_rt_read_msg *io_can_rt_read_msg_from_task(struct ev_task *task);
 
+/**
+ * Obtains a pointer to a CAN frame filter read operation from a pointer to its
+ * completion task.
+ */
+struct io_can_rt_read_filter *io_can_rt_read_filter_from_task(
+		struct ev_task *task);
+
 /**
  * Obtains a pointer to a CAN error frame read operation from a pointer to its
  * completion task.
@@ -283,6 +283,36 @@ class CanRouter : public Device {
     return ev::Future<const can_msg*, int>(future);
   }
 
+  /// @see io_can_rt_submit_read_filter()
+  void
+  submit_read_filter(struct io_can_rt_read_filter& read_filter) noexcept {
+    io_can_rt_submit_read_filter(*this, &read_filter);
+  }
+
+  /// @see io_can_rt_cancel_read_filter()
+  bool
+  cancel_read_filter(struct io_can_rt_read_filter& read_filter) noexcept {
+    return io_can_rt_cancel_read_filter(*this, &read_filter) != 0;
+  }
+
+  /// @see io_can_rt_abort_read_filter()
+  bool
+  abort_read_filter(struct io_can_rt_read_filter& read_filter) noexcept {
+    return io_can_rt_abort_read_filter(*this, &read_filter) != 0;
+  }
+
+  /// @see io_can_rt_async_read_filter()
+  ev::Future<const can_msg*, int>
+  async_read_filter(uint_least32_t first, uint_least32_t last,
+                    uint_least32_t mask, CanFlag flags,
+                    struct io_can_rt_read_filter** pread_filter = nullptr) {
+    auto future = io_can_rt_async_read_filter(
+        *this, first, last, mask, static_cast<uint_least8_t>(flags),
+        pread_filter);
+    if (!future) util::throw_errc("async_read_filter");
+    return ev::Future<const can_msg*, int>(future);
+  }
+
   /// @see io_can_rt_submit_read_err()
   void
   submit_read_error(struct io_can_rt_read_err& read_err) noexcept {
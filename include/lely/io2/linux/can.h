@@ -37,6 +37,8 @@
 #include <lely/io2/can.h>
 #include <lely/io2/sys/io.h>
 
+struct can_net_filter;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -204,6 +206,32 @@ int io_can_chan_is_open(const io_can_chan_t *chan);
  */
 int io_can_chan_close(io_can_chan_t *chan);
 
+/**
+ * Installs acceptance filters on the SocketCAN file descriptor associated with
+ * a CAN channel (see the CAN_RAW_FILTER socket option), so the kernel drops the
+ * CAN frames not accepted by any of the filters. CAN error frames are not
+ * affected. The filters are discarded when the channel is closed.
+ *
+ * Since the filters also apply to the frames sent by the channel itself, they
+ * cannot be used if write confirmations are enabled (see
+ * io_can_chan_create()).
+ *
+ * The signature of this function matches #io_can_net_filter_func_t, so it can
+ * be used to let a CAN network interface install the filters needed by its
+ * receivers (see io_can_net_set_filter_func()).
+ *
+ * @param chan    a pointer to a CAN channel.
+ * @param filters a pointer to an array of acceptance filters. If
+ *                <b>filters</b> is NULL, all CAN frames are accepted.
+ * @param n       the number of filters in <b>filters</b>. If <b>n</b> is 0 and
+ *                <b>filters</b> is not NULL, all CAN frames are dropped.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int io_can_chan_set_filter(io_can_chan_t *chan,
+		const struct can_net_filter *filters, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
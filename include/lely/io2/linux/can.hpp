@@ -193,6 +193,27 @@ class CanChannel : public CanChannelBase {
     close(ec);
     if (ec) throw ::std::system_error(ec, "close");
   }
+
+  /// @see io_can_chan_set_filter()
+  void
+  set_filter(const can_net_filter* filters, ::std::size_t n,
+             ::std::error_code& ec) noexcept {
+    int errsv = get_errc();
+    set_errc(0);
+    if (!io_can_chan_set_filter(*this, filters, n))
+      ec.clear();
+    else
+      ec = util::make_error_code();
+    set_errc(errsv);
+  }
+
+  /// @see io_can_chan_set_filter()
+  void
+  set_filter(const can_net_filter* filters, ::std::size_t n) {
+    ::std::error_code ec;
+    set_filter(filters, n, ec);
+    if (ec) throw ::std::system_error(ec, "set_filter");
+  }
 };
 
 }  // namespace io
@@ -5,10 +5,12 @@
  * A virtual CAN bus makes it possible to write platform-independent tests for
  * CAN applications and to create controlled error conditions. It consists of a
  * virtual CAN controller with which one or more virtual CAN channels are
- * registered. When a virtual channel sends a message, it is placed into the
- * receive queue of all other channels. Each channel only as a receive queue.
- * Send operations succeed if every (other) channel has a slot available in
- * their receive queue; otherwise they block or time out.
+ * registered. When a virtual channel sends a message, it is placed, once, into
+ * the shared receive queue of the controller, from which every other channel
+ * reads it at its own pace. Like on a real CAN bus, send operations do not wait
+ * for slow readers. If a channel falls too far behind (see
+ * io_vcan_chan_create()), its oldest unread frames are dropped (see
+ * io_vcan_chan_get_ndropped()).
  *
  * @copyright 2019 Lely Industries N.V.
  *
@@ -33,6 +35,51 @@
 #include <lely/io2/can.h>
 #include <lely/io2/clock.h>
 
+/// The statistics of the bus timing simulation of a virtual CAN controller.
+struct io_vcan_sim_stats {
+	/// The number of CAN frames transmitted on the bus.
+	size_t nframes;
+	/**
+	 * The number of times a CAN frame was dropped for a channel because it
+	 * fell too far behind.
+	 */
+	size_t ndropped;
+	/// The number of CAN frames waiting to be transmitted.
+	size_t npending;
+	/// The time (in nanoseconds) the bus was busy transmitting CAN frames.
+	uint_least64_t busy_nsec;
+	/**
+	 * The time (in nanoseconds) elapsed between the start of the simulation
+	 * and the last time it was updated. The bus load equals
+	 * #busy_nsec / #elapsed_nsec.
+	 */
+	uint_least64_t elapsed_nsec;
+	/**
+	 * The maximum time (in nanoseconds) a CAN frame was queued before its
+	 * transmission started.
+	 */
+	uint_least64_t max_delay_nsec;
+};
+
+/**
+ * The statistics of the bus timing simulation of a virtual CAN controller for a
+ * single CAN-ID.
+ */
+struct io_vcan_sim_id_stats {
+	/// The number of CAN frames with this CAN-ID transmitted on the bus.
+	size_t nframes;
+	/**
+	 * The total time (in nanoseconds) CAN frames with this CAN-ID were
+	 * queued before their transmission started.
+	 */
+	uint_least64_t delay_nsec;
+	/**
+	 * The maximum time (in nanoseconds) a CAN frame with this CAN-ID was
+	 * queued before its transmission started.
+	 */
+	uint_least64_t max_delay_nsec;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -130,6 +177,83 @@ int io_vcan_ctrl_write_msg(
 int io_vcan_ctrl_write_err(
 		io_can_ctrl_t *ctrl, const struct can_err *err, int timeout);
 
+/**
+ * Enables the bus timing simulation of a virtual CAN controller. In this mode,
+ * CAN frames are not delivered instantly. Instead, each frame occupies the bus
+ * for a duration determined by the bitrate, the length of the frame and bit
+ * stuffing. Frames written while the bus is busy are queued, and, once the bus
+ * becomes idle, the frame with the highest priority (lowest CAN-ID) wins
+ * arbitration. Frames are delivered to the registered channels by
+ * io_vcan_ctrl_sim_flush() (which is also invoked on every write), with the
+ * time at which their transmission completed as timestamp, according to the
+ * clock of the controller. If a channel falls too far behind, its oldest unread
+ * frame is dropped. Error frames are not affected by the simulation.
+ *
+ * The controller does not have a timer of its own. A frame is only delivered
+ * once io_vcan_ctrl_sim_flush() is invoked at or after the end of its
+ * transmission, so a frame written to an otherwise idle bus is NOT delivered
+ * until the next write or flush. The user MUST drive the simulation, either
+ * by registering the controller with a virtual clock (see
+ * io_vclock_insert_ctrl()), which does so automatically, or by invoking
+ * io_vcan_ctrl_sim_flush() from a timer at the time it reports.
+ *
+ * If the simulation is already enabled, the statistics are reset.
+ *
+ * @param ctrl  a pointer to a virtual CAN controller.
+ * @param txlen the maximum number of frames that can be queued for
+ *              transmission. If <b>txlen</b> is 0, the default value
+ *              #LELY_IO_VCAN_TXLEN is used.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see io_vcan_ctrl_disable_sim()
+ */
+int io_vcan_ctrl_enable_sim(io_can_ctrl_t *ctrl, size_t txlen);
+
+/**
+ * Disables the bus timing simulation of a virtual CAN controller. Any queued
+ * frames are delivered immediately, in order of arbitration.
+ *
+ * @see io_vcan_ctrl_enable_sim()
+ */
+void io_vcan_ctrl_disable_sim(io_can_ctrl_t *ctrl);
+
+/**
+ * Advances the bus timing simulation of a virtual CAN controller to the current
+ * time of its clock and delivers all CAN frames whose transmission has
+ * completed. This function MUST be invoked (e.g., from a timer) at or after
+ * the time stored in *<b>next</b>, since no frame is delivered otherwise (see
+ * io_vcan_ctrl_enable_sim()).
+ *
+ * @param ctrl a pointer to a virtual CAN controller.
+ * @param next the address at which to store the time at which the transmission
+ *             of the next queued frame completes (can be NULL). This value is
+ *             only set if the function returns 1.
+ *
+ * @returns 1 if frames are still queued for transmission, 0 if not, or -1 on
+ * error. In the latter case, the error number can be obtained with get_errc().
+ */
+int io_vcan_ctrl_sim_flush(io_can_ctrl_t *ctrl, struct timespec *next);
+
+/**
+ * Stores the statistics of the bus timing simulation of a virtual CAN
+ * controller in *<b>stats</b>. If the simulation was never enabled, all
+ * statistics are 0.
+ */
+void io_vcan_ctrl_get_sim_stats(
+		const io_can_ctrl_t *ctrl, struct io_vcan_sim_stats *stats);
+
+/**
+ * Stores the statistics of the bus timing simulation of a virtual CAN
+ * controller for frames with the specified 11-bit CAN-ID in *<b>stats</b>.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int io_vcan_ctrl_get_sim_id_stats(const io_can_ctrl_t *ctrl, uint_least32_t id,
+		struct io_vcan_sim_id_stats *stats);
+
 void *io_vcan_chan_alloc(void);
 void io_vcan_chan_free(void *ptr);
 io_can_chan_t *io_vcan_chan_init(io_can_chan_t *chan, io_ctx_t *ctx,
@@ -142,9 +266,10 @@ void io_vcan_chan_fini(io_can_chan_t *chan);
  * @param ctx   a pointer to the I/O context with which the channel should be
  *              registered.
  * @param exec  a pointer to the executor used to execute asynchronous tasks.
- * @param rxlen the receive queue length (in number of frames) of the channel.
- *              If <b>rxlen</b> is 0, the default value #LELY_IO_VCAN_RXLEN is
- *              used.
+ * @param rxlen the maximum number of unread frames of the channel. If the
+ *              channel falls further behind, the oldest unread frame is
+ *              dropped. If <b>rxlen</b> is 0, the default value
+ *              #LELY_IO_VCAN_RXLEN is used.
  *
  * @returns a pointer to a new CAN channel, or NULL on error. In the latter
  * case, the error number can be obtained with get_errc().
@@ -161,6 +286,13 @@ void io_vcan_chan_destroy(io_can_chan_t *chan);
  */
 io_can_ctrl_t *io_vcan_chan_get_ctrl(const io_can_chan_t *chan);
 
+/**
+ * Returns the number of CAN frames dropped by a virtual CAN channel because it
+ * fell too far behind the other channels registered with the virtual CAN
+ * controller.
+ */
+size_t io_vcan_chan_get_ndropped(const io_can_chan_t *chan);
+
 /**
  * Opens a virtual CAN channel by registering it with the specified virtual CAN
  * controller. If the channel was already open, it is first closed as if by
@@ -110,6 +110,44 @@ class VirtualCanController : public CanControllerBase {
     write(err, timeout, ec);
     if (ec) throw ::std::system_error(ec, "write");
   }
+
+  /// @see io_vcan_ctrl_enable_sim()
+  void
+  enable_sim(::std::size_t txlen = 0) {
+    if (io_vcan_ctrl_enable_sim(*this, txlen) == -1)
+      util::throw_errc("enable_sim");
+  }
+
+  /// @see io_vcan_ctrl_disable_sim()
+  void
+  disable_sim() noexcept {
+    io_vcan_ctrl_disable_sim(*this);
+  }
+
+  /// @see io_vcan_ctrl_sim_flush()
+  bool
+  sim_flush(timespec* next = nullptr) {
+    int result = io_vcan_ctrl_sim_flush(*this, next);
+    if (result == -1) util::throw_errc("sim_flush");
+    return result != 0;
+  }
+
+  /// @see io_vcan_ctrl_get_sim_stats()
+  io_vcan_sim_stats
+  get_sim_stats() const noexcept {
+    io_vcan_sim_stats stats;
+    io_vcan_ctrl_get_sim_stats(*this, &stats);
+    return stats;
+  }
+
+  /// @see io_vcan_ctrl_get_sim_id_stats()
+  io_vcan_sim_id_stats
+  get_sim_id_stats(uint_least32_t id) const {
+    io_vcan_sim_id_stats stats;
+    if (io_vcan_ctrl_get_sim_id_stats(*this, id, &stats) == -1)
+      util::throw_errc("get_sim_id_stats");
+    return stats;
+  }
 };
 
 /// A virtual CAN channel.
@@ -148,6 +186,12 @@ class VirtualCanChannel : public CanChannelBase {
     return CanControllerBase(io_vcan_chan_get_ctrl(*this));
   }
 
+  /// @see io_vcan_chan_get_ndropped()
+  ::std::size_t
+  get_ndropped() const noexcept {
+    return io_vcan_chan_get_ndropped(*this);
+  }
+
   /// @see io_vcan_chan_open()
   void
   open(const io_can_ctrl_t* ctrl) noexcept {
@@ -0,0 +1,168 @@
+/**@file
+ * This header file is part of the I/O library; it contains the virtual clock
+ * declarations.
+ *
+ * The virtual clock provides a discrete-event time base for simulations. It
+ * does not follow any system clock. Instead, it keeps track of the expiration
+ * times of the timers created with io_vclock_create_timer() and the
+ * transmission times of the virtual CAN controllers registered with
+ * io_vclock_insert_ctrl(), and jumps straight to the earliest of those when
+ * io_vclock_advance() is invoked. io_vclock_run() combines this with running
+ * a set of event loops until they are idle, so a simulation runs as fast as the
+ * tasks can be executed, independent of the simulated duration, and with a
+ * deterministic order of events.
+ *
+ * Timers and virtual CAN controllers MUST be registered and unregistered from
+ * the thread advancing the clock.
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_IO2_VCLOCK_H_
+#define LELY_IO2_VCLOCK_H_
+
+#include <lely/ev/loop.h>
+#include <lely/io2/can.h>
+#include <lely/io2/clock.h>
+#include <lely/io2/timer.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *io_vclock_alloc(void);
+void io_vclock_free(void *ptr);
+io_clock_t *io_vclock_init(io_clock_t *clock, const struct timespec *start);
+void io_vclock_fini(io_clock_t *clock);
+
+/**
+ * Creates a new virtual clock. The time of the clock can be changed explicitly
+ * with io_clock_settime(), which updates all registered timers and virtual CAN
+ * controllers.
+ *
+ * @param start a pointer to the initial time of the clock. If <b>start</b> is
+ *              NULL, the clock starts at 0.
+ *
+ * @returns a pointer to a new clock, or NULL on error. In the latter case, the
+ * error number can be obtained with get_errc().
+ */
+io_clock_t *io_vclock_create(const struct timespec *start);
+
+/**
+ * Destroys a virtual clock. All timers created with io_vclock_create_timer()
+ * MUST have been destroyed and all virtual CAN controllers MUST have been
+ * unregistered.
+ *
+ * @see io_vclock_create()
+ */
+void io_vclock_destroy(io_clock_t *clock);
+
+/**
+ * Creates a new timer driven by a virtual clock. The timer is a user-defined
+ * timer (see io_user_timer_create()) whose time is updated by the virtual
+ * clock.
+ *
+ * @param clock a pointer to a virtual clock.
+ * @param ctx   a pointer to the I/O context with which the timer should be
+ *              registered.
+ * @param exec  a pointer to the executor used to execute asynchronous tasks.
+ *
+ * @returns a pointer to a new timer, or NULL on error. In the latter case, the
+ * error number can be obtained with get_errc().
+ */
+io_timer_t *io_vclock_create_timer(
+		io_clock_t *clock, io_ctx_t *ctx, ev_exec_t *exec);
+
+/**
+ * Destroys a timer created by io_vclock_create_timer().
+ *
+ * @see io_vclock_create_timer()
+ */
+void io_vclock_destroy_timer(io_clock_t *clock, io_timer_t *timer);
+
+/**
+ * Registers a virtual CAN controller with a virtual clock. The controller MUST
+ * have been created with <b>clock</b> as its clock. If the bus timing
+ * simulation of the controller is enabled (see io_vcan_ctrl_enable_sim()), the
+ * clock advances to the end of the transmission of each frame.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+int io_vclock_insert_ctrl(io_clock_t *clock, io_can_ctrl_t *ctrl);
+
+/**
+ * Unregisters a virtual CAN controller from a virtual clock.
+ *
+ * @see io_vclock_insert_ctrl()
+ */
+void io_vclock_remove_ctrl(io_clock_t *clock, io_can_ctrl_t *ctrl);
+
+/**
+ * Obtains the next time at which a timer expires or a frame completes its
+ * transmission on a registered virtual CAN bus.
+ *
+ * @param clock a pointer to a virtual clock.
+ * @param next  the address at which to store the next time. This value is only
+ *              set if the function returns 1.
+ *
+ * @returns 1 if a timer is armed or a frame is being transmitted, 0 if not, or
+ * -1 on error. In the latter case, the error number can be obtained with
+ * get_errc().
+ */
+int io_vclock_get_next(io_clock_t *clock, struct timespec *next);
+
+/**
+ * Advances a virtual clock to the next time obtained with io_vclock_get_next().
+ * This triggers the expiration of the timers and the delivery of CAN frames due
+ * at that time.
+ *
+ * @param clock a pointer to a virtual clock.
+ * @param end   a pointer to the time beyond which the clock MUST NOT advance
+ *              (can be NULL). If the next time lies beyond *<b>end</b>, the
+ *              clock is set to *<b>end</b> instead.
+ *
+ * @returns 1 if the clock advanced to the next time, 0 if no time was pending
+ * or it lies beyond *<b>end</b>, or -1 on error. In the latter case, the error
+ * number can be obtained with get_errc().
+ */
+int io_vclock_advance(io_clock_t *clock, const struct timespec *end);
+
+/**
+ * Runs a discrete-event simulation. This function repeatedly polls the
+ * specified event loops (see ev_loop_poll()) until none of them executes a
+ * task, and then advances the virtual clock as if by io_vclock_advance(), until
+ * no time is pending or the clock reaches *<b>end</b>. Each loop is restarted
+ * with ev_loop_restart() before it is polled.
+ *
+ * @param clock  a pointer to a virtual clock.
+ * @param loops  an array of pointers to event loops.
+ * @param nloops the number of event loops in <b>loops</b>.
+ * @param end    a pointer to the time at which the simulation ends (can be
+ *               NULL).
+ *
+ * @returns the number of tasks executed, or `(size_t)-1` on error. In the
+ * latter case, the error number can be obtained with get_errc().
+ */
+size_t io_vclock_run(io_clock_t *clock, ev_loop_t *const *loops, size_t nloops,
+		const struct timespec *end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !LELY_IO2_VCLOCK_H_
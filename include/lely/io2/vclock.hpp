@@ -0,0 +1,121 @@
+/**@file
+ * This header file is part of the I/O library; it contains the C++ interface
+ * for the virtual clock.
+ *
+ * @see lely/io2/vclock.h
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LELY_IO2_VCLOCK_HPP_
+#define LELY_IO2_VCLOCK_HPP_
+
+#include <lely/io2/clock.hpp>
+#include <lely/io2/timer.hpp>
+#include <lely/io2/vclock.h>
+
+#include <utility>
+
+namespace lely {
+namespace io {
+
+/// A virtual clock.
+class VirtualClock : public Clock {
+ public:
+  /// @see io_vclock_create()
+  explicit VirtualClock(const timespec* start = nullptr)
+      : Clock(io_vclock_create(start)) {
+    if (!static_cast<io_clock_t*>(*this)) util::throw_errc("VirtualClock");
+  }
+
+  VirtualClock(const VirtualClock&) = delete;
+  VirtualClock& operator=(const VirtualClock&) = delete;
+
+  /// @see io_vclock_destroy()
+  ~VirtualClock() { io_vclock_destroy(*this); }
+
+  /// @see io_vclock_insert_ctrl()
+  void
+  insert(io_can_ctrl_t* ctrl) {
+    if (io_vclock_insert_ctrl(*this, ctrl) == -1) util::throw_errc("insert");
+  }
+
+  /// @see io_vclock_remove_ctrl()
+  void
+  remove(io_can_ctrl_t* ctrl) noexcept {
+    io_vclock_remove_ctrl(*this, ctrl);
+  }
+
+  /// @see io_vclock_advance()
+  bool
+  advance(const timespec* end = nullptr) {
+    int result = io_vclock_advance(*this, end);
+    if (result == -1) util::throw_errc("advance");
+    return result != 0;
+  }
+
+  /// @see io_vclock_run()
+  ::std::size_t
+  run(ev_loop_t* const* loops, ::std::size_t nloops,
+      const timespec* end = nullptr) {
+    ::std::size_t n = io_vclock_run(*this, loops, nloops, end);
+    if (n == static_cast<::std::size_t>(-1)) util::throw_errc("run");
+    return n;
+  }
+};
+
+/// A timer driven by a virtual clock.
+class VirtualTimer : public TimerBase {
+ public:
+  /// @see io_vclock_create_timer()
+  VirtualTimer(io_clock_t* clock, io_ctx_t* ctx, ev_exec_t* exec)
+      : TimerBase(io_vclock_create_timer(clock, ctx, exec)), clock_(clock) {
+    if (!timer) util::throw_errc("VirtualTimer");
+  }
+
+  VirtualTimer(const VirtualTimer&) = delete;
+
+  VirtualTimer(VirtualTimer&& other) noexcept
+      : TimerBase(other.timer), clock_(other.clock_) {
+    other.timer = nullptr;
+    other.dev = nullptr;
+  }
+
+  VirtualTimer& operator=(const VirtualTimer&) = delete;
+
+  VirtualTimer&
+  operator=(VirtualTimer&& other) noexcept {
+    using ::std::swap;
+    swap(timer, other.timer);
+    swap(dev, other.dev);
+    swap(clock_, other.clock_);
+    return *this;
+  }
+
+  /// @see io_vclock_destroy_timer()
+  ~VirtualTimer() {
+    if (timer) io_vclock_destroy_timer(clock_, *this);
+  }
+
+ private:
+  io_clock_t* clock_{nullptr};
+};
+
+}  // namespace io
+}  // namespace lely
+
+#endif  // !LELY_IO2_VCLOCK_HPP_
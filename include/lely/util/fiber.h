@@ -84,6 +84,49 @@ typedef struct fiber fiber_t;
  */
 #define FIBER_GUARD_STACK 0x8
 
+/**
+ * A flag specifying the fiber stack pool to request huge pages (on Linux,
+ * transparent huge pages) for guarded fiber stacks. The end of each stack is
+ * aligned to the huge page size (typically 2 MiB), so the pages used first can
+ * be backed by a huge page. Stacks smaller than a huge page always use normal
+ * pages.
+ *
+ * @see fiber_stack_pool_init()
+ */
+#define FIBER_STACK_HUGE_PAGES 0x1
+
+/**
+ * A flag specifying the fiber stack pool to commit memory for guarded fiber
+ * stacks lazily. Stacks are mapped without reserving swap space, and the pages
+ * of stacks returned to the pool are released to the operating system, so they
+ * are only committed again once they are used.
+ *
+ * @see fiber_stack_pool_init()
+ */
+#define FIBER_STACK_LAZY 0x2
+
+/// The statistics of the fiber stack allocator. @see fiber_stack_get_stats()
+struct fiber_stack_stats {
+	/// The total number of fibers created by fiber_create().
+	size_t ncreated;
+	/// The number of fibers created with a stack taken from the pool.
+	size_t nreused;
+	/// The number of guarded stacks currently mapped, including unused ones.
+	size_t nstacks;
+	/// The number of unused guarded stacks in the pool.
+	size_t nunused;
+	/// The peak number of guarded stacks mapped at the same time.
+	size_t peak_nstacks;
+	/**
+	 * The largest number of bytes of a guarded stack observed to be in use
+	 * when the fiber was destroyed, excluding the guard pages and the first
+	 * page of the stack. The usage is measured with page granularity (or
+	 * huge page granularity, if the stack is backed by huge pages), and
+	 * only on platforms supporting `mincore()`.
+	 */
+	size_t peak_usage;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -192,6 +235,36 @@ fiber_t *fiber_resume(fiber_t *fiber);
  */
 fiber_t *fiber_resume_with(fiber_t *fiber, fiber_func_t *func, void *arg);
 
+/**
+ * Configures the process-wide pool of guarded fiber stacks (see
+ * #FIBER_GUARD_STACK). When a fiber is destroyed, its stack is kept in the pool,
+ * instead of being unmapped, as long as the pool contains fewer than
+ * <b>max_unused</b> stacks. fiber_create() takes a stack of the requested size
+ * from the pool, if available, before mapping a new one. The pool is disabled
+ * by default. This function can be called by any thread at any time; it only
+ * affects stacks mapped or released afterwards.
+ *
+ * @param max_unused the maximum number of unused stacks kept in the pool. If 0,
+ *                   the pool is disabled and all unused stacks are unmapped.
+ * @param flags      any supported combination of #FIBER_STACK_HUGE_PAGES and
+ *                   #FIBER_STACK_LAZY.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ *
+ * @see fiber_stack_pool_fini()
+ */
+int fiber_stack_pool_init(size_t max_unused, int flags);
+
+/// Disables the fiber stack pool and unmaps all unused stacks.
+void fiber_stack_pool_fini(void);
+
+/**
+ * Stores the statistics of the (process-wide) fiber stack allocator at
+ * <b>stats</b>.
+ */
+void fiber_stack_get_stats(struct fiber_stack_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
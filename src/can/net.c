@@ -32,6 +32,26 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifndef LELY_CAN_NET_NFILTER
+/**
+ * The maximum number of acceptance filters generated by a CAN network
+ * interface. This value MUST be at least 5.
+ */
+#define LELY_CAN_NET_NFILTER 64
+#endif
+
+#ifndef LELY_CAN_NET_FILTER_HYST
+/**
+ * The number of times the last receiver for a CAN identifier has to be stopped
+ * before the acceptance filters of a CAN network interface are narrowed.
+ */
+#define LELY_CAN_NET_FILTER_HYST 8
+#endif
+
+/// The flags taken into account by the acceptance filters.
+#define CAN_NET_FILTER_FLAGS (CAN_FLAG_IDE | CAN_FLAG_RTR)
 
 /// A CAN network interface.
 struct __can_net {
@@ -51,6 +71,26 @@ struct __can_net {
 	can_send_func_t *send_func;
 	/// A pointer to the user-specified data for #send_func.
 	void *send_data;
+	/// A pointer to the callback function invoked when the filters change.
+	can_filter_func_t *filter_func;
+	/// A pointer to the user-specified data for #filter_func.
+	void *filter_data;
+	/// The acceptance filters passed to #filter_func.
+	struct can_net_filter filters[LELY_CAN_NET_NFILTER];
+	/// The number of filters in #filters.
+	size_t nfilter;
+	/**
+	 * The number of identifiers accepted by #filters for which no receiver
+	 * is active anymore.
+	 */
+	size_t nstale;
+	/// The receiver keys of the stale identifiers.
+	uint_least64_t stale[LELY_CAN_NET_FILTER_HYST];
+	/**
+	 * A flag indicating whether the last invocation of #filter_func
+	 * failed.
+	 */
+	int filter_error;
 };
 
 /**
@@ -59,6 +99,44 @@ struct __can_net {
  */
 static void can_net_set_next(can_net_t *net);
 
+/**
+ * Returns 1 if a CAN frame with the specified identifier and flags is accepted
+ * by the current filters of a CAN network interface, and 0 if not.
+ */
+static int can_net_filter_match(
+		const can_net_t *net, uint_least32_t id, uint_least8_t flags);
+
+/**
+ * Recomputes the acceptance filters of a CAN network interface and invokes the
+ * filter callback function.
+ *
+ * @param net   a pointer to a CAN network interface.
+ * @param force a flag indicating whether the callback function should be
+ *              invoked even if the filters did not change.
+ *
+ * @returns the result of the callback function, or 0 if it was not invoked.
+ */
+static int can_net_update_filter(can_net_t *net, int force);
+
+/**
+ * Returns 1 if a CAN frame with the specified identifier and flags is accepted
+ * by an acceptance filter, and 0 if not.
+ */
+static inline int can_net_filter_accept(const struct can_net_filter *filter,
+		uint_least32_t id, uint_least8_t flags);
+
+/**
+ * Merges the pair of adjacent acceptance filters whose combination accepts the
+ * fewest additional identifiers.
+ *
+ * @param filters an array of filters.
+ * @param n       the number of filters in <b>filters</b> (MUST be at least 5).
+ *
+ * @returns the index of the merged filter. The number of filters is reduced by
+ * one.
+ */
+static size_t can_net_filter_merge(struct can_net_filter *filters, size_t n);
+
 /// A CAN timer.
 struct __can_timer {
 	/// The node of this timer in the tree of timers.
@@ -139,6 +217,12 @@ __can_net_init(struct __can_net *net)
 	net->send_func = NULL;
 	net->send_data = NULL;
 
+	net->filter_func = NULL;
+	net->filter_data = NULL;
+	net->nfilter = 0;
+	net->nstale = 0;
+	net->filter_error = 0;
+
 	return net;
 }
 
@@ -340,6 +424,29 @@ can_net_set_send_func(can_net_t *net, can_send_func_t *func, void *data)
 	net->send_data = data;
 }
 
+void
+can_net_get_filter_func(
+		const can_net_t *net, can_filter_func_t **pfunc, void **pdata)
+{
+	assert(net);
+
+	if (pfunc)
+		*pfunc = net->filter_func;
+	if (pdata)
+		*pdata = net->filter_data;
+}
+
+int
+can_net_set_filter_func(can_net_t *net, can_filter_func_t *func, void *data)
+{
+	assert(net);
+
+	net->filter_func = func;
+	net->filter_data = data;
+
+	return func ? can_net_update_filter(net, 1) : 0;
+}
+
 void *
 __can_timer_alloc(void)
 {
@@ -611,6 +718,22 @@ can_recv_start(can_recv_t *recv, can_net_t *net, uint_least32_t id,
 	} else {
 		rbtree_insert(&recv->net->recv_tree, &recv->node);
 		dlnode_init(&recv->list);
+		// Widen the acceptance filters if they do not accept the new
+		// identifier. Otherwise, the identifier may have been one of
+		// the stale ones, which is restarted before the filters are
+		// narrowed.
+		if (net->filter_func
+				&& (net->filter_error
+						|| !can_net_filter_match(net,
+								id, flags))) {
+			can_net_update_filter(net, 0);
+		} else {
+			size_t i = 0;
+			while (i < net->nstale && net->stale[i] != recv->key)
+				i++;
+			if (i < net->nstale)
+				net->stale[i] = net->stale[--net->nstale];
+		}
 	}
 }
 
@@ -625,8 +748,10 @@ can_recv_stop(can_recv_t *recv)
 	struct dlnode *prev = recv->list.prev;
 	struct dlnode *next = recv->list.next;
 
+	can_net_t *net = recv->net;
+
 	if (!prev)
-		rbtree_remove(&recv->net->recv_tree, &recv->node);
+		rbtree_remove(&net->recv_tree, &recv->node);
 	dlnode_remove(&recv->list);
 	dlnode_init(&recv->list);
 
@@ -635,6 +760,14 @@ can_recv_stop(can_recv_t *recv)
 	if (!prev && next) {
 		recv = structof(next, can_recv_t, list);
 		rbtree_insert(&recv->net->recv_tree, &recv->node);
+	} else if (!prev && net->filter_func) {
+		// Only narrow the acceptance filters once enough identifiers
+		// have become stale, to prevent an update every time a
+		// receiver is restarted.
+		assert(net->nstale < LELY_CAN_NET_FILTER_HYST);
+		net->stale[net->nstale] = recv->key;
+		if (++net->nstale >= LELY_CAN_NET_FILTER_HYST)
+			can_net_update_filter(net, 0);
 	}
 }
 
@@ -653,6 +786,133 @@ can_net_set_next(can_net_t *net)
 		net->next_func(&net->next, net->next_data);
 }
 
+static int
+can_net_filter_match(
+		const can_net_t *net, uint_least32_t id, uint_least8_t flags)
+{
+	assert(net);
+
+	for (size_t i = 0; i < net->nfilter; i++) {
+		if (can_net_filter_accept(&net->filters[i], id, flags))
+			return 1;
+	}
+	return 0;
+}
+
+static int
+can_net_update_filter(can_net_t *net, int force)
+{
+	assert(net);
+	assert(net->filter_func);
+
+	struct can_net_filter filters[LELY_CAN_NET_NFILTER];
+	size_t n = 0;
+
+	// The receiver keys are sorted by flags first, and then by identifier.
+	// The filters are kept in the same order, so nearby identifiers end up
+	// in adjacent filters.
+	rbtree_foreach (&net->recv_tree, node) {
+		const can_recv_t *recv = structof(node, can_recv_t, node);
+		uint_least32_t id = recv->key & CAN_MASK_EID;
+		uint_least8_t flags = (recv->key >> 32) & CAN_NET_FILTER_FLAGS;
+
+		size_t i = 0;
+		while (i < n && !can_net_filter_accept(&filters[i], id, flags))
+			i++;
+		if (i < n)
+			continue;
+
+		if (n == LELY_CAN_NET_NFILTER) {
+			i = can_net_filter_merge(filters, n--);
+			if (can_net_filter_accept(&filters[i], id, flags))
+				continue;
+		}
+
+		// Insert the new filter in order.
+		uint_least64_t key = can_recv_key(id, flags);
+		for (i = n; i > 0; i--) {
+			const struct can_net_filter *prev = &filters[i - 1];
+			if (can_recv_key(prev->id, prev->flags) < key)
+				break;
+		}
+		memmove(filters + i + 1, filters + i,
+				(n - i) * sizeof(*filters));
+		uint_least32_t mask = (flags & CAN_FLAG_IDE) ? CAN_MASK_EID
+							     : CAN_MASK_BID;
+		filters[i] = (struct can_net_filter){ id, mask, flags };
+		n++;
+	}
+	net->nstale = 0;
+
+	// Do not reinstall the filters if the identifiers that became stale
+	// have been restarted in the meantime.
+	int equal = !force && !net->filter_error && n == net->nfilter;
+	for (size_t i = 0; equal && i < n; i++) {
+		const struct can_net_filter *f1 = &filters[i];
+		const struct can_net_filter *f2 = &net->filters[i];
+		equal = f1->id == f2->id && f1->mask == f2->mask
+				&& f1->flags == f2->flags;
+	}
+	if (equal)
+		return 0;
+
+	memcpy(net->filters, filters, n * sizeof(*filters));
+	net->nfilter = n;
+
+	int result = net->filter_func(filters, n, net->filter_data);
+	net->filter_error = result == -1;
+	return result;
+}
+
+static inline int
+can_net_filter_accept(const struct can_net_filter *filter, uint_least32_t id,
+		uint_least8_t flags)
+{
+	assert(filter);
+
+	return filter->flags == (flags & CAN_NET_FILTER_FLAGS)
+			&& !((id ^ filter->id) & filter->mask);
+}
+
+static size_t
+can_net_filter_merge(struct can_net_filter *filters, size_t n)
+{
+	assert(filters);
+	// There are at most four distinct combinations of flags, so with five
+	// filters at least one adjacent pair has the same flags.
+	assert(n > 4);
+
+	// Find the pair of adjacent filters with the same flags whose combined
+	// filter accepts the fewest additional identifiers.
+	size_t best = n;
+	int best_cost = 0;
+	for (size_t i = 0; i + 1 < n; i++) {
+		const struct can_net_filter *f1 = &filters[i];
+		const struct can_net_filter *f2 = &filters[i + 1];
+		if (f1->flags != f2->flags)
+			continue;
+		uint_least32_t mask = f1->mask & f2->mask & ~(f1->id ^ f2->id);
+		uint_least32_t full = (f1->flags & CAN_FLAG_IDE) ? CAN_MASK_EID
+								: CAN_MASK_BID;
+		// Count the number of identifier bits that are ignored.
+		int cost = 0;
+		for (uint_least32_t bits = full & ~mask; bits; bits &= bits - 1)
+			cost++;
+		if (best == n || cost < best_cost) {
+			best = i;
+			best_cost = cost;
+		}
+	}
+	assert(best < n - 1);
+
+	struct can_net_filter *filter = &filters[best];
+	filter->mask &= filter[1].mask & ~(filter->id ^ filter[1].id);
+	filter->id &= filter->mask;
+	memmove(filter + 1, filter + 2, (n - best - 2) * sizeof(*filters));
+
+	return best;
+}
+
 static inline uint_least64_t
 can_recv_key(uint_least32_t id, uint_least8_t flags)
 {
@@ -43,6 +43,9 @@
 // Disable ASCII gateway support.
 #undef LELY_NO_CO_GW_TXT
 #define LELY_NO_CO_GW_TXT 1
+// Disable binary gateway support.
+#undef LELY_NO_CO_GW_BIN
+#define LELY_NO_CO_GW_BIN 1
 #endif // LELY_NO_MALLOC
 
 #if LELY_NO_STDIO
@@ -33,13 +33,14 @@
 #include <lely/co/val.h>
 #include <lely/util/diag.h>
 #include <lely/util/endian.h>
+#if !LELY_NO_MALLOC
+#include <lely/util/spscring.h>
+#endif
 #include <lely/util/time.h>
 
 #include <assert.h>
 #include <stdlib.h>
-#if LELY_NO_MALLOC
 #include <string.h>
-#endif
 
 #if LELY_NO_MALLOC
 #ifndef CO_EMCY_CAN_BUF_SIZE
@@ -66,12 +67,28 @@ struct co_emcy_msg {
 	co_unsigned8_t er;
 };
 
+#if !LELY_NO_MALLOC
+/// The log of EMCY messages received from a remote node.
+struct co_emcy_log {
+	/// The ring buffer used to control #recs.
+	struct spscring ring;
+	/// The number of messages discarded since the last one was logged.
+	co_unsigned32_t nlost;
+	/// An array of received EMCY messages.
+	struct co_emcy_rec *recs;
+};
+#endif
+
 /// A remote CANopen EMCY producer node.
 struct co_emcy_node {
 	/// The node-ID.
 	co_unsigned8_t id;
 	/// A pointer to the CAN frame receiver.
 	can_recv_t *recv;
+#if !LELY_NO_MALLOC
+	/// A pointer to the log of received EMCY messages (can be NULL).
+	struct co_emcy_log *log;
+#endif
 };
 
 /**
@@ -95,12 +112,26 @@ struct __co_emcy {
 	co_obj_t *obj_1003;
 	/// The number of messages in #msgs.
 	size_t nmsg;
-	/// An array of EMCY messages. The first element is the most recent.
+	/// The index in #msgs of the most recent message.
+	size_t first;
+	/// The maximum number of messages, or 0 if unlimited.
+	size_t depth;
+	/**
+	 * A ring buffer of EMCY messages. The messages are stored from the most
+	 * recent to the oldest, starting at #first.
+	 */
 #if LELY_NO_MALLOC
 	struct co_emcy_msg msgs[CO_EMCY_MAX_NMSG];
 #else
 	struct co_emcy_msg *msgs;
+	/// The number of elements allocated for #msgs.
+	size_t maxmsg;
 #endif
+	/**
+	 * A flag specifying whether repeated EMCY messages are coalesced during
+	 * the inhibit time.
+	 */
+	int coalesce;
 	/// The CAN frame buffer.
 	struct can_buf buf;
 #if LELY_NO_MALLOC
@@ -122,6 +153,23 @@ struct __co_emcy {
 	void *data;
 };
 
+/**
+ * Returns a pointer to the message at the specified index in the EMCY message
+ * stack, where 0 is the most recent message.
+ */
+static inline struct co_emcy_msg *co_emcy_get_msg(
+		const co_emcy_t *emcy, size_t i);
+
+/**
+ * Ensures the EMCY message stack has room for at least <b>n</b> messages.
+ *
+ * @returns 0 on success, or -1 on error.
+ */
+static int co_emcy_reserve(co_emcy_t *emcy, size_t n);
+
+/// Returns the combined error register of all messages in the stack.
+static co_unsigned8_t co_emcy_get_er(const co_emcy_t *emcy);
+
 /// The pre-defined error field.
 struct co_1003 {
 	/// Number of errors.
@@ -240,11 +288,15 @@ __co_emcy_init(struct __co_emcy *emcy, can_net_t *net, co_dev_t *dev)
 	emcy->obj_1003 = co_dev_find_obj(emcy->dev, 0x1003);
 
 	emcy->nmsg = 0;
+	emcy->first = 0;
+	emcy->depth = 0;
 #if LELY_NO_MALLOC
 	memset(emcy->msgs, 0, CO_EMCY_MAX_NMSG * sizeof(*emcy->msgs));
 #else
 	emcy->msgs = NULL;
+	emcy->maxmsg = 0;
 #endif
+	emcy->coalesce = 0;
 
 	// Create a CAN frame buffer for pending EMCY messages that will be send
 	// once the inhibit time has elapsed.
@@ -271,6 +323,9 @@ __co_emcy_init(struct __co_emcy *emcy, can_net_t *net, co_dev_t *dev)
 		struct co_emcy_node *node = &emcy->nodes[id - 1];
 		node->id = id;
 		node->recv = NULL;
+#if !LELY_NO_MALLOC
+		node->log = NULL;
+#endif
 	}
 
 	co_obj_t *obj_1028 = co_dev_find_obj(emcy->dev, 0x1028);
@@ -325,6 +380,8 @@ __co_emcy_fini(struct __co_emcy *emcy)
 	can_buf_fini(&emcy->buf);
 
 #if !LELY_NO_MALLOC
+	co_emcy_set_log_size(emcy, 0);
+
 	free(emcy->msgs);
 #endif
 }
@@ -485,39 +542,31 @@ co_emcy_push(co_emcy_t *emcy, co_unsigned16_t eec, co_unsigned8_t er,
 	else
 		diag(DIAG_INFO, 0, "EMCY: %04X %02X", eec, er);
 
-#if LELY_NO_MALLOC
-	if (emcy->nmsg > CO_EMCY_MAX_NMSG - 1) {
-		set_errnum(ERRNUM_NOMEM);
+	if (emcy->depth && emcy->nmsg >= emcy->depth) {
+		// Discard the oldest message(s) to make room on the stack.
+		emcy->nmsg = emcy->depth - 1;
+	} else if (co_emcy_reserve(emcy, emcy->nmsg + 1) == -1) {
 		return -1;
 	}
+
+#if LELY_NO_MALLOC
+	size_t maxmsg = CO_EMCY_MAX_NMSG;
 #else
-	// Make room on the stack.
-	struct co_emcy_msg *msgs = realloc(emcy->msgs,
-			(emcy->nmsg + 1) * sizeof(struct co_emcy_msg));
-	if (!msgs) {
-#if !LELY_NO_ERRNO
-		set_errc(errno2c(errno));
-#endif
-		return -1;
-	}
-	emcy->msgs = msgs;
+	size_t maxmsg = emcy->maxmsg;
 #endif
-
-	// Move the older messages.
-	if (emcy->nmsg)
-		memmove(emcy->msgs + 1, emcy->msgs,
-				emcy->nmsg * sizeof(struct co_emcy_msg));
+	// Push the error to the stack. The older messages stay in place.
+	emcy->first = (emcy->first + maxmsg - 1) % maxmsg;
 	emcy->nmsg++;
-	// Push the error to the stack.
-	emcy->msgs[0].eec = eec;
-	emcy->msgs[0].er = er;
+	struct co_emcy_msg *msg = co_emcy_get_msg(emcy, 0);
+	msg->eec = eec;
+	msg->er = er;
 
 	// Update the pre-defined error field.
 	if (emcy->obj_1003)
 		co_emcy_set_1003(emcy);
 
 	// Obtain the new (combined) error register.
-	co_emcy_peek(emcy, NULL, &er);
+	er = co_emcy_get_er(emcy);
 
 	return co_emcy_send(emcy, eec, er, msef);
 }
@@ -538,15 +587,11 @@ co_emcy_peek(const co_emcy_t *emcy, co_unsigned16_t *peec, co_unsigned8_t *per)
 	assert(emcy);
 
 	if (peec)
-		*peec = emcy->nmsg ? emcy->msgs[0].eec : 0;
-	if (per) {
-		co_unsigned8_t er = 0;
-		// Compute the combined error register.
-		for (size_t i = 0; i < emcy->nmsg; i++)
-			er |= emcy->msgs[i].er;
-		*per = er;
-	}
+		*peec = emcy->nmsg ? co_emcy_get_msg(emcy, 0)->eec : 0;
+	if (per)
+		*per = co_emcy_get_er(emcy);
 }
+
 int
 co_emcy_remove(co_emcy_t *emcy, size_t n)
 {
@@ -555,10 +600,25 @@ co_emcy_remove(co_emcy_t *emcy, size_t n)
 	if (n >= emcy->nmsg)
 		return 0;
 
-	// Move the older messages.
-	if (--emcy->nmsg)
-		memmove(emcy->msgs + n, emcy->msgs + n + 1,
-				(emcy->nmsg - n) * sizeof(struct co_emcy_msg));
+	// Close the gap by moving the messages on the shortest side.
+	if (n < emcy->nmsg / 2) {
+#if LELY_NO_MALLOC
+		size_t maxmsg = CO_EMCY_MAX_NMSG;
+#else
+		size_t maxmsg = emcy->maxmsg;
+#endif
+		for (size_t i = n; i > 0; i--) {
+			struct co_emcy_msg *msg = co_emcy_get_msg(emcy, i - 1);
+			*co_emcy_get_msg(emcy, i) = *msg;
+		}
+		emcy->first = (emcy->first + 1) % maxmsg;
+	} else {
+		for (size_t i = n; i + 1 < emcy->nmsg; i++) {
+			struct co_emcy_msg *msg = co_emcy_get_msg(emcy, i + 1);
+			*co_emcy_get_msg(emcy, i) = *msg;
+		}
+	}
+	emcy->nmsg--;
 
 	// Update the pre-defined error field.
 	if (emcy->obj_1003)
@@ -584,7 +644,7 @@ co_emcy_find(const co_emcy_t *emcy, co_unsigned16_t eec)
 	assert(emcy);
 
 	for (size_t i = 0; i < emcy->nmsg; i++) {
-		if (emcy->msgs[i].eec == eec)
+		if (co_emcy_get_msg(emcy, i)->eec == eec)
 			return i;
 	}
 
@@ -610,6 +670,55 @@ co_emcy_clear(co_emcy_t *emcy)
 	return co_emcy_send(emcy, 0, 0, NULL);
 }
 
+size_t
+co_emcy_get_depth(const co_emcy_t *emcy)
+{
+	assert(emcy);
+
+	return emcy->depth;
+}
+
+int
+co_emcy_set_depth(co_emcy_t *emcy, size_t depth)
+{
+	assert(emcy);
+
+#if LELY_NO_MALLOC
+	if (depth > CO_EMCY_MAX_NMSG) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+#endif
+
+	emcy->depth = depth;
+
+	if (depth && emcy->nmsg > depth) {
+		// Discard the oldest messages.
+		emcy->nmsg = depth;
+		if (emcy->obj_1003)
+			co_emcy_set_1003(emcy);
+		co_sub_set_val_u8(emcy->sub_1001_00, co_emcy_get_er(emcy));
+	}
+
+	return 0;
+}
+
+int
+co_emcy_get_coalesce(const co_emcy_t *emcy)
+{
+	assert(emcy);
+
+	return emcy->coalesce;
+}
+
+void
+co_emcy_set_coalesce(co_emcy_t *emcy, int coalesce)
+{
+	assert(emcy);
+
+	emcy->coalesce = !!coalesce;
+}
+
 void
 co_emcy_get_ind(const co_emcy_t *emcy, co_emcy_ind_t **pind, void **pdata)
 {
@@ -630,6 +739,83 @@ co_emcy_set_ind(co_emcy_t *emcy, co_emcy_ind_t *ind, void *data)
 	emcy->data = data;
 }
 
+#if !LELY_NO_MALLOC
+
+int
+co_emcy_set_log_size(co_emcy_t *emcy, size_t size)
+{
+	assert(emcy);
+
+	int errc = 0;
+
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+		struct co_emcy_node *node = &emcy->nodes[id - 1];
+		if (node->log) {
+			free(node->log->recs);
+			free(node->log);
+			node->log = NULL;
+		}
+		// Only nodes in the emergency consumer object have a log.
+		if (!size || !node->recv)
+			continue;
+
+		struct co_emcy_log *log = malloc(sizeof(*log));
+		if (!log) {
+#if !LELY_NO_ERRNO
+			errc = errno2c(errno);
+#endif
+			goto error;
+		}
+		log->recs = calloc(size, sizeof(*log->recs));
+		if (!log->recs) {
+#if !LELY_NO_ERRNO
+			errc = errno2c(errno);
+#endif
+			free(log);
+			goto error;
+		}
+		spscring_init(&log->ring, size);
+		log->nlost = 0;
+		node->log = log;
+	}
+
+	return 0;
+
+error:
+	co_emcy_set_log_size(emcy, 0);
+	set_errc(errc);
+	return -1;
+}
+
+size_t
+co_emcy_read_log(co_emcy_t *emcy, co_unsigned8_t id, struct co_emcy_rec *recs,
+		size_t n)
+{
+	assert(emcy);
+	assert(recs || !n);
+
+	if (!id || id > CO_NUM_NODES)
+		return 0;
+	struct co_emcy_log *log = emcy->nodes[id - 1].log;
+	if (!log)
+		return 0;
+
+	size_t nrecs = 0;
+	while (nrecs < n) {
+		// Copy the messages in (at most) two consecutive ranges.
+		size_t size = n - nrecs;
+		size_t i = spscring_c_alloc_no_wrap(&log->ring, &size);
+		if (!size)
+			break;
+		memcpy(recs + nrecs, log->recs + i, size * sizeof(*recs));
+		spscring_c_commit(&log->ring, size);
+		nrecs += size;
+	}
+	return nrecs;
+}
+
+#endif // !LELY_NO_MALLOC
+
 static int
 co_emcy_node_recv(const struct can_msg *msg, void *data)
 {
@@ -660,6 +846,27 @@ co_emcy_node_recv(const struct can_msg *msg, void *data)
 		memcpy(msef, msg->data + 3,
 				MAX((uint_least8_t)(msg->len - 3), 5));
 
+#if !LELY_NO_MALLOC
+	struct co_emcy_log *log = node->log;
+	if (log) {
+		// Append the message to the log, unless it is full.
+		size_t size = 1;
+		size_t i = spscring_p_alloc(&log->ring, &size);
+		if (size) {
+			struct co_emcy_rec *rec = &log->recs[i];
+			can_net_get_time(emcy->net, &rec->time);
+			rec->eec = eec;
+			rec->er = er;
+			memcpy(rec->msef, msef, sizeof(rec->msef));
+			rec->nlost = log->nlost;
+			log->nlost = 0;
+			spscring_p_commit(&log->ring, 1);
+		} else {
+			log->nlost++;
+		}
+	}
+#endif
+
 	// Notify the user.
 	trace("EMCY: received %04X %02X", eec, er);
 	if (emcy->ind)
@@ -681,9 +888,9 @@ co_emcy_set_1003(co_emcy_t *emcy)
 		return 0;
 
 	// Copy the emergency error codes.
-	val_1003->n = MIN((co_unsigned8_t)emcy->nmsg, nsubidx - 1);
+	val_1003->n = (co_unsigned8_t)MIN(emcy->nmsg, (size_t)nsubidx - 1);
 	for (int i = 0; i < val_1003->n; i++)
-		val_1003->ef[i] = emcy->msgs[i].eec;
+		val_1003->ef[i] = co_emcy_get_msg(emcy, i)->eec;
 	for (int i = val_1003->n; i < nsubidx - 1; i++)
 		val_1003->ef[i] = 0;
 
@@ -886,6 +1093,18 @@ co_emcy_send(co_emcy_t *emcy, co_unsigned16_t eec, co_unsigned8_t er,
 		memcpy(msg.data + 3, msef, 5);
 	}
 
+	// If the last frame waiting for the inhibit time to elapse has the same
+	// emergency error code, update it instead of adding another frame.
+	if (emcy->coalesce && can_buf_size(&emcy->buf)) {
+		struct can_msg *last = &emcy->buf.ptr[(emcy->buf.end - 1)
+				& emcy->buf.size];
+		if (last->id == msg.id && last->flags == msg.flags
+				&& ldle_u16(last->data) == eec) {
+			memcpy(last->data + 2, msg.data + 2, CAN_MAX_LEN - 2);
+			return 0;
+		}
+	}
+
 	// Add the frame to the buffer.
 	if (!can_buf_write(&emcy->buf, &msg, 1)) {
 		if (!can_buf_reserve(&emcy->buf, 1))
@@ -923,4 +1142,66 @@ co_emcy_flush(co_emcy_t *emcy)
 	}
 }
 
+static inline struct co_emcy_msg *
+co_emcy_get_msg(const co_emcy_t *emcy, size_t i)
+{
+	assert(emcy);
+	assert(i < emcy->nmsg);
+
+#if LELY_NO_MALLOC
+	size_t maxmsg = CO_EMCY_MAX_NMSG;
+#else
+	size_t maxmsg = emcy->maxmsg;
+#endif
+	return (struct co_emcy_msg *)&emcy->msgs[(emcy->first + i) % maxmsg];
+}
+
+static int
+co_emcy_reserve(co_emcy_t *emcy, size_t n)
+{
+	assert(emcy);
+
+#if LELY_NO_MALLOC
+	if (n > CO_EMCY_MAX_NMSG) {
+		set_errnum(ERRNUM_NOMEM);
+		return -1;
+	}
+#else
+	if (n <= emcy->maxmsg)
+		return 0;
+
+	// Double the size of the ring buffer to amortize the cost of copying.
+	size_t maxmsg = MAX(n, 2 * emcy->maxmsg);
+	if (emcy->depth)
+		maxmsg = MIN(maxmsg, MAX(n, emcy->depth));
+	struct co_emcy_msg *msgs = malloc(maxmsg * sizeof(*msgs));
+	if (!msgs) {
+#if !LELY_NO_ERRNO
+		set_errc(errno2c(errno));
+#endif
+		return -1;
+	}
+	for (size_t i = 0; i < emcy->nmsg; i++)
+		msgs[i] = *co_emcy_get_msg(emcy, i);
+	free(emcy->msgs);
+	emcy->msgs = msgs;
+	emcy->maxmsg = maxmsg;
+	emcy->first = 0;
+#endif
+
+	return 0;
+}
+
+static co_unsigned8_t
+co_emcy_get_er(const co_emcy_t *emcy)
+{
+	assert(emcy);
+
+	co_unsigned8_t er = 0;
+	// Compute the combined error register.
+	for (size_t i = 0; i < emcy->nmsg; i++)
+		er |= co_emcy_get_msg(emcy, i)->er;
+	return er;
+}
+
 #endif // !LELY_NO_CO_EMCY
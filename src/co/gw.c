@@ -28,6 +28,7 @@
 #include <lely/co/csdo.h>
 #include <lely/co/dev.h>
 #include <lely/util/errnum.h>
+#include <lely/util/sllist.h>
 #if !LELY_NO_CO_EMCY
 #include <lely/co/emcy.h>
 #endif
@@ -56,6 +57,18 @@
 
 struct co_gw_job;
 
+#if !LELY_NO_CO_CSDO
+/// The SDO upload/download requests for a single node.
+struct co_gw_sdo {
+	/// A pointer to the job on the default SDO channel.
+	struct co_gw_job *job;
+	/// The queue of requests waiting for a free Client-SDO channel.
+	struct sllist queue;
+	/// The number of requests in #queue.
+	size_t nqueue;
+};
+#endif
+
 /// A CANopen network.
 struct co_gw_net {
 	/// A pointer to the CANopen gateway.
@@ -76,8 +89,13 @@ struct co_gw_net {
 	 */
 	unsigned bootup_ind : 1;
 #if !LELY_NO_CO_CSDO
-	/// An array of pointers to the SDO upload/download jobs.
-	struct co_gw_job *sdo[CO_NUM_NODES];
+	/// An array containing the SDO upload/download requests for each node.
+	struct co_gw_sdo sdo[CO_NUM_NODES];
+	/**
+	 * An array of pointers to the SDO upload/download jobs using the
+	 * Client-SDO services of the NMT service.
+	 */
+	struct co_gw_job *csdo[CO_NUM_SDOS];
 #endif
 #if !LELY_NO_CO_MASTER && !LELY_NO_CO_LSS
 	/// A pointer to the LSS job.
@@ -239,14 +257,32 @@ static void co_gw_net_rpdo_ind(co_rpdo_t *pdo, co_unsigned32_t ac,
 
 /// A CANopen gateway network job.
 struct co_gw_job {
-	/// The address of the pointer to this job in the network.
+	/// The address of the pointer to this job in the network (can be NULL).
 	struct co_gw_job **pself;
+	/// The node of this job in the queue of pending SDO requests.
+	struct slnode node;
 	/// A pointer to the CANopen network.
 	struct co_gw_net *net;
 	/// A pointer to request-specific data.
 	void *data;
 	/// A pointer to the destructor for #data.
-	void (*dtor)(void *data);
+	void (*dtor)(struct co_gw_job *job);
+#if !LELY_NO_CO_CSDO
+	/**
+	 * The download indication function of a borrowed Client-SDO service,
+	 * restored when the job is destroyed.
+	 */
+	co_csdo_ind_t *dn_ind;
+	/// A pointer to user-specified data for #dn_ind.
+	void *dn_data;
+	/**
+	 * The upload indication function of a borrowed Client-SDO service,
+	 * restored when the job is destroyed.
+	 */
+	co_csdo_ind_t *up_ind;
+	/// A pointer to user-specified data for #up_ind.
+	void *up_data;
+#endif
 	/// The service parameters of the request.
 	struct co_gw_req req;
 };
@@ -256,7 +292,8 @@ struct co_gw_job {
 
 /// Creates a new CANopen gateway network job. @see co_gw_job_destroy()
 static struct co_gw_job *co_gw_job_create(struct co_gw_job **pself,
-		struct co_gw_net *net, void *data, void (*dtor)(void *data),
+		struct co_gw_net *net, void *data,
+		void (*dtor)(struct co_gw_job *job),
 		const struct co_gw_req *req);
 /// Destroys a CANopen gateway network job. @see co_gw_job_create()
 static void co_gw_job_destroy(struct co_gw_job *job);
@@ -265,12 +302,63 @@ static void co_gw_job_destroy(struct co_gw_job *job);
 static void co_gw_job_remove(struct co_gw_job *job);
 
 #if !LELY_NO_CO_CSDO
-/// Creates a new SDO upload/download job.
-static struct co_gw_job *co_gw_job_create_sdo(struct co_gw_job **pself,
-		struct co_gw_net *net, co_unsigned8_t id,
+/**
+ * Creates a new SDO upload/download job for a remote node and starts it if a
+ * Client-SDO channel is available. Otherwise the job is queued.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc(). The error number is #ERRNUM_BUSY if the
+ * queue is full.
+ */
+static int co_gw_net_sdo_push(struct co_gw_net *net, co_unsigned8_t id,
 		const struct co_gw_req *req);
+/**
+ * Starts as many queued SDO upload/download jobs for a remote node as there are
+ * Client-SDO channels available. If <b>all</b> is 0, only the default SDO
+ * channel is considered.
+ */
+static void co_gw_net_sdo_next(
+		struct co_gw_net *net, co_unsigned8_t id, int all);
+/**
+ * Finds an available Client-SDO channel for a remote node. If <b>all</b> is 0,
+ * only the default SDO channel is considered.
+ *
+ * @returns the address at which to store the job using the channel, or NULL if
+ * no channel is available. On success, *<b>psdo</b> contains a pointer to the
+ * Client-SDO service of the NMT service to be used, or NULL if a new Client-SDO
+ * service is needed for the default channel.
+ */
+static struct co_gw_job **co_gw_net_sdo_chan(struct co_gw_net *net,
+		co_unsigned8_t id, int all, co_csdo_t **psdo);
+/**
+ * Starts an SDO upload/download job on a Client-SDO channel.
+ *
+ * @param job   a pointer to the job.
+ * @param id    the node-ID of the server.
+ * @param pself the address at which to store the job (see
+ *              co_gw_net_sdo_chan()).
+ * @param sdo   a pointer to the Client-SDO service of the NMT service, or NULL
+ *              to create a Client-SDO service for the default channel.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the job has to be
+ * destroyed by the caller.
+ */
+static int co_gw_job_start_sdo(struct co_gw_job *job, co_unsigned8_t id,
+		struct co_gw_job **pself, co_csdo_t *sdo);
+/// Aborts an SDO upload/download job without sending a confirmation.
+static void co_gw_job_sdo_cancel(struct co_gw_job *job);
+/**
+ * Destroys a completed SDO upload/download job and starts the next queued job
+ * for the same node, if any.
+ */
+static void co_gw_job_sdo_done(struct co_gw_job *job, co_unsigned32_t ac);
 /// Destroys the Client-SDO service in an SDO upload/download job.
-static void co_gw_job_sdo_dtor(void *data);
+static void co_gw_job_sdo_dtor(struct co_gw_job *job);
+/**
+ * Releases the Client-SDO service of the NMT service used by an SDO
+ * upload/download job and restores its original indication functions.
+ */
+static void co_gw_job_csdo_dtor(struct co_gw_job *job);
 /// The confirmation function for an 'SDO upload' request.
 static void co_gw_job_sdo_up_con(co_csdo_t *sdo, co_unsigned16_t idx,
 		co_unsigned8_t subidx, co_unsigned32_t ac, const void *ptr,
@@ -331,6 +419,11 @@ struct __co_gw {
 	co_gw_rate_func_t *rate_func;
 	/// A pointer to the user-specified data for #rate_func.
 	void *rate_data;
+	/**
+	 * The maximum number of SDO requests per node waiting for a free
+	 * Client-SDO channel.
+	 */
+	size_t sdo_queue;
 };
 
 #if !LELY_NO_CO_CSDO
@@ -533,6 +626,8 @@ __co_gw_init(struct __co_gw *gw)
 	gw->rate_func = NULL;
 	gw->rate_data = NULL;
 
+	gw->sdo_queue = LELY_CO_GW_SDO_QUEUE;
+
 	return gw;
 }
 
@@ -950,6 +1045,22 @@ co_gw_set_rate_func(co_gw_t *gw, co_gw_rate_func_t *func, void *data)
 	gw->rate_data = data;
 }
 
+size_t
+co_gw_get_sdo_queue(const co_gw_t *gw)
+{
+	assert(gw);
+
+	return gw->sdo_queue;
+}
+
+void
+co_gw_set_sdo_queue(co_gw_t *gw, size_t depth)
+{
+	assert(gw);
+
+	gw->sdo_queue = depth;
+}
+
 static struct co_gw_net *
 co_gw_net_create(co_gw_t *gw, co_unsigned16_t id, co_nmt_t *nmt)
 {
@@ -975,8 +1086,13 @@ co_gw_net_create(co_gw_t *gw, co_unsigned16_t id, co_nmt_t *nmt)
 	net->bootup_ind = 1;
 
 #if !LELY_NO_CO_CSDO
-	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
-		net->sdo[id - 1] = NULL;
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+		net->sdo[id - 1].job = NULL;
+		sllist_init(&net->sdo[id - 1].queue);
+		net->sdo[id - 1].nqueue = 0;
+	}
+	for (co_unsigned8_t num = 1; num <= CO_NUM_SDOS; num++)
+		net->csdo[num - 1] = NULL;
 #endif
 #if !LELY_NO_CO_MASTER && !LELY_NO_CO_LSS
 	net->lss = NULL;
@@ -1082,8 +1198,17 @@ co_gw_net_destroy(struct co_gw_net *net)
 		co_nmt_set_cs_ind(net->nmt, net->cs_ind, net->cs_data);
 
 #if !LELY_NO_CO_CSDO
-		for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
-			co_gw_job_destroy(net->sdo[id - 1]);
+		for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+			struct co_gw_sdo *sdo = &net->sdo[id - 1];
+			struct slnode *node;
+			while ((node = sllist_pop_front(&sdo->queue)))
+				co_gw_job_destroy(structof(
+						node, struct co_gw_job, node));
+			sdo->nqueue = 0;
+			co_gw_job_sdo_cancel(sdo->job);
+		}
+		for (co_unsigned8_t num = 1; num <= CO_NUM_SDOS; num++)
+			co_gw_job_sdo_cancel(net->csdo[num - 1]);
 #endif
 #if !LELY_NO_CO_MASTER && !LELY_NO_CO_LSS
 		co_gw_job_destroy(net->lss);
@@ -1363,29 +1488,32 @@ co_gw_net_emcy_ind(co_emcy_t *emcy, co_unsigned8_t id, co_unsigned16_t ec,
 
 static struct co_gw_job *
 co_gw_job_create(struct co_gw_job **pself, struct co_gw_net *net, void *data,
-		void (*dtor)(void *data), const struct co_gw_req *req)
+		void (*dtor)(struct co_gw_job *job), const struct co_gw_req *req)
 {
-	assert(pself);
 	assert(req);
 
-	if (*pself)
+	if (pself && *pself)
 		co_gw_job_destroy(*pself);
 
-	*pself = malloc(CO_GW_JOB_SIZE + req->size);
-	if (!*pself) {
+	struct co_gw_job *job = malloc(CO_GW_JOB_SIZE + req->size);
+	if (!job) {
 #if !LELY_NO_ERRNO
 		set_errc(errno2c(errno));
 #endif
 		return NULL;
 	}
 
-	(*pself)->pself = pself;
-	(*pself)->net = net;
-	(*pself)->data = data;
-	(*pself)->dtor = dtor;
-	memcpy(&(*pself)->req, req, req->size);
+	job->pself = pself;
+	slnode_init(&job->node);
+	job->net = net;
+	job->data = data;
+	job->dtor = dtor;
+	memcpy(&job->req, req, req->size);
+
+	if (pself)
+		*pself = job;
 
-	return *pself;
+	return job;
 }
 
 static void
@@ -1395,7 +1523,7 @@ co_gw_job_destroy(struct co_gw_job *job)
 		co_gw_job_remove(job);
 
 		if (job->dtor)
-			job->dtor(job->data);
+			job->dtor(job);
 
 		free(job);
 	}
@@ -1412,28 +1540,143 @@ co_gw_job_remove(struct co_gw_job *job)
 
 #if !LELY_NO_CO_CSDO
 
-static struct co_gw_job *
-co_gw_job_create_sdo(struct co_gw_job **pself, struct co_gw_net *net,
-		co_unsigned8_t id, const struct co_gw_req *req)
+static int
+co_gw_net_sdo_push(struct co_gw_net *net, co_unsigned8_t id,
+		const struct co_gw_req *req)
 {
-	assert(pself);
 	assert(net);
+	assert(net->gw);
+	assert(id && id <= CO_NUM_NODES);
+	assert(req);
 
-	co_gw_t *gw = net->gw;
+	struct co_gw_sdo *sdo = &net->sdo[id - 1];
 
-	int errc = 0;
+	// Only look for an available channel if no other requests are waiting,
+	// to preserve the order of the requests.
+	co_csdo_t *csdo = NULL;
+	struct co_gw_job **pself = !sdo->nqueue
+			? co_gw_net_sdo_chan(net, id, 1, &csdo)
+			: NULL;
+	if (!pself && sdo->nqueue >= net->gw->sdo_queue) {
+		set_errnum(ERRNUM_BUSY);
+		return -1;
+	}
 
-	if (*pself) {
-		errc = errnum2c(ERRNUM_BUSY);
-		goto error_param;
+	struct co_gw_job *job = co_gw_job_create(NULL, net, NULL, NULL, req);
+	if (!job)
+		return -1;
+
+	if (!pself) {
+		sllist_push_back(&sdo->queue, &job->node);
+		sdo->nqueue++;
+		return 0;
 	}
 
-	co_csdo_t *sdo = co_csdo_create(co_nmt_get_net(net->nmt), NULL, id);
-	if (!sdo) {
-		errc = get_errc();
-		goto error_create_sdo;
+	if (co_gw_job_start_sdo(job, id, pself, csdo) == -1) {
+		int errc = get_errc();
+		co_gw_job_destroy(job);
+		set_errc(errc);
+		return -1;
 	}
 
+	return 0;
+}
+
+static void
+co_gw_net_sdo_next(struct co_gw_net *net, co_unsigned8_t id, int all)
+{
+	assert(net);
+	assert(id && id <= CO_NUM_NODES);
+
+	struct co_gw_sdo *sdo = &net->sdo[id - 1];
+	while (sdo->nqueue) {
+		co_csdo_t *csdo = NULL;
+		struct co_gw_job **pself =
+				co_gw_net_sdo_chan(net, id, all, &csdo);
+		if (!pself)
+			break;
+
+		struct co_gw_job *job = structof(sllist_pop_front(&sdo->queue),
+				struct co_gw_job, node);
+		sdo->nqueue--;
+
+		int errc = get_errc();
+		if (co_gw_job_start_sdo(job, id, pself, csdo) == -1) {
+			int iec = errnum2iec(get_errnum());
+			set_errc(errc);
+			// Only the service number and user-specified data are
+			// needed for the confirmation.
+			struct co_gw_req req = job->req;
+			co_gw_job_destroy(job);
+			co_gw_send_con(net->gw, &req, iec, 0);
+		}
+	}
+}
+
+static struct co_gw_job **
+co_gw_net_sdo_chan(struct co_gw_net *net, co_unsigned8_t id, int all,
+		co_csdo_t **psdo)
+{
+	assert(net);
+	assert(id && id <= CO_NUM_NODES);
+	assert(psdo);
+
+	if (!net->sdo[id - 1].job) {
+		*psdo = NULL;
+		return &net->sdo[id - 1].job;
+	}
+
+	if (!all)
+		return NULL;
+
+	for (co_unsigned8_t num = 1; num <= CO_NUM_SDOS; num++) {
+		if (net->csdo[num - 1])
+			continue;
+		co_csdo_t *sdo = co_nmt_get_csdo(net->nmt, num);
+		if (!sdo || !co_csdo_is_valid(sdo) || !co_csdo_is_idle(sdo))
+			continue;
+		// Skip Client-SDOs for other nodes, as well as those using the
+		// default SDO channel of the node.
+		const struct co_sdo_par *par = co_csdo_get_par(sdo);
+		co_unsigned32_t cobid = par->cobid_req;
+		if (par->id != id || (cobid & CO_SDO_COBID_FRAME)
+				|| (cobid & CAN_MASK_BID) == 0x600u + id)
+			continue;
+		*psdo = sdo;
+		return &net->csdo[num - 1];
+	}
+
+	return NULL;
+}
+
+static int
+co_gw_job_start_sdo(struct co_gw_job *job, co_unsigned8_t id,
+		struct co_gw_job **pself, co_csdo_t *sdo)
+{
+	assert(job);
+	assert(job->net);
+	assert(pself);
+	assert(!*pself);
+
+	struct co_gw_net *net = job->net;
+	co_gw_t *gw = net->gw;
+
+	if (sdo) {
+		// Save the indication functions of the borrowed service so they
+		// can be restored once the job completes.
+		co_csdo_get_dn_ind(sdo, &job->dn_ind, &job->dn_data);
+		co_csdo_get_up_ind(sdo, &job->up_ind, &job->up_data);
+		job->dtor = &co_gw_job_csdo_dtor;
+	} else {
+		sdo = co_csdo_create(co_nmt_get_net(net->nmt), NULL, id);
+		if (!sdo)
+			return -1;
+		job->dtor = &co_gw_job_sdo_dtor;
+	}
+	job->data = sdo;
+	job->pself = pself;
+	*pself = job;
+
 	// The actual SDO timeout is limited by the global gateway command
 	// timeout.
 	int timeout = net->timeout;
@@ -1441,31 +1684,83 @@ co_gw_job_create_sdo(struct co_gw_job **pself, struct co_gw_net *net,
 		timeout = timeout ? MIN(timeout, gw->timeout) : gw->timeout;
 	co_csdo_set_timeout(sdo, timeout);
 
-	struct co_gw_job *job = co_gw_job_create(
-			pself, net, sdo, &co_gw_job_sdo_dtor, req);
-	if (!job) {
-		errc = get_errc();
-		goto error_create_job;
+	if (job->req.srv == CO_GW_SRV_SDO_UP) {
+		const struct co_gw_req_sdo_up *par =
+				(const struct co_gw_req_sdo_up *)&job->req;
+		co_csdo_set_up_ind(sdo, &co_gw_job_sdo_ind, job);
+		return co_csdo_up_req(sdo, par->idx, par->subidx,
+				&co_gw_job_sdo_up_con, job);
+	} else {
+		assert(job->req.srv == CO_GW_SRV_SDO_DN);
+		const struct co_gw_req_sdo_dn *par =
+				(const struct co_gw_req_sdo_dn *)&job->req;
+		co_csdo_set_dn_ind(sdo, &co_gw_job_sdo_ind, job);
+		return co_csdo_dn_req(sdo, par->idx, par->subidx, par->val,
+				par->len, &co_gw_job_sdo_dn_con, job);
 	}
+}
 
-	return job;
+static void
+co_gw_job_sdo_cancel(struct co_gw_job *job)
+{
+	if (!job)
+		return;
 
-error_create_job:
-	co_csdo_destroy(sdo);
-error_create_sdo:
-error_param:
-	set_errc(errc);
-	return NULL;
+	co_csdo_t *sdo = job->data;
+	if (sdo && !co_csdo_is_idle(sdo) && !co_csdo_is_stopped(sdo)) {
+		// Prevent a confirmation from being sent. Aborting the request
+		// invokes the confirmation function, which destroys the job.
+		job->req.srv = 0;
+		co_csdo_abort_req(sdo, CO_SDO_AC_ERROR);
+	} else {
+		co_gw_job_destroy(job);
+	}
 }
 
 static void
-co_gw_job_sdo_dtor(void *data)
+co_gw_job_sdo_done(struct co_gw_job *job, co_unsigned32_t ac)
 {
-	co_csdo_t *sdo = data;
+	assert(job);
+	assert(job->net);
+
+	co_csdo_t *sdo = job->data;
+	// Requests for the gateway itself are never queued.
+	if (!sdo) {
+		co_gw_job_destroy(job);
+		return;
+	}
+
+	struct co_gw_net *net = job->net;
+	co_unsigned8_t id = co_csdo_get_par(sdo)->id;
+	// If a Client-SDO service of the NMT service was stopped, the NMT
+	// service may be (re)initializing its services. In that case, only the
+	// default SDO channel can be used safely.
+	int all = job->dtor != &co_gw_job_csdo_dtor || ac != CO_SDO_AC_NO_SDO;
+
+	co_gw_job_destroy(job);
+
+	co_gw_net_sdo_next(net, id, all);
+}
+
+static void
+co_gw_job_sdo_dtor(struct co_gw_job *job)
+{
+	assert(job);
+	co_csdo_t *sdo = job->data;
 
 	co_csdo_destroy(sdo);
 }
 
+static void
+co_gw_job_csdo_dtor(struct co_gw_job *job)
+{
+	assert(job);
+	co_csdo_t *sdo = job->data;
+
+	co_csdo_set_dn_ind(sdo, job->dn_ind, job->dn_data);
+	co_csdo_set_up_ind(sdo, job->up_ind, job->up_data);
+}
+
 static void
 co_gw_job_sdo_up_con(co_csdo_t *sdo, co_unsigned16_t idx, co_unsigned8_t subidx,
 		co_unsigned32_t ac, const void *ptr, size_t n, void *data)
@@ -1508,7 +1803,7 @@ co_gw_job_sdo_up_con(co_csdo_t *sdo, co_unsigned16_t idx, co_unsigned8_t subidx,
 	}
 
 done:
-	co_gw_job_destroy(job);
+	co_gw_job_sdo_done(job, ac);
 }
 
 static void
@@ -1527,7 +1822,7 @@ co_gw_job_sdo_dn_con(co_csdo_t *sdo, co_unsigned16_t idx, co_unsigned8_t subidx,
 	if (job->req.srv == CO_GW_SRV_SDO_DN)
 		co_gw_send_con(job->net->gw, &job->req, 0, ac);
 
-	co_gw_job_destroy(job);
+	co_gw_job_sdo_done(job, ac);
 }
 
 static void
@@ -1544,7 +1839,7 @@ co_gw_job_sdo_ind(const co_csdo_t *sdo, co_unsigned16_t idx,
 	struct co_gw_ind_sdo ind = { .size = sizeof(ind),
 		.srv = CO_GW_SRV_SDO,
 		.net = job->net->id,
-		.node = co_csdo_get_num(job->data),
+		.node = co_csdo_get_par(job->data)->id,
 		.nbyte = nbyte,
 		.up = job->req.srv == CO_GW_SRV_SDO_UP,
 		.data = job->req.data,
@@ -1812,7 +2107,7 @@ co_gw_recv_sdo_up(co_gw_t *gw, co_unsigned16_t net, co_unsigned8_t node,
 
 	struct co_gw_job *job = NULL;
 	if (node == co_dev_get_id(dev)) {
-		job = co_gw_job_create(&gw->net[net - 1]->sdo[node - 1],
+		job = co_gw_job_create(&gw->net[net - 1]->sdo[node - 1].job,
 				gw->net[net - 1], NULL, NULL, req);
 		if (!job) {
 			iec = errnum2iec(get_errnum());
@@ -1836,23 +2131,10 @@ co_gw_recv_sdo_up(co_gw_t *gw, co_unsigned16_t net, co_unsigned8_t node,
 			goto error_srv;
 		}
 
-		job = co_gw_job_create_sdo(&gw->net[net - 1]->sdo[node - 1],
-				gw->net[net - 1], node, req);
-		if (!job) {
+		if (co_gw_net_sdo_push(gw->net[net - 1], node, req) == -1) {
 			iec = errnum2iec(get_errnum());
 			goto error_create_job;
 		}
-		const struct co_gw_req_sdo_up *par =
-				(const struct co_gw_req_sdo_up *)&job->req;
-
-		co_csdo_set_up_ind(job->data, &co_gw_job_sdo_ind, job);
-		// clang-format off
-		if (co_csdo_up_req(job->data, par->idx, par->subidx,
-				&co_gw_job_sdo_up_con, job) == -1) {
-			// clang-format on
-			iec = errnum2iec(get_errnum());
-			goto error_up_req;
-		}
 	}
 
 	return 0;
@@ -1893,7 +2175,7 @@ co_gw_recv_sdo_dn(co_gw_t *gw, co_unsigned16_t net, co_unsigned8_t node,
 
 	struct co_gw_job *job = NULL;
 	if (node == co_dev_get_id(dev)) {
-		job = co_gw_job_create(&gw->net[net - 1]->sdo[node - 1],
+		job = co_gw_job_create(&gw->net[net - 1]->sdo[node - 1].job,
 				gw->net[net - 1], NULL, NULL, req);
 		if (!job) {
 			iec = errnum2iec(get_errnum());
@@ -1916,22 +2198,10 @@ co_gw_recv_sdo_dn(co_gw_t *gw, co_unsigned16_t net, co_unsigned8_t node,
 			goto error_srv;
 		}
 
-		job = co_gw_job_create_sdo(&gw->net[net - 1]->sdo[node - 1],
-				gw->net[net - 1], node, req);
-		if (!job) {
+		if (co_gw_net_sdo_push(gw->net[net - 1], node, req) == -1) {
 			iec = errnum2iec(get_errnum());
 			goto error_create_job;
 		}
-		par = (const struct co_gw_req_sdo_dn *)&job->req;
-
-		co_csdo_set_dn_ind(job->data, &co_gw_job_sdo_ind, job);
-		// clang-format off
-		if (co_csdo_dn_req(job->data, par->idx, par->subidx, par->val,
-				par->len, &co_gw_job_sdo_dn_con, job) == -1) {
-			// clang-format on
-			iec = errnum2iec(get_errnum());
-			goto error_dn_req;
-		}
 	}
 
 	return 0;
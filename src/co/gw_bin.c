@@ -0,0 +1,402 @@
+/**@file
+ * This file is part of the CANopen library; it contains the implementation of
+ * the binary gateway functions.
+ *
+ * @see lely/co/gw_bin.h
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "co.h"
+
+#if !LELY_NO_CO_GW_BIN
+
+#include <lely/co/gw_bin.h>
+#include <lely/libc/stdlib.h>
+#include <lely/util/errnum.h>
+#include <lely/util/spscring.h>
+#include <lely/util/util.h>
+
+#include <assert.h>
+#include <string.h>
+
+/// Rounds <b>n</b> up to a multiple of #CO_GW_BIN_ALIGN.
+#define CO_GW_BIN_ALIGN_UP(n) \
+	(((n) + CO_GW_BIN_ALIGN - 1) & ~(size_t)(CO_GW_BIN_ALIGN - 1))
+
+/**
+ * A single-producer, single-consumer ring buffer containing CANopen gateway
+ * service records. Each record consists of a service struct, padded to a
+ * multiple of #CO_GW_BIN_ALIGN bytes. Records are never split across the end of
+ * the buffer; if a record does not fit in the remaining space, a record with
+ * size 0 is written to mark the end, and the record is written at the start of
+ * the buffer.
+ */
+struct co_gw_bin_ring {
+	/// The ring buffer used to control #buf.
+	struct spscring ring;
+	/// The records.
+	_Alignas(CO_GW_BIN_ALIGN) unsigned char buf[];
+};
+
+/// A CANopen binary gateway.
+struct __co_gw_bin {
+	/// A pointer to the ring buffer containing the requests.
+	struct co_gw_bin_ring *req;
+	/// A pointer to the ring buffer containing the indications and
+	/// confirmations.
+	struct co_gw_bin_ring *ind;
+	/// The maximum number of indications before the user is notified.
+	size_t batch;
+	/// The number of records written since the last notification.
+	size_t pending;
+	/// The number of records dropped because #ind was full.
+	size_t lost;
+	/// A pointer to the callback function invoked by co_gw_bin_send().
+	co_gw_bin_send_func_t *send_func;
+	/// A pointer to the user-specified data for #send_func.
+	void *send_data;
+	/// A pointer to the notification function.
+	co_gw_bin_notify_func_t *notify_func;
+	/// A pointer to the user-specified data for #notify_func.
+	void *notify_data;
+};
+
+/// Returns 1 if the specified service is an indication, and 0 if not.
+static int co_gw_bin_is_ind(int srv);
+
+size_t
+co_gw_bin_ring_sizeof(size_t size)
+{
+	size = sizeof(struct co_gw_bin_ring) + CO_GW_BIN_ALIGN_UP(size);
+	// Round up to a multiple of the cache line size, as required by
+	// aligned_alloc().
+	return ALIGN(size, _Alignof(struct co_gw_bin_ring));
+}
+
+struct co_gw_bin_ring *
+co_gw_bin_ring_init(void *ptr, size_t size)
+{
+	assert(ptr);
+
+	struct co_gw_bin_ring *ring = ptr;
+	spscring_init(&ring->ring, size & ~(size_t)(CO_GW_BIN_ALIGN - 1));
+
+	return ring;
+}
+
+struct co_gw_bin_ring *
+co_gw_bin_ring_create(size_t size)
+{
+	void *ptr = aligned_alloc(_Alignof(struct co_gw_bin_ring),
+			co_gw_bin_ring_sizeof(size));
+	if (!ptr) {
+#if !LELY_NO_ERRNO
+		set_errc(errno2c(errno));
+#endif
+		return NULL;
+	}
+
+	return co_gw_bin_ring_init(ptr, size);
+}
+
+void
+co_gw_bin_ring_destroy(struct co_gw_bin_ring *ring)
+{
+	aligned_free(ring);
+}
+
+int
+co_gw_bin_ring_write(struct co_gw_bin_ring *ring, const struct co_gw_srv *srv)
+{
+	assert(ring);
+	assert(srv);
+
+	size_t size = spscring_size(&ring->ring);
+	size_t n = CO_GW_BIN_ALIGN_UP(srv->size);
+	if (srv->size < sizeof(struct co_gw_srv) || n > size) {
+		set_errnum(ERRNUM_MSGSIZE);
+		return -1;
+	}
+
+	size_t k = n;
+	size_t i = spscring_p_alloc_no_wrap(&ring->ring, &k);
+	if (k < n && i + k == size
+			&& spscring_p_capacity(&ring->ring) >= k + n) {
+		// Mark the end of the buffer and continue at the start.
+		*(size_t *)(ring->buf + i) = 0;
+		spscring_p_commit(&ring->ring, k);
+		k = n;
+		i = spscring_p_alloc_no_wrap(&ring->ring, &k);
+		assert(!i);
+	}
+	if (k < n) {
+		set_errnum(ERRNUM_AGAIN);
+		return -1;
+	}
+
+	memcpy(ring->buf + i, srv, srv->size);
+	spscring_p_commit(&ring->ring, n);
+
+	return 0;
+}
+
+const struct co_gw_srv *
+co_gw_bin_ring_peek(struct co_gw_bin_ring *ring)
+{
+	assert(ring);
+
+	for (;;) {
+		size_t k = spscring_size(&ring->ring);
+		size_t i = spscring_c_alloc_no_wrap(&ring->ring, &k);
+		if (!k)
+			return NULL;
+		const struct co_gw_srv *srv = (const void *)(ring->buf + i);
+		if (srv->size)
+			return srv;
+		// Skip the end-of-buffer marker.
+		spscring_c_commit(&ring->ring, k);
+	}
+}
+
+void
+co_gw_bin_ring_pop(struct co_gw_bin_ring *ring)
+{
+	assert(ring);
+
+	const struct co_gw_srv *srv = co_gw_bin_ring_peek(ring);
+	if (srv)
+		spscring_c_commit(&ring->ring, CO_GW_BIN_ALIGN_UP(srv->size));
+}
+
+void *
+__co_gw_bin_alloc(void)
+{
+	void *ptr = malloc(sizeof(struct __co_gw_bin));
+#if !LELY_NO_ERRNO
+	if (!ptr)
+		set_errc(errno2c(errno));
+#endif
+	return ptr;
+}
+
+void
+__co_gw_bin_free(void *ptr)
+{
+	free(ptr);
+}
+
+struct __co_gw_bin *
+__co_gw_bin_init(struct __co_gw_bin *gw, struct co_gw_bin_ring *req,
+		struct co_gw_bin_ring *ind)
+{
+	assert(gw);
+	assert(req);
+	assert(ind);
+
+	gw->req = req;
+	gw->ind = ind;
+
+	gw->batch = LELY_CO_GW_BIN_BATCH;
+	gw->pending = 0;
+	gw->lost = 0;
+
+	gw->send_func = NULL;
+	gw->send_data = NULL;
+
+	gw->notify_func = NULL;
+	gw->notify_data = NULL;
+
+	return gw;
+}
+
+void
+__co_gw_bin_fini(struct __co_gw_bin *gw)
+{
+	(void)gw;
+}
+
+co_gw_bin_t *
+co_gw_bin_create(struct co_gw_bin_ring *req, struct co_gw_bin_ring *ind)
+{
+	int errc = 0;
+
+	co_gw_bin_t *gw = __co_gw_bin_alloc();
+	if (!gw) {
+		errc = get_errc();
+		goto error_alloc_gw;
+	}
+
+	if (!__co_gw_bin_init(gw, req, ind)) {
+		errc = get_errc();
+		goto error_init_gw;
+	}
+
+	return gw;
+
+error_init_gw:
+	__co_gw_bin_free(gw);
+error_alloc_gw:
+	set_errc(errc);
+	return NULL;
+}
+
+void
+co_gw_bin_destroy(co_gw_bin_t *gw)
+{
+	if (gw) {
+		__co_gw_bin_fini(gw);
+		__co_gw_bin_free(gw);
+	}
+}
+
+int
+co_gw_bin_recv(co_gw_bin_t *gw, const struct co_gw_srv *srv)
+{
+	assert(gw);
+	assert(srv);
+
+	if (co_gw_bin_ring_write(gw->ind, srv) == -1) {
+		gw->lost++;
+		return -1;
+	}
+	gw->pending++;
+
+	// Notify the user immediately of confirmations, but batch indications.
+	if (!co_gw_bin_is_ind(srv->srv) || gw->pending >= gw->batch)
+		co_gw_bin_flush(gw);
+
+	return 0;
+}
+
+void
+co_gw_bin_flush(co_gw_bin_t *gw)
+{
+	assert(gw);
+
+	if (!gw->pending)
+		return;
+	gw->pending = 0;
+
+	if (gw->notify_func)
+		gw->notify_func(gw->notify_data);
+}
+
+size_t
+co_gw_bin_get_batch(const co_gw_bin_t *gw)
+{
+	assert(gw);
+
+	return gw->batch;
+}
+
+void
+co_gw_bin_set_batch(co_gw_bin_t *gw, size_t batch)
+{
+	assert(gw);
+
+	gw->batch = batch;
+	if (gw->pending >= gw->batch)
+		co_gw_bin_flush(gw);
+}
+
+size_t
+co_gw_bin_get_lost(const co_gw_bin_t *gw)
+{
+	assert(gw);
+
+	return gw->lost;
+}
+
+size_t
+co_gw_bin_send(co_gw_bin_t *gw)
+{
+	assert(gw);
+
+	size_t n = 0;
+	const struct co_gw_srv *srv;
+	while ((srv = co_gw_bin_ring_peek(gw->req))) {
+		// Ignore records that are too small to be a request.
+		if (srv->size >= sizeof(struct co_gw_req) && gw->send_func)
+			gw->send_func((const struct co_gw_req *)srv,
+					gw->send_data);
+		co_gw_bin_ring_pop(gw->req);
+		n++;
+	}
+	return n;
+}
+
+void
+co_gw_bin_get_send_func(const co_gw_bin_t *gw, co_gw_bin_send_func_t **pfunc,
+		void **pdata)
+{
+	assert(gw);
+
+	if (pfunc)
+		*pfunc = gw->send_func;
+	if (pdata)
+		*pdata = gw->send_data;
+}
+
+void
+co_gw_bin_set_send_func(
+		co_gw_bin_t *gw, co_gw_bin_send_func_t *func, void *data)
+{
+	assert(gw);
+
+	gw->send_func = func;
+	gw->send_data = data;
+}
+
+void
+co_gw_bin_get_notify_func(const co_gw_bin_t *gw,
+		co_gw_bin_notify_func_t **pfunc, void **pdata)
+{
+	assert(gw);
+
+	if (pfunc)
+		*pfunc = gw->notify_func;
+	if (pdata)
+		*pdata = gw->notify_data;
+}
+
+void
+co_gw_bin_set_notify_func(
+		co_gw_bin_t *gw, co_gw_bin_notify_func_t *func, void *data)
+{
+	assert(gw);
+
+	gw->notify_func = func;
+	gw->notify_data = data;
+}
+
+static int
+co_gw_bin_is_ind(int srv)
+{
+	switch (srv) {
+	case CO_GW_SRV_RPDO:
+	case CO_GW_SRV_EC:
+	case CO_GW_SRV_EMCY:
+	case CO_GW_SRV_SDO:
+	case CO_GW_SRV__SYNC:
+	case CO_GW_SRV__TIME:
+	case CO_GW_SRV__BOOT: return 1;
+	default: return 0;
+	}
+}
+
+#endif // !LELY_NO_CO_GW_BIN
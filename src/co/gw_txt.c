@@ -40,6 +40,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 
 /// A CANopen ASCII gateway.
 struct __co_gw_txt {
@@ -128,9 +129,48 @@ static int co_gw_txt_recv_txt(co_gw_txt_t *gw, const char *txt);
 static size_t co_gw_txt_print_val(char **pbegin, char *end,
 		co_unsigned16_t type, const void *val);
 
+/**
+ * Prints an integer or boolean CANopen value without invoking printf(). The
+ * output is identical to that of co_val_print().
+ *
+ * @returns the number of characters that would have been written, or 0 if
+ * <b>type</b> is not an integer or boolean type.
+ */
+static size_t co_gw_txt_print_int(char **pbegin, char *end,
+		co_unsigned16_t type, const union co_val *val);
+
+/// Prints the sequence number of a confirmation, i.e., "[seq] ".
+static size_t co_gw_txt_print_seq(
+		char **pbegin, char *end, co_unsigned32_t seq);
+
+/// Prints an unsigned integer in decimal notation.
+static size_t co_gw_txt_print_dec(char **pbegin, char *end, uint_least64_t u);
+
+/**
+ * Prints an unsigned integer in hexadecimal notation, including the "0x"
+ * prefix, with at least <b>width</b> digits.
+ */
+static size_t co_gw_txt_print_hex(
+		char **pbegin, char *end, uint_least64_t u, int width);
+
 /// Invokes the callback function to send a request.
 static void co_gw_txt_send_req(co_gw_txt_t *gw, const struct co_gw_req *req);
 
+/**
+ * Parses and sends an 'SDO upload' or 'SDO download' request with an integer or
+ * boolean value in a single pass, without invoking the generic lexers. Only the
+ * common form of these requests is recognized: decimal or hexadecimal numbers,
+ * full or single-character keywords and values within the range of the data
+ * type. Anything else (octal numbers, explicit '+' signs, abbreviations,
+ * out-of-range values, ...) is left to the generic lexers. No diagnostic
+ * messages are generated; if the request is not recognized, nothing is sent.
+ *
+ * @returns the number of characters read, or 0 if the request was not
+ * recognized.
+ */
+static size_t co_gw_txt_send_fast(
+		co_gw_txt_t *gw, const char *begin, const char *end);
+
 /// Sends an 'SDO upload' request after parsing its parameters.
 static size_t co_gw_txt_send_sdo_up(co_gw_txt_t *gw, int srv, void *data,
 		co_unsigned16_t net, co_unsigned8_t node, const char *begin,
@@ -293,6 +333,40 @@ static size_t co_gw_txt_lex_id(const char *begin, const char *end,
 static size_t co_gw_txt_lex_id_sel(const char *begin, const char *end,
 		struct floc *at, struct co_id *plo, struct co_id *phi);
 
+/**
+ * Lexes an unsigned decimal or hexadecimal integer for co_gw_txt_send_fast().
+ *
+ * @returns the number of characters read, or 0 if the integer is not
+ * recognized (e.g., because it is an octal number, is followed by a suffix or
+ * exceeds <b>max</b>).
+ */
+static size_t co_gw_txt_lex_fast_u64(const char *begin, const char *end,
+		uint_least64_t max, uint_least64_t *pu64);
+
+/// Lexes the name of an integer or boolean data type (case-insensitive).
+static size_t co_gw_txt_lex_fast_type(
+		const char *begin, const char *end, co_unsigned16_t *ptype);
+
+/**
+ * Lexes an integer or boolean value of the specified type. Unlike
+ * co_val_lex(), out-of-range values are not clamped, but rejected.
+ */
+static size_t co_gw_txt_lex_fast_val(const char *begin, const char *end,
+		co_unsigned16_t type, union co_val *val);
+
+/**
+ * Returns the number of blank characters at <b>begin</b>. Unlike lex_ctype(),
+ * this function does not keep track of the file location.
+ */
+static size_t co_gw_txt_lex_fast_blank(const char *begin, const char *end);
+
+/**
+ * Returns 1 if <b>cp</b> points to the end of a request parsed by
+ * co_gw_txt_send_fast(), i.e., whitespace, a comment, a line break or the end
+ * of the buffer, and 0 if not.
+ */
+static int co_gw_txt_is_fast_end(const char *cp, const char *end);
+
 void *
 __co_gw_txt_alloc(void)
 {
@@ -526,6 +600,16 @@ co_gw_txt_send(co_gw_txt_t *gw, const char *begin, const char *end,
 	if ((end && cp >= end) || !*cp)
 		goto done;
 
+	// Try the single-pass lexer for SDO requests with integer values first,
+	// since these make up the bulk of (commissioning) scripts. If the
+	// request is not recognized, it is parsed again by the generic lexers.
+	if ((chars = co_gw_txt_send_fast(gw, cp, end))) {
+		if (floc)
+			floc_lex(floc, cp, cp + chars);
+		cp += chars;
+		goto trailer;
+	}
+
 	co_unsigned32_t seq = 0;
 	co_unsigned16_t net = 0;
 	co_unsigned8_t node = 0xff;
@@ -732,6 +816,7 @@ co_gw_txt_send(co_gw_txt_t *gw, const char *begin, const char *end,
 		goto error;
 	cp += chars;
 
+trailer:
 	// Skip trailing whitespace and/or comments.
 	cp += lex_ctype(&isblank, cp, end, floc);
 	cp += lex_line_comment("#", cp, end, floc);
@@ -753,7 +838,28 @@ error:
 	if (iec)
 		gw->iec = iec;
 
-	return floc_lex(at, begin, cp);
+	if (at)
+		floc_lex(at, begin, cp);
+	return cp - begin;
+}
+
+size_t
+co_gw_txt_send_batch(co_gw_txt_t *gw, const char *begin, const char *end,
+		struct floc *at)
+{
+	assert(gw);
+	assert(begin);
+	assert(!end || end >= begin);
+
+	const char *cp = begin;
+	while ((!end || cp < end) && *cp) {
+		size_t chars = co_gw_txt_send(gw, cp, end, at);
+		if (!chars)
+			break;
+		cp += chars;
+	}
+
+	return cp - begin;
 }
 
 void
@@ -866,26 +972,29 @@ co_gw_txt_recv_sdo_up(co_gw_txt_t *gw, co_unsigned32_t seq,
 	if (co_val_read(con->type, &val, bp, bp + con->len) != con->len)
 		co_gw_txt_recv_err(gw, seq, 0, CO_SDO_AC_TYPE_LEN);
 
-	size_t chars = co_gw_txt_print_val(NULL, NULL, con->type, &val);
+	size_t chars = co_gw_txt_print_seq(NULL, NULL, seq)
+			+ co_gw_txt_print_val(NULL, NULL, con->type, &val);
 #if __STDC_NO_VLA__
 	int result = -1;
 	char *buf = malloc(chars + 1);
 	if (buf) {
 		char *cp = buf;
-		co_gw_txt_print_val(&cp, cp + chars, con->type, &val);
+		co_gw_txt_print_seq(&cp, buf + chars, seq);
+		co_gw_txt_print_val(&cp, buf + chars, con->type, &val);
 		*cp = '\0';
 
-		result = co_gw_txt_recv_fmt(gw, "[%" PRIu32 "] %s", seq, buf);
+		result = co_gw_txt_recv_txt(gw, buf);
 
 		free(buf);
 	}
 #else
 	char buf[chars + 1];
 	char *cp = buf;
-	co_gw_txt_print_val(&cp, cp + chars, con->type, &val);
+	co_gw_txt_print_seq(&cp, buf + chars, seq);
+	co_gw_txt_print_val(&cp, buf + chars, con->type, &val);
 	*cp = '\0';
 
-	int result = co_gw_txt_recv_fmt(gw, "[%" PRIu32 "] %s", seq, buf);
+	int result = co_gw_txt_recv_txt(gw, buf);
 #endif
 
 	co_val_fini(con->type, &val);
@@ -1000,7 +1109,15 @@ co_gw_txt_recv_err(co_gw_txt_t *gw, co_unsigned32_t seq, int iec,
 				"[%" PRIu32 "] ERROR: %08" PRIX32 " (%s)", seq,
 				ac, co_sdo_ac2str(ac));
 	} else {
-		return co_gw_txt_recv_fmt(gw, "[%" PRIu32 "] OK", seq);
+		// This is by far the most common confirmation, so avoid the
+		// overhead of co_gw_txt_recv_fmt().
+		char buf[16];
+		char *cp = buf;
+		co_gw_txt_print_seq(&cp, buf + sizeof(buf) - 1, seq);
+		print_char(&cp, buf + sizeof(buf) - 1, 'O');
+		print_char(&cp, buf + sizeof(buf) - 1, 'K');
+		*cp = '\0';
+		return co_gw_txt_recv_txt(gw, buf);
 	}
 }
 
@@ -1189,8 +1306,100 @@ co_gw_txt_print_val(
 	case CO_DEFTYPE_OCTET_STRING:
 		return co_val_print(CO_DEFTYPE_DOMAIN, val, pbegin, end);
 	case CO_DEFTYPE_REAL64: return print_c99_dbl(pbegin, end, u->r64);
-	default: return co_val_print(type, val, pbegin, end);
+	default: {
+		size_t chars = co_gw_txt_print_int(pbegin, end, type, u);
+		return chars ? chars : co_val_print(type, val, pbegin, end);
 	}
+	}
+}
+
+static size_t
+co_gw_txt_print_int(char **pbegin, char *end, co_unsigned16_t type,
+		const union co_val *val)
+{
+	assert(val);
+
+	int_least64_t i = 0;
+	switch (type) {
+	case CO_DEFTYPE_BOOLEAN: return print_char(pbegin, end, '0' + !!val->b);
+	case CO_DEFTYPE_INTEGER8: i = val->i8; break;
+	case CO_DEFTYPE_INTEGER16: i = val->i16; break;
+	case CO_DEFTYPE_INTEGER24: i = val->i24; break;
+	case CO_DEFTYPE_INTEGER32: i = val->i32; break;
+	case CO_DEFTYPE_INTEGER40: i = val->i40; break;
+	case CO_DEFTYPE_INTEGER48: i = val->i48; break;
+	case CO_DEFTYPE_INTEGER56: i = val->i56; break;
+	case CO_DEFTYPE_INTEGER64: i = val->i64; break;
+	case CO_DEFTYPE_UNSIGNED8:
+		return co_gw_txt_print_hex(pbegin, end, val->u8, 2);
+	case CO_DEFTYPE_UNSIGNED16:
+		return co_gw_txt_print_hex(pbegin, end, val->u16, 4);
+	case CO_DEFTYPE_UNSIGNED24:
+		return co_gw_txt_print_hex(pbegin, end, val->u24, 6);
+	case CO_DEFTYPE_UNSIGNED32:
+		return co_gw_txt_print_hex(pbegin, end, val->u32, 8);
+	case CO_DEFTYPE_UNSIGNED40:
+		return co_gw_txt_print_hex(pbegin, end, val->u40, 10);
+	case CO_DEFTYPE_UNSIGNED48:
+		return co_gw_txt_print_hex(pbegin, end, val->u48, 12);
+	case CO_DEFTYPE_UNSIGNED56:
+		return co_gw_txt_print_hex(pbegin, end, val->u56, 14);
+	case CO_DEFTYPE_UNSIGNED64:
+		return co_gw_txt_print_hex(pbegin, end, val->u64, 16);
+	default: return 0;
+	}
+
+	if (i < 0) {
+		size_t chars = print_char(pbegin, end, '-');
+		// Avoid overflow when negating INT64_MIN.
+		uint_least64_t u = (uint_least64_t)-(i + 1) + 1;
+		return chars + co_gw_txt_print_dec(pbegin, end, u);
+	}
+	return co_gw_txt_print_dec(pbegin, end, i);
+}
+
+static size_t
+co_gw_txt_print_seq(char **pbegin, char *end, co_unsigned32_t seq)
+{
+	size_t chars = 0;
+	chars += print_char(pbegin, end, '[');
+	chars += co_gw_txt_print_dec(pbegin, end, seq);
+	chars += print_char(pbegin, end, ']');
+	chars += print_char(pbegin, end, ' ');
+	return chars;
+}
+
+static size_t
+co_gw_txt_print_dec(char **pbegin, char *end, uint_least64_t u)
+{
+	// Generate the digits in reverse order.
+	char buf[20];
+	char *cp = buf + sizeof(buf);
+	do
+		*--cp = '0' + u % 10;
+	while (u /= 10);
+
+	size_t chars = 0;
+	while (cp < buf + sizeof(buf))
+		chars += print_char(pbegin, end, *cp++);
+	return chars;
+}
+
+static size_t
+co_gw_txt_print_hex(char **pbegin, char *end, uint_least64_t u, int width)
+{
+	int n = 1;
+	while (n < 16 && u >> (4 * n))
+		n++;
+	if (n < width)
+		n = width;
+
+	size_t chars = 0;
+	chars += print_char(pbegin, end, '0');
+	chars += print_char(pbegin, end, 'x');
+	while (n--)
+		chars += print_char(pbegin, end, xtoc((int)(u >> (4 * n))));
+	return chars;
 }
 
 static size_t
@@ -2147,6 +2356,149 @@ co_gw_txt_send_req(co_gw_txt_t *gw, const struct co_gw_req *req)
 	}
 }
 
+static size_t
+co_gw_txt_send_fast(co_gw_txt_t *gw, const char *begin, const char *end)
+{
+	assert(begin);
+	assert(!end || end >= begin);
+
+	const char *cp = begin;
+	size_t chars = 0;
+
+	uint_least64_t seq = 0;
+	if ((end && cp >= end) || *cp != '[')
+		return 0;
+	cp++;
+	cp += co_gw_txt_lex_fast_blank(cp, end);
+	if (!(chars = co_gw_txt_lex_fast_u64(cp, end, CO_UNSIGNED32_MAX, &seq)))
+		return 0;
+	cp += chars;
+	cp += co_gw_txt_lex_fast_blank(cp, end);
+	if ((end && cp >= end) || *cp != ']')
+		return 0;
+	cp++;
+	cp += co_gw_txt_lex_fast_blank(cp, end);
+	void *data = (void *)(uintptr_t)seq;
+
+	// Parse the optional network-ID and node-ID.
+	uint_least64_t id[2] = { 0, 0 };
+	int nid = 0;
+	for (; nid < 2; nid++) {
+		chars = co_gw_txt_lex_fast_u64(
+				cp, end, CO_UNSIGNED16_MAX, &id[nid]);
+		if (!chars)
+			break;
+		cp += chars;
+		if (!(chars = co_gw_txt_lex_fast_blank(cp, end)))
+			return 0;
+		cp += chars;
+	}
+	co_unsigned16_t net = 0;
+	co_unsigned8_t node = 0xff;
+	if (nid == 2) {
+		if (!id[0] || id[0] > CO_GW_NUM_NET || id[1] > CO_NUM_NODES)
+			return 0;
+		net = (co_unsigned16_t)id[0];
+		node = (co_unsigned8_t)id[1];
+	} else if (nid == 1) {
+		// If only a single ID was provided, it is the node-ID.
+		if (id[0] > CO_NUM_NODES)
+			return 0;
+		node = (co_unsigned8_t)id[0];
+	}
+
+	// Only the full and single-character forms of 'r[ead]' and 'w[rite]'
+	// are recognized.
+	int srv = 0;
+	chars = co_gw_txt_lex_cmd(cp, end, NULL);
+	if ((chars == 1 && (*cp == 'r' || *cp == 'R'))
+			|| (chars == 4 && !strncasecmp("read", cp, chars)))
+		srv = CO_GW_SRV_SDO_UP;
+	else if ((chars == 1 && (*cp == 'w' || *cp == 'W'))
+			|| (chars == 5 && !strncasecmp("write", cp, chars)))
+		srv = CO_GW_SRV_SDO_DN;
+	else
+		return 0;
+	cp += chars;
+	if (!(chars = co_gw_txt_lex_fast_blank(cp, end)))
+		return 0;
+	cp += chars;
+
+	uint_least64_t idx = 0;
+	if (!(chars = co_gw_txt_lex_fast_u64(cp, end, CO_UNSIGNED16_MAX, &idx)))
+		return 0;
+	cp += chars;
+	if (!(chars = co_gw_txt_lex_fast_blank(cp, end)))
+		return 0;
+	cp += chars;
+
+	uint_least64_t subidx = 0;
+	chars = co_gw_txt_lex_fast_u64(cp, end, CO_UNSIGNED8_MAX, &subidx);
+	if (!chars)
+		return 0;
+	cp += chars;
+	if (!(chars = co_gw_txt_lex_fast_blank(cp, end)))
+		return 0;
+	cp += chars;
+
+	co_unsigned16_t type = 0;
+	if (!(chars = co_gw_txt_lex_fast_type(cp, end, &type)))
+		return 0;
+	cp += chars;
+
+	if (srv == CO_GW_SRV_SDO_UP) {
+		if (!co_gw_txt_is_fast_end(cp, end))
+			return 0;
+
+		struct co_gw_req_sdo_up req = { .size = sizeof(req),
+			.srv = srv,
+			.data = data,
+			.net = net,
+			.node = node,
+			.idx = (co_unsigned16_t)idx,
+			.subidx = (co_unsigned8_t)subidx,
+			.type = type };
+		co_gw_txt_send_req(gw, (struct co_gw_req *)&req);
+
+		return cp - begin;
+	}
+
+	if (!(chars = co_gw_txt_lex_fast_blank(cp, end)))
+		return 0;
+	cp += chars;
+
+	union co_val val;
+	if (!(chars = co_gw_txt_lex_fast_val(cp, end, type, &val)))
+		return 0;
+	cp += chars;
+	if (!co_gw_txt_is_fast_end(cp, end))
+		return 0;
+
+	// Integer values never exceed 8 bytes, so the request can be
+	// constructed on the stack.
+	union {
+		struct co_gw_req_sdo_dn req;
+		uint_least8_t buf[CO_GW_REQ_SDO_DN_SIZE
+				+ sizeof(co_unsigned64_t)];
+	} u;
+	size_t n = co_val_write(type, &val, NULL, NULL);
+	assert(n <= sizeof(co_unsigned64_t));
+	size_t size = MAX(CO_GW_REQ_SDO_DN_SIZE + n, sizeof(u.req));
+	u.req = (struct co_gw_req_sdo_dn){ .size = size,
+		.srv = srv,
+		.data = data,
+		.net = net,
+		.node = node,
+		.idx = (co_unsigned16_t)idx,
+		.subidx = (co_unsigned8_t)subidx,
+		.len = n };
+	uint_least8_t *bp = u.buf + CO_GW_REQ_SDO_DN_SIZE;
+	co_val_write(type, &val, bp, bp + n);
+	co_gw_txt_send_req(gw, (struct co_gw_req *)&u.req);
+
+	return cp - begin;
+}
+
 static size_t
 co_gw_txt_lex_prefix(const char *begin, const char *end, struct floc *at,
 		co_unsigned32_t *pseq, co_unsigned16_t *pnet,
@@ -2958,4 +3310,218 @@ co_gw_txt_lex_id_sel(const char *begin, const char *end, struct floc *at,
 	return cp - begin;
 }
 
+static size_t
+co_gw_txt_lex_fast_u64(const char *begin, const char *end, uint_least64_t max,
+		uint_least64_t *pu64)
+{
+	assert(begin);
+
+	const char *cp = begin;
+
+	if ((end && cp >= end) || !isdigit((unsigned char)*cp))
+		return 0;
+
+	uint_least64_t u64 = 0;
+	if (*cp == '0' && (!end || end - cp >= 2)
+			&& (cp[1] == 'x' || cp[1] == 'X')) {
+		cp += 2;
+		const char *digits = cp;
+		while ((!end || cp < end) && isxdigit((unsigned char)*cp)) {
+			uint_least64_t d = ctox((unsigned char)*cp++);
+			if (d > max || u64 > (max - d) / 16)
+				return 0;
+			u64 = u64 * 16 + d;
+		}
+		if (cp == digits)
+			return 0;
+	} else if (*cp == '0') {
+		cp++;
+	} else {
+		while ((!end || cp < end) && isdigit((unsigned char)*cp)) {
+			uint_least64_t d = *cp++ - '0';
+			if (d > max || u64 > (max - d) / 10)
+				return 0;
+			u64 = u64 * 10 + d;
+		}
+	}
+
+	// Reject octal numbers and numbers with suffixes (or exponents).
+	if ((!end || cp < end)
+			&& (isalnum((unsigned char)*cp) || *cp == '_'
+					|| *cp == '.'))
+		return 0;
+
+	if (pu64)
+		*pu64 = u64;
+
+	return cp - begin;
+}
+
+static size_t
+co_gw_txt_lex_fast_type(
+		const char *begin, const char *end, co_unsigned16_t *ptype)
+{
+	static const struct {
+		const char *name;
+		co_unsigned16_t type;
+	} types[] = {
+		// clang-format off
+		{ "b", CO_DEFTYPE_BOOLEAN },
+		{ "i8", CO_DEFTYPE_INTEGER8 },
+		{ "i16", CO_DEFTYPE_INTEGER16 },
+		{ "i24", CO_DEFTYPE_INTEGER24 },
+		{ "i32", CO_DEFTYPE_INTEGER32 },
+		{ "i40", CO_DEFTYPE_INTEGER40 },
+		{ "i48", CO_DEFTYPE_INTEGER48 },
+		{ "i56", CO_DEFTYPE_INTEGER56 },
+		{ "i64", CO_DEFTYPE_INTEGER64 },
+		{ "u8", CO_DEFTYPE_UNSIGNED8 },
+		{ "u16", CO_DEFTYPE_UNSIGNED16 },
+		{ "u24", CO_DEFTYPE_UNSIGNED24 },
+		{ "u32", CO_DEFTYPE_UNSIGNED32 },
+		{ "u40", CO_DEFTYPE_UNSIGNED40 },
+		{ "u48", CO_DEFTYPE_UNSIGNED48 },
+		{ "u56", CO_DEFTYPE_UNSIGNED56 },
+		{ "u64", CO_DEFTYPE_UNSIGNED64 }
+		// clang-format on
+	};
+
+	size_t chars = co_gw_txt_lex_cmd(begin, end, NULL);
+	if (!chars || chars > 3)
+		return 0;
+
+	int c = tolower((unsigned char)*begin);
+	for (size_t i = 0; i < sizeof(types) / sizeof(*types); i++) {
+		// Only accept exact (case-insensitive) matches.
+		if (types[i].name[0] == c && strlen(types[i].name) == chars
+				&& !strncasecmp(types[i].name, begin, chars)) {
+			if (ptype)
+				*ptype = types[i].type;
+			return chars;
+		}
+	}
+
+	return 0;
+}
+
+static size_t
+co_gw_txt_lex_fast_val(const char *begin, const char *end,
+		co_unsigned16_t type, union co_val *val)
+{
+	assert(begin);
+	assert(val);
+
+	int_least64_t min = 0;
+	uint_least64_t max = 0;
+	switch (type) {
+	case CO_DEFTYPE_BOOLEAN: max = CO_BOOLEAN_MAX; break;
+	case CO_DEFTYPE_INTEGER8:
+		min = CO_INTEGER8_MIN;
+		max = CO_INTEGER8_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER16:
+		min = CO_INTEGER16_MIN;
+		max = CO_INTEGER16_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER24:
+		min = CO_INTEGER24_MIN;
+		max = CO_INTEGER24_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER32:
+		min = CO_INTEGER32_MIN;
+		max = CO_INTEGER32_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER40:
+		min = CO_INTEGER40_MIN;
+		max = CO_INTEGER40_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER48:
+		min = CO_INTEGER48_MIN;
+		max = CO_INTEGER48_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER56:
+		min = CO_INTEGER56_MIN;
+		max = CO_INTEGER56_MAX;
+		break;
+	case CO_DEFTYPE_INTEGER64:
+		min = CO_INTEGER64_MIN;
+		max = CO_INTEGER64_MAX;
+		break;
+	case CO_DEFTYPE_UNSIGNED8: max = CO_UNSIGNED8_MAX; break;
+	case CO_DEFTYPE_UNSIGNED16: max = CO_UNSIGNED16_MAX; break;
+	case CO_DEFTYPE_UNSIGNED24: max = CO_UNSIGNED24_MAX; break;
+	case CO_DEFTYPE_UNSIGNED32: max = CO_UNSIGNED32_MAX; break;
+	case CO_DEFTYPE_UNSIGNED40: max = CO_UNSIGNED40_MAX; break;
+	case CO_DEFTYPE_UNSIGNED48: max = CO_UNSIGNED48_MAX; break;
+	case CO_DEFTYPE_UNSIGNED56: max = CO_UNSIGNED56_MAX; break;
+	case CO_DEFTYPE_UNSIGNED64: max = CO_UNSIGNED64_MAX; break;
+	default: return 0;
+	}
+
+	const char *cp = begin;
+	size_t chars = 0;
+
+	// Only signed integers can be negative.
+	int neg = min && (!end || cp < end) && *cp == '-';
+	if (neg)
+		cp++;
+
+	uint_least64_t u = 0;
+	// The magnitude of the minimum value is one more than the maximum.
+	chars = co_gw_txt_lex_fast_u64(cp, end, neg ? max + 1 : max, &u);
+	if (!chars)
+		return 0;
+	cp += chars;
+
+	// Avoid overflow when negating the magnitude of INT64_MIN. The value of
+	// i is only used for signed integers, which do not exceed INT64_MAX.
+	int_least64_t i = neg && u ? -(int_least64_t)(u - 1) - 1
+				   : (int_least64_t)(u & INT64_MAX);
+
+	switch (type) {
+	case CO_DEFTYPE_BOOLEAN: val->b = !!u; break;
+	case CO_DEFTYPE_INTEGER8: val->i8 = (co_integer8_t)i; break;
+	case CO_DEFTYPE_INTEGER16: val->i16 = (co_integer16_t)i; break;
+	case CO_DEFTYPE_INTEGER24: val->i24 = (co_integer24_t)i; break;
+	case CO_DEFTYPE_INTEGER32: val->i32 = (co_integer32_t)i; break;
+	case CO_DEFTYPE_INTEGER40: val->i40 = i; break;
+	case CO_DEFTYPE_INTEGER48: val->i48 = i; break;
+	case CO_DEFTYPE_INTEGER56: val->i56 = i; break;
+	case CO_DEFTYPE_INTEGER64: val->i64 = i; break;
+	case CO_DEFTYPE_UNSIGNED8: val->u8 = (co_unsigned8_t)u; break;
+	case CO_DEFTYPE_UNSIGNED16: val->u16 = (co_unsigned16_t)u; break;
+	case CO_DEFTYPE_UNSIGNED24: val->u24 = (co_unsigned24_t)u; break;
+	case CO_DEFTYPE_UNSIGNED32: val->u32 = (co_unsigned32_t)u; break;
+	case CO_DEFTYPE_UNSIGNED40: val->u40 = u; break;
+	case CO_DEFTYPE_UNSIGNED48: val->u48 = u; break;
+	case CO_DEFTYPE_UNSIGNED56: val->u56 = u; break;
+	case CO_DEFTYPE_UNSIGNED64: val->u64 = u; break;
+	}
+
+	return cp - begin;
+}
+
+static size_t
+co_gw_txt_lex_fast_blank(const char *begin, const char *end)
+{
+	assert(begin);
+
+	const char *cp = begin;
+	while ((!end || cp < end) && isblank((unsigned char)*cp))
+		cp++;
+	return cp - begin;
+}
+
+static int
+co_gw_txt_is_fast_end(const char *cp, const char *end)
+{
+	assert(cp);
+
+	if ((end && cp >= end) || !*cp)
+		return 1;
+
+	return isblank((unsigned char)*cp) || isbreak((unsigned char)*cp)
+			|| *cp == '#';
+}
+
 #endif // !LELY_NO_CO_GW_TXT
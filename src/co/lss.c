@@ -29,11 +29,14 @@
 #include <lely/co/nmt.h>
 #include <lely/co/obj.h>
 #include <lely/co/val.h>
+#include <lely/util/bits.h>
+#include <lely/util/diag.h>
 #include <lely/util/endian.h>
 #include <lely/util/errnum.h>
 #include <lely/util/time.h>
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdlib.h>
 
 struct __co_lss_state;
@@ -94,6 +97,52 @@ struct __co_lss {
 	co_unsigned8_t nid;
 	/// The LSS address obtained from the LSS Slowscan or Fastscan service.
 	struct co_id id;
+	/**
+	 * The LSS numbers restricted to the expected values in objects
+	 * 1F85..1F88 during the discovery service (bit <b>i</b> for LSS number
+	 * <b>i</b>).
+	 */
+	co_unsigned8_t disc_cand;
+	/**
+	 * The node-ID of the slave whose expected value is currently being
+	 * checked, for each restricted LSS number.
+	 */
+	co_unsigned8_t disc_nid[4];
+	/**
+	 * The bits for which the 1-branch still has to be checked during the
+	 * discovery service, for each LSS number.
+	 */
+	co_unsigned32_t disc_pend[4];
+	/// The type of the pending Fastscan request of the discovery service.
+	int disc_probe;
+	/**
+	 * The type of the Fastscan request to be sent once the discovery service
+	 * has re-synchronized the slaves.
+	 */
+	int disc_resume;
+	/// The index of the next re-synchronization request.
+	co_unsigned8_t disc_sync;
+	/// A flag indicating whether a slave responded to the pending request.
+	int disc_resp;
+	/**
+	 * A flag indicating whether the discovery service detected a late
+	 * response and fell back to the LSS timeout.
+	 */
+	int disc_fixed;
+	/// The time at which the pending Fastscan request was sent.
+	struct timespec disc_sent;
+	/// The time at which the discovery service was started.
+	struct timespec disc_start;
+	/// The LSS addresses found by the discovery service.
+	struct co_id disc_ids[CO_NUM_NODES];
+	/// The index of the next LSS address to be assigned a node-ID.
+	int disc_next;
+	/// The node-ID being assigned by the discovery service.
+	co_unsigned8_t disc_id;
+	/// The node-IDs assigned during the current discovery session.
+	co_unsigned32_t disc_taken[4];
+	/// The statistics of the current discovery session.
+	struct co_lss_discover_stats disc_stats;
 #endif
 	/// A pointer to the 'activate bit timing' indication function.
 	co_lss_rate_ind_t *rate_ind;
@@ -124,6 +173,12 @@ struct __co_lss {
 	co_lss_scan_ind_t *scan_ind;
 	/// A pointer to user-specified data for #scan_ind.
 	void *scan_data;
+	/// A pointer to the discovery indication function.
+	co_lss_discover_ind_t *disc_ind;
+	/// A pointer to the discovery confirmation function.
+	co_lss_discover_con_t *disc_con;
+	/// A pointer to user-specified data for #disc_ind and #disc_con.
+	void *disc_data;
 #endif
 };
 
@@ -532,6 +587,39 @@ LELY_CO_DEFINE_STATE(co_lss_fastscan_fini_state,
 )
 // clang-format on
 
+/// The 'CAN frame received' transition function of the discovery scan state.
+static co_lss_state_t *co_lss_discover_scan_on_recv(
+		co_lss_t *lss, const struct can_msg *msg);
+
+/// The 'timeout' transition function of the discovery scan state.
+static co_lss_state_t *co_lss_discover_scan_on_time(
+		co_lss_t *lss, const struct timespec *tp);
+
+/// The discovery scan state.
+// clang-format off
+LELY_CO_DEFINE_STATE(co_lss_discover_scan_state,
+	.on_recv = &co_lss_discover_scan_on_recv,
+	.on_time = &co_lss_discover_scan_on_time
+)
+// clang-format on
+
+/// The entry function of the discovery assignment state.
+static co_lss_state_t *co_lss_discover_next_on_enter(co_lss_t *lss);
+
+/**
+ * The exit function of the discovery assignment state. This function assigns
+ * a node-ID to the next LSS address found during the scan.
+ */
+static void co_lss_discover_next_on_leave(co_lss_t *lss);
+
+/// The discovery assignment state.
+// clang-format off
+LELY_CO_DEFINE_STATE(co_lss_discover_next_state,
+	.on_enter = &co_lss_discover_next_on_enter,
+	.on_leave = &co_lss_discover_next_on_leave
+)
+// clang-format on
+
 #endif // !LELY_NO_CO_MASTER
 
 #undef LELY_CO_DEFINE_STATE
@@ -648,6 +736,117 @@ static int co_lss_send_fastscan_req(const co_lss_t *lss, co_unsigned32_t id,
  */
 static void co_lss_init_ind(co_lss_t *lss, co_unsigned8_t cs);
 
+/// The types of Fastscan requests sent by the LSS discovery service.
+enum co_lss_disc_probe {
+	/// The reset request, to which all slaves in the waiting state respond.
+	CO_LSS_DISC_RESET,
+	/// Checks if a slave matches with the current bit set to 0.
+	CO_LSS_DISC_BIT0,
+	/// Checks if a slave matches with the current bit set to 1.
+	CO_LSS_DISC_BIT1,
+	/// Checks if a slave matches the complete LSS number.
+	CO_LSS_DISC_NUMBER,
+	/**
+	 * Re-synchronizes the LSSPos value of the slaves with the current
+	 * prefix of the LSS address. This is necessary after backtracking to a
+	 * previous LSS number, since the slaves matching the earlier prefix may
+	 * still respond to requests for the later LSS numbers.
+	 */
+	CO_LSS_DISC_SYNC,
+	/**
+	 * Waits, without sending a request, until the LSS timeout of the last
+	 * request has elapsed, before a complete LSS number is verified. A
+	 * response received in the meantime arrived after the (adaptive)
+	 * timeout of its request and may have been attributed to the wrong one.
+	 */
+	CO_LSS_DISC_GUARD
+};
+
+/**
+ * Prepares the LSS discovery service to check the specified LSS number.
+ *
+ * @param lss a pointer to an LSS master service.
+ * @param sub the index of the LSS number (in the range [0..3]).
+ *
+ * @returns the type of the next Fastscan request (see #co_lss_disc_probe).
+ */
+static int co_lss_discover_enter(co_lss_t *lss, co_unsigned8_t sub);
+
+/**
+ * Records the LSS address found by the discovery service and backtracks to
+ * the next unchecked branch.
+ *
+ * @returns the type of the next Fastscan request, or -1 if the scan is
+ * complete.
+ */
+static int co_lss_discover_found(co_lss_t *lss);
+
+/**
+ * Backtracks the LSS discovery service to the next unchecked branch.
+ *
+ * @returns the type of the next Fastscan request, or -1 if the scan is
+ * complete.
+ */
+static int co_lss_discover_back(co_lss_t *lss);
+
+/**
+ * Restarts the search of the current LSS number of the discovery service with
+ * the LSS timeout after a late response was detected.
+ *
+ * @returns the type of the next Fastscan request (see #co_lss_disc_probe).
+ */
+static int co_lss_discover_retry(co_lss_t *lss);
+
+/**
+ * Sends the next Fastscan request of the LSS discovery service and starts the
+ * (adaptive) timeout.
+ *
+ * @param lss   a pointer to an LSS master service.
+ * @param probe the type of the request (see #co_lss_disc_probe).
+ *
+ * @returns 0 on success, or -1 on error.
+ */
+static int co_lss_discover_send(co_lss_t *lss, int probe);
+
+/**
+ * Returns 1 if the specified node is a slave in the network list of an LSS
+ * master, and 0 if not.
+ */
+static int co_lss_discover_is_slave(const co_lss_t *lss, co_unsigned8_t id);
+
+/**
+ * Returns the node-ID of the next slave with a distinct, non-zero expected
+ * value for the specified LSS number, starting at node-ID <b>id</b>, or 0 if
+ * no such slave exists.
+ */
+static co_unsigned8_t co_lss_discover_next_cand(
+		const co_lss_t *lss, co_unsigned8_t sub, co_unsigned8_t id);
+
+/**
+ * Returns the first node-ID in the network list of an LSS master that has not
+ * yet been assigned during the current discovery session and whose expected
+ * identity matches the specified LSS address, or 255 if none was found.
+ */
+static co_unsigned8_t co_lss_discover_get_nid(
+		const co_lss_t *lss, const struct co_id *id);
+
+/// Assigns a node-ID to the next LSS address found by the discovery service.
+static void co_lss_discover_next(co_lss_t *lss);
+
+/**
+ * The 'switch state selective' indication function of the LSS discovery
+ * service. @see co_lss_cs_ind_t
+ */
+static void co_lss_discover_cs_ind(
+		co_lss_t *lss, co_unsigned8_t cs, void *data);
+
+/**
+ * The 'configure node-ID' indication function of the LSS discovery service.
+ * @see co_lss_err_ind_t
+ */
+static void co_lss_discover_err_ind(co_lss_t *lss, co_unsigned8_t cs,
+		co_unsigned8_t err, co_unsigned8_t spec, void *data);
+
 /**
  * Returns a pointer to the specified number in an LSS address.
  *
@@ -728,6 +927,23 @@ __co_lss_init(struct __co_lss *lss, co_nmt_t *nmt)
 	lss->lssid = 0;
 	lss->nid = 0;
 	lss->id = (struct co_id)CO_ID_INIT;
+	lss->disc_cand = 0;
+	for (int i = 0; i < 4; i++) {
+		lss->disc_nid[i] = 0;
+		lss->disc_pend[i] = 0;
+		lss->disc_taken[i] = 0;
+	}
+	lss->disc_probe = CO_LSS_DISC_RESET;
+	lss->disc_resume = CO_LSS_DISC_RESET;
+	lss->disc_sync = 0;
+	lss->disc_resp = 0;
+	lss->disc_fixed = 0;
+	lss->disc_sent = (struct timespec){ 0, 0 };
+	lss->disc_start = (struct timespec){ 0, 0 };
+	lss->disc_next = 0;
+	lss->disc_id = 0xff;
+	lss->disc_stats = (struct co_lss_discover_stats)
+			CO_LSS_DISCOVER_STATS_INIT;
 #endif
 
 	lss->rate_ind = NULL;
@@ -745,6 +961,9 @@ __co_lss_init(struct __co_lss *lss, co_nmt_t *nmt)
 	lss->nid_data = NULL;
 	lss->scan_ind = NULL;
 	lss->scan_data = NULL;
+	lss->disc_ind = NULL;
+	lss->disc_con = NULL;
+	lss->disc_data = NULL;
 #endif
 
 	if (co_lss_start(lss) == -1) {
@@ -1406,6 +1625,69 @@ co_lss_fastscan_req(co_lss_t *lss, const struct co_id *id,
 	return 0;
 }
 
+int
+co_lss_discover_req(co_lss_t *lss, int prune, co_lss_discover_ind_t *ind,
+		co_lss_discover_con_t *con, void *data)
+{
+	if (!co_lss_is_master(lss) || !co_lss_is_idle(lss)) {
+		set_errnum(ERRNUM_PERM);
+		return -1;
+	}
+
+	trace("LSS: discovery");
+
+	// An LSS number can only be restricted to the expected values if all
+	// slaves in the network list specify one.
+	lss->disc_cand = 0;
+	for (co_unsigned8_t sub = 0; prune && sub < 4; sub++) {
+		int n = 0;
+		for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+			if (!co_lss_discover_is_slave(lss, id))
+				continue;
+			if (!co_dev_get_val_u32(lss->dev, 0x1f85 + sub, id)) {
+				n = 0;
+				break;
+			}
+			n++;
+		}
+		if (n)
+			lss->disc_cand |= 1u << sub;
+	}
+
+	for (int i = 0; i < 4; i++) {
+		lss->disc_nid[i] = 0;
+		lss->disc_pend[i] = 0;
+		lss->disc_taken[i] = 0;
+	}
+	lss->disc_fixed = 0;
+	lss->disc_next = 0;
+	lss->disc_id = 0xff;
+	lss->disc_stats = (struct co_lss_discover_stats)
+			CO_LSS_DISCOVER_STATS_INIT;
+	can_net_get_time(lss->net, &lss->disc_start);
+
+	lss->id = (struct co_id)CO_ID_INIT;
+	lss->bitchk = 0x80;
+	lss->lsssub = 0;
+
+	lss->cs = 0x4f;
+	can_recv_start(lss->recv, lss->net, CO_LSS_CANID(0), 0);
+	if (co_lss_discover_send(lss, CO_LSS_DISC_RESET) == -1) {
+		int errc = get_errc();
+		can_recv_stop(lss->recv);
+		lss->cs = 0;
+		set_errc(errc);
+		return -1;
+	}
+
+	lss->disc_ind = ind;
+	lss->disc_con = con;
+	lss->disc_data = data;
+	co_lss_enter(lss, co_lss_discover_scan_state);
+
+	return 0;
+}
+
 #endif // !LELY_NO_CO_MASTER
 
 static int
@@ -2341,6 +2623,146 @@ co_lss_fastscan_fini_on_leave(co_lss_t *lss)
 				lss->scan_data);
 }
 
+static co_lss_state_t *
+co_lss_discover_scan_on_recv(co_lss_t *lss, const struct can_msg *msg)
+{
+	assert(lss);
+	assert(msg);
+
+	if (msg->len < 1 || msg->data[0] != lss->cs)
+		return NULL;
+
+	// Only the first response is used to measure the latency; the other
+	// slaves matching the same request respond at the same time.
+	if (!lss->disc_resp) {
+		lss->disc_resp = 1;
+		struct timespec now = { 0, 0 };
+		can_net_get_time(lss->net, &now);
+		int_least64_t usec = timespec_diff_usec(&now, &lss->disc_sent);
+		if (usec > 0 && (uint_least64_t)usec > lss->disc_stats.latency)
+			lss->disc_stats.latency = usec;
+	}
+
+	// Wait until the timeout expires before handling the response.
+	return NULL;
+}
+
+static co_lss_state_t *
+co_lss_discover_scan_on_time(co_lss_t *lss, const struct timespec *tp)
+{
+	assert(lss);
+	assert(lss->lsssub < 4);
+	(void)tp;
+
+	co_unsigned8_t sub = lss->lsssub;
+	co_unsigned32_t *pid = co_id_sub(&lss->id, sub);
+	assert(pid);
+
+	int probe = -1;
+	switch (lss->disc_probe) {
+	case CO_LSS_DISC_RESET:
+		// We're done if no slave is in the waiting state.
+		if (lss->disc_resp)
+			probe = co_lss_discover_enter(lss, 0);
+		break;
+	case CO_LSS_DISC_BIT0:
+	case CO_LSS_DISC_BIT1:
+		assert(lss->bitchk <= 31);
+		if (lss->disc_probe == CO_LSS_DISC_BIT0) {
+			if (lss->disc_resp) {
+				// Check the 1-branch after the 0-branch.
+				lss->disc_pend[lss->lsssub] |= UINT32_C(1)
+						<< lss->bitchk;
+			} else {
+				// Since at least one slave matches the bits
+				// checked so far, a timeout indicates the bit
+				// is 1.
+				*pid |= UINT32_C(1) << lss->bitchk;
+			}
+		} else if (!lss->disc_resp) {
+			// The slaves in this branch were identified earlier.
+			probe = co_lss_discover_back(lss);
+			break;
+		}
+		if (lss->bitchk) {
+			lss->bitchk--;
+			probe = CO_LSS_DISC_BIT0;
+		} else if (lss->disc_stats.timeout
+				< (uint_least64_t)lss->timeout * 1000) {
+			// Make sure no late response can be mistaken for a
+			// response to the verification of the LSS number.
+			probe = CO_LSS_DISC_GUARD;
+		} else {
+			// Verify the complete LSS number. This also lets the
+			// matching slaves proceed to the next one.
+			probe = CO_LSS_DISC_NUMBER;
+		}
+		break;
+	case CO_LSS_DISC_GUARD:
+		if (lss->disc_resp)
+			probe = co_lss_discover_retry(lss);
+		else
+			probe = CO_LSS_DISC_NUMBER;
+		break;
+	case CO_LSS_DISC_NUMBER:
+		if (!lss->disc_resp && !(lss->disc_cand & (1u << sub))
+				&& !lss->disc_fixed) {
+			// At least one slave matches the bits found for this
+			// LSS number, unless one of them was derived from a
+			// late response.
+			probe = co_lss_discover_retry(lss);
+		} else if (!lss->disc_resp)
+			probe = co_lss_discover_back(lss);
+		else if (lss->lsssub < 3)
+			probe = co_lss_discover_enter(lss, lss->lsssub + 1);
+		else
+			probe = co_lss_discover_found(lss);
+		break;
+	case CO_LSS_DISC_SYNC:
+		// Send the postponed request once the LSSPos value of all
+		// slaves matches the current LSS number.
+		if (lss->disc_sync > lss->lsssub)
+			probe = lss->disc_resume;
+		else
+			probe = CO_LSS_DISC_SYNC;
+		break;
+	}
+
+	if (probe != -1 && lss->lsssub < sub) {
+		// Start by resetting all slaves before sending the next request
+		// in the new branch.
+		lss->disc_resume = probe;
+		lss->disc_sync = 0;
+		probe = CO_LSS_DISC_SYNC;
+	}
+
+	if (probe != -1 && !co_lss_discover_send(lss, probe))
+		return NULL;
+
+	struct timespec now = { 0, 0 };
+	can_net_get_time(lss->net, &now);
+	lss->disc_stats.scan_time =
+			timespec_diff_usec(&now, &lss->disc_start);
+
+	can_timer_stop(lss->timer);
+	can_recv_stop(lss->recv);
+	return co_lss_discover_next_state;
+}
+
+static co_lss_state_t *
+co_lss_discover_next_on_enter(co_lss_t *lss)
+{
+	(void)lss;
+
+	return co_lss_wait_state;
+}
+
+static void
+co_lss_discover_next_on_leave(co_lss_t *lss)
+{
+	co_lss_discover_next(lss);
+}
+
 #endif // !LELY_NO_CO_MASTER
 
 static co_lss_state_t *
@@ -2658,6 +3080,318 @@ co_lss_init_ind(co_lss_t *lss, co_unsigned8_t cs)
 	can_timer_timeout(lss->timer, lss->net, lss->timeout);
 }
 
+static int
+co_lss_discover_enter(co_lss_t *lss, co_unsigned8_t sub)
+{
+	assert(lss);
+	assert(sub < 4);
+
+	lss->lsssub = sub;
+	co_unsigned32_t *pid = co_id_sub(&lss->id, sub);
+	assert(pid);
+
+	if (lss->disc_cand & (1u << sub)) {
+		// Check the expected values one by one.
+		co_unsigned8_t id = co_lss_discover_next_cand(lss, sub, 1);
+		assert(id);
+		lss->disc_nid[sub] = id;
+		*pid = co_dev_get_val_u32(lss->dev, 0x1f85 + sub, id);
+		return CO_LSS_DISC_NUMBER;
+	}
+
+	// Start with the 0-branch of the most-significant bit.
+	*pid = 0;
+	lss->disc_pend[sub] = 0;
+	lss->bitchk = 31;
+	return CO_LSS_DISC_BIT0;
+}
+
+static int
+co_lss_discover_found(co_lss_t *lss)
+{
+	assert(lss);
+
+	struct co_lss_discover_stats *stats = &lss->disc_stats;
+	// A slave may be found again after the search was restarted.
+	for (int i = 0; i < stats->nfound; i++) {
+		const struct co_id *id = &lss->disc_ids[i];
+		if (id->vendor_id == lss->id.vendor_id
+				&& id->product_code == lss->id.product_code
+				&& id->revision == lss->id.revision
+				&& id->serial_nr == lss->id.serial_nr)
+			return co_lss_discover_back(lss);
+	}
+
+	trace("LSS: discovered slave %08" PRIx32 ":%08" PRIx32 ":%08" PRIx32
+	      ":%08" PRIx32,
+			lss->id.vendor_id, lss->id.product_code,
+			lss->id.revision, lss->id.serial_nr);
+	lss->disc_ids[stats->nfound++] = lss->id;
+	// Stop if no more node-IDs can be assigned.
+	if (stats->nfound == CO_NUM_NODES)
+		return -1;
+
+	return co_lss_discover_back(lss);
+}
+
+static int
+co_lss_discover_back(co_lss_t *lss)
+{
+	assert(lss);
+
+	for (;;) {
+		co_unsigned8_t sub = lss->lsssub;
+		co_unsigned32_t *pid = co_id_sub(&lss->id, sub);
+		assert(pid);
+
+		if (lss->disc_cand & (1u << sub)) {
+			co_unsigned8_t id = co_lss_discover_next_cand(
+					lss, sub, lss->disc_nid[sub] + 1);
+			if (id) {
+				lss->disc_nid[sub] = id;
+				*pid = co_dev_get_val_u32(
+						lss->dev, 0x1f85 + sub, id);
+				return CO_LSS_DISC_NUMBER;
+			}
+		} else if (lss->disc_pend[sub]) {
+			// Continue with the 1-branch of the least-significant
+			// pending bit. The bits below it are still unknown.
+			lss->bitchk = ctz32(lss->disc_pend[sub]);
+			co_unsigned32_t bit = UINT32_C(1) << lss->bitchk;
+			lss->disc_pend[sub] &= ~bit;
+			*pid = (*pid & ~(bit - 1)) | bit;
+			return CO_LSS_DISC_BIT1;
+		}
+
+		// All branches of this LSS number have been checked.
+		if (!sub)
+			return -1;
+		lss->lsssub--;
+	}
+}
+
+static int
+co_lss_discover_retry(co_lss_t *lss)
+{
+	assert(lss);
+	assert(!(lss->disc_cand & (1u << lss->lsssub)));
+
+	trace("LSS: late response detected; using the LSS timeout");
+	lss->disc_fixed = 1;
+	// The pending branches of the current LSS number are no longer
+	// reliable, so the search starts over.
+	return co_lss_discover_enter(lss, lss->lsssub);
+}
+
+static int
+co_lss_discover_send(co_lss_t *lss, int probe)
+{
+	assert(lss);
+
+	if (probe == CO_LSS_DISC_GUARD) {
+		lss->disc_probe = probe;
+		lss->disc_resp = 0;
+		// Measure the latency of a late response from the last request.
+		struct timespec start = lss->disc_sent;
+		timespec_add_usec(&start, (uint_least64_t)lss->timeout * 1000);
+		can_timer_start(lss->timer, lss->net, &start, NULL);
+		return 0;
+	}
+
+	co_unsigned32_t id = 0;
+	co_unsigned8_t bitchk = 0x80;
+	co_unsigned8_t lsssub = 0;
+	co_unsigned8_t lssnext = 0;
+	if (probe == CO_LSS_DISC_SYNC) {
+		// The first request resets the LSSPos value of all slaves; the
+		// others send the complete LSS numbers of the current prefix.
+		if (lss->disc_sync) {
+			lsssub = lss->disc_sync - 1;
+			id = *co_id_sub(&lss->id, lsssub);
+			bitchk = 0;
+			lssnext = lsssub + 1;
+		}
+		lss->disc_sync++;
+	} else if (probe != CO_LSS_DISC_RESET) {
+		id = *co_id_sub(&lss->id, lss->lsssub);
+		bitchk = probe == CO_LSS_DISC_NUMBER ? 0 : lss->bitchk;
+		lsssub = lssnext = lss->lsssub;
+		// Only let the slaves proceed to the next LSS number once the
+		// current one is complete. Never let them proceed beyond the
+		// last number, since that would switch them to the LSS
+		// configuration state.
+		if (probe == CO_LSS_DISC_NUMBER && lssnext < 3)
+			lssnext++;
+	}
+	if (co_lss_send_fastscan_req(lss, id, bitchk, lsssub, lssnext) == -1)
+		return -1;
+
+	lss->disc_probe = probe;
+	lss->disc_resp = 0;
+	lss->disc_stats.nreq++;
+
+	// Adapt the timeout to the observed latency, but never exceed the LSS
+	// timeout.
+	uint_least64_t timeout = (uint_least64_t)lss->timeout * 1000;
+	if (lss->disc_stats.latency && !lss->disc_fixed) {
+		uint_least64_t usec = LELY_CO_LSS_DISCOVER_FACTOR
+				* lss->disc_stats.latency;
+		if (usec < LELY_CO_LSS_DISCOVER_MIN_TIMEOUT)
+			usec = LELY_CO_LSS_DISCOVER_MIN_TIMEOUT;
+		if (usec < timeout)
+			timeout = usec;
+	}
+	lss->disc_stats.timeout = timeout;
+
+	can_net_get_time(lss->net, &lss->disc_sent);
+	struct timespec start = lss->disc_sent;
+	timespec_add_usec(&start, timeout);
+	can_timer_start(lss->timer, lss->net, &start, NULL);
+
+	return 0;
+}
+
+static int
+co_lss_discover_is_slave(const co_lss_t *lss, co_unsigned8_t id)
+{
+	assert(lss);
+
+	if (!id || id > CO_NUM_NODES || id == co_dev_get_id(lss->dev))
+		return 0;
+
+	return !!(co_dev_get_val_u32(lss->dev, 0x1f81, id) & 0x01);
+}
+
+static co_unsigned8_t
+co_lss_discover_next_cand(
+		const co_lss_t *lss, co_unsigned8_t sub, co_unsigned8_t id)
+{
+	assert(lss);
+	assert(sub < 4);
+
+	for (; id && id <= CO_NUM_NODES; id++) {
+		if (!co_lss_discover_is_slave(lss, id))
+			continue;
+		co_unsigned32_t val =
+				co_dev_get_val_u32(lss->dev, 0x1f85 + sub, id);
+		if (!val)
+			continue;
+		// Skip values that were already checked for an earlier slave.
+		co_unsigned8_t i = 1;
+		for (; i < id; i++) {
+			if (co_lss_discover_is_slave(lss, i)
+					&& co_dev_get_val_u32(lss->dev,
+							   0x1f85 + sub, i)
+							== val)
+				break;
+		}
+		if (i == id)
+			return id;
+	}
+
+	return 0;
+}
+
+static co_unsigned8_t
+co_lss_discover_get_nid(const co_lss_t *lss, const struct co_id *id)
+{
+	assert(lss);
+	assert(id);
+
+	for (co_unsigned8_t nid = 1; nid <= CO_NUM_NODES; nid++) {
+		if (!co_lss_discover_is_slave(lss, nid))
+			continue;
+		if (lss->disc_taken[(nid - 1) / 32]
+				& (UINT32_C(1) << ((nid - 1) % 32)))
+			continue;
+		co_unsigned8_t sub = 0;
+		for (; sub < 4; sub++) {
+			co_unsigned32_t val = co_dev_get_val_u32(
+					lss->dev, 0x1f85 + sub, nid);
+			if (val && val != *co_id_sub((struct co_id *)id, sub))
+				break;
+		}
+		if (sub == 4)
+			return nid;
+	}
+
+	return 0xff;
+}
+
+static void
+co_lss_discover_next(co_lss_t *lss)
+{
+	assert(lss);
+
+	struct co_lss_discover_stats *stats = &lss->disc_stats;
+	while (lss->disc_next < stats->nfound) {
+		const struct co_id *id = &lss->disc_ids[lss->disc_next++];
+
+		co_unsigned8_t nid = co_lss_discover_get_nid(lss, id);
+		if (lss->disc_ind)
+			nid = lss->disc_ind(lss, id, nid, lss->disc_data);
+		// Leave the slave unconfigured on an invalid node-ID.
+		if (!nid || nid > CO_NUM_NODES)
+			continue;
+		lss->disc_taken[(nid - 1) / 32] |= UINT32_C(1)
+				<< ((nid - 1) % 32);
+		lss->disc_id = nid;
+
+		// Switch the slave to the LSS configuration state. The node-ID
+		// is configured by co_lss_discover_cs_ind().
+		if (!co_lss_switch_sel_req(lss, id, &co_lss_discover_cs_ind,
+				    NULL))
+			return;
+		diag(DIAG_ERROR, get_errc(),
+				"LSS: unable to switch slave to configuration state");
+	}
+
+	struct timespec now = { 0, 0 };
+	can_net_get_time(lss->net, &now);
+	stats->total_time = timespec_diff_usec(&now, &lss->disc_start);
+
+	if (lss->disc_con)
+		lss->disc_con(lss, stats, lss->disc_data);
+}
+
+static void
+co_lss_discover_cs_ind(co_lss_t *lss, co_unsigned8_t cs, void *data)
+{
+	assert(lss);
+	(void)data;
+
+	if (cs) {
+		// Configure the node-ID and wait for the response.
+		// clang-format off
+		if (!co_lss_set_id_req(lss, lss->disc_id,
+				&co_lss_discover_err_ind, NULL))
+			// clang-format on
+			return;
+		diag(DIAG_ERROR, get_errc(), "LSS: unable to configure node-ID");
+		co_lss_switch_req(lss, 0x00);
+	}
+
+	co_lss_discover_next(lss);
+}
+
+static void
+co_lss_discover_err_ind(co_lss_t *lss, co_unsigned8_t cs, co_unsigned8_t err,
+		co_unsigned8_t spec, void *data)
+{
+	assert(lss);
+	(void)spec;
+	(void)data;
+
+	if (cs && !err)
+		lss->disc_stats.nconf++;
+
+	// Switch the slave back to the waiting state, so the next slave can be
+	// selected.
+	co_lss_switch_req(lss, 0x00);
+
+	co_lss_discover_next(lss);
+}
+
 static inline co_unsigned32_t *
 co_id_sub(struct co_id *id, co_unsigned8_t sub)
 {
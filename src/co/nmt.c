@@ -23,6 +23,11 @@
 
 #include "co.h"
 #include <lely/util/diag.h>
+#if !LELY_NO_CO_NMT_BOOT && !LELY_NO_STDIO
+#include <lely/util/endian.h>
+#include <lely/util/frbuf.h>
+#include <lely/util/fwbuf.h>
+#endif
 #if !LELY_NO_CO_MASTER
 #include <lely/can/buf.h>
 #include <lely/co/csdo.h>
@@ -53,6 +58,19 @@
 
 #include <assert.h>
 #include <stdlib.h>
+
+#if !LELY_NO_CO_NMT_BOOT && !LELY_NO_STDIO
+
+/// The magic number at the start of a boot cache file ("CONB").
+#define CO_NMT_BOOT_CACHE_MAGIC 0x424e4f43u
+
+/**
+ * The size (in bytes) of a record in a boot cache file: the node-ID followed by
+ * the members of #co_nmt_boot_rec, in little-endian byte order.
+ */
+#define CO_NMT_BOOT_CACHE_REC_SIZE (1 + 7 * 4)
+
+#endif
 #if LELY_NO_MALLOC
 #include <string.h>
 #endif
@@ -65,14 +83,6 @@
  */
 #define CO_NMT_CAN_BUF_SIZE 16
 #endif
-#ifndef CO_NMT_MAX_NHB
-/**
- * The default maximum number of heartbeat consumers in the absence of dynamic
- * memory allocation. The default value equals the maximum number of CANopen
- * nodes.
- */
-#define CO_NMT_MAX_NHB CO_NUM_NODES
-#endif
 #endif // LELY_NO_MALLOC
 
 struct __co_nmt_state;
@@ -84,11 +94,6 @@ typedef const struct __co_nmt_state co_nmt_state_t;
 struct co_nmt_slave {
 	/// A pointer to the NMT master service.
 	co_nmt_t *nmt;
-	/**
-	 * A pointer to the CAN frame receiver for the boot-up event and node
-	 * guarding messages.
-	 */
-	can_recv_t *recv;
 #if !LELY_NO_CO_NG
 	/// A pointer to the CAN timer for node guarding.
 	can_timer_t *timer;
@@ -120,8 +125,26 @@ struct co_nmt_slave {
 #if !LELY_NO_CO_NMT_BOOT
 	/// A flag specifying whether the 'boot slave' process has ended.
 	unsigned booted : 1;
+	/**
+	 * A flag specifying whether the 'boot slave' process is waiting for
+	 * one of the running processes to complete.
+	 */
+	unsigned queued : 1;
 	/// A pointer to the NMT 'boot slave' service.
 	co_nmt_boot_t *boot;
+	/// The SDO timeout (in milliseconds) of the 'boot slave' process.
+	int boot_timeout;
+	/// The time at which the 'boot slave' process was requested.
+	struct timespec boot_req;
+	/**
+	 * The sequence number of the request for the 'boot slave' process.
+	 * Queued processes are started in the order of their sequence numbers.
+	 */
+	uint_least64_t boot_seq;
+	/// The durations of the phases of the last 'boot slave' process.
+	struct co_nmt_boot_times boot_times;
+	/// The boot cache record.
+	struct co_nmt_boot_rec boot_rec;
 #endif
 #if !LELY_NO_CO_NMT_CFG
 	/// A pointer to the NMT 'update configuration' service.
@@ -215,12 +238,12 @@ struct __co_nmt {
 #endif
 	/// The producer heartbeat time (in milliseconds).
 	co_unsigned16_t ms;
-	/// An array of pointers to the heartbeat consumers.
-#if LELY_NO_MALLOC
-	co_nmt_hb_t *hbs[CO_NMT_MAX_NHB];
-#else
-	co_nmt_hb_t **hbs;
-#endif
+	/**
+	 * A pointer to the error control engine monitoring the heartbeat
+	 * consumers (and, for a master, the error control messages of all
+	 * slaves).
+	 */
+	co_nmt_hb_t *hb;
 	/// The number of heartbeat consumers.
 	co_unsigned8_t nhb;
 	/// A pointer to the heartbeat event indication function.
@@ -264,6 +287,14 @@ struct __co_nmt {
 	 */
 	int timeout;
 #if !LELY_NO_CO_NMT_BOOT
+	/// The maximum number of concurrent 'boot slave' processes.
+	int boot_max;
+	/// The number of running 'boot slave' processes.
+	int nboot;
+	/// The sequence number of the last 'boot slave' request.
+	uint_least64_t boot_seq;
+	/// A flag specifying whether the boot cache is enabled.
+	int boot_cache;
 	/// A pointer to the NMT 'boot slave' indication function.
 	co_nmt_boot_ind_t *boot_ind;
 	/// A pointer to user-specified data for #boot_ind.
@@ -709,8 +740,18 @@ static void co_nmt_hb_fini(co_nmt_t *nmt);
 #if !LELY_NO_CO_MASTER
 
 #if !LELY_NO_CO_NMT_BOOT || !LELY_NO_CO_NMT_CFG
-/// Find the heartbeat consumer for the specified node.
-static co_nmt_hb_t *co_nmt_hb_find(
+/**
+ * Finds the heartbeat consumer for the specified node in object 1016 (Consumer
+ * heartbeat time). If more than one entry exists for the node, the active one
+ * is preferred.
+ *
+ * @param nmt a pointer to an NMT master service.
+ * @param id  the node-ID.
+ * @param pms the address at which to store the heartbeat time (can be NULL).
+ *
+ * @returns 1 if an entry exists for the node, and 0 if not.
+ */
+static int co_nmt_hb_find(
 		co_nmt_t *nmt, co_unsigned8_t id, co_unsigned16_t *pms);
 #endif
 
@@ -728,6 +769,21 @@ static void co_nmt_slaves_fini(co_nmt_t *nmt);
  * mandatory slaves, or -1 if an error occurred for a mandatory slave.
  */
 static int co_nmt_slaves_boot(co_nmt_t *nmt);
+
+/**
+ * Creates and starts the 'boot slave' service for the specified node.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+static int co_nmt_boot_start(co_nmt_t *nmt, co_unsigned8_t id);
+
+/**
+ * Starts the queued 'boot slave' processes, in the order in which they were
+ * requested, as long as the maximum number of concurrent processes is not
+ * reached.
+ */
+static void co_nmt_boot_next(co_nmt_t *nmt);
 #endif
 
 /**
@@ -926,11 +982,12 @@ __co_nmt_init(struct __co_nmt *nmt, can_net_t *net, co_dev_t *dev)
 
 	nmt->ms = 0;
 
-#if LELY_NO_MALLOC
-	memset(nmt->hbs, 0, CO_NMT_MAX_NHB * sizeof(*nmt->hbs));
-#else
-	nmt->hbs = NULL;
-#endif
+	// Create the error control engine for the heartbeat consumers.
+	nmt->hb = co_nmt_hb_create(nmt->net, nmt);
+	if (!nmt->hb) {
+		errc = get_errc();
+		goto error_create_hb;
+	}
 	nmt->nhb = 0;
 	nmt->hb_ind = &default_hb_ind;
 	nmt->hb_data = NULL;
@@ -967,7 +1024,6 @@ __co_nmt_init(struct __co_nmt *nmt, can_net_t *net, co_dev_t *dev)
 		struct co_nmt_slave *slave = &nmt->slaves[id - 1];
 		slave->nmt = nmt;
 
-		slave->recv = NULL;
 #if !LELY_NO_CO_NG
 		slave->timer = NULL;
 #endif
@@ -981,8 +1037,15 @@ __co_nmt_init(struct __co_nmt *nmt, can_net_t *net, co_dev_t *dev)
 
 		slave->booting = 0;
 		slave->booted = 0;
+		slave->queued = 0;
 
 		slave->boot = NULL;
+		slave->boot_timeout = 0;
+		slave->boot_req = (struct timespec){ 0, 0 };
+		slave->boot_seq = 0;
+		slave->boot_times = (struct co_nmt_boot_times)
+				CO_NMT_BOOT_TIMES_INIT;
+		slave->boot_rec = (struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
 #endif
 
 #if !LELY_NO_CO_NMT_CFG
@@ -1001,29 +1064,26 @@ __co_nmt_init(struct __co_nmt *nmt, can_net_t *net, co_dev_t *dev)
 #endif
 	}
 
+#if !LELY_NO_CO_NG
 	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
 		struct co_nmt_slave *slave = &nmt->slaves[id - 1];
 
-		slave->recv = can_recv_create();
-		if (!slave->recv) {
-			errc = get_errc();
-			goto error_init_slave;
-		}
-		can_recv_set_func(slave->recv, &co_nmt_recv_700, nmt);
-
-#if !LELY_NO_CO_NG
 		slave->timer = can_timer_create();
 		if (!slave->timer) {
 			errc = get_errc();
 			goto error_init_slave;
 		}
 		can_timer_set_func(slave->timer, &co_nmt_ng_timer, slave);
-#endif
 	}
+#endif
 
 	nmt->timeout = LELY_CO_NMT_TIMEOUT;
 
 #if !LELY_NO_CO_NMT_BOOT
+	nmt->boot_max = LELY_CO_NMT_BOOT_MAX;
+	nmt->nboot = 0;
+	nmt->boot_seq = 0;
+	nmt->boot_cache = 0;
 	nmt->boot_ind = NULL;
 	nmt->boot_data = NULL;
 #endif
@@ -1121,19 +1181,17 @@ __co_nmt_init(struct __co_nmt *nmt, can_net_t *net, co_dev_t *dev)
 // 	co_dev_set_tpdo_event_ind(nmt->dev, NULL, NULL);
 // #endif
 #if !LELY_NO_CO_MASTER
-error_init_slave:
-	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
-		struct co_nmt_slave *slave = &nmt->slaves[id - 1];
-
-		can_recv_destroy(slave->recv);
 #if !LELY_NO_CO_NG
-		can_timer_destroy(slave->timer);
+error_init_slave:
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		can_timer_destroy(nmt->slaves[id - 1].timer);
 #endif
-	}
 	can_timer_destroy(nmt->cs_timer);
 error_create_cs_timer:
 	can_buf_fini(&nmt->buf);
 #endif
+	co_nmt_hb_destroy(nmt->hb);
+error_create_hb:
 	can_timer_destroy(nmt->ec_timer);
 error_create_ec_timer:
 	can_recv_destroy(nmt->recv_700);
@@ -1208,14 +1266,10 @@ __co_nmt_fini(struct __co_nmt *nmt)
 #if !LELY_NO_CO_MASTER
 	co_nmt_slaves_fini(nmt);
 
-	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
-		struct co_nmt_slave *slave = &nmt->slaves[id - 1];
-
-		can_recv_destroy(slave->recv);
 #if !LELY_NO_CO_NG
-		can_timer_destroy(slave->timer);
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		can_timer_destroy(nmt->slaves[id - 1].timer);
 #endif
-	}
 #endif
 
 #if !LELY_NO_CO_MASTER
@@ -1224,6 +1278,7 @@ __co_nmt_fini(struct __co_nmt *nmt)
 #endif
 
 	co_nmt_hb_fini(nmt);
+	co_nmt_hb_destroy(nmt->hb);
 
 	co_nmt_ec_fini(nmt);
 
@@ -1904,38 +1959,250 @@ co_nmt_boot_req(co_nmt_t *nmt, co_unsigned8_t id, int timeout)
 	trace("NMT: booting slave %d", id);
 
 	// Disable the heartbeat consumer during the 'boot slave' process.
-	co_nmt_hb_t *hb = co_nmt_hb_find(nmt, id, NULL);
-	if (hb)
-		co_nmt_hb_set_1016(hb, id, 0);
+	co_nmt_hb_set_1016(nmt->hb, id, 0);
 
 	slave->booting = 1;
-
-	slave->boot = co_nmt_boot_create(nmt->net, nmt->dev, nmt);
-	if (!slave->boot) {
-		errc = get_errc();
-		goto error_create_boot;
+	slave->boot_timeout = timeout;
+	can_net_get_time(nmt->net, &slave->boot_req);
+	// Requests issued at the same time have the same timestamp, so use a
+	// sequence number to keep track of the order of submission.
+	slave->boot_seq = ++nmt->boot_seq;
+
+	// Postpone the process if the maximum number of concurrent processes
+	// has been reached.
+	if (nmt->boot_max > 0 && nmt->nboot >= nmt->boot_max) {
+		trace("NMT: queued 'boot slave' process for slave %d", id);
+		slave->queued = 1;
+		return 0;
 	}
 
-	// clang-format off
-	if (co_nmt_boot_boot_req(slave->boot, id, timeout, &co_nmt_dn_ind,
-			&co_nmt_up_ind, nmt) == -1) {
-		// clang-format on
+	if (co_nmt_boot_start(nmt, id) == -1) {
 		errc = get_errc();
-		goto error_boot_req;
+		goto error_start;
 	}
 
 	return 0;
 
-error_boot_req:
-	co_nmt_boot_destroy(slave->boot);
-	slave->boot = NULL;
-error_create_boot:
+error_start:
 	slave->booting = 0;
 error_param:
 	set_errc(errc);
 	return -1;
 }
 
+int
+co_nmt_get_boot_max(const co_nmt_t *nmt)
+{
+	assert(nmt);
+
+	return nmt->boot_max;
+}
+
+void
+co_nmt_set_boot_max(co_nmt_t *nmt, int max)
+{
+	assert(nmt);
+
+	nmt->boot_max = max > 0 ? max : 0;
+
+	// Start any queued processes allowed by the new limit.
+	if (nmt->master)
+		co_nmt_boot_next(nmt);
+}
+
+int
+co_nmt_get_boot_times(const co_nmt_t *nmt, co_unsigned8_t id,
+		struct co_nmt_boot_times *ptimes)
+{
+	assert(nmt);
+	assert(ptimes);
+
+	if (!nmt->master) {
+		set_errnum(ERRNUM_PERM);
+		return -1;
+	}
+
+	if (!id || id > CO_NUM_NODES) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+	*ptimes = nmt->slaves[id - 1].boot_times;
+	return 0;
+}
+
+int
+co_nmt_get_boot_cache(const co_nmt_t *nmt)
+{
+	assert(nmt);
+
+	return nmt->boot_cache;
+}
+
+void
+co_nmt_set_boot_cache(co_nmt_t *nmt, int cache)
+{
+	assert(nmt);
+
+	nmt->boot_cache = !!cache;
+}
+
+int
+co_nmt_get_boot_rec(const co_nmt_t *nmt, co_unsigned8_t id,
+		struct co_nmt_boot_rec *prec)
+{
+	assert(nmt);
+
+	if (!id || id > CO_NUM_NODES) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+	const struct co_nmt_boot_rec *rec = &nmt->slaves[id - 1].boot_rec;
+
+	if (prec)
+		*prec = *rec;
+
+	return rec->cfg_date && rec->cfg_time;
+}
+
+int
+co_nmt_set_boot_rec(co_nmt_t *nmt, co_unsigned8_t id,
+		const struct co_nmt_boot_rec *rec)
+{
+	assert(nmt);
+
+	if (!id || id > CO_NUM_NODES) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+	if (rec)
+		nmt->slaves[id - 1].boot_rec = *rec;
+	else
+		nmt->slaves[id - 1].boot_rec =
+				(struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
+
+	return 0;
+}
+
+#if !LELY_NO_STDIO
+
+int
+co_nmt_load_boot_cache(co_nmt_t *nmt, const char *filename)
+{
+	assert(nmt);
+	assert(filename);
+
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		nmt->slaves[id - 1].boot_rec =
+				(struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
+
+	frbuf_t *buf = frbuf_create(filename);
+	if (!buf)
+		goto error_create_buf;
+
+	uint_least8_t magic[4];
+	ssize_t result = frbuf_read(buf, magic, sizeof(magic));
+	if (result == -1)
+		goto error_read;
+	if (result != (ssize_t)sizeof(magic)
+			|| ldle_u32(magic) != CO_NMT_BOOT_CACHE_MAGIC) {
+		diag(DIAG_ERROR, 0, "%s: invalid boot cache", filename);
+		set_errnum(ERRNUM_INVAL);
+		goto error_read;
+	}
+
+	uint_least8_t rec[CO_NMT_BOOT_CACHE_REC_SIZE];
+	while ((result = frbuf_read(buf, rec, sizeof(rec))) > 0) {
+		co_unsigned8_t id = rec[0];
+		if (result != (ssize_t)sizeof(rec) || !id
+				|| id > CO_NUM_NODES) {
+			diag(DIAG_ERROR, 0, "%s: invalid boot cache record",
+					filename);
+			set_errnum(ERRNUM_INVAL);
+			goto error_read;
+		}
+		struct co_nmt_boot_rec *boot_rec =
+				&nmt->slaves[id - 1].boot_rec;
+		boot_rec->device_type = ldle_u32(rec + 1);
+		boot_rec->vendor_id = ldle_u32(rec + 5);
+		boot_rec->product_code = ldle_u32(rec + 9);
+		boot_rec->revision = ldle_u32(rec + 13);
+		boot_rec->serial_nr = ldle_u32(rec + 17);
+		boot_rec->cfg_date = ldle_u32(rec + 21);
+		boot_rec->cfg_time = ldle_u32(rec + 25);
+	}
+	if (result == -1)
+		goto error_read;
+
+	frbuf_destroy(buf);
+
+	return 0;
+
+error_read:
+	frbuf_destroy(buf);
+error_create_buf:
+	// Do not use a partially loaded cache.
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		nmt->slaves[id - 1].boot_rec =
+				(struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
+	return -1;
+}
+
+int
+co_nmt_save_boot_cache(const co_nmt_t *nmt, const char *filename)
+{
+	assert(nmt);
+	assert(filename);
+
+	fwbuf_t *buf = fwbuf_create(filename);
+	if (!buf) {
+		diag(DIAG_ERROR, get_errc(), "%s", filename);
+		goto error_create_buf;
+	}
+
+	uint_least8_t magic[4];
+	stle_u32(magic, CO_NMT_BOOT_CACHE_MAGIC);
+	if (fwbuf_write(buf, magic, sizeof(magic)) != (ssize_t)sizeof(magic))
+		goto error_write;
+
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+		const struct co_nmt_boot_rec *boot_rec =
+				&nmt->slaves[id - 1].boot_rec;
+		// Only store valid records.
+		if (!boot_rec->cfg_date || !boot_rec->cfg_time)
+			continue;
+
+		uint_least8_t rec[CO_NMT_BOOT_CACHE_REC_SIZE];
+		rec[0] = id;
+		stle_u32(rec + 1, boot_rec->device_type);
+		stle_u32(rec + 5, boot_rec->vendor_id);
+		stle_u32(rec + 9, boot_rec->product_code);
+		stle_u32(rec + 13, boot_rec->revision);
+		stle_u32(rec + 17, boot_rec->serial_nr);
+		stle_u32(rec + 21, boot_rec->cfg_date);
+		stle_u32(rec + 25, boot_rec->cfg_time);
+		if (fwbuf_write(buf, rec, sizeof(rec)) != (ssize_t)sizeof(rec))
+			goto error_write;
+	}
+
+	if (fwbuf_commit(buf) == -1)
+		goto error_commit;
+
+	fwbuf_destroy(buf);
+
+	return 0;
+
+error_commit:
+error_write:
+	diag(DIAG_ERROR, get_errc(), "%s", filename);
+	fwbuf_destroy(buf);
+error_create_buf:
+	return -1;
+}
+
+#endif // !LELY_NO_STDIO
+
 int
 co_nmt_is_booting(const co_nmt_t *nmt, co_unsigned8_t id)
 {
@@ -2013,9 +2280,7 @@ co_nmt_cfg_req(co_nmt_t *nmt, co_unsigned8_t id, int timeout,
 	trace("NMT: starting update configuration process for node %d", id);
 
 	// Disable the heartbeat consumer during a configuration request.
-	co_nmt_hb_t *hb = co_nmt_hb_find(nmt, id, NULL);
-	if (hb)
-		co_nmt_hb_set_1016(hb, id, 0);
+	co_nmt_hb_set_1016(nmt->hb, id, 0);
 
 	slave->configuring = 1;
 
@@ -2324,14 +2589,38 @@ co_nmt_boot_con(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es)
 	slave->es = es;
 	slave->booting = 0;
 	slave->booted = 1;
+
+	// Record the phase durations, including the time spent in the queue.
+	co_nmt_boot_get_times(slave->boot, &slave->boot_times);
+	struct timespec now = { 0, 0 };
+	can_net_get_time(nmt->net, &now);
+	uint_least64_t total = timespec_diff_usec(&now, &slave->boot_req);
+	if (total > slave->boot_times.total) {
+		slave->boot_times.phase[CO_NMT_BOOT_PHASE_QUEUE] =
+				total - slave->boot_times.total;
+		slave->boot_times.total = total;
+	}
+
+	// Update the boot cache record. The record is invalidated if the
+	// process failed.
+	if (nmt->boot_cache) {
+		if (es)
+			slave->boot_rec = (struct co_nmt_boot_rec)
+					CO_NMT_BOOT_REC_INIT;
+		else
+			co_nmt_boot_get_rec(slave->boot, &slave->boot_rec);
+	}
+
 	co_nmt_boot_destroy(slave->boot);
 	slave->boot = NULL;
+	if (nmt->nboot > 0)
+		nmt->nboot--;
 
 	// Re-enable the heartbeat consumer for the node, if necessary.
 	co_unsigned16_t ms = 0;
-	co_nmt_hb_t *hb = co_nmt_hb_find(nmt, id, &ms);
+	int hb = co_nmt_hb_find(nmt, id, &ms);
 	if (hb)
-		co_nmt_hb_set_1016(hb, id, ms);
+		co_nmt_hb_set_1016(nmt->hb, id, ms);
 
 	// Update object 1F82 (Request NMT) with the NMT state.
 	co_sub_t *sub = co_dev_find_sub(nmt->dev, 0x1f82, id);
@@ -2354,7 +2643,7 @@ co_nmt_boot_con(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es)
 	// heartbeat consumption or node guarding.
 	if (!es || es == 'L') {
 		if (hb) {
-			co_nmt_hb_set_st(hb, st);
+			co_nmt_hb_set_st(nmt->hb, id, st);
 #if !LELY_NO_CO_NG
 			// Disable node guarding.
 			slave->assignment &= 0xff;
@@ -2377,6 +2666,10 @@ co_nmt_boot_con(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es)
 		nmt->boot_ind(nmt, id, st, es, nmt->boot_data);
 
 	co_nmt_emit_boot(nmt, id, st, es);
+
+	// Start the next 'boot slave' process, if any are waiting.
+	if (nmt->master)
+		co_nmt_boot_next(nmt);
 }
 #endif // !LELY_NO_CO_NMT_BOOT
 
@@ -2413,9 +2706,8 @@ co_nmt_cfg_con(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned32_t ac)
 	if (!slave->booting) {
 #endif
 		co_unsigned16_t ms = 0;
-		co_nmt_hb_t *hb = co_nmt_hb_find(nmt, id, &ms);
-		if (hb)
-			co_nmt_hb_set_1016(hb, id, ms);
+		if (co_nmt_hb_find(nmt, id, &ms))
+			co_nmt_hb_set_1016(nmt->hb, id, ms);
 #if !LELY_NO_CO_NMT_BOOT
 	}
 #endif
@@ -2427,6 +2719,17 @@ co_nmt_cfg_con(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned32_t ac)
 
 #endif // !LELY_NO_CO_NMT_BOOT
 
+#if !LELY_NO_CO_MASTER
+int
+co_nmt_ec_ind(co_nmt_t *nmt, const struct can_msg *msg)
+{
+	assert(nmt);
+	assert(nmt->master);
+
+	return co_nmt_recv_700(msg, nmt);
+}
+#endif
+
 void
 co_nmt_hb_ind(co_nmt_t *nmt, co_unsigned8_t id, int state, int reason,
 		co_unsigned8_t st)
@@ -2539,11 +2842,14 @@ co_1016_dn_ind(co_sub_t *sub, struct co_sdo_req *req, void *data)
 		return CO_SDO_AC_NO_SUB;
 
 	assert(type == CO_DEFTYPE_UNSIGNED32);
-	if (val.u32 == co_sub_get_val_u32(sub))
+	co_unsigned32_t old = co_sub_get_val_u32(sub);
+	if (val.u32 == old)
 		return 0;
 
 	co_unsigned8_t id = (val.u32 >> 16) & 0xff;
 	co_unsigned16_t ms = val.u32 & 0xffff;
+	co_unsigned8_t old_id = (old >> 16) & 0xff;
+	co_unsigned16_t old_ms = old & 0xffff;
 
 	// If the heartbeat consumer is active (valid node-ID and non-zero
 	// heartbeat time), check the other entries for duplicate node-IDs.
@@ -2564,7 +2870,7 @@ co_1016_dn_ind(co_sub_t *sub, struct co_sdo_req *req, void *data)
 		// Disable heartbeat consumption for booting slaves or slaves
 		// that are being configured.
 #if !LELY_NO_CO_NMT_BOOT
-		if (nmt->slaves[id - 1].boot)
+		if (nmt->slaves[id - 1].booting)
 			ms = 0;
 #endif
 #if !LELY_NO_CO_NMT_CFG
@@ -2575,7 +2881,13 @@ co_1016_dn_ind(co_sub_t *sub, struct co_sdo_req *req, void *data)
 
 	co_sub_dn(sub, &val);
 
-	co_nmt_hb_set_1016(nmt->hbs[subidx - 1], id, ms);
+	// Deactivate the previous heartbeat consumer, if it was active. Since
+	// active entries have unique node-IDs, this does not affect the other
+	// entries.
+	if (old_ms)
+		co_nmt_hb_set_1016(nmt->hb, old_id, 0);
+	if (ms)
+		co_nmt_hb_set_1016(nmt->hb, id, ms);
 	return 0;
 }
 
@@ -3757,46 +4069,20 @@ static void
 co_nmt_hb_init(co_nmt_t *nmt)
 {
 	assert(nmt);
-
-	// Create and initialize the heartbeat consumers.
-#if LELY_NO_MALLOC
-	memset(nmt->hbs, 0, CO_NMT_MAX_NHB * sizeof(*nmt->hbs));
-#else
-	assert(!nmt->hbs);
-#endif
 	assert(!nmt->nhb);
-	co_obj_t *obj_1016 = co_dev_find_obj(nmt->dev, 0x1016);
-	if (obj_1016) {
-		nmt->nhb = co_obj_get_val_u8(obj_1016, 0x00);
-#if LELY_NO_MALLOC
-		if (nmt->nhb > CO_NMT_MAX_NHB) {
-			set_errnum(ERRNUM_NOMEM);
-#else // !LELY_NO_MALLOC
-		nmt->hbs = calloc(nmt->nhb, sizeof(*nmt->hbs));
-		if (!nmt->hbs && nmt->nhb) {
-#if !LELY_NO_ERRNO
-			set_errc(errno2c(errno));
-#endif
-#endif // !LELY_NO_MALLOC
-			diag(DIAG_ERROR, get_errc(),
-					"unable to create heartbeat consumers");
-			nmt->nhb = 0;
-		}
-	}
 
-	for (co_unsigned8_t i = 0; i < nmt->nhb; i++) {
-		nmt->hbs[i] = co_nmt_hb_create(nmt->net, nmt);
-		if (!nmt->hbs[i]) {
-			diag(DIAG_ERROR, get_errc(),
-					"unable to create heartbeat consumer 0x%02X",
-					(co_unsigned8_t)(i + 1));
-			continue;
-		}
+	// Activate the heartbeat consumers in object 1016.
+	co_obj_t *obj_1016 = co_dev_find_obj(nmt->dev, 0x1016);
+	if (!obj_1016)
+		return;
 
-		co_unsigned32_t val = co_obj_get_val_u32(obj_1016, i + 1);
+	nmt->nhb = co_obj_get_val_u8(obj_1016, 0x00);
+	for (co_unsigned8_t i = 1; i <= nmt->nhb; i++) {
+		co_unsigned32_t val = co_obj_get_val_u32(obj_1016, i);
 		co_unsigned8_t id = (val >> 16) & 0xff;
 		co_unsigned16_t ms = val & 0xffff;
-		co_nmt_hb_set_1016(nmt->hbs[i], id, ms);
+		if (ms)
+			co_nmt_hb_set_1016(nmt->hb, id, ms);
 	}
 }
 
@@ -3805,20 +4091,16 @@ co_nmt_hb_fini(co_nmt_t *nmt)
 {
 	assert(nmt);
 
-	// Destroy all heartbeat consumers.
-	for (size_t i = 0; i < nmt->nhb; i++)
-		co_nmt_hb_destroy(nmt->hbs[i]);
-#if !LELY_NO_MALLOC
-	free(nmt->hbs);
-	nmt->hbs = NULL;
-#endif
+	// Deactivate all heartbeat consumers.
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		co_nmt_hb_set_1016(nmt->hb, id, 0);
 	nmt->nhb = 0;
 }
 
 #if !LELY_NO_CO_MASTER
 
 #if !LELY_NO_CO_NMT_BOOT || !LELY_NO_CO_NMT_CFG
-static co_nmt_hb_t *
+static int
 co_nmt_hb_find(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned16_t *pms)
 {
 	assert(nmt);
@@ -3826,17 +4108,21 @@ co_nmt_hb_find(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned16_t *pms)
 
 	const co_obj_t *obj_1016 = co_dev_find_obj(nmt->dev, 0x1016);
 	if (!obj_1016)
-		return NULL;
+		return 0;
 
-	for (co_unsigned8_t i = 0; i < nmt->nhb; i++) {
-		co_unsigned32_t val = co_obj_get_val_u32(obj_1016, i + 1);
-		if (id == ((val >> 16) & 0xff)) {
-			if (pms)
-				*pms = val & 0xffff;
-			return nmt->hbs[i];
-		}
+	int found = 0;
+	for (co_unsigned8_t i = 1; i <= nmt->nhb; i++) {
+		co_unsigned32_t val = co_obj_get_val_u32(obj_1016, i);
+		if (id != ((val >> 16) & 0xff))
+			continue;
+		found = 1;
+		co_unsigned16_t ms = val & 0xffff;
+		if (pms)
+			*pms = ms;
+		if (ms)
+			break;
 	}
-	return NULL;
+	return found;
 }
 #endif
 
@@ -3848,10 +4134,8 @@ co_nmt_slaves_init(co_nmt_t *nmt)
 
 	co_nmt_slaves_fini(nmt);
 
-	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
-		// Start listening for boot-up notifications.
-		can_recv_start(nmt->slaves[id - 1].recv, nmt->net,
-				CO_NMT_EC_CANID(id), 0);
+	// Start listening for boot-up notifications.
+	co_nmt_hb_set_master(nmt->hb, 1);
 
 	co_obj_t *obj_1f81 = co_dev_find_obj(nmt->dev, 0x1f81);
 	if (!obj_1f81)
@@ -3867,10 +4151,12 @@ co_nmt_slaves_fini(co_nmt_t *nmt)
 {
 	assert(nmt);
 
+	// Stop listening for boot-up notifications.
+	co_nmt_hb_set_master(nmt->hb, 0);
+
 	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
 		struct co_nmt_slave *slave = &nmt->slaves[id - 1];
 
-		can_recv_stop(slave->recv);
 #if !LELY_NO_CO_NG
 		can_timer_stop(slave->timer);
 #endif
@@ -3884,9 +4170,12 @@ co_nmt_slaves_fini(co_nmt_t *nmt)
 
 		slave->booting = 0;
 		slave->booted = 0;
+		slave->queued = 0;
 
 		co_nmt_boot_destroy(slave->boot);
 		slave->boot = NULL;
+		slave->boot_times = (struct co_nmt_boot_times)
+				CO_NMT_BOOT_TIMES_INIT;
 #endif
 		slave->bootup = 0;
 
@@ -3906,6 +4195,9 @@ co_nmt_slaves_fini(co_nmt_t *nmt)
 		slave->ng_state = CO_NMT_EC_RESOLVED;
 #endif
 	}
+#if !LELY_NO_CO_NMT_BOOT
+	nmt->nboot = 0;
+#endif
 }
 
 #if !LELY_NO_CO_NMT_BOOT
@@ -3937,6 +4229,85 @@ co_nmt_slaves_boot(co_nmt_t *nmt)
 	}
 	return res;
 }
+
+static int
+co_nmt_boot_start(co_nmt_t *nmt, co_unsigned8_t id)
+{
+	assert(nmt);
+	assert(nmt->master);
+	assert(id && id <= CO_NUM_NODES);
+	struct co_nmt_slave *slave = &nmt->slaves[id - 1];
+	assert(slave->booting);
+	assert(!slave->boot);
+
+	int errc = 0;
+
+	slave->queued = 0;
+
+	slave->boot = co_nmt_boot_create(nmt->net, nmt->dev, nmt);
+	if (!slave->boot) {
+		errc = get_errc();
+		goto error_create_boot;
+	}
+
+	// The process may complete immediately, in which case co_nmt_boot_con()
+	// is invoked before co_nmt_boot_boot_req() returns.
+	nmt->nboot++;
+	// clang-format off
+	if (co_nmt_boot_boot_req(slave->boot, id, slave->boot_timeout,
+			&co_nmt_dn_ind, &co_nmt_up_ind, nmt) == -1) {
+		// clang-format on
+		errc = get_errc();
+		goto error_boot_req;
+	}
+
+	return 0;
+
+error_boot_req:
+	nmt->nboot--;
+	co_nmt_boot_destroy(slave->boot);
+	slave->boot = NULL;
+error_create_boot:
+	set_errc(errc);
+	return -1;
+}
+
+static void
+co_nmt_boot_next(co_nmt_t *nmt)
+{
+	assert(nmt);
+	assert(nmt->master);
+
+	while (nmt->boot_max <= 0 || nmt->nboot < nmt->boot_max) {
+		// Find the slave which has been waiting the longest.
+		struct co_nmt_slave *next = NULL;
+		for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+			struct co_nmt_slave *slave = &nmt->slaves[id - 1];
+			if (!slave->queued)
+				continue;
+			if (!next || slave->boot_seq < next->boot_seq)
+				next = slave;
+		}
+		if (!next)
+			break;
+
+		co_unsigned8_t id = (co_unsigned8_t)(next - nmt->slaves + 1);
+		if (co_nmt_boot_start(nmt, id) == -1) {
+			diag(DIAG_ERROR, get_errc(),
+					"unable to boot slave %d", id);
+			// Report the failure as if the slave did not respond,
+			// so the network boot-up procedure does not wait
+			// forever.
+			next->queued = 0;
+			next->booting = 0;
+			next->es = 'B';
+			if (nmt->boot_ind)
+				nmt->boot_ind(nmt, id, 0, next->es,
+						nmt->boot_data);
+			co_nmt_emit_boot(nmt, id, 0, next->es);
+		}
+	}
+}
 #endif
 
 static int
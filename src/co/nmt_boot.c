@@ -109,6 +109,22 @@ struct __co_nmt_boot {
 	co_unsigned8_t st;
 	/// The error status.
 	char es;
+	/// The current phase (one of #co_nmt_boot_phase, or -1 if none).
+	int phase;
+	/// The time at which the current phase started.
+	struct timespec phase_start;
+	/// The durations of the phases.
+	struct co_nmt_boot_times times;
+	/// A flag specifying whether the boot cache of the NMT master is used.
+	int cache;
+	/**
+	 * 1 if the identity check was skipped because of a boot cache hit, -1
+	 * if the identity check is performed after the configuration check
+	 * failed on a boot cache hit, and 0 otherwise.
+	 */
+	int hit;
+	/// The identity and configuration of the slave.
+	struct co_nmt_boot_rec rec;
 };
 
 /**
@@ -783,6 +799,38 @@ static int co_nmt_boot_up(co_nmt_boot_t *boot, co_unsigned16_t idx,
 static int co_nmt_boot_chk(co_nmt_boot_t *boot, co_unsigned16_t idx,
 		co_unsigned8_t subidx, const void *ptr, size_t n);
 
+/**
+ * Returns the UNSIGNED32 value in the result of an SDO upload request, or 0 if
+ * the result does not contain a valid value.
+ */
+static co_unsigned32_t co_nmt_boot_get_u32(const void *ptr, size_t n);
+
+/**
+ * Checks if the device type of the slave and its expected identity and
+ * configuration date and time match the boot cache record of the NMT master. On
+ * success, the identity in the record is copied to the current record.
+ *
+ * @returns 1 if the record matches, and 0 if not.
+ */
+static int co_nmt_boot_chk_rec(co_nmt_boot_t *boot);
+
+/**
+ * Returns the state to enter when the configuration of the slave does not match
+ * the expected configuration. If the identity check was skipped because of a
+ * boot cache hit, the record is invalidated and the identity is checked before
+ * the configuration is updated.
+ */
+static co_nmt_boot_state_t *co_nmt_boot_chk_cfg_fail(co_nmt_boot_t *boot);
+
+/**
+ * Ends the current phase of the 'boot slave' process, if any, and adds its
+ * duration to the statistics before starting the next phase.
+ *
+ * @param boot  a pointer to a 'boot slave' service.
+ * @param phase the next phase (one of #co_nmt_boot_phase, or -1 if none).
+ */
+static void co_nmt_boot_set_phase(co_nmt_boot_t *boot, int phase);
+
 #if !LELY_NO_CO_NG
 /**
  * Sends a node guarding RTR to the slave.
@@ -857,6 +905,14 @@ __co_nmt_boot_init(struct __co_nmt_boot *boot, can_net_t *net, co_dev_t *dev,
 	co_sdo_req_init(&boot->req);
 	boot->retry = 0;
 
+	boot->phase = -1;
+	boot->phase_start = boot->start;
+	boot->times = (struct co_nmt_boot_times)CO_NMT_BOOT_TIMES_INIT;
+
+	boot->cache = 0;
+	boot->hit = 0;
+	boot->rec = (struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
+
 	co_nmt_boot_enter(boot, co_nmt_boot_wait_state);
 	return boot;
 
@@ -942,11 +998,40 @@ co_nmt_boot_boot_req(co_nmt_boot_t *boot, co_unsigned8_t id, int timeout,
 	co_csdo_set_dn_ind(boot->sdo, dn_ind, data);
 	co_csdo_set_up_ind(boot->sdo, up_ind, data);
 
+	boot->cache = co_nmt_get_boot_cache(boot->nmt);
+
 	co_nmt_boot_emit_time(boot, NULL);
 
 	return 0;
 }
 
+void
+co_nmt_boot_get_times(
+		const co_nmt_boot_t *boot, struct co_nmt_boot_times *ptimes)
+{
+	assert(boot);
+	assert(ptimes);
+
+	*ptimes = boot->times;
+
+	struct timespec now = { 0, 0 };
+	can_net_get_time(boot->net, &now);
+	// Include the duration of the current phase.
+	if (boot->phase >= 0)
+		ptimes->phase[boot->phase] += timespec_diff_usec(
+				&now, &boot->phase_start);
+	ptimes->total = timespec_diff_usec(&now, &boot->start);
+}
+
+void
+co_nmt_boot_get_rec(const co_nmt_boot_t *boot, struct co_nmt_boot_rec *prec)
+{
+	assert(boot);
+	assert(prec);
+
+	*prec = boot->rec;
+}
+
 static int
 co_nmt_boot_recv(const struct can_msg *msg, void *data)
 {
@@ -1086,6 +1171,8 @@ co_nmt_boot_wait_on_time(co_nmt_boot_t *boot, const struct timespec *tp)
 	boot->st = 0;
 	boot->es = 0;
 
+	boot->times.attempts++;
+
 	// Retrieve the slave assignment for the node.
 	boot->assignment = co_dev_get_val_u32(boot->dev, 0x1f81, boot->id);
 
@@ -1127,6 +1214,9 @@ co_nmt_boot_abort_on_enter(co_nmt_boot_t *boot)
 	can_recv_stop(boot->recv);
 	can_timer_stop(boot->timer);
 
+	// Do not attribute the time until the next attempt to any phase.
+	co_nmt_boot_set_phase(boot, -1);
+
 	// If the node is already operational, end the 'boot slave' process with
 	// error status L.
 	if (!boot->es && (boot->st & ~CO_NMT_ST_TOGGLE) == CO_NMT_ST_START)
@@ -1182,8 +1272,13 @@ co_nmt_boot_chk_device_type_on_enter(co_nmt_boot_t *boot)
 {
 	assert(boot);
 
+	co_nmt_boot_set_phase(boot, CO_NMT_BOOT_PHASE_ID);
+
 	boot->es = 'B';
 
+	boot->hit = 0;
+	boot->rec = (struct co_nmt_boot_rec)CO_NMT_BOOT_REC_INIT;
+
 	// The device type check may follow an NMT 'reset communication'
 	// command, in which case we may have to give the slave some time to
 	// complete the state change. Start the first SDO request by simulating
@@ -1223,8 +1318,19 @@ co_nmt_boot_chk_device_type_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 		boot->es = 'C';
 		return co_nmt_boot_abort_state;
 	}
+	boot->rec.device_type = co_nmt_boot_get_u32(ptr, n);
 
 	can_recv_stop(boot->recv);
+
+	// If the device type and the expected identity and configuration of the
+	// slave match the boot cache record, skip reading the identity object.
+	// The configuration check verifies that the slave is still the one
+	// that was configured.
+	if (boot->cache && co_nmt_boot_chk_rec(boot)) {
+		boot->hit = 1;
+		return co_nmt_boot_chk_node_state;
+	}
+
 	return co_nmt_boot_chk_vendor_id_state;
 }
 
@@ -1265,6 +1371,7 @@ co_nmt_boot_chk_vendor_id_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 
 	if (ac || !co_nmt_boot_chk(boot, 0x1f85, boot->id, ptr, n))
 		return co_nmt_boot_abort_state;
+	boot->rec.vendor_id = co_nmt_boot_get_u32(ptr, n);
 
 	return co_nmt_boot_chk_product_code_state;
 }
@@ -1306,6 +1413,7 @@ co_nmt_boot_chk_product_code_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 
 	if (ac || !co_nmt_boot_chk(boot, 0x1f86, boot->id, ptr, n))
 		return co_nmt_boot_abort_state;
+	boot->rec.product_code = co_nmt_boot_get_u32(ptr, n);
 
 	return co_nmt_boot_chk_revision_state;
 }
@@ -1347,6 +1455,7 @@ co_nmt_boot_chk_revision_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 
 	if (ac || !co_nmt_boot_chk(boot, 0x1f87, boot->id, ptr, n))
 		return co_nmt_boot_abort_state;
+	boot->rec.revision = co_nmt_boot_get_u32(ptr, n);
 
 	return co_nmt_boot_chk_serial_nr_state;
 }
@@ -1357,11 +1466,14 @@ co_nmt_boot_chk_serial_nr_on_enter(co_nmt_boot_t *boot)
 	assert(boot);
 
 	// If the expected serial number (sub-object 1F88:ID) is 0, skip the
-	// check and proceed to 'check node state'.
+	// check and proceed to 'check node state' (or to 'update
+	// configuration', if the identity is checked after a failed
+	// configuration check).
 	co_unsigned32_t serial_nr =
 			co_dev_get_val_u32(boot->dev, 0x1f88, boot->id);
 	if (!serial_nr)
-		return co_nmt_boot_chk_node_state;
+		return boot->hit < 0 ? co_nmt_boot_up_cfg_state
+				     : co_nmt_boot_chk_node_state;
 
 	boot->es = 'O';
 
@@ -1388,8 +1500,12 @@ co_nmt_boot_chk_serial_nr_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 
 	if (ac || !co_nmt_boot_chk(boot, 0x1f88, boot->id, ptr, n))
 		return co_nmt_boot_abort_state;
+	boot->rec.serial_nr = co_nmt_boot_get_u32(ptr, n);
 
-	return co_nmt_boot_chk_node_state;
+	// If the identity was checked after a failed configuration check,
+	// proceed to 'update configuration'.
+	return boot->hit < 0 ? co_nmt_boot_up_cfg_state
+			     : co_nmt_boot_chk_node_state;
 }
 
 static co_nmt_boot_state_t *
@@ -1397,6 +1513,8 @@ co_nmt_boot_chk_node_on_enter(co_nmt_boot_t *boot)
 {
 	assert(boot);
 
+	co_nmt_boot_set_phase(boot, CO_NMT_BOOT_PHASE_NODE);
+
 	// If the keep-alive bit is set, check the node state.
 	if (boot->assignment & 0x10) {
 		int ms;
@@ -1510,6 +1628,8 @@ co_nmt_boot_chk_sw_on_enter(co_nmt_boot_t *boot)
 {
 	assert(boot);
 
+	co_nmt_boot_set_phase(boot, CO_NMT_BOOT_PHASE_SW);
+
 	if (boot->assignment & 0x20) {
 		boot->es = 'G';
 
@@ -2026,6 +2146,8 @@ co_nmt_boot_chk_cfg_date_on_enter(co_nmt_boot_t *boot)
 {
 	assert(boot);
 
+	co_nmt_boot_set_phase(boot, CO_NMT_BOOT_PHASE_CFG);
+
 	boot->es = 'J';
 
 	// If the expected configuration date (sub-object 1F26:ID) or time
@@ -2072,7 +2194,7 @@ co_nmt_boot_chk_cfg_date_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 	// If the configuration date does not match the expected value, skip
 	// checking the time and proceed to 'update configuration'.
 	if (ac || !co_nmt_boot_chk(boot, 0x1f26, boot->id, ptr, n))
-		return co_nmt_boot_up_cfg_state;
+		return co_nmt_boot_chk_cfg_fail(boot);
 
 	// Read the configuration time of the slave (sub-object 1020:02).
 	if (co_nmt_boot_up(boot, 0x1020, 0x02) == -1)
@@ -2098,7 +2220,10 @@ co_nmt_boot_chk_cfg_time_on_up_con(co_nmt_boot_t *boot, co_unsigned32_t ac,
 	// If the configuration time does not match the expected value, proceed
 	// to 'update configuration'.
 	if (ac || !co_nmt_boot_chk(boot, 0x1f27, boot->id, ptr, n))
-		return co_nmt_boot_up_cfg_state;
+		return co_nmt_boot_chk_cfg_fail(boot);
+
+	boot->rec.cfg_date = co_dev_get_val_u32(boot->dev, 0x1f26, boot->id);
+	boot->rec.cfg_time = co_dev_get_val_u32(boot->dev, 0x1f27, boot->id);
 
 	return co_nmt_boot_ec_state;
 }
@@ -2126,11 +2251,7 @@ co_nmt_boot_up_cfg_on_enter(co_nmt_boot_t *boot)
 static co_nmt_boot_state_t *
 co_nmt_boot_up_cfg_on_cfg_con(co_nmt_boot_t *boot, co_unsigned32_t ac)
 {
-#if LELY_NO_STDIO
-	(void)boot;
-#else
 	assert(boot);
-#endif
 
 	if (ac) {
 #if !LELY_NO_STDIO
@@ -2142,6 +2263,11 @@ co_nmt_boot_up_cfg_on_cfg_con(co_nmt_boot_t *boot, co_unsigned32_t ac)
 		return co_nmt_boot_abort_state;
 	}
 
+	// Record the expected configuration date and time, which the slave is
+	// now assumed to have.
+	boot->rec.cfg_date = co_dev_get_val_u32(boot->dev, 0x1f26, boot->id);
+	boot->rec.cfg_time = co_dev_get_val_u32(boot->dev, 0x1f27, boot->id);
+
 	return co_nmt_boot_ec_state;
 }
 
@@ -2150,6 +2276,8 @@ co_nmt_boot_ec_on_enter(co_nmt_boot_t *boot)
 {
 	assert(boot);
 
+	co_nmt_boot_set_phase(boot, CO_NMT_BOOT_PHASE_EC);
+
 	if (boot->ms) {
 		boot->es = 'K';
 		// Start the CAN frame receiver for heartbeat messages.
@@ -2238,6 +2366,85 @@ co_nmt_boot_chk(co_nmt_boot_t *boot, co_unsigned16_t idx, co_unsigned8_t subidx,
 	return !co_val_cmp(type, &val, co_sub_get_val(sub));
 }
 
+static co_unsigned32_t
+co_nmt_boot_get_u32(const void *ptr, size_t n)
+{
+	co_unsigned32_t val = 0;
+	// clang-format off
+	if (!co_val_read(CO_DEFTYPE_UNSIGNED32, &val, ptr,
+			(const uint_least8_t *)ptr + n))
+		// clang-format on
+		return 0;
+	return val;
+}
+
+static int
+co_nmt_boot_chk_rec(co_nmt_boot_t *boot)
+{
+	assert(boot);
+
+	struct co_nmt_boot_rec rec = CO_NMT_BOOT_REC_INIT;
+	if (co_nmt_get_boot_rec(boot->nmt, boot->id, &rec) != 1)
+		return 0;
+
+	const co_dev_t *dev = boot->dev;
+	co_unsigned8_t id = boot->id;
+	// clang-format off
+	if (rec.device_type != boot->rec.device_type
+			|| rec.vendor_id != co_dev_get_val_u32(dev, 0x1f85, id)
+			|| rec.product_code
+					!= co_dev_get_val_u32(dev, 0x1f86, id)
+			|| rec.revision != co_dev_get_val_u32(dev, 0x1f87, id)
+			|| rec.serial_nr != co_dev_get_val_u32(dev, 0x1f88, id)
+			|| rec.cfg_date != co_dev_get_val_u32(dev, 0x1f26, id)
+			|| rec.cfg_time != co_dev_get_val_u32(dev, 0x1f27, id))
+		// clang-format on
+		return 0;
+
+	boot->rec.vendor_id = rec.vendor_id;
+	boot->rec.product_code = rec.product_code;
+	boot->rec.revision = rec.revision;
+	boot->rec.serial_nr = rec.serial_nr;
+	return 1;
+}
+
+static co_nmt_boot_state_t *
+co_nmt_boot_chk_cfg_fail(co_nmt_boot_t *boot)
+{
+	assert(boot);
+
+	if (boot->hit <= 0)
+		return co_nmt_boot_up_cfg_state;
+
+	// The slave lost its configuration or was replaced by a device that
+	// has not been configured. Do not update the configuration before its
+	// identity has been checked.
+	co_nmt_set_boot_rec(boot->nmt, boot->id, NULL);
+	boot->hit = -1;
+	boot->rec.vendor_id = 0;
+	boot->rec.product_code = 0;
+	boot->rec.revision = 0;
+	boot->rec.serial_nr = 0;
+	return co_nmt_boot_chk_vendor_id_state;
+}
+
+static void
+co_nmt_boot_set_phase(co_nmt_boot_t *boot, int phase)
+{
+	assert(boot);
+	assert(phase < CO_NMT_BOOT_NUM_PHASE);
+
+	struct timespec now = { 0, 0 };
+	can_net_get_time(boot->net, &now);
+
+	if (boot->phase >= 0)
+		boot->times.phase[boot->phase] += timespec_diff_usec(
+				&now, &boot->phase_start);
+
+	boot->phase = phase;
+	boot->phase_start = now;
+}
+
 #if !LELY_NO_CO_NG
 static int
 co_nmt_boot_send_rtr(co_nmt_boot_t *boot)
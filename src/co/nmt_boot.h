@@ -91,6 +91,28 @@ void co_nmt_boot_destroy(co_nmt_boot_t *boot);
 int co_nmt_boot_boot_req(co_nmt_boot_t *boot, co_unsigned8_t id, int timeout,
 		co_csdo_ind_t *dn_ind, co_csdo_ind_t *up_ind, void *data);
 
+/**
+ * Retrieves the durations of the phases of a CANopen NMT 'boot slave' service.
+ * The durations are measured from the creation of the service; the
+ * #CO_NMT_BOOT_PHASE_QUEUE phase is not included.
+ *
+ * @param boot   a pointer to an NMT 'boot slave' service.
+ * @param ptimes the address at which to store the durations.
+ */
+void co_nmt_boot_get_times(const co_nmt_boot_t *boot,
+		struct co_nmt_boot_times *ptimes);
+
+/**
+ * Retrieves the identity and configuration of the slave as determined by a
+ * CANopen NMT 'boot slave' service. The configuration date and time are only
+ * set if the slave was found, or made, to have the expected configuration.
+ *
+ * @param boot a pointer to an NMT 'boot slave' service.
+ * @param prec the address at which to store the record.
+ */
+void co_nmt_boot_get_rec(
+		const co_nmt_boot_t *boot, struct co_nmt_boot_rec *prec);
+
 #ifdef __cplusplus
 }
 #endif
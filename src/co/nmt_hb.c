@@ -25,26 +25,29 @@
 #include "co.h"
 #include <lely/co/dev.h>
 #include <lely/util/diag.h>
+#include <lely/util/time.h>
 
 #include <assert.h>
 #include <stdlib.h>
 
-/// A CANopen NMT heartbeat consumer.
-struct __co_nmt_hb {
-	/// A pointer to a CAN network interface.
-	can_net_t *net;
-	/// A pointer to an NMT master/slave service.
-	co_nmt_t *nmt;
-	/// A pointer to the CAN frame receiver.
+/// The state of the heartbeat consumer for a single remote node.
+struct co_nmt_hb_node {
+	/**
+	 * A pointer to the CAN frame receiver for the error control messages of
+	 * the node. The receiver is only created once it is needed.
+	 */
 	can_recv_t *recv;
-	/// A pointer to the CAN timer.
-	can_timer_t *timer;
-	/// The node-ID.
-	co_unsigned8_t id;
-	/// The state of the node (excluding the toggle bit).
-	co_unsigned8_t st;
+	/// The time at which the next heartbeat timeout occurs.
+	struct timespec deadline;
 	/// The consumer heartbeat time (in milliseconds).
 	co_unsigned16_t ms;
+	/// The state of the node (excluding the toggle bit).
+	co_unsigned8_t st;
+	/**
+	 * The position of the node in the deadline heap, plus one, or 0 if no
+	 * deadline is set.
+	 */
+	co_unsigned8_t pos;
 	/**
 	 * Indicates whether a heartbeat error occurred (#CO_NMT_EC_OCCURRED or
 	 * #CO_NMT_EC_RESOLVED).
@@ -52,20 +55,84 @@ struct __co_nmt_hb {
 	int state;
 };
 
+/// A CANopen NMT error control engine.
+struct __co_nmt_hb {
+	/// A pointer to a CAN network interface.
+	can_net_t *net;
+	/// A pointer to an NMT master/slave service.
+	co_nmt_t *nmt;
+	/// A pointer to the CAN timer for the earliest deadline.
+	can_timer_t *timer;
+#if !LELY_NO_CO_MASTER
+	/**
+	 * A flag indicating whether the error control messages of all nodes are
+	 * forwarded to the NMT master.
+	 */
+	int master;
+#endif
+	/// The heartbeat consumer states, indexed by node-ID - 1.
+	struct co_nmt_hb_node nodes[CO_NUM_NODES];
+	/// A binary min-heap of node-IDs, ordered by deadline.
+	co_unsigned8_t heap[CO_NUM_NODES];
+	/// The number of node-IDs in #heap.
+	co_unsigned8_t nheap;
+	/// The deadline for which #timer is running (if #armed is 1).
+	struct timespec next;
+	/// A flag indicating whether #timer is running.
+	int armed;
+};
+
 /**
- * The CAN receive callback function for a heartbeat consumer.
+ * The CAN receive callback function for the error control engine.
  *
  * @see can_recv_func_t
  */
 static int co_nmt_hb_recv(const struct can_msg *msg, void *data);
 
 /**
- * The CAN timer callback function for a heartbeat consumer.
+ * The CAN timer callback function for the error control engine.
  *
  * @see can_timer_func_t
  */
 static int co_nmt_hb_timer(const struct timespec *tp, void *data);
 
+/**
+ * Processes a heartbeat message from an active heartbeat consumer.
+ *
+ * @returns 1 if the message was consumed, and 0 if not.
+ */
+static int co_nmt_hb_recv_st(
+		co_nmt_hb_t *hb, co_unsigned8_t id, const struct can_msg *msg);
+
+/**
+ * Starts or stops the CAN frame receiver for the specified node, depending on
+ * whether its heartbeat consumer is active or the NMT master is listening.
+ */
+static void co_nmt_hb_update_recv(co_nmt_hb_t *hb, co_unsigned8_t id);
+
+/// (Re)starts or stops the CAN timer for the earliest deadline, if necessary.
+static void co_nmt_hb_update_timer(co_nmt_hb_t *hb);
+
+/// Returns 1 if the deadline at heap position <b>i</b> precedes <b>j</b>.
+static inline int co_nmt_hb_less(
+		const co_nmt_hb_t *hb, co_unsigned8_t i, co_unsigned8_t j);
+
+/// Swaps the node-IDs at heap positions <b>i</b> and <b>j</b>.
+static inline void co_nmt_hb_swap(
+		co_nmt_hb_t *hb, co_unsigned8_t i, co_unsigned8_t j);
+
+/// Restores the heap property after the deadline at <b>i</b> decreased.
+static void co_nmt_hb_sift_up(co_nmt_hb_t *hb, co_unsigned8_t i);
+
+/// Restores the heap property after the deadline at <b>i</b> increased.
+static void co_nmt_hb_sift_down(co_nmt_hb_t *hb, co_unsigned8_t i);
+
+/// Inserts a node in, or moves it within, the deadline heap.
+static void co_nmt_hb_push(co_nmt_hb_t *hb, co_unsigned8_t id);
+
+/// Removes a node from the deadline heap, if present.
+static void co_nmt_hb_remove(co_nmt_hb_t *hb, co_unsigned8_t id);
+
 void *
 __co_nmt_hb_alloc(void)
 {
@@ -95,13 +162,6 @@ __co_nmt_hb_init(struct __co_nmt_hb *hb, can_net_t *net, co_nmt_t *nmt)
 	hb->net = net;
 	hb->nmt = nmt;
 
-	hb->recv = can_recv_create();
-	if (!hb->recv) {
-		errc = get_errc();
-		goto error_create_recv;
-	}
-	can_recv_set_func(hb->recv, &co_nmt_hb_recv, hb);
-
 	hb->timer = can_timer_create();
 	if (!hb->timer) {
 		errc = get_errc();
@@ -109,17 +169,28 @@ __co_nmt_hb_init(struct __co_nmt_hb *hb, can_net_t *net, co_nmt_t *nmt)
 	}
 	can_timer_set_func(hb->timer, &co_nmt_hb_timer, hb);
 
-	hb->id = 0;
-	hb->st = 0;
-	hb->ms = 0;
-	hb->state = CO_NMT_EC_RESOLVED;
+#if !LELY_NO_CO_MASTER
+	hb->master = 0;
+#endif
+
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++) {
+		struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+		node->recv = NULL;
+		node->deadline = (struct timespec){ 0, 0 };
+		node->ms = 0;
+		node->st = 0;
+		node->pos = 0;
+		node->state = CO_NMT_EC_RESOLVED;
+		hb->heap[id - 1] = 0;
+	}
+	hb->nheap = 0;
+
+	hb->next = (struct timespec){ 0, 0 };
+	hb->armed = 0;
 
 	return hb;
 
-	// can_timer_destroy(hb->timer);
 error_create_timer:
-	can_recv_destroy(hb->recv);
-error_create_recv:
 	set_errc(errc);
 	return NULL;
 }
@@ -129,8 +200,10 @@ __co_nmt_hb_fini(struct __co_nmt_hb *hb)
 {
 	assert(hb);
 
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		can_recv_destroy(hb->nodes[id - 1].recv);
+
 	can_timer_destroy(hb->timer);
-	can_recv_destroy(hb->recv);
 }
 
 co_nmt_hb_t *
@@ -172,43 +245,120 @@ co_nmt_hb_set_1016(co_nmt_hb_t *hb, co_unsigned8_t id, co_unsigned16_t ms)
 {
 	assert(hb);
 
-	can_recv_stop(hb->recv);
-	can_timer_stop(hb->timer);
+	if (!id || id > CO_NUM_NODES)
+		return;
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
 
-	hb->id = id;
-	hb->st = 0;
-	hb->ms = ms;
-	hb->state = CO_NMT_EC_RESOLVED;
+	co_nmt_hb_remove(hb, id);
 
-	if (hb->id && hb->id <= CO_NUM_NODES && hb->ms) {
-		can_recv_start(hb->recv, hb->net, CO_NMT_EC_CANID(hb->id), 0);
-	} else {
-		can_recv_stop(hb->recv);
-		can_timer_stop(hb->timer);
-	}
+	node->st = 0;
+	node->ms = ms;
+	node->state = CO_NMT_EC_RESOLVED;
+
+	co_nmt_hb_update_recv(hb, id);
+	co_nmt_hb_update_timer(hb);
 }
 
 void
-co_nmt_hb_set_st(co_nmt_hb_t *hb, co_unsigned8_t st)
+co_nmt_hb_set_st(co_nmt_hb_t *hb, co_unsigned8_t id, co_unsigned8_t st)
 {
 	assert(hb);
 
-	if (hb->id && hb->id <= CO_NUM_NODES && hb->ms) {
-		hb->st = st;
-		hb->state = CO_NMT_EC_RESOLVED;
-		// Reset the CAN timer for the heartbeat consumer.
-		can_timer_timeout(hb->timer, hb->net, hb->ms);
+	if (!id || id > CO_NUM_NODES)
+		return;
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+
+	if (node->ms) {
+		node->st = st;
+		node->state = CO_NMT_EC_RESOLVED;
+		// Reset the deadline for the heartbeat consumer.
+		can_net_get_time(hb->net, &node->deadline);
+		timespec_add_msec(&node->deadline, node->ms);
+		co_nmt_hb_push(hb, id);
+		co_nmt_hb_update_timer(hb);
 	}
 }
 
+#if !LELY_NO_CO_MASTER
+void
+co_nmt_hb_set_master(co_nmt_hb_t *hb, int master)
+{
+	assert(hb);
+
+	master = !!master;
+	if (master == hb->master)
+		return;
+	hb->master = master;
+
+	for (co_unsigned8_t id = 1; id <= CO_NUM_NODES; id++)
+		co_nmt_hb_update_recv(hb, id);
+}
+#endif
+
 static int
 co_nmt_hb_recv(const struct can_msg *msg, void *data)
 {
 	assert(msg);
+	assert(msg->id > 0x700 && msg->id <= 0x77f);
 	co_nmt_hb_t *hb = data;
 	assert(hb);
-	assert(hb->id && hb->id <= CO_NUM_NODES);
-	assert(msg->id == (uint_least32_t)CO_NMT_EC_CANID(hb->id));
+
+	co_unsigned8_t id = msg->id & 0x7f;
+	if (co_nmt_hb_recv_st(hb, id, msg))
+		return 1;
+
+#if !LELY_NO_CO_MASTER
+	if (hb->master)
+		return co_nmt_ec_ind(hb->nmt, msg);
+#endif
+	return 0;
+}
+
+static int
+co_nmt_hb_timer(const struct timespec *tp, void *data)
+{
+	assert(tp);
+	co_nmt_hb_t *hb = data;
+	assert(hb);
+
+	hb->armed = 0;
+
+	// Handle all expired deadlines. The heap is inspected again after each
+	// indication, since the user may have modified the heartbeat consumers.
+	while (hb->nheap) {
+		co_unsigned8_t id = hb->heap[0];
+		struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+		if (timespec_cmp(&node->deadline, tp) > 0)
+			break;
+		co_nmt_hb_remove(hb, id);
+
+		// Notify the application of the occurrence of a heartbeat
+		// timeout event.
+		diag(DIAG_INFO, 0,
+				"NMT: heartbeat time out occurred for node %d",
+				id);
+		node->state = CO_NMT_EC_OCCURRED;
+		co_nmt_hb_ind(hb->nmt, id, node->state, CO_NMT_EC_TIMEOUT, 0);
+	}
+
+	co_nmt_hb_update_timer(hb);
+
+	return 0;
+}
+
+static int
+co_nmt_hb_recv_st(co_nmt_hb_t *hb, co_unsigned8_t id, const struct can_msg *msg)
+{
+	assert(hb);
+	assert(id && id <= CO_NUM_NODES);
+	assert(msg);
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+
+	// This might happen upon receipt of a boot-up message. The 'boot slave'
+	// process has disabled the heartbeat consumer, but the event has
+	// already been scheduled.
+	if (!node->ms)
+		return 0;
 
 	// Obtain the node status from the CAN frame. Ignore if the toggle bit
 	// is set, since then it is not a heartbeat message.
@@ -223,32 +373,27 @@ co_nmt_hb_recv(const struct can_msg *msg, void *data)
 	if (st == CO_NMT_ST_BOOTUP && co_nmt_is_master(hb->nmt))
 		return 0;
 
-	// This might happen upon receipt of a boot-up message. The 'boot slave'
-	// process has disabled the heartbeat consumer, but the event has
-	// already been scheduled.
-	if (!hb->ms)
-		return 0;
-
 	// Update the state.
-	co_unsigned8_t old_st = hb->st;
-	int old_state = hb->state;
-	co_nmt_hb_set_st(hb, st);
+	co_unsigned8_t old_st = node->st;
+	int old_state = node->state;
+	co_nmt_hb_set_st(hb, id, st);
 
 	if (old_state == CO_NMT_EC_OCCURRED) {
 		diag(DIAG_INFO, 0,
 				"NMT: heartbeat time out resolved for node %d",
-				hb->id);
+				id);
 		// If a heartbeat timeout event occurred, notify the user that
 		// it has been resolved.
-		co_nmt_hb_ind(hb->nmt, hb->id, hb->state, CO_NMT_EC_TIMEOUT, 0);
+		co_nmt_hb_ind(hb->nmt, id, CO_NMT_EC_RESOLVED,
+				CO_NMT_EC_TIMEOUT, 0);
 	}
 
 	// Notify the application of the occurrence of a state change.
 	if (st != old_st) {
 		diag(DIAG_INFO, 0,
 				"NMT: heartbeat state change occurred for node %d",
-				hb->id);
-		co_nmt_hb_ind(hb->nmt, hb->id, CO_NMT_EC_OCCURRED,
+				id);
+		co_nmt_hb_ind(hb->nmt, id, CO_NMT_EC_OCCURRED,
 				CO_NMT_EC_STATE, st);
 	}
 
@@ -256,19 +401,160 @@ co_nmt_hb_recv(const struct can_msg *msg, void *data)
 	return 1;
 }
 
-static int
-co_nmt_hb_timer(const struct timespec *tp, void *data)
+static void
+co_nmt_hb_update_recv(co_nmt_hb_t *hb, co_unsigned8_t id)
 {
-	(void)tp;
-	co_nmt_hb_t *hb = data;
 	assert(hb);
+	assert(id && id <= CO_NUM_NODES);
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
 
-	// Notify the application of the occurrence of a heartbeat timeout
-	// event.
-	diag(DIAG_INFO, 0, "NMT: heartbeat time out occurred for node %d",
-			hb->id);
-	hb->state = CO_NMT_EC_OCCURRED;
-	co_nmt_hb_ind(hb->nmt, hb->id, hb->state, CO_NMT_EC_TIMEOUT, 0);
+	int active = node->ms != 0;
+#if !LELY_NO_CO_MASTER
+	active = active || hb->master;
+#endif
+	if (!active) {
+		if (node->recv)
+			can_recv_stop(node->recv);
+		return;
+	}
 
-	return 0;
+	if (!node->recv) {
+		node->recv = can_recv_create();
+		if (!node->recv) {
+			diag(DIAG_ERROR, get_errc(),
+					"unable to create CAN frame receiver for node %d",
+					id);
+			return;
+		}
+		can_recv_set_func(node->recv, &co_nmt_hb_recv, hb);
+	}
+	can_recv_start(node->recv, hb->net, CO_NMT_EC_CANID(id), 0);
+}
+
+static void
+co_nmt_hb_update_timer(co_nmt_hb_t *hb)
+{
+	assert(hb);
+
+	if (!hb->nheap) {
+		if (hb->armed) {
+			can_timer_stop(hb->timer);
+			hb->armed = 0;
+		}
+		return;
+	}
+
+	// Only reprogram the CAN timer if the earliest deadline changed.
+	const struct timespec *next = &hb->nodes[hb->heap[0] - 1].deadline;
+	if (hb->armed && !timespec_cmp(&hb->next, next))
+		return;
+	hb->next = *next;
+	hb->armed = 1;
+	can_timer_start(hb->timer, hb->net, &hb->next, NULL);
+}
+
+static inline int
+co_nmt_hb_less(const co_nmt_hb_t *hb, co_unsigned8_t i, co_unsigned8_t j)
+{
+	assert(hb);
+	assert(i < hb->nheap);
+	assert(j < hb->nheap);
+
+	return timespec_cmp(&hb->nodes[hb->heap[i] - 1].deadline,
+				       &hb->nodes[hb->heap[j] - 1].deadline)
+			< 0;
+}
+
+static inline void
+co_nmt_hb_swap(co_nmt_hb_t *hb, co_unsigned8_t i, co_unsigned8_t j)
+{
+	assert(hb);
+	assert(i < hb->nheap);
+	assert(j < hb->nheap);
+
+	co_unsigned8_t id = hb->heap[i];
+	hb->heap[i] = hb->heap[j];
+	hb->heap[j] = id;
+
+	hb->nodes[hb->heap[i] - 1].pos = i + 1;
+	hb->nodes[hb->heap[j] - 1].pos = j + 1;
+}
+
+static void
+co_nmt_hb_sift_up(co_nmt_hb_t *hb, co_unsigned8_t i)
+{
+	assert(hb);
+
+	while (i) {
+		co_unsigned8_t parent = (i - 1) / 2;
+		if (!co_nmt_hb_less(hb, i, parent))
+			break;
+		co_nmt_hb_swap(hb, i, parent);
+		i = parent;
+	}
+}
+
+static void
+co_nmt_hb_sift_down(co_nmt_hb_t *hb, co_unsigned8_t i)
+{
+	assert(hb);
+
+	for (;;) {
+		size_t min = i;
+		size_t left = 2 * (size_t)i + 1;
+		size_t right = left + 1;
+		if (left < hb->nheap && co_nmt_hb_less(hb, left, min))
+			min = left;
+		if (right < hb->nheap && co_nmt_hb_less(hb, right, min))
+			min = right;
+		if (min == i)
+			break;
+		co_nmt_hb_swap(hb, i, min);
+		i = min;
+	}
+}
+
+static void
+co_nmt_hb_push(co_nmt_hb_t *hb, co_unsigned8_t id)
+{
+	assert(hb);
+	assert(id && id <= CO_NUM_NODES);
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+
+	if (!node->pos) {
+		assert(hb->nheap < CO_NUM_NODES);
+		hb->heap[hb->nheap++] = id;
+		node->pos = hb->nheap;
+		co_nmt_hb_sift_up(hb, node->pos - 1);
+	} else {
+		// The deadline can only have moved forward, since the clock of
+		// the CAN network interface is monotonic, but restore the heap
+		// property in both directions to be safe.
+		co_nmt_hb_sift_up(hb, node->pos - 1);
+		co_nmt_hb_sift_down(hb, node->pos - 1);
+	}
+}
+
+static void
+co_nmt_hb_remove(co_nmt_hb_t *hb, co_unsigned8_t id)
+{
+	assert(hb);
+	assert(id && id <= CO_NUM_NODES);
+	struct co_nmt_hb_node *node = &hb->nodes[id - 1];
+
+	if (!node->pos)
+		return;
+
+	co_unsigned8_t i = node->pos - 1;
+	co_unsigned8_t last = --hb->nheap;
+	node->pos = 0;
+	if (i == last)
+		return;
+
+	// Move the last node-ID into the vacated position.
+	co_unsigned8_t moved = hb->heap[last];
+	hb->heap[i] = moved;
+	hb->nodes[moved - 1].pos = i + 1;
+	co_nmt_hb_sift_up(hb, i);
+	co_nmt_hb_sift_down(hb, hb->nodes[moved - 1].pos - 1);
 }
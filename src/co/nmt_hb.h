@@ -28,7 +28,11 @@
 
 struct __co_nmt_hb;
 #ifndef __cplusplus
-/// An opaque CANopen NMT heartbeat consumer type.
+/**
+ * An opaque CANopen NMT error control engine type. A single engine monitors the
+ * heartbeat messages of all remote nodes (0x701..0x77F) and, if the NMT service
+ * is a master, forwards the other error control messages to the master.
+ */
 typedef struct __co_nmt_hb co_nmt_hb_t;
 #endif
 
@@ -52,6 +56,20 @@ extern "C" {
 void co_nmt_hb_ind(co_nmt_t *nmt, co_unsigned8_t id, int state, int reason,
 		co_unsigned8_t st);
 
+#if !LELY_NO_CO_MASTER
+/**
+ * The CANopen NMT error control indication function, invoked by the error
+ * control engine of an NMT master when a boot-up, heartbeat or node guarding
+ * message is received which is not consumed by an active heartbeat consumer.
+ *
+ * @param nmt a pointer to an NMT master service.
+ * @param msg a pointer to the received CAN frame.
+ *
+ * @returns 1 if the frame was processed, and 0 if not.
+ */
+int co_nmt_ec_ind(co_nmt_t *nmt, const struct can_msg *msg);
+#endif
+
 void *__co_nmt_hb_alloc(void);
 void __co_nmt_hb_free(void *ptr);
 struct __co_nmt_hb *__co_nmt_hb_init(
@@ -59,45 +77,60 @@ struct __co_nmt_hb *__co_nmt_hb_init(
 void __co_nmt_hb_fini(struct __co_nmt_hb *hb);
 
 /**
- * Creates a new CANopen NMT heartbeat consumer service.
+ * Creates a new CANopen NMT error control engine. Initially, no heartbeat
+ * consumers are active.
  *
  * @param net a pointer to a CAN network.
  * @param nmt a pointer to an NMT master/slave service.
  *
- * @returns a pointer to a new heartbeat consumer service, or NULL on error. In
- * the latter case, the error number can be obtained with get_errc().
+ * @returns a pointer to a new error control engine, or NULL on error. In the
+ * latter case, the error number can be obtained with get_errc().
  *
  * @see co_nmt_hb_destroy()
  */
 co_nmt_hb_t *co_nmt_hb_create(can_net_t *net, co_nmt_t *nmt);
 
-/// Destroys a CANopen NMT heartbeat consumer service. @see co_nmt_hb_create()
+/// Destroys a CANopen NMT error control engine. @see co_nmt_hb_create()
 void co_nmt_hb_destroy(co_nmt_hb_t *hb);
 
 /**
- * Processes the value of CANopen object 1016 (Consumer heartbeat time) for the
- * specified heartbeat consumer. If the node-ID is valid and the heartbeat time
- * is non-zero, the heartbeat consumer is activated. Note that this only
- * activates the CAN frame receiver for heartbeat messages. The CAN timer for
- * heartbeat events is not activated until the first heartbeat message is
- * received or co_nmt_hb_set_st() is invoked.
+ * Processes a sub-object of CANopen object 1016 (Consumer heartbeat time) for
+ * the specified node. If the node-ID is valid and the heartbeat time is
+ * non-zero, the heartbeat consumer for the node is activated, otherwise it is
+ * deactivated. Note that this only activates the reception of heartbeat
+ * messages. The deadline for heartbeat events is not set until the first
+ * heartbeat message is received or co_nmt_hb_set_st() is invoked.
  *
- * @param hb a pointer to a heartbeat consumer service.
+ * @param hb a pointer to an error control engine.
  * @param id the node-ID.
  * @param ms the heartbeat time (in milliseconds).
  */
 void co_nmt_hb_set_1016(co_nmt_hb_t *hb, co_unsigned8_t id, co_unsigned16_t ms);
 
 /**
- * Sets the expected state of a remote NMT node. If the heartbeat consumer is
- * active, invocation of this function is equivalent to reception of a heartbeat
- * message with the specified state and will (re)activate the CAN timer for
- * heartbeat events.
+ * Sets the expected state of a remote NMT node. If the heartbeat consumer for
+ * the node is active, invocation of this function is equivalent to reception of
+ * a heartbeat message with the specified state and will (re)set the deadline
+ * for heartbeat events.
  *
- * @param hb a pointer to a heartbeat consumer service.
+ * @param hb a pointer to an error control engine.
+ * @param id the node-ID.
  * @param st the state of the node (excluding the toggle bit).
  */
-void co_nmt_hb_set_st(co_nmt_hb_t *hb, co_unsigned8_t st);
+void co_nmt_hb_set_st(co_nmt_hb_t *hb, co_unsigned8_t id, co_unsigned8_t st);
+
+#if !LELY_NO_CO_MASTER
+/**
+ * Enables or disables the reception of the error control messages of all
+ * remote nodes on behalf of an NMT master. If enabled, messages not consumed
+ * by an active heartbeat consumer are passed to co_nmt_ec_ind().
+ *
+ * @param hb     a pointer to an error control engine.
+ * @param master a flag indicating whether the messages should be forwarded to
+ *               the NMT master.
+ */
+void co_nmt_hb_set_master(co_nmt_hb_t *hb, int master);
+#endif
 
 #ifdef __cplusplus
 }
@@ -64,6 +64,10 @@ struct __co_sync {
 	co_sync_err_t *err;
 	/// A pointer to user-specified data for #err.
 	void *err_data;
+	/// A pointer to the scheduling function.
+	co_sync_sched_t *sched;
+	/// A pointer to user-specified data for #sched.
+	void *sched_data;
 };
 
 /**
@@ -73,6 +77,12 @@ struct __co_sync {
  */
 static void co_sync_update(co_sync_t *sync);
 
+/**
+ * Starts or stops the SYNC timer, or invokes the scheduling function, depending
+ * on whether the SYNC service is an active producer.
+ */
+static void co_sync_update_timer(co_sync_t *sync);
+
 /**
  * The download indication function for (all sub-objects of) CANopen object 1005
  * (COB-ID SYNC message).
@@ -176,6 +186,8 @@ __co_sync_init(struct __co_sync *sync, can_net_t *net, co_dev_t *dev)
 	sync->ind_data = NULL;
 	sync->err = NULL;
 	sync->err_data = NULL;
+	sync->sched = NULL;
+	sync->sched_data = NULL;
 
 	if (co_sync_start(sync) == -1) {
 		errc = get_errc();
@@ -290,6 +302,8 @@ co_sync_stop(co_sync_t *sync)
 		return;
 
 	can_timer_stop(sync->timer);
+	if (sync->sched)
+		sync->sched(sync, NULL, NULL, sync->sched_data);
 	can_recv_stop(sync->recv);
 
 	// Remove the download indication function for the synchronous counter
@@ -376,6 +390,65 @@ co_sync_set_err(co_sync_t *sync, co_sync_err_t *err, void *data)
 	sync->err_data = data;
 }
 
+void
+co_sync_get_sched(const co_sync_t *sync, co_sync_sched_t **psched,
+		void **pdata)
+{
+	assert(sync);
+
+	if (psched)
+		*psched = sync->sched;
+	if (pdata)
+		*pdata = sync->sched_data;
+}
+
+void
+co_sync_set_sched(co_sync_t *sync, co_sync_sched_t *sched, void *data)
+{
+	assert(sync);
+
+	if (!sync->stopped && sync->sched)
+		sync->sched(sync, NULL, NULL, sync->sched_data);
+
+	sync->sched = sched;
+	sync->sched_data = data;
+
+	if (!sync->stopped)
+		co_sync_update_timer(sync);
+}
+
+void
+co_sync_stage(co_sync_t *sync, struct can_msg *msg)
+{
+	assert(sync);
+	assert(msg);
+
+	*msg = (struct can_msg)CAN_MSG_INIT;
+	msg->id = sync->cobid;
+	if (sync->cobid & CO_SYNC_COBID_FRAME) {
+		msg->id &= CAN_MASK_EID;
+		msg->flags |= CAN_FLAG_IDE;
+	} else {
+		msg->id &= CAN_MASK_BID;
+	}
+	if (sync->max_cnt) {
+		msg->len = 1;
+		msg->data[0] = sync->cnt;
+		sync->cnt = sync->cnt < sync->max_cnt ? sync->cnt + 1 : 1;
+	}
+}
+
+void
+co_sync_sent(co_sync_t *sync, const struct can_msg *msg)
+{
+	assert(sync);
+	assert(msg);
+
+	co_unsigned8_t cnt = msg->len ? msg->data[0] : 0;
+	if (sync->ind)
+		sync->ind(sync, cnt, sync->ind_data);
+}
+
 static void
 co_sync_update(co_sync_t *sync)
 {
@@ -398,6 +471,16 @@ co_sync_update(co_sync_t *sync)
 		can_recv_stop(sync->recv);
 	}
 
+	sync->cnt = 1;
+
+	co_sync_update_timer(sync);
+}
+
+static void
+co_sync_update_timer(co_sync_t *sync)
+{
+	assert(sync);
+
 	if ((sync->cobid & CO_SYNC_COBID_PRODUCER) && sync->us) {
 		// Start SYNC transmission at the next multiple of the SYNC
 		// period.
@@ -410,14 +493,22 @@ co_sync_update(co_sync_t *sync)
 		timespec_add_usec(&start, sync->us);
 		struct timespec interval = { 0, 0 };
 		timespec_add_usec(&interval, sync->us);
-		can_timer_start(sync->timer, sync->net, &start, &interval);
+		if (sync->sched) {
+			// Let the external time source transmit the SYNC
+			// messages.
+			can_timer_stop(sync->timer);
+			sync->sched(sync, &start, &interval, sync->sched_data);
+		} else {
+			can_timer_start(sync->timer, sync->net, &start,
+					&interval);
+		}
 	} else {
 		// Stop the SYNC timer unless we are an active SYNC producer
 		// (with a non-zero communication cycle period).
 		can_timer_stop(sync->timer);
+		if (sync->sched)
+			sync->sched(sync, NULL, NULL, sync->sched_data);
 	}
-
-	sync->cnt = 1;
 }
 
 static co_unsigned32_t
@@ -574,24 +665,10 @@ co_sync_timer(const struct timespec *tp, void *data)
 	co_sync_t *sync = data;
 	assert(sync);
 
-	struct can_msg msg = CAN_MSG_INIT;
-	msg.id = sync->cobid;
-	if (sync->cobid & CO_SYNC_COBID_FRAME) {
-		msg.id &= CAN_MASK_EID;
-		msg.flags |= CAN_FLAG_IDE;
-	} else {
-		msg.id &= CAN_MASK_BID;
-	}
-	if (sync->max_cnt) {
-		msg.len = 1;
-		msg.data[0] = sync->cnt;
-		sync->cnt = sync->cnt < sync->max_cnt ? sync->cnt + 1 : 1;
-	}
+	struct can_msg msg;
+	co_sync_stage(sync, &msg);
 	can_net_send(sync->net, &msg);
-
-	co_unsigned8_t cnt = msg.len ? msg.data[0] : 0;
-	if (sync->ind)
-		sync->ind(sync, cnt, sync->ind_data);
+	co_sync_sent(sync, &msg);
 
 	return 0;
 }
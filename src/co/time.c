@@ -30,13 +30,18 @@
 #include <lely/co/sdo.h>
 #include <lely/co/time.h>
 #include <lely/co/val.h>
+#include <lely/util/diag.h>
 #include <lely/util/endian.h>
 #include <lely/util/errnum.h>
 #include <lely/util/time.h>
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdlib.h>
 
+/// The resolution (in nanoseconds) of a CANopen TIME_OF_DAY value.
+#define CO_TIME_RES 1000000
+
 /// A CANopen TIME producer/consumer service.
 struct __co_time {
 	/// A pointer to a CAN network interface.
@@ -59,6 +64,24 @@ struct __co_time {
 	co_time_ind_t *ind;
 	/// A pointer to user-specified data for #ind.
 	void *data;
+	/**
+	 * A flag specifying whether the last time stamp sent is waiting for a
+	 * transmit confirmation.
+	 */
+	int txpending;
+	/// The time at which the last time stamp was queued.
+	struct timespec txtime;
+	/// A flag specifying whether the local clock is disciplined.
+	int discipline;
+	/// The local time at which the last time stamp was received.
+	struct timespec ref;
+	/**
+	 * The peak absolute residual (in nanoseconds) of the received time
+	 * stamps, decaying with each time stamp.
+	 */
+	int_least64_t jitter;
+	/// The statistics of the clock discipline.
+	struct co_time_clock_stats stats;
 };
 
 /**
@@ -91,6 +114,21 @@ static int co_time_recv(const struct can_msg *msg, void *data);
  */
 static int co_time_timer(const struct timespec *tp, void *data);
 
+/**
+ * Processes a time stamp with the clock discipline filter of a TIME consumer
+ * service.
+ *
+ * @param time   a pointer to a TIME consumer service.
+ * @param remote a pointer to the received time.
+ * @param local  a pointer to the local time at which the time stamp was
+ *               received.
+ */
+static void co_time_discipline(co_time_t *time, const struct timespec *remote,
+		const struct timespec *local);
+
+/// Adds a signed number of nanoseconds to a time.
+static void co_time_add_nsec(struct timespec *tp, int_least64_t nsec);
+
 void
 co_time_of_day_get(const co_time_of_day_t *tod, struct timespec *tp)
 {
@@ -206,6 +244,14 @@ __co_time_init(struct __co_time *time, can_net_t *net, co_dev_t *dev)
 	time->ind = NULL;
 	time->data = NULL;
 
+	time->txpending = 0;
+	time->txtime = (struct timespec){ 0, 0 };
+
+	time->discipline = 0;
+	time->ref = (struct timespec){ 0, 0 };
+	time->jitter = 0;
+	time->stats = (struct co_time_clock_stats)CO_TIME_CLOCK_STATS_INIT;
+
 	if (co_time_start(time) == -1) {
 		errc = get_errc();
 		goto error_start;
@@ -379,6 +425,113 @@ co_time_stop_prod(co_time_t *time)
 		can_timer_stop(time->timer);
 }
 
+int
+co_time_tx_con(co_time_t *time, const struct can_msg *msg,
+		const struct timespec *tp)
+{
+	assert(time);
+	assert(msg);
+	assert(tp);
+
+	if (!time->txpending || !(time->cobid & CO_TIME_COBID_PRODUCER))
+		return 0;
+
+	uint_least32_t id = time->cobid;
+	uint_least8_t flags = 0;
+	if (id & CO_TIME_COBID_FRAME) {
+		id &= CAN_MASK_EID;
+		flags |= CAN_FLAG_IDE;
+	} else {
+		id &= CAN_MASK_BID;
+	}
+	if (msg->id != id || (msg->flags & CAN_FLAG_IDE) != flags)
+		return 0;
+	time->txpending = 0;
+
+	int_least64_t delay = timespec_diff_nsec(tp, &time->txtime);
+	if (delay < 0)
+		delay = 0;
+	// Use an exponentially weighted moving average to smooth the delay.
+	int_least64_t *txdelay = &time->stats.txdelay;
+	if (*txdelay)
+		*txdelay += (delay - *txdelay) / 8;
+	else
+		*txdelay = delay;
+
+	return 1;
+}
+
+int
+co_time_get_discipline(const co_time_t *time)
+{
+	assert(time);
+
+	return time->discipline;
+}
+
+void
+co_time_set_discipline(co_time_t *time, int discipline)
+{
+	assert(time);
+
+	time->discipline = !!discipline;
+
+	// Restart the filter.
+	time->ref = (struct timespec){ 0, 0 };
+	time->jitter = 0;
+	time->stats.n = 0;
+	time->stats.nstep = 0;
+	time->stats.offset = 0;
+	time->stats.drift = 0;
+	time->stats.residual = 0;
+}
+
+int
+co_time_get_clock(const co_time_t *time, const struct timespec *local,
+		struct timespec *tp, uint_least64_t *perr)
+{
+	assert(time);
+	assert(tp);
+
+	if (!time->discipline || time->stats.n < LELY_CO_TIME_MIN_SAMPLES) {
+		set_errnum(ERRNUM_AGAIN);
+		return -1;
+	}
+
+	struct timespec now = { 0, 0 };
+	if (!local) {
+		can_net_get_time(time->net, &now);
+		local = &now;
+	}
+
+	// Extrapolate the offset with the estimated drift.
+	int_least64_t dt = timespec_diff_nsec(local, &time->ref);
+	*tp = *local;
+	co_time_add_nsec(tp, time->stats.offset
+					+ time->stats.drift * dt / 1000000000);
+
+	if (perr) {
+		// The error is bounded by the resolution of the time stamps,
+		// the observed jitter and the error of the estimated drift.
+		if (dt < 0)
+			dt = -dt;
+		*perr = CO_TIME_RES / 2 + time->jitter
+				+ dt / 1000000 * LELY_CO_TIME_DRIFT_ERR;
+	}
+
+	return 0;
+}
+
+void
+co_time_get_clock_stats(
+		const co_time_t *time, struct co_time_clock_stats *stats)
+{
+	assert(time);
+	assert(stats);
+
+	*stats = time->stats;
+}
+
 static void
 co_time_update(co_time_t *time)
 {
@@ -482,6 +635,12 @@ co_time_recv(const struct can_msg *msg, void *data)
 	struct timespec tv;
 	co_time_of_day_get(&tod, &tv);
 
+	if (time->discipline) {
+		struct timespec now = { 0, 0 };
+		can_net_get_time(time->net, &now);
+		co_time_discipline(time, &tv, &now);
+	}
+
 	if (time->ind)
 		time->ind(time, &tv, time->data);
 
@@ -496,15 +655,19 @@ co_time_timer(const struct timespec *tp, void *data)
 	co_time_t *time = data;
 	assert(time);
 
+	// Advance the time stamp by the estimated transmit delay.
+	struct timespec ts = *tp;
+	timespec_add_nsec(&ts, time->stats.txdelay);
+
 	// Update the high-resolution time stamp, if it exists.
 	if (time->sub_1013_00)
 		co_sub_set_val_u32(time->sub_1013_00,
 				(co_unsigned32_t)timespec_diff_usec(
-						tp, &time->start));
+						&ts, &time->start));
 
 	// Convert the time to a TIME_OF_DAY value.
 	co_time_of_day_t tod = { 0, 0 };
-	co_time_of_day_set(&tod, tp);
+	co_time_of_day_set(&tod, &ts);
 
 	struct can_msg msg = CAN_MSG_INIT;
 	msg.id = time->cobid;
@@ -517,9 +680,82 @@ co_time_timer(const struct timespec *tp, void *data)
 	msg.len = 6;
 	stle_u32(msg.data, tod.ms & UINT32_C(0x0fffffff));
 	stle_u16(msg.data + 4, tod.days);
-	can_net_send(time->net, &msg);
+	if (!can_net_send(time->net, &msg)) {
+		// Wait for the transmit confirmation (see co_time_tx_con()).
+		time->txpending = 1;
+		time->txtime = *tp;
+	}
 
 	return 0;
 }
 
+static void
+co_time_discipline(co_time_t *time, const struct timespec *remote,
+		const struct timespec *local)
+{
+	assert(time);
+	assert(remote);
+	assert(local);
+
+	struct co_time_clock_stats *stats = &time->stats;
+
+	// The time stamp is truncated to its resolution, so the middle of the
+	// resolution interval is the best estimate of the producer time.
+	int_least64_t offset =
+			timespec_diff_nsec(remote, local) + CO_TIME_RES / 2;
+
+	int_least64_t dt = timespec_diff_nsec(local, &time->ref);
+	if (stats->n && dt <= 0)
+		return;
+
+	// Predict the offset based on the current estimates.
+	int_least64_t pred = stats->offset + stats->drift * dt / 1000000000;
+	int_least64_t residual = offset - pred;
+
+	int_least64_t step = (int_least64_t)LELY_CO_TIME_STEP * 1000000;
+	if (!stats->n || residual > step || residual < -step) {
+		if (stats->n) {
+			diag(DIAG_INFO, 0,
+					"TIME: clock stepped by %" PRId64 " ns",
+					residual);
+			stats->nstep++;
+		}
+		// (Re)start the filter.
+		stats->n = 1;
+		stats->offset = offset;
+		stats->drift = 0;
+		stats->residual = 0;
+		time->ref = *local;
+		time->jitter = 0;
+		return;
+	}
+
+	// Update the estimates with a proportional-integral filter.
+	stats->offset = pred + residual / (1 << LELY_CO_TIME_KP_SHIFT);
+	int_least64_t drift = stats->drift
+			+ residual * 1000000000 / dt
+					/ (1 << LELY_CO_TIME_KI_SHIFT);
+	int_least64_t max_drift = (int_least64_t)LELY_CO_TIME_MAX_DRIFT * 1000;
+	stats->drift = (int_least32_t)MAX(-max_drift, MIN(drift, max_drift));
+	stats->residual = residual;
+	stats->n++;
+	time->ref = *local;
+
+	// Keep track of the peak residual, which decays with each time stamp.
+	if (residual < 0)
+		residual = -residual;
+	time->jitter = MAX(residual, time->jitter - time->jitter / 8);
+}
+
+static void
+co_time_add_nsec(struct timespec *tp, int_least64_t nsec)
+{
+	assert(tp);
+
+	if (nsec < 0)
+		timespec_sub_nsec(tp, -nsec);
+	else
+		timespec_add_nsec(tp, nsec);
+}
+
 #endif // !LELY_NO_CO_TIME
@@ -0,0 +1,323 @@
+/**@file
+ * This file is part of the C++ CANopen application library; it contains the
+ * implementation of the per-bus real-time runtime.
+ *
+ * @see lely/coapp/bus_runtime.hpp
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "coapp.hpp"
+
+#if !LELY_NO_STDIO && !LELY_NO_THREADS && defined(__linux__)
+
+#include <lely/coapp/bus_runtime.hpp>
+#include <lely/util/time.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <cerrno>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lely {
+
+namespace canopen {
+
+namespace {
+
+/**
+ * Touches every page of (at most) the specified number of bytes of the stack
+ * below the frame of the caller. This function is not inlined, so the touched
+ * region is released when it returns and is reused by the frames of the next
+ * function called by the caller (i.e., the event loop).
+ */
+__attribute__((noinline)) void
+PrefaultStack(::std::size_t n) noexcept {
+  auto page_size = static_cast<::std::size_t>(sysconf(_SC_PAGESIZE));
+
+  // Do not touch more than the part of the stack that is left, excluding a
+  // reserve for this frame and the guard page.
+  pthread_attr_t attr;
+  if (!pthread_getattr_np(pthread_self(), &attr)) {
+    void* addr = nullptr;
+    ::std::size_t size = 0;
+    if (!pthread_attr_getstack(&attr, &addr, &size)) {
+      volatile unsigned char c = 0;
+      auto avail = static_cast<::std::size_t>(
+          const_cast<unsigned char*>(&c) - static_cast<unsigned char*>(addr));
+      avail = avail > 4 * page_size ? avail - 4 * page_size : 0;
+      if (n > avail) n = avail;
+    }
+    pthread_attr_destroy(&attr);
+  }
+  if (!n) return;
+
+  auto stack = static_cast<volatile unsigned char*>(alloca(n));
+  for (::std::size_t i = 0; i < n; i += page_size) stack[i] = 0;
+  stack[n - 1] = 0;
+}
+
+}  // namespace
+
+/// The internal implementation of #lely::canopen::BusRuntime.
+struct BusRuntime::Impl_ : io_svc {
+  Impl_(io::ContextBase ctx, const BusRuntimeAttributes& attr);
+  Impl_(const Impl_&) = delete;
+  Impl_& operator=(const Impl_&) = delete;
+  ~Impl_();
+
+  void CreateThread();
+  void Start();
+  void Shutdown();
+  void Join();
+
+  void OnLatencyWait(int overrun) noexcept;
+
+  static const io_svc_vtbl svc_vtbl;
+
+  io::ContextBase ctx{nullptr};
+  BusRuntimeAttributes attr;
+  io::Poll poll;
+  ev::Loop loop;
+  io::Timer timer;
+  ::std::unique_ptr<io::CanController> ctrl;
+  io::CanChannel chan;
+  io::Timer latency_timer;
+  io::TimerWait latency_wait;
+  timespec deadline{0, 0};
+  mutable ::std::mutex mtx;
+  BusRuntimeStats stats;
+  ::std::atomic<bool> shutdown{false};
+  pthread_t thr{};
+  ::std::atomic<bool> joined{false};
+};
+
+// clang-format off
+const io_svc_vtbl BusRuntime::Impl_::svc_vtbl = {
+    nullptr,
+    [](io_svc* svc) noexcept {
+      static_cast<BusRuntime::Impl_*>(svc)->Shutdown();
+    }
+};
+// clang-format on
+
+BusRuntime::BusRuntime(io::ContextBase ctx, const BusRuntimeAttributes& attr)
+    : impl_(new Impl_(ctx, attr)) {
+  impl_->CreateThread();
+}
+
+BusRuntime::BusRuntime(io::ContextBase ctx, const char* ifname,
+                       const BusRuntimeAttributes& attr)
+    : impl_(new Impl_(ctx, attr)) {
+  Open(ifname);
+  impl_->CreateThread();
+}
+
+BusRuntime::~BusRuntime() = default;
+
+io::Poll&
+BusRuntime::GetPoll() noexcept {
+  return impl_->poll;
+}
+
+ev::Loop&
+BusRuntime::GetLoop() noexcept {
+  return impl_->loop;
+}
+
+ev::Executor
+BusRuntime::GetExecutor() const noexcept {
+  return impl_->loop.get_executor();
+}
+
+io::Timer&
+BusRuntime::GetTimer() noexcept {
+  return impl_->timer;
+}
+
+io::CanChannel&
+BusRuntime::GetChannel() noexcept {
+  return impl_->chan;
+}
+
+void
+BusRuntime::Open(const char* ifname) {
+  ::std::unique_ptr<io::CanController> ctrl(new io::CanController(ifname));
+  impl_->chan.open(*ctrl);
+  impl_->ctrl = ::std::move(ctrl);
+}
+
+BusRuntimeStats
+BusRuntime::GetStats() const {
+  ::std::lock_guard<::std::mutex> lock(impl_->mtx);
+  return impl_->stats;
+}
+
+void
+BusRuntime::ResetStats() noexcept {
+  ::std::lock_guard<::std::mutex> lock(impl_->mtx);
+  impl_->stats = BusRuntimeStats();
+}
+
+void
+BusRuntime::Join() {
+  impl_->Join();
+}
+
+BusRuntime::Impl_::Impl_(io::ContextBase ctx_,
+                         const BusRuntimeAttributes& attr_)
+    : io_svc IO_SVC_INIT(&svc_vtbl),
+      ctx(ctx_),
+      attr(attr_),
+      poll(ctx),
+      loop(poll.get_poll()),
+      timer(poll, loop.get_executor(), CLOCK_MONOTONIC),
+      chan(poll, loop.get_executor()),
+      latency_timer(poll, loop.get_executor(), CLOCK_MONOTONIC),
+      latency_wait([this](int overrun, ::std::error_code ec) {
+        if (!ec) OnLatencyWait(overrun);
+      }) {
+  // The thread does not exist until CreateThread() succeeds, so the
+  // destructor MUST NOT join it before then.
+  joined = true;
+
+  if (attr.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
+    util::throw_errc("mlockall");
+}
+
+BusRuntime::Impl_::~Impl_() { Join(); }
+
+void
+BusRuntime::Impl_::CreateThread() {
+  pthread_attr_t pattr;
+  int errc = pthread_attr_init(&pattr);
+  if (errc) util::throw_errc("pthread_attr_init", errc);
+
+  if (attr.stack_size)
+    errc = pthread_attr_setstacksize(&pattr, attr.stack_size);
+  if (!errc && attr.prefault_stack) {
+    ::std::size_t stack_size = 0;
+    errc = pthread_attr_getstacksize(&pattr, &stack_size);
+    if (!errc && attr.prefault_stack >= stack_size) errc = EINVAL;
+  }
+  if (!errc && !attr.cpus.empty()) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (int cpu : attr.cpus) CPU_SET(cpu, &cpuset);
+    errc = pthread_attr_setaffinity_np(&pattr, sizeof(cpuset), &cpuset);
+  }
+  if (!errc && attr.policy != SCHED_OTHER) {
+    // Do not inherit the scheduling policy of the calling thread, otherwise
+    // the policy and priority are ignored.
+    errc = pthread_attr_setinheritsched(&pattr, PTHREAD_EXPLICIT_SCHED);
+    if (!errc) errc = pthread_attr_setschedpolicy(&pattr, attr.policy);
+    if (!errc) {
+      sched_param param{};
+      param.sched_priority = attr.priority;
+      errc = pthread_attr_setschedparam(&pattr, &param);
+    }
+  }
+  if (!errc) {
+    errc = pthread_create(
+        &thr, &pattr,
+        [](void* arg) noexcept -> void* {
+          static_cast<BusRuntime::Impl_*>(arg)->Start();
+          return nullptr;
+        },
+        this);
+  }
+  pthread_attr_destroy(&pattr);
+  if (errc) util::throw_errc("pthread_create", errc);
+  ctx.insert(*this);
+  joined = false;
+}
+
+void
+BusRuntime::Impl_::Start() {
+  // Map the part of the stack used by the event loop before it starts.
+  if (attr.prefault_stack) PrefaultStack(attr.prefault_stack);
+
+  if (attr.latency_period.count() > 0) {
+    auto period = util::to_timespec(attr.latency_period);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    timespec_add(&deadline, &period);
+    itimerspec value = {period, deadline};
+    if (!io_timer_settime(latency_timer, TIMER_ABSTIME, &value, nullptr))
+      latency_timer.submit_wait(latency_wait);
+  }
+
+  // Start the event loop. Signal the existence of a fake task to prevent the
+  // loop for stopping early.
+  auto exec = loop.get_executor();
+  exec.on_task_init();
+  loop.run();
+  exec.on_task_fini();
+
+  latency_timer.cancel_wait(latency_wait);
+
+  // Finish remaining tasks, but do not block.
+  loop.restart();
+  loop.poll();
+}
+
+void
+BusRuntime::Impl_::Shutdown() {
+  // Stop the blocking run of the event loop.
+  if (!shutdown.exchange(true)) loop.stop();
+}
+
+void
+BusRuntime::Impl_::Join() {
+  if (!joined.exchange(true)) {
+    Shutdown();
+    pthread_join(thr, nullptr);
+    ctx.remove(*this);
+  }
+}
+
+void
+BusRuntime::Impl_::OnLatencyWait(int overrun) noexcept {
+  timespec now = {0, 0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  // Skip the expirations that were missed.
+  auto period = util::to_timespec(attr.latency_period);
+  for (int i = 0; i < overrun; i++) timespec_add(&deadline, &period);
+  ::std::chrono::nanoseconds latency(timespec_diff_nsec(&now, &deadline));
+  timespec_add(&deadline, &period);
+
+  {
+    ::std::lock_guard<::std::mutex> lock(mtx);
+    if (!stats.n || latency < stats.min) stats.min = latency;
+    if (!stats.n || latency > stats.max) stats.max = latency;
+    stats.sum += latency;
+    stats.n++;
+    stats.nmissed += overrun;
+  }
+
+  latency_timer.submit_wait(latency_wait);
+}
+
+}  // namespace canopen
+
+}  // namespace lely
+
+#endif  // !LELY_NO_STDIO && !LELY_NO_THREADS && __linux__
@@ -31,9 +31,17 @@
 
 #include <algorithm>
 #include <array>
+#if !LELY_NO_THREADS
+#include <condition_variable>
+#endif
 #include <map>
+#include <mutex>
 #include <string>
+#if !LELY_NO_THREADS
+#include <thread>
+#endif
 #include <utility>
+#include <vector>
 
 #include <cassert>
 
@@ -67,6 +75,87 @@ struct BasicMaster::Impl_ {
   ::std::map<uint8_t, Sdo> sdos;
 };
 
+/// The internal implementation of the asynchronous CANopen master.
+struct AsyncMaster::Impl_ {
+  /// A notification queued for a driver.
+  struct Event {
+    enum class Type {
+      CAN_STATE,
+      CAN_ERROR,
+      RPDO_WRITE,
+      COMMAND,
+      HEARTBEAT,
+      STATE,
+      SYNC,
+      SYNC_ERROR,
+      TIME,
+      EMCY,
+      NODE_GUARDING,
+      BOOT,
+      CONFIG
+    };
+
+    explicit Event(Type type_) : type(type_) {}
+
+    Type type;
+    DriverBase* driver{nullptr};
+    io::CanState new_state{io::CanState::ACTIVE};
+    io::CanState old_state{io::CanState::ACTIVE};
+    io::CanError error{io::CanError::NONE};
+    NmtCommand cs{NmtCommand::START};
+    NmtState st{NmtState::BOOTUP};
+    bool occurred{false};
+    uint8_t cnt{0};
+    uint8_t subidx{0};
+    uint8_t er{0};
+    char es{0};
+    uint16_t idx{0};
+    uint16_t eec{0};
+    ::std::array<uint8_t, 5> msef{{0}};
+    time_point t;
+    ::std::chrono::system_clock::time_point abs_time;
+    ::std::string what;
+  };
+
+  /**
+   * The mailbox of a driver. The mailbox is a task which, when executed, swaps
+   * the queue of pending notifications with a (previously emptied) batch and
+   * invokes the driver for each notification in the batch. Both vectors retain
+   * their capacity, so a mailbox does not allocate memory in steady state.
+   */
+  struct Mailbox : ev_task {
+    explicit Mailbox(AsyncMaster* master);
+
+    void Push(Event&& event);
+
+    void Drain(DriverBase* driver) noexcept;
+
+    static void Func(ev_task* task) noexcept;
+
+    void Dispatch(DriverBase* driver, Event& event) noexcept;
+
+    AsyncMaster* master;
+    bool posted{false};
+    // Whether Func() is executing, and in which thread.
+    bool running{false};
+#if !LELY_NO_THREADS
+    ::std::thread::id thread;
+    // Signaled at the end of Func().
+    ::std::condition_variable_any done;
+#endif
+    ::std::vector<Event> queue;
+    ::std::vector<Event> batch;
+  };
+
+  explicit Impl_(AsyncMaster* self);
+  ~Impl_();
+
+  Mailbox& GetMailbox(uint8_t id);
+
+  AsyncMaster* self;
+  ::std::array<::std::unique_ptr<Mailbox>, CO_NUM_NODES> mailboxes;
+};
+
 void
 BasicMaster::TpdoEventMutex::lock() {
   ::std::lock_guard<util::BasicLockable> lock(*node);
@@ -516,21 +605,58 @@ BasicMaster::CancelSdo(uint8_t id) {
     impl_->sdos.clear();
 }
 
+AsyncMaster::AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                         io::CanChannelBase& chan, __co_dev* dev, uint8_t id)
+    : BasicMaster(exec, timer, chan, dev, id), impl_(new Impl_(this)) {}
+
+#if !LELY_NO_CO_DCF
+AsyncMaster::AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                         io::CanChannelBase& chan, const ::std::string& dcf_txt,
+                         const ::std::string& dcf_bin, uint8_t id)
+    : BasicMaster(exec, timer, chan, dcf_txt, dcf_bin, id),
+      impl_(new Impl_(this)) {}
+#endif
+
+#if !LELY_NO_CO_SDEV
+AsyncMaster::AsyncMaster(ev_exec_t* exec, io::TimerBase& timer,
+                         io::CanChannelBase& chan, const co_sdev* sdev,
+                         uint8_t id)
+    : BasicMaster(exec, timer, chan, sdev, id), impl_(new Impl_(this)) {}
+#endif
+
+AsyncMaster::~AsyncMaster() = default;
+
+void
+AsyncMaster::Erase(DriverBase& driver) {
+  BasicMaster::Erase(driver);
+
+  // Discard the pending notifications for the driver, since it may be
+  // destroyed before they would be delivered.
+  ::std::lock_guard<util::BasicLockable> lock(*this);
+  auto id = driver.id();
+  if (id && id <= CO_NUM_NODES && impl_->mailboxes[id - 1])
+    impl_->mailboxes[id - 1]->Drain(&driver);
+}
+
 void
 AsyncMaster::OnCanState(io::CanState new_state,
                         io::CanState old_state) noexcept {
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post(
-        [=]() { driver->OnCanState(new_state, old_state); });
+    Impl_::Event event{Impl_::Event::Type::CAN_STATE};
+    event.driver = it.second;
+    event.new_state = new_state;
+    event.old_state = old_state;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
 void
 AsyncMaster::OnCanError(io::CanError error) noexcept {
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post([=]() { driver->OnCanError(error); });
+    Impl_::Event event{Impl_::Event::Type::CAN_ERROR};
+    event.driver = it.second;
+    event.error = error;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
@@ -538,8 +664,11 @@ void
 AsyncMaster::OnRpdoWrite(uint8_t id, uint16_t idx, uint8_t subidx) noexcept {
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post([=]() { driver->OnRpdoWrite(idx, subidx); });
+    Impl_::Event event{Impl_::Event::Type::RPDO_WRITE};
+    event.driver = it->second;
+    event.idx = idx;
+    event.subidx = subidx;
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
@@ -549,8 +678,10 @@ AsyncMaster::OnCommand(NmtCommand cs) noexcept {
   // pre-operational or operational state.
   if (cs != NmtCommand::ENTER_PREOP && cs != NmtCommand::START) CancelSdo();
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post([=]() { driver->OnCommand(cs); });
+    Impl_::Event event{Impl_::Event::Type::COMMAND};
+    event.driver = it.second;
+    event.cs = cs;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
@@ -558,8 +689,10 @@ void
 AsyncMaster::OnHeartbeat(uint8_t id, bool occurred) noexcept {
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post([=]() { driver->OnHeartbeat(occurred); });
+    Impl_::Event event{Impl_::Event::Type::HEARTBEAT};
+    event.driver = it->second;
+    event.occurred = occurred;
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
@@ -573,24 +706,32 @@ AsyncMaster::OnState(uint8_t id, NmtState st) noexcept {
   }
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post([=]() { driver->OnState(st); });
+    Impl_::Event event{Impl_::Event::Type::STATE};
+    event.driver = it->second;
+    event.st = st;
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
 void
 AsyncMaster::OnSync(uint8_t cnt, const time_point& t) noexcept {
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post([=]() { driver->OnSync(cnt, t); });
+    Impl_::Event event{Impl_::Event::Type::SYNC};
+    event.driver = it.second;
+    event.cnt = cnt;
+    event.t = t;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
 void
 AsyncMaster::OnSyncError(uint16_t eec, uint8_t er) noexcept {
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post([=]() { driver->OnSyncError(eec, er); });
+    Impl_::Event event{Impl_::Event::Type::SYNC_ERROR};
+    event.driver = it.second;
+    event.eec = eec;
+    event.er = er;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
@@ -598,21 +739,24 @@ void
 AsyncMaster::OnTime(
     const ::std::chrono::system_clock::time_point& abs_time) noexcept {
   for (const auto& it : *this) {
-    DriverBase* driver = it.second;
-    driver->GetExecutor().post([=]() { driver->OnTime(abs_time); });
+    Impl_::Event event{Impl_::Event::Type::TIME};
+    event.driver = it.second;
+    event.abs_time = abs_time;
+    impl_->GetMailbox(it.first).Push(::std::move(event));
   }
 }
 
 void
 AsyncMaster::OnEmcy(uint8_t id, uint16_t eec, uint8_t er,
                     uint8_t msef[5]) noexcept {
-  ::std::array<uint8_t, 5> value = {0};
-  ::std::copy_n(msef, value.size(), value.begin());
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post(
-        [=]() mutable { driver->OnEmcy(eec, er, value.data()); });
+    Impl_::Event event{Impl_::Event::Type::EMCY};
+    event.driver = it->second;
+    event.eec = eec;
+    event.er = er;
+    ::std::copy_n(msef, event.msef.size(), event.msef.begin());
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
@@ -620,8 +764,10 @@ void
 AsyncMaster::OnNodeGuarding(uint8_t id, bool occurred) noexcept {
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post([=]() { driver->OnNodeGuarding(occurred); });
+    Impl_::Event event{Impl_::Event::Type::NODE_GUARDING};
+    event.driver = it->second;
+    event.occurred = occurred;
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
@@ -630,8 +776,16 @@ AsyncMaster::OnBoot(uint8_t id, NmtState st, char es,
                     const ::std::string& what) noexcept {
   auto it = find(id);
   if (it != end()) {
-    DriverBase* driver = it->second;
-    driver->GetExecutor().post([=]() { driver->OnBoot(st, es, what); });
+    Impl_::Event event{Impl_::Event::Type::BOOT};
+    event.driver = it->second;
+    event.st = st;
+    event.es = es;
+    try {
+      event.what = what;
+    } catch (...) {
+      // Deliver the boot event without the description.
+    }
+    impl_->GetMailbox(id).Push(::std::move(event));
   }
 }
 
@@ -645,14 +799,197 @@ AsyncMaster::OnConfig(uint8_t id) noexcept {
     return;
   }
 
-  // Let the driver perform the configuration update.
-  DriverBase* driver = it->second;
-  driver->GetExecutor().post([this, id, driver]() {
-    driver->OnConfig([this, id](::std::error_code ec) {
-      ::std::lock_guard<util::BasicLockable> lock(*this);
-      ConfigResult(id, ec);
-    });
-  });
+  // Let the driver perform the configuration update. The request is queued in
+  // the mailbox of the driver to preserve the order with respect to other
+  // notifications.
+  Impl_::Event event{Impl_::Event::Type::CONFIG};
+  event.driver = it->second;
+  impl_->GetMailbox(id).Push(::std::move(event));
+}
+
+AsyncMaster::Impl_::Impl_(AsyncMaster* self_) : self(self_) {}
+
+AsyncMaster::Impl_::~Impl_() {
+  ::std::unique_lock<util::BasicLockable> lock(*self);
+  for (auto& mailbox : mailboxes) {
+    if (!mailbox) continue;
+    // Discard the pending notifications, so the mailbox task is not posted
+    // again, and abort the task if it has not been executed yet.
+    mailbox->queue.clear();
+    if (!mailbox->posted || ev_exec_abort(mailbox->exec, mailbox.get())) {
+      mailbox->posted = false;
+      continue;
+    }
+    // The master cannot be destroyed by a driver while it handles a
+    // notification, since the mailbox task would never complete.
+#if LELY_NO_THREADS
+    assert(!mailbox->running);
+#else
+    assert(!mailbox->running ||
+           mailbox->thread != ::std::this_thread::get_id());
+    // Wait until the task that is currently being executed completes.
+    mailbox->done.wait(lock, [&]() { return !mailbox->posted; });
+#endif
+  }
+}
+
+AsyncMaster::Impl_::Mailbox&
+AsyncMaster::Impl_::GetMailbox(uint8_t id) {
+  assert(id && id <= CO_NUM_NODES);
+
+  auto& mailbox = mailboxes[id - 1];
+  // The mailbox is created on first use and reused afterwards.
+  if (!mailbox) mailbox.reset(new Mailbox(self));
+  return *mailbox;
+}
+
+AsyncMaster::Impl_::Mailbox::Mailbox(AsyncMaster* master_)
+    : ev_task EV_TASK_INIT(nullptr, &Func), master(master_) {
+  queue.reserve(16);
+  batch.reserve(16);
+}
+
+void
+AsyncMaster::Impl_::Mailbox::Push(Event&& event) {
+  // This function is invoked with the master locked.
+  if (!queue.empty()) {
+    auto& back = queue.back();
+    // Coalesce consecutive SYNC notifications.
+    if (event.type == Event::Type::SYNC && back.type == Event::Type::SYNC &&
+        back.driver == event.driver) {
+      back.cnt = event.cnt;
+      back.t = event.t;
+      return;
+    }
+    // Drop an RPDO write notification if one is already pending for the same
+    // sub-object since the last notification of any other type. The driver
+    // reads the most recent value when it handles the notification.
+    if (event.type == Event::Type::RPDO_WRITE) {
+      for (auto it = queue.rbegin();
+           it != queue.rend() && it->type == Event::Type::RPDO_WRITE; ++it) {
+        if (it->driver == event.driver && it->idx == event.idx &&
+            it->subidx == event.subidx)
+          return;
+      }
+    }
+  }
+
+  queue.push_back(::std::move(event));
+
+  if (!posted) {
+    posted = true;
+    exec = queue.back().driver->GetExecutor();
+    ev_exec_post(exec, this);
+  }
+}
+
+void
+AsyncMaster::Impl_::Mailbox::Drain(DriverBase* driver) noexcept {
+  // This function is invoked with the master locked.
+  queue.erase(::std::remove_if(queue.begin(), queue.end(),
+                               [driver](const Event& event) {
+                                 return event.driver == driver;
+                               }),
+              queue.end());
+  // The notifications in the batch that is currently being handled cannot be
+  // removed, but they are skipped.
+  for (auto& event : batch) {
+    if (event.driver == driver) event.driver = nullptr;
+  }
+  // Do not leave the task pending if there is nothing left to deliver.
+  if (posted && queue.empty() && batch.empty() && ev_exec_abort(exec, this))
+    posted = false;
+}
+
+void
+AsyncMaster::Impl_::Mailbox::Func(ev_task* task) noexcept {
+  auto self = static_cast<Mailbox*>(task);
+  auto master = self->master;
+
+  ::std::unique_lock<util::BasicLockable> lock(*master);
+  assert(self->posted);
+  assert(self->batch.empty());
+  ::std::swap(self->queue, self->batch);
+  self->running = true;
+#if !LELY_NO_THREADS
+  self->thread = ::std::this_thread::get_id();
+#endif
+
+  // The master is unlocked while the driver handles a notification. In the
+  // meantime, the driver may be removed, in which case its remaining
+  // notifications are skipped.
+  for (auto& event : self->batch) {
+    auto driver = event.driver;
+    if (!driver) continue;
+    lock.unlock();
+    self->Dispatch(driver, event);
+    lock.lock();
+  }
+  self->batch.clear();
+  self->running = false;
+
+  if (self->queue.empty())
+    self->posted = false;
+  else
+    // Notifications queued while this batch was being handled may be intended
+    // for a different driver (and executor).
+    ev_exec_post(self->exec = self->queue.front().driver->GetExecutor(), self);
+#if !LELY_NO_THREADS
+  // Wake up the destructor of the master, if it is waiting.
+  self->done.notify_all();
+#endif
+}
+
+void
+AsyncMaster::Impl_::Mailbox::Dispatch(DriverBase* driver,
+                                      Event& event) noexcept {
+  switch (event.type) {
+    case Event::Type::CAN_STATE:
+      driver->OnCanState(event.new_state, event.old_state);
+      break;
+    case Event::Type::CAN_ERROR:
+      driver->OnCanError(event.error);
+      break;
+    case Event::Type::RPDO_WRITE:
+      driver->OnRpdoWrite(event.idx, event.subidx);
+      break;
+    case Event::Type::COMMAND:
+      driver->OnCommand(event.cs);
+      break;
+    case Event::Type::HEARTBEAT:
+      driver->OnHeartbeat(event.occurred);
+      break;
+    case Event::Type::STATE:
+      driver->OnState(event.st);
+      break;
+    case Event::Type::SYNC:
+      driver->OnSync(event.cnt, event.t);
+      break;
+    case Event::Type::SYNC_ERROR:
+      driver->OnSyncError(event.eec, event.er);
+      break;
+    case Event::Type::TIME:
+      driver->OnTime(event.abs_time);
+      break;
+    case Event::Type::EMCY:
+      driver->OnEmcy(event.eec, event.er, event.msef.data());
+      break;
+    case Event::Type::NODE_GUARDING:
+      driver->OnNodeGuarding(event.occurred);
+      break;
+    case Event::Type::BOOT:
+      driver->OnBoot(event.st, event.es, event.what);
+      break;
+    case Event::Type::CONFIG: {
+      auto master = this->master;
+      auto id = driver->id();
+      driver->OnConfig([master, id](::std::error_code ec) {
+        ::std::lock_guard<util::BasicLockable> lock(*master);
+        master->ConfigResult(id, ec);
+      });
+      break;
+    }
+  }
 }
 
 BasicMaster::Impl_::Impl_(BasicMaster* self_, co_nmt_t* nmt) : self(self_) {
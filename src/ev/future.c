@@ -41,11 +41,26 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef LELY_EV_FUTURE_MAX
 #define LELY_EV_FUTURE_MAX MAX((LELY_VLA_SIZE_MAX / sizeof(ev_future_t *)), 1)
 #endif
 
+#ifndef LELY_EV_PROMISE_MAX_UNUSED
+/// The default maximum number of unused promises cached per thread.
+#define LELY_EV_PROMISE_MAX_UNUSED 64
+#endif
+
+/// The size (in bytes) of the smallest size class of cached promises.
+#define EV_PROMISE_CLS_MIN 128
+
+/**
+ * The number of size classes of cached promises. Each class is twice the size
+ * of the previous one. Larger promises are never cached.
+ */
+#define EV_PROMISE_NCLS 4
+
 /// The state of a future.
 enum ev_future_state {
 	/// The future is waiting.
@@ -108,12 +123,38 @@ struct ev_promise {
 #endif
 	/// The (destructor) function invoked when this struct is reclaimed.
 	ev_promise_dtor_t *dtor;
+	/**
+	 * The size class of the memory block containing this promise, or
+	 * #EV_PROMISE_NCLS if the block cannot be cached.
+	 */
+	int cls;
 	/// The future used to monitor if the promise has been satisfied.
 	struct ev_future future;
 };
 
 #define EV_PROMISE_SIZE ALIGN(sizeof(ev_promise_t), _Alignof(max_align_t))
 
+/// The per-thread cache of unused promise memory blocks.
+#if LELY_NO_THREADS
+static struct ev_promise_thrd {
+#else
+static _Thread_local struct ev_promise_thrd {
+#endif
+	/**
+	 * The number of invocations of ev_promise_thrd_init() minus the the
+	 * number of invocation of ev_promise_thrd_fini() for this thread.
+	 */
+	size_t refcnt;
+	/// The maximum number of unused blocks for this thread.
+	size_t max_unused;
+	/// The lists of unused blocks, one for each size class.
+	struct slnode *unused[EV_PROMISE_NCLS];
+	/// The allocation statistics for this thread.
+	struct ev_promise_stats stats;
+} ev_promise_thrd;
+
+static int ev_promise_cls(size_t size);
+
 static inline ev_promise_t *ev_promise_from_future(const ev_future_t *future);
 
 static void *ev_promise_alloc(size_t size);
@@ -150,6 +191,50 @@ struct ev_future_when_any {
 
 static void ev_future_when_any_func(struct ev_task *task);
 
+int
+ev_promise_thrd_init(size_t max_unused)
+{
+	struct ev_promise_thrd *thr = &ev_promise_thrd;
+
+	if (thr->refcnt++)
+		return 1;
+
+	if (!(thr->max_unused = max_unused))
+		thr->max_unused = LELY_EV_PROMISE_MAX_UNUSED;
+	for (int i = 0; i < EV_PROMISE_NCLS; i++)
+		thr->unused[i] = NULL;
+	thr->stats.nunused = 0;
+
+	return 0;
+}
+
+void
+ev_promise_thrd_fini(void)
+{
+	struct ev_promise_thrd *thr = &ev_promise_thrd;
+	assert(thr->refcnt);
+
+	if (--thr->refcnt)
+		return;
+
+	for (int i = 0; i < EV_PROMISE_NCLS; i++) {
+		struct slnode *node;
+		while ((node = thr->unused[i])) {
+			thr->unused[i] = node->next;
+			free(node);
+		}
+	}
+	thr->stats.nunused = 0;
+}
+
+void
+ev_promise_thrd_get_stats(struct ev_promise_stats *stats)
+{
+	assert(stats);
+
+	*stats = ev_promise_thrd.stats;
+}
+
 ev_promise_t *
 ev_promise_create(size_t size, ev_promise_dtor_t *dtor)
 {
@@ -596,22 +681,75 @@ ev_promise_from_future(const ev_future_t *future)
 	return structof(future, ev_promise_t, future);
 }
 
+static int
+ev_promise_cls(size_t size)
+{
+	int cls = 0;
+	for (size_t n = EV_PROMISE_CLS_MIN; n < size; n *= 2) {
+		if (++cls == EV_PROMISE_NCLS)
+			break;
+	}
+	return cls;
+}
+
 static void *
 ev_promise_alloc(size_t size)
 {
-	// cppcheck-suppress AssignmentAddressToInteger
-	void *ptr = calloc(1, EV_PROMISE_SIZE + size);
+	struct ev_promise_thrd *thr = &ev_promise_thrd;
+
+	size += EV_PROMISE_SIZE;
+	int cls = ev_promise_cls(size);
+
+	ev_promise_t *promise = NULL;
+	if (cls < EV_PROMISE_NCLS && thr->unused[cls]) {
+		struct slnode *node = thr->unused[cls];
+		thr->unused[cls] = node->next;
+		assert(thr->stats.nunused);
+		thr->stats.nunused--;
+		thr->stats.nreused++;
+		// Only clear the part of the block that is actually used, so the
+		// result is indistinguishable from a newly allocated promise.
+		promise = memset(node, 0, size);
+	} else {
+		// Round the size up to the size class, so the block can be
+		// cached once the promise is destroyed. Without a cache for this
+		// thread, only allocate what is needed and never cache the block.
+		if (!thr->refcnt)
+			cls = EV_PROMISE_NCLS;
+		else if (cls < EV_PROMISE_NCLS)
+			size = (size_t)EV_PROMISE_CLS_MIN << cls;
+		// cppcheck-suppress AssignmentAddressToInteger
+		promise = calloc(1, size);
+		if (!promise) {
 #if !LELY_NO_ERRNO
-	if (!ptr)
-		set_errc(errno2c(errno));
+			set_errc(errno2c(errno));
 #endif
-	return ptr;
+			return NULL;
+		}
+		thr->stats.nalloc++;
+	}
+	promise->cls = cls;
+	return promise;
 }
 
 static void
 ev_promise_free(void *ptr)
 {
-	free(ptr);
+	struct ev_promise_thrd *thr = &ev_promise_thrd;
+
+	if (!ptr)
+		return;
+
+	int cls = ((ev_promise_t *)ptr)->cls;
+	if (thr->refcnt && cls < EV_PROMISE_NCLS
+			&& thr->stats.nunused < thr->max_unused) {
+		struct slnode *node = ptr;
+		node->next = thr->unused[cls];
+		thr->unused[cls] = node;
+		thr->stats.nunused++;
+	} else {
+		free(ptr);
+	}
 }
 
 static ev_promise_t *
@@ -57,22 +57,60 @@ static const struct ev_exec_vtbl ev_strand_exec_vtbl = {
 };
 // clang-format on
 
+/**
+ * The sentinel value of #ev_strand.head indicating that the strand task has
+ * been posted to the inner executor, but no new tasks have been submitted since
+ * the last time the submission stack was emptied.
+ */
+#define EV_STRAND_POSTED (&ev_strand_posted)
+
 struct ev_strand {
 	const struct ev_exec_vtbl *exec_vptr;
 	ev_exec_t *inner_exec;
 	struct ev_task task;
+	/**
+	 * The top of the (intrusive) stack of submitted tasks. Producers push
+	 * tasks onto this stack without taking a lock. The bottom of the stack
+	 * is either NULL, if the strand task was not yet posted, or
+	 * #EV_STRAND_POSTED, if it was. The stack is emptied in one go by the
+	 * consumer, after which the tasks are appended, in reverse order, to
+	 * #queue.
+	 */
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+	struct slnode *head;
+#else
+	_Atomic(struct slnode *) head;
+#endif
 #if !LELY_NO_THREADS
+#if LELY_NO_ATOMICS
+	/// The mutex protecting #head.
+	mtx_t head_mtx;
+#endif
+	/// The mutex protecting #queue.
 	mtx_t mtx;
 #endif
-	int posted;
+	/// The queue of tasks waiting to be executed, in order of submission.
 	struct sllist queue;
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
 	const int *thr;
+#else
+	_Atomic(const int *) thr;
+#endif
 };
 
+static struct slnode ev_strand_posted;
+
 static void ev_strand_func(struct ev_task *task);
 
 static inline struct ev_strand *ev_strand_from_exec(const ev_exec_t *exec);
 
+static void ev_strand_push(struct ev_strand *strand, struct ev_task *task);
+static void ev_strand_pop(struct ev_strand *strand);
+static int ev_strand_release(struct ev_strand *strand);
+
+static const int *ev_strand_get_thr(const struct ev_strand *strand);
+static void ev_strand_set_thr(struct ev_strand *strand, const int *thr);
+
 #if LELY_NO_THREADS
 static const int ev_strand_thrd;
 #else
@@ -109,16 +147,32 @@ ev_strand_init(ev_exec_t *exec, ev_exec_t *inner_exec)
 	strand->task = (struct ev_task)EV_TASK_INIT(
 			strand->inner_exec, &ev_strand_func);
 
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+	strand->head = NULL;
+#else
+	atomic_init(&strand->head, NULL);
+#endif
+
 #if !LELY_NO_THREADS
-	if (mtx_init(&strand->mtx, mtx_plain) != thrd_success)
+#if LELY_NO_ATOMICS
+	if (mtx_init(&strand->head_mtx, mtx_plain) != thrd_success)
 		return NULL;
 #endif
-
-	strand->posted = 0;
+	if (mtx_init(&strand->mtx, mtx_plain) != thrd_success) {
+#if LELY_NO_ATOMICS
+		mtx_destroy(&strand->head_mtx);
+#endif
+		return NULL;
+	}
+#endif
 
 	sllist_init(&strand->queue);
 
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
 	strand->thr = NULL;
+#else
+	atomic_init(&strand->thr, NULL);
+#endif
 
 	return exec;
 }
@@ -130,22 +184,45 @@ ev_strand_fini(ev_exec_t *exec)
 
 	ev_strand_exec_abort(exec, NULL);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&strand->mtx);
+	// Abort ev_strand_func(). Since the submission stack is empty after
+	// ev_strand_exec_abort(), the strand task was posted if and only if the
+	// head of the stack is #EV_STRAND_POSTED.
+#if !LELY_NO_THREADS && LELY_NO_ATOMICS
+	mtx_lock(&strand->head_mtx);
+#endif
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+	if (strand->head && ev_exec_abort(strand->task.exec, &strand->task))
+		strand->head = NULL;
+#else
+	if (atomic_load_explicit(&strand->head, memory_order_acquire)
+			&& ev_exec_abort(strand->task.exec, &strand->task))
+		atomic_store_explicit(
+				&strand->head, NULL, memory_order_release);
+#endif
+#if !LELY_NO_THREADS && LELY_NO_ATOMICS
+	mtx_unlock(&strand->head_mtx);
 #endif
-	// Abort ev_strand_func().
-	if (strand->posted && ev_exec_abort(strand->task.exec, &strand->task))
-		strand->posted = 0;
 #if !LELY_NO_THREADS
 	// If necessary, busy-wait until ev_strand_func() completes.
-	while (strand->posted) {
-		mtx_unlock(&strand->mtx);
+	for (;;) {
+#if LELY_NO_ATOMICS
+		mtx_lock(&strand->head_mtx);
+		int posted = strand->head != NULL;
+		mtx_unlock(&strand->head_mtx);
+#else
+		int posted = atomic_load_explicit(&strand->head,
+					     memory_order_acquire)
+				!= NULL;
+#endif
+		if (!posted)
+			break;
 		thrd_yield();
-		mtx_lock(&strand->mtx);
 	}
-	mtx_unlock(&strand->mtx);
 
 	mtx_destroy(&strand->mtx);
+#if LELY_NO_ATOMICS
+	mtx_destroy(&strand->head_mtx);
+#endif
 #endif
 }
 
@@ -220,26 +297,15 @@ ev_strand_exec_dispatch(ev_exec_t *exec, struct ev_task *task)
 		task->exec = exec;
 	ev_strand_exec_on_task_init(exec);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&strand->mtx);
-#endif
-	if (strand->thr == &ev_strand_thrd) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&strand->mtx);
-#endif
+	// Only the thread currently running a task from this strand can observe
+	// its own thread-local address, so no synchronization is needed.
+	if (ev_strand_get_thr(strand) == &ev_strand_thrd) {
 		if (task->func)
 			task->func(task);
 		ev_strand_exec_on_task_fini(exec);
 		return 1;
 	} else {
-		sllist_push_back(&strand->queue, &task->_node);
-		int post = !strand->posted;
-		strand->posted = 1;
-#if !LELY_NO_THREADS
-		mtx_unlock(&strand->mtx);
-#endif
-		if (post)
-			ev_exec_post(strand->task.exec, &strand->task);
+		ev_strand_push(strand, task);
 		return 0;
 	}
 }
@@ -255,17 +321,7 @@ ev_strand_exec_defer(ev_exec_t *exec, struct ev_task *task)
 		task->exec = exec;
 	ev_strand_exec_on_task_init(exec);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&strand->mtx);
-#endif
-	sllist_push_back(&strand->queue, &task->_node);
-	int post = !strand->posted;
-	strand->posted = 1;
-#if !LELY_NO_THREADS
-	mtx_unlock(&strand->mtx);
-#endif
-	if (post)
-		ev_exec_post(strand->task.exec, &strand->task);
+	ev_strand_push(strand, task);
 }
 
 static size_t
@@ -279,6 +335,8 @@ ev_strand_exec_abort(ev_exec_t *exec, struct ev_task *task)
 #if !LELY_NO_THREADS
 	mtx_lock(&strand->mtx);
 #endif
+	// Move all submitted tasks to the queue, so they can be found.
+	ev_strand_pop(strand);
 	if (!task)
 		sllist_append(&queue, &strand->queue);
 	else if (sllist_remove(&strand->queue, &task->_node))
@@ -306,28 +364,35 @@ ev_strand_func(struct ev_task *task)
 	mtx_lock(&strand->mtx);
 #endif
 	task = ev_task_from_node(sllist_pop_front(&strand->queue));
-	if (task) {
-		assert(!strand->thr);
-		strand->thr = &ev_strand_thrd;
+	if (!task) {
+		ev_strand_pop(strand);
+		task = ev_task_from_node(sllist_pop_front(&strand->queue));
+	}
 #if !LELY_NO_THREADS
-		mtx_unlock(&strand->mtx);
+	mtx_unlock(&strand->mtx);
 #endif
+	if (task) {
+		assert(!ev_strand_get_thr(strand));
+		ev_strand_set_thr(strand, &ev_strand_thrd);
 		assert(task->exec == exec);
 		if (task->func)
 			task->func(task);
 		ev_strand_exec_on_task_fini(exec);
+		assert(ev_strand_get_thr(strand) == &ev_strand_thrd);
+		ev_strand_set_thr(strand, NULL);
+	}
+
 #if !LELY_NO_THREADS
-		mtx_lock(&strand->mtx);
+	mtx_lock(&strand->mtx);
 #endif
-		assert(strand->thr == &ev_strand_thrd);
-		strand->thr = NULL;
-	}
-	assert(strand->posted == 1);
-	int post = strand->posted = !sllist_empty(&strand->queue);
+	int post = !sllist_empty(&strand->queue);
 #if !LELY_NO_THREADS
 	mtx_unlock(&strand->mtx);
 #endif
-	if (post)
+	// If the queue is empty, try to mark the strand as idle. This fails if
+	// new tasks were submitted in the mean time. Note that the strand may
+	// be destroyed as soon as ev_strand_release() succeeds.
+	if (post || !ev_strand_release(strand))
 		ev_exec_post(strand->task.exec, &strand->task);
 }
 
@@ -339,4 +404,124 @@ ev_strand_from_exec(const ev_exec_t *exec)
 	return structof(exec, struct ev_strand, exec_vptr);
 }
 
+static void
+ev_strand_push(struct ev_strand *strand, struct ev_task *task)
+{
+	assert(strand);
+	assert(task);
+	struct slnode *node = &task->_node;
+
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+#if !LELY_NO_THREADS
+	mtx_lock(&strand->head_mtx);
+#endif
+	struct slnode *head = strand->head;
+	node->next = head;
+	strand->head = node;
+#if !LELY_NO_THREADS
+	mtx_unlock(&strand->head_mtx);
+#endif
+#else
+	struct slnode *head = atomic_load_explicit(
+			&strand->head, memory_order_relaxed);
+	do
+		node->next = head;
+	while (!atomic_compare_exchange_weak_explicit(&strand->head, &head,
+			node, memory_order_release, memory_order_relaxed));
+#endif
+	// Only the producer that finds the strand idle posts the strand task.
+	if (!head)
+		ev_exec_post(strand->task.exec, &strand->task);
+}
+
+static void
+ev_strand_pop(struct ev_strand *strand)
+{
+	assert(strand);
+
+	// Take all submitted tasks, but leave the strand marked as posted. If
+	// the strand is idle, the stack is empty.
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+#if !LELY_NO_THREADS
+	mtx_lock(&strand->head_mtx);
+#endif
+	struct slnode *node = strand->head;
+	if (node && node != EV_STRAND_POSTED)
+		strand->head = EV_STRAND_POSTED;
+#if !LELY_NO_THREADS
+	mtx_unlock(&strand->head_mtx);
+#endif
+#else
+	struct slnode *node = atomic_load_explicit(
+			&strand->head, memory_order_relaxed);
+	while (node && node != EV_STRAND_POSTED
+			&& !atomic_compare_exchange_weak_explicit(&strand->head,
+					&node, EV_STRAND_POSTED,
+					memory_order_acquire,
+					memory_order_relaxed))
+		;
+#endif
+	if (!node || node == EV_STRAND_POSTED)
+		return;
+
+	// Reverse the stack to restore the order of submission.
+	struct sllist queue;
+	sllist_init(&queue);
+	while (node && node != EV_STRAND_POSTED) {
+		struct slnode *next = node->next;
+		sllist_push_front(&queue, node);
+		node = next;
+	}
+	sllist_append(&strand->queue, &queue);
+}
+
+static int
+ev_strand_release(struct ev_strand *strand)
+{
+	assert(strand);
+
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+#if !LELY_NO_THREADS
+	mtx_lock(&strand->head_mtx);
+#endif
+	int result = strand->head == EV_STRAND_POSTED;
+	if (result)
+		strand->head = NULL;
+#if !LELY_NO_THREADS
+	mtx_unlock(&strand->head_mtx);
+#endif
+	return result;
+#else
+	struct slnode *node = EV_STRAND_POSTED;
+	return atomic_compare_exchange_strong_explicit(&strand->head, &node,
+			NULL, memory_order_release, memory_order_relaxed);
+#endif
+}
+
+static const int *
+ev_strand_get_thr(const struct ev_strand *strand)
+{
+	assert(strand);
+
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+	return strand->thr;
+#else
+	return atomic_load_explicit(
+			(_Atomic(const int *) *)&strand->thr,
+			memory_order_relaxed);
+#endif
+}
+
+static void
+ev_strand_set_thr(struct ev_strand *strand, const int *thr)
+{
+	assert(strand);
+
+#if LELY_NO_THREADS || LELY_NO_ATOMICS
+	strand->thr = thr;
+#else
+	atomic_store_explicit(&strand->thr, thr, memory_order_relaxed);
+#endif
+}
+
 #endif // !LELY_NO_MALLOC
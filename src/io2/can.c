@@ -24,6 +24,8 @@
 #include "io2.h"
 #define LELY_IO_CAN_INLINE extern inline
 #include <lely/io2/can.h>
+#include <lely/ev/exec.h>
+#include <lely/util/errnum.h>
 #include <lely/util/util.h>
 
 #include <assert.h>
@@ -42,6 +44,14 @@ struct io_can_chan_async_write {
 
 static void io_can_chan_async_write_func(struct ev_task *task);
 
+/**
+ * Completes an operation of a CAN channel that does not support it by
+ * submitting its completion task with *<b>perrc</b> =
+ * #errnum2c(#ERRNUM_NOTSUP).
+ */
+static void io_can_chan_submit_notsup(
+		io_can_chan_t *chan, struct ev_task *task, int *perrc);
+
 ev_future_t *
 io_can_chan_async_read(io_can_chan_t *chan, ev_exec_t *exec,
 		struct can_msg *msg, struct can_err *err, struct timespec *tp,
@@ -89,6 +99,42 @@ io_can_chan_async_write(io_can_chan_t *chan, ev_exec_t *exec,
 	return future;
 }
 
+void
+io_can_chan_submit_readv(io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	assert(chan);
+	assert(readv);
+
+	// Mark the task as belonging to a vectored operation, so it can share
+	// the queue with single read operations.
+	readv->task._data = &readv->task;
+	readv->r.n = 0;
+	readv->r.errc = 0;
+	if ((*chan)->submit_readv)
+		(*chan)->submit_readv(chan, readv);
+	else
+		io_can_chan_submit_notsup(chan, &readv->task, &readv->r.errc);
+}
+
+void
+io_can_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	assert(chan);
+	assert(writev);
+
+	// Mark the task as belonging to a vectored operation, so it can share
+	// the queue with single write operations.
+	writev->task._data = &writev->task;
+	writev->r.n = 0;
+	writev->r.errc = 0;
+	writev->_nconfirm = 0;
+	if ((*chan)->submit_writev)
+		(*chan)->submit_writev(chan, writev);
+	else
+		io_can_chan_submit_notsup(chan, &writev->task, &writev->r.errc);
+}
+
 struct io_can_chan_read *
 io_can_chan_read_from_task(struct ev_task *task)
 {
@@ -101,6 +147,18 @@ io_can_chan_write_from_task(struct ev_task *task)
 	return task ? structof(task, struct io_can_chan_write, task) : NULL;
 }
 
+struct io_can_chan_readv *
+io_can_chan_readv_from_task(struct ev_task *task)
+{
+	return task ? structof(task, struct io_can_chan_readv, task) : NULL;
+}
+
+struct io_can_chan_writev *
+io_can_chan_writev_from_task(struct ev_task *task)
+{
+	return task ? structof(task, struct io_can_chan_writev, task) : NULL;
+}
+
 static void
 io_can_chan_async_read_func(struct ev_task *task)
 {
@@ -124,3 +182,16 @@ io_can_chan_async_write_func(struct ev_task *task)
 	ev_promise_set(async_write->promise, &write->errc);
 	ev_promise_release(async_write->promise);
 }
+
+static void
+io_can_chan_submit_notsup(
+		io_can_chan_t *chan, struct ev_task *task, int *perrc)
+{
+	assert(task);
+	assert(perrc);
+
+	if (!task->exec)
+		task->exec = io_can_chan_get_exec(chan);
+	*perrc = errnum2c(ERRNUM_NOTSUP);
+	ev_exec_post(task->exec, task);
+}
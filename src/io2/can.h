@@ -25,6 +25,7 @@
 #include <lely/ev/exec.h>
 #include <lely/io2/can.h>
 
+#include <limits.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -39,6 +40,55 @@ static size_t io_can_chan_read_queue_post(
 static void io_can_chan_write_post(struct io_can_chan_write *write, int errc);
 static size_t io_can_chan_write_queue_post(struct sllist *queue, int errc);
 
+/**
+ * Returns 1 if <b>task</b> is the completion task of a vectored read or write
+ * operation (see io_can_chan_submit_readv() and io_can_chan_submit_writev()),
+ * and 0 if not. This allows both kinds of operations to share a queue.
+ */
+static inline int io_can_chan_task_is_vec(const struct ev_task *task);
+
+static void io_can_chan_readv_post(
+		struct io_can_chan_readv *readv, size_t n, int errc);
+static void io_can_chan_writev_post(
+		struct io_can_chan_writev *writev, int errc);
+
+/**
+ * Submits the completion task of a single or vectored read operation. For a
+ * vectored read operation, <b>result</b> is the number of CAN frames read.
+ */
+static void io_can_chan_read_task_post(
+		struct ev_task *task, int result, int errc);
+
+/// Submits the completion task of a single or vectored write operation.
+static void io_can_chan_write_task_post(struct ev_task *task, int errc);
+
+/**
+ * Performs a non-blocking single or vectored read operation by invoking
+ * <b>read</b> with a timeout of 0, until the receive buffer is empty or, for
+ * a vectored read, all frames have been read.
+ *
+ * @returns the result of the single read operation, the (non-zero) number of
+ * CAN frames received by a vectored read operation, or -1 on error. In the
+ * latter case, the error number can be obtained with get_errc().
+ */
+static int io_can_chan_task_read(io_can_chan_t *chan, struct ev_task *task,
+		int (*read)(io_can_chan_t *chan, struct can_msg *msg,
+				struct can_err *err, struct timespec *tp,
+				int timeout));
+
+/**
+ * Performs (the remainder of) a single or vectored write operation by invoking
+ * <b>write</b> for each CAN frame. The number of frames written by a vectored
+ * write operation is updated as the frames are written.
+ *
+ * @returns 0 on success, or -1 on error. In the latter case, the error number
+ * can be obtained with get_errc().
+ */
+static int io_can_chan_task_write(io_can_chan_t *chan, struct ev_task *task,
+		int timeout,
+		int (*write)(io_can_chan_t *chan, const struct can_msg *msg,
+				int timeout));
+
 static inline void
 io_can_chan_read_post(struct io_can_chan_read *read, int result, int errc)
 {
@@ -57,10 +107,8 @@ io_can_chan_read_queue_post(struct sllist *queue, int result, int errc)
 
 	struct slnode *node;
 	while ((node = sllist_pop_front(queue))) {
-		struct ev_task *task = ev_task_from_node(node);
-		struct io_can_chan_read *read =
-				io_can_chan_read_from_task(task);
-		io_can_chan_read_post(read, result, errc);
+		io_can_chan_read_task_post(
+				ev_task_from_node(node), result, errc);
 		n += n < SIZE_MAX;
 	}
 
@@ -84,16 +132,108 @@ io_can_chan_write_queue_post(struct sllist *queue, int errc)
 
 	struct slnode *node;
 	while ((node = sllist_pop_front(queue))) {
-		struct ev_task *task = ev_task_from_node(node);
-		struct io_can_chan_write *write =
-				io_can_chan_write_from_task(task);
-		io_can_chan_write_post(write, errc);
+		io_can_chan_write_task_post(ev_task_from_node(node), errc);
 		n += n < SIZE_MAX;
 	}
 
 	return n;
 }
 
+static inline int
+io_can_chan_task_is_vec(const struct ev_task *task)
+{
+	return task->_data == task;
+}
+
+static inline void
+io_can_chan_readv_post(struct io_can_chan_readv *readv, size_t n, int errc)
+{
+	readv->r.n = n;
+	readv->r.errc = errc;
+
+	ev_exec_t *exec = readv->task.exec;
+	ev_exec_post(exec, &readv->task);
+	ev_exec_on_task_fini(exec);
+}
+
+static inline void
+io_can_chan_writev_post(struct io_can_chan_writev *writev, int errc)
+{
+	writev->r.errc = errc;
+
+	ev_exec_t *exec = writev->task.exec;
+	ev_exec_post(exec, &writev->task);
+	ev_exec_on_task_fini(exec);
+}
+
+static inline void
+io_can_chan_read_task_post(struct ev_task *task, int result, int errc)
+{
+	if (io_can_chan_task_is_vec(task))
+		io_can_chan_readv_post(io_can_chan_readv_from_task(task),
+				result > 0 ? (size_t)result : 0, errc);
+	else
+		io_can_chan_read_post(io_can_chan_read_from_task(task), result,
+				errc);
+}
+
+static inline void
+io_can_chan_write_task_post(struct ev_task *task, int errc)
+{
+	if (io_can_chan_task_is_vec(task))
+		io_can_chan_writev_post(
+				io_can_chan_writev_from_task(task), errc);
+	else
+		io_can_chan_write_post(io_can_chan_write_from_task(task), errc);
+}
+
+static inline int
+io_can_chan_task_read(io_can_chan_t *chan, struct ev_task *task,
+		int (*read)(io_can_chan_t *chan, struct can_msg *msg,
+				struct can_err *err, struct timespec *tp,
+				int timeout))
+{
+	if (!io_can_chan_task_is_vec(task)) {
+		struct io_can_chan_read *read_ =
+				io_can_chan_read_from_task(task);
+		return read(chan, read_->msg, read_->err, read_->tp, 0);
+	}
+
+	struct io_can_chan_readv *readv = io_can_chan_readv_from_task(task);
+	int n = 0;
+	while ((size_t)n < readv->n && n < INT_MAX) {
+		struct timespec *tp = readv->tps ? &readv->tps[n] : NULL;
+		int result = read(chan, &readv->msgs[n], NULL, tp, 0);
+		if (result == -1) {
+			// Report the error only if no frame was read.
+			if (!n)
+				return -1;
+			break;
+		}
+		// Error frames are discarded.
+		n += result;
+	}
+	return n;
+}
+
+static inline int
+io_can_chan_task_write(io_can_chan_t *chan, struct ev_task *task, int timeout,
+		int (*write)(io_can_chan_t *chan, const struct can_msg *msg,
+				int timeout))
+{
+	if (!io_can_chan_task_is_vec(task))
+		return write(chan, io_can_chan_write_from_task(task)->msg,
+				timeout);
+
+	struct io_can_chan_writev *writev = io_can_chan_writev_from_task(task);
+	while (writev->r.n < writev->n) {
+		if (write(chan, &writev->msgs[writev->r.n], timeout) == -1)
+			return -1;
+		writev->r.n++;
+	}
+	return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
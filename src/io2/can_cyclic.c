@@ -0,0 +1,608 @@
+/**@file
+ * This file is part of the I/O library; it contains the implementation of the
+ * cyclic CAN frame transmitter.
+ *
+ * @see lely/io2/can_cyclic.h
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "io2.h"
+
+#if !LELY_NO_MALLOC
+
+#include <lely/io2/can_cyclic.h>
+#include <lely/io2/ctx.h>
+#if !LELY_NO_THREADS
+#include <lely/libc/threads.h>
+#endif
+#include <lely/util/diag.h>
+#include <lely/util/errnum.h>
+#include <lely/util/time.h>
+#include <lely/util/util.h>
+
+#include <assert.h>
+#include <stdlib.h>
+
+static void io_can_cyclic_svc_shutdown(struct io_svc *svc);
+
+// clang-format off
+static const struct io_svc_vtbl io_can_cyclic_svc_vtbl = {
+	NULL,
+	&io_can_cyclic_svc_shutdown
+};
+// clang-format on
+
+/// The implementation of a cyclic CAN frame transmitter.
+struct io_can_cyclic {
+	/// The I/O service representing the transmitter.
+	struct io_svc svc;
+	/// A pointer to the I/O context with which the service is registered.
+	io_ctx_t *ctx;
+	/// A pointer to the timer used to schedule the transmissions.
+	io_timer_t *timer;
+	/// A pointer to the CAN channel.
+	io_can_chan_t *chan;
+	/// The operation used to wait for the timer to expire.
+	struct io_timer_wait wait;
+	/// The CAN frame staged for (or being written in) the current cycle.
+	struct can_msg msg;
+	/// The operation used to write #msg.
+	struct io_can_chan_write write;
+#if !LELY_NO_THREADS
+	/// The mutex protecting the callbacks, flags, schedule and statistics.
+	mtx_t mtx;
+#endif
+	/// A pointer to the function used to stage the next frame.
+	io_can_cyclic_func_t *func;
+	/// The user-specified argument for #func.
+	void *arg;
+	/// A pointer to the function invoked when a write operation completes.
+	io_can_cyclic_on_write_func_t *on_write_func;
+	/// The user-specified argument for #on_write_func.
+	void *on_write_arg;
+	/// The absolute time of the next expiration.
+	struct timespec next;
+	/// The period.
+	struct timespec interval;
+	/// The deadline of the write operation in progress.
+	struct timespec deadline;
+	/**
+	 * The generation of the schedule, incremented by io_can_cyclic_start()
+	 * to discard frames staged for a previous schedule.
+	 */
+	unsigned gen;
+	/// The statistics.
+	struct io_can_cyclic_stats stats;
+	/// A flag indicating whether the transmitter has been started.
+	unsigned started : 1;
+	/// A flag indicating whether the transmitter is being shut down.
+	unsigned shutdown : 1;
+	/// A flag indicating whether #msg contains a staged frame.
+	unsigned staged : 1;
+	/// A flag indicating whether #func is being invoked.
+	unsigned staging : 1;
+	/// A flag indicating whether #wait has been submitted to #timer.
+	unsigned wait_submitted : 1;
+	/// A flag indicating whether #write has been submitted to #chan.
+	unsigned write_submitted : 1;
+};
+
+static void io_can_cyclic_wait_func(struct ev_task *task);
+static void io_can_cyclic_write_func(struct ev_task *task);
+
+static inline io_can_cyclic_t *io_can_cyclic_from_svc(
+		const struct io_svc *svc);
+
+/**
+ * Invokes the user-specified function to stage the frame for the next cycle,
+ * unless a frame is already staged. The mutex MUST be locked when this function
+ * is invoked; it is unlocked while the user-specified function runs.
+ *
+ * @returns 1 if a frame is staged, and 0 if not.
+ */
+static int io_can_cyclic_do_stage(io_can_cyclic_t *cyc);
+
+/// Records the latency of a completed write operation in the statistics.
+static void io_can_cyclic_do_record(
+		io_can_cyclic_t *cyc, int_least64_t nsec, int errc);
+
+#if !LELY_NO_THREADS
+static size_t io_can_cyclic_do_abort_tasks(io_can_cyclic_t *cyc);
+#endif
+
+void *
+io_can_cyclic_alloc(void)
+{
+	void *ptr = malloc(sizeof(io_can_cyclic_t));
+#if !LELY_NO_ERRNO
+	if (!ptr)
+		set_errc(errno2c(errno));
+#endif
+	return ptr;
+}
+
+void
+io_can_cyclic_free(void *ptr)
+{
+	free(ptr);
+}
+
+io_can_cyclic_t *
+io_can_cyclic_init(io_can_cyclic_t *cyc, ev_exec_t *exec, io_timer_t *timer,
+		io_can_chan_t *chan)
+{
+	assert(cyc);
+	assert(timer);
+	assert(chan);
+
+	if (!exec)
+		exec = io_can_chan_get_exec(chan);
+
+	cyc->svc = (struct io_svc)IO_SVC_INIT(&io_can_cyclic_svc_vtbl);
+	cyc->ctx = io_can_chan_get_ctx(chan);
+	assert(cyc->ctx);
+
+	cyc->timer = timer;
+	cyc->chan = chan;
+
+	cyc->wait = (struct io_timer_wait)IO_TIMER_WAIT_INIT(
+			exec, &io_can_cyclic_wait_func);
+
+	cyc->msg = (struct can_msg)CAN_MSG_INIT;
+	cyc->write = (struct io_can_chan_write)IO_CAN_CHAN_WRITE_INIT(
+			&cyc->msg, exec, &io_can_cyclic_write_func);
+
+#if !LELY_NO_THREADS
+	if (mtx_init(&cyc->mtx, mtx_plain) != thrd_success)
+		return NULL;
+#endif
+
+	cyc->func = NULL;
+	cyc->arg = NULL;
+	cyc->on_write_func = NULL;
+	cyc->on_write_arg = NULL;
+
+	cyc->next = (struct timespec){ 0, 0 };
+	cyc->interval = (struct timespec){ 0, 0 };
+	cyc->deadline = (struct timespec){ 0, 0 };
+	cyc->gen = 0;
+
+	cyc->stats = (struct io_can_cyclic_stats)IO_CAN_CYCLIC_STATS_INIT;
+
+	cyc->started = 0;
+	cyc->shutdown = 0;
+	cyc->staged = 0;
+	cyc->staging = 0;
+	cyc->wait_submitted = 0;
+	cyc->write_submitted = 0;
+
+	io_ctx_insert(cyc->ctx, &cyc->svc);
+
+	return cyc;
+}
+
+void
+io_can_cyclic_fini(io_can_cyclic_t *cyc)
+{
+	assert(cyc);
+
+	io_ctx_remove(cyc->ctx, &cyc->svc);
+	// Cancel all pending operations.
+	io_can_cyclic_svc_shutdown(&cyc->svc);
+
+#if !LELY_NO_THREADS
+	int warning = 0;
+	mtx_lock(&cyc->mtx);
+	// If necessary, busy-wait until all submitted operations complete.
+	while (cyc->wait_submitted || cyc->write_submitted || cyc->staging) {
+		if (io_can_cyclic_do_abort_tasks(cyc))
+			continue;
+		mtx_unlock(&cyc->mtx);
+		if (!warning) {
+			warning = 1;
+			diag(DIAG_WARNING, 0,
+					"io_can_cyclic_fini() invoked with pending operations");
+		}
+		thrd_yield();
+		mtx_lock(&cyc->mtx);
+	}
+	mtx_unlock(&cyc->mtx);
+
+	mtx_destroy(&cyc->mtx);
+#endif
+}
+
+io_can_cyclic_t *
+io_can_cyclic_create(ev_exec_t *exec, io_timer_t *timer, io_can_chan_t *chan)
+{
+	int errc = 0;
+
+	io_can_cyclic_t *cyc = io_can_cyclic_alloc();
+	if (!cyc) {
+		errc = get_errc();
+		goto error_alloc;
+	}
+
+	io_can_cyclic_t *tmp = io_can_cyclic_init(cyc, exec, timer, chan);
+	if (!tmp) {
+		errc = get_errc();
+		goto error_init;
+	}
+	cyc = tmp;
+
+	return cyc;
+
+error_init:
+	io_can_cyclic_free(cyc);
+error_alloc:
+	set_errc(errc);
+	return NULL;
+}
+
+void
+io_can_cyclic_destroy(io_can_cyclic_t *cyc)
+{
+	if (cyc) {
+		io_can_cyclic_fini(cyc);
+		io_can_cyclic_free(cyc);
+	}
+}
+
+void
+io_can_cyclic_set_func(
+		io_can_cyclic_t *cyc, io_can_cyclic_func_t *func, void *arg)
+{
+	assert(cyc);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	cyc->func = func;
+	cyc->arg = func ? arg : NULL;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+void
+io_can_cyclic_set_on_write_func(io_can_cyclic_t *cyc,
+		io_can_cyclic_on_write_func_t *func, void *arg)
+{
+	assert(cyc);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	cyc->on_write_func = func;
+	cyc->on_write_arg = func ? arg : NULL;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+int
+io_can_cyclic_start(io_can_cyclic_t *cyc, const struct timespec *start,
+		const struct timespec *interval)
+{
+	assert(cyc);
+	assert(start);
+	assert(interval);
+
+	if (interval->tv_sec < 0 || (!interval->tv_sec && !interval->tv_nsec)) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	if (cyc->shutdown) {
+		set_errnum(ERRNUM_CANCELED);
+		goto error;
+	}
+
+	// Let the kernel (or the timer implementation) generate the
+	// expirations, so they do not drift.
+	struct itimerspec value = { *interval, *start };
+	if (io_timer_settime(cyc->timer, TIMER_ABSTIME, &value, NULL) == -1)
+		goto error;
+
+	cyc->next = *start;
+	cyc->interval = *interval;
+	// Discard any frame staged for the previous schedule.
+	cyc->gen++;
+	cyc->staged = 0;
+	cyc->started = 1;
+
+	int submit = !cyc->wait_submitted;
+	if (submit)
+		cyc->wait_submitted = 1;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+	if (submit)
+		io_timer_submit_wait(cyc->timer, &cyc->wait);
+
+	return 0;
+
+error:
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+	return -1;
+}
+
+void
+io_can_cyclic_stop(io_can_cyclic_t *cyc)
+{
+	assert(cyc);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	if (cyc->started) {
+		cyc->started = 0;
+		cyc->staged = 0;
+		struct itimerspec value = { { 0, 0 }, { 0, 0 } };
+		io_timer_settime(cyc->timer, 0, &value, NULL);
+	}
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+void
+io_can_cyclic_get_stats(
+		const io_can_cyclic_t *cyc, struct io_can_cyclic_stats *stats)
+{
+	assert(cyc);
+	assert(stats);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&cyc->mtx);
+#endif
+	*stats = cyc->stats;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&cyc->mtx);
+#endif
+}
+
+void
+io_can_cyclic_reset_stats(io_can_cyclic_t *cyc)
+{
+	assert(cyc);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	cyc->stats = (struct io_can_cyclic_stats)IO_CAN_CYCLIC_STATS_INIT;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+static void
+io_can_cyclic_svc_shutdown(struct io_svc *svc)
+{
+	io_can_cyclic_t *cyc = io_can_cyclic_from_svc(svc);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	int shutdown = !cyc->shutdown;
+	cyc->shutdown = 1;
+	cyc->started = 0;
+	// Abort io_can_cyclic_wait_func().
+	if (shutdown && cyc->wait_submitted
+			&& io_timer_abort_wait(cyc->timer, &cyc->wait))
+		cyc->wait_submitted = 0;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+static void
+io_can_cyclic_wait_func(struct ev_task *task)
+{
+	assert(task);
+	struct io_timer_wait *wait = io_timer_wait_from_task(task);
+	io_can_cyclic_t *cyc = structof(wait, io_can_cyclic_t, wait);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	assert(cyc->wait_submitted);
+	cyc->wait_submitted = 0;
+
+	if (!cyc->started || wait->r.result < 0) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&cyc->mtx);
+#endif
+		return;
+	}
+
+	// Skip the expirations that were not processed in time.
+	int overrun = wait->r.result;
+	cyc->stats.nmissed += overrun;
+	for (int i = 0; i < overrun; i++)
+		timespec_add(&cyc->next, &cyc->interval);
+	struct timespec deadline = cyc->next;
+	timespec_add(&cyc->next, &cyc->interval);
+
+	int submit_write = 0;
+	if (cyc->write_submitted) {
+		// The previous frame has not been written yet.
+		cyc->stats.nmissed++;
+	} else if (cyc->func && !io_can_cyclic_do_stage(cyc)) {
+		// The user-specified function did not stage a frame in time.
+		cyc->stats.nmissed++;
+	} else {
+		cyc->deadline = deadline;
+		cyc->staged = 0;
+		submit_write = cyc->write_submitted = 1;
+	}
+
+	int submit_wait = cyc->wait_submitted =
+			cyc->started && !cyc->shutdown;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+
+	if (submit_write)
+		io_can_chan_submit_write(cyc->chan, &cyc->write);
+	if (submit_wait)
+		io_timer_submit_wait(cyc->timer, &cyc->wait);
+}
+
+static void
+io_can_cyclic_write_func(struct ev_task *task)
+{
+	assert(task);
+	struct io_can_chan_write *write = io_can_chan_write_from_task(task);
+	io_can_cyclic_t *cyc = structof(write, io_can_cyclic_t, write);
+
+	struct timespec now = { 0, 0 };
+	io_clock_gettime(io_timer_get_clock(cyc->timer), &now);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	assert(cyc->write_submitted);
+	cyc->write_submitted = 0;
+
+	int errc = write->errc;
+	io_can_cyclic_do_record(
+			cyc, timespec_diff_nsec(&now, &cyc->deadline), errc);
+
+	struct can_msg msg = cyc->msg;
+	io_can_cyclic_on_write_func_t *on_write_func = cyc->on_write_func;
+	void *on_write_arg = cyc->on_write_arg;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+
+	if (on_write_func)
+		on_write_func(&msg, &now, errc, on_write_arg);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	// Stage the frame for the next cycle, so it is ready by the time the
+	// timer expires.
+	if (cyc->started && cyc->func)
+		io_can_cyclic_do_stage(cyc);
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+}
+
+static inline io_can_cyclic_t *
+io_can_cyclic_from_svc(const struct io_svc *svc)
+{
+	assert(svc);
+
+	return structof(svc, io_can_cyclic_t, svc);
+}
+
+static int
+io_can_cyclic_do_stage(io_can_cyclic_t *cyc)
+{
+	assert(cyc);
+	assert(cyc->func);
+
+	if (cyc->staged)
+		return 1;
+	// Do not stage a frame twice if the timer expires while the
+	// user-specified function is running.
+	if (cyc->staging || cyc->write_submitted)
+		return 0;
+	cyc->staging = 1;
+
+	io_can_cyclic_func_t *func = cyc->func;
+	void *arg = cyc->arg;
+	unsigned gen = cyc->gen;
+#if !LELY_NO_THREADS
+	mtx_unlock(&cyc->mtx);
+#endif
+	struct can_msg msg = CAN_MSG_INIT;
+	func(&msg, arg);
+#if !LELY_NO_THREADS
+	mtx_lock(&cyc->mtx);
+#endif
+	cyc->staging = 0;
+
+	// Discard the frame if the transmitter was restarted in the mean time.
+	if (gen == cyc->gen && cyc->started) {
+		cyc->msg = msg;
+		cyc->staged = 1;
+	}
+	return cyc->staged;
+}
+
+static void
+io_can_cyclic_do_record(io_can_cyclic_t *cyc, int_least64_t nsec, int errc)
+{
+	assert(cyc);
+	struct io_can_cyclic_stats *stats = &cyc->stats;
+
+	if (errc) {
+		stats->nerror++;
+		return;
+	}
+
+	if (nsec < 0)
+		nsec = 0;
+	if (!stats->nwrite || nsec < stats->min)
+		stats->min = nsec;
+	if (!stats->nwrite || nsec > stats->max)
+		stats->max = nsec;
+	stats->sum += nsec;
+	stats->nwrite++;
+
+	int bin = 0;
+	for (int_least64_t usec = nsec / 1000;
+			usec && bin < IO_CAN_CYCLIC_NBIN - 1; usec >>= 1)
+		bin++;
+	stats->hist[bin]++;
+}
+
+#if !LELY_NO_THREADS
+static size_t
+io_can_cyclic_do_abort_tasks(io_can_cyclic_t *cyc)
+{
+	assert(cyc);
+
+	size_t n = 0;
+
+	if (cyc->wait_submitted
+			&& io_timer_abort_wait(cyc->timer, &cyc->wait)) {
+		cyc->wait_submitted = 0;
+		n++;
+	}
+
+	if (cyc->write_submitted
+			&& io_can_chan_abort_write(cyc->chan, &cyc->write)) {
+		cyc->write_submitted = 0;
+		n++;
+	}
+
+	return n;
+}
+#endif // !LELY_NO_THREADS
+
+#endif // !LELY_NO_MALLOC
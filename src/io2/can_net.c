@@ -28,12 +28,14 @@
 #include <lely/can/net.h>
 #include <lely/io2/can_net.h>
 #include <lely/io2/ctx.h>
+#if !LELY_NO_THREADS && !LELY_NO_ATOMICS
+#include <lely/libc/stdatomic.h>
+#endif
 #include <lely/libc/stdlib.h>
 #if !LELY_NO_THREADS
 #include <lely/libc/threads.h>
 #endif
 #include <lely/util/diag.h>
-#include <lely/util/spscring.h>
 #include <lely/util/time.h>
 #include <lely/util/util.h>
 
@@ -55,6 +57,44 @@
 #define LELY_IO_CAN_NET_TXTIMEO 100
 #endif
 
+/// An entry in the transmit queue of a CAN network interface.
+struct io_can_net_txent {
+	/// The CAN frame to be sent.
+	struct can_msg msg;
+	/**
+	 * The priority of the frame. The most significant bits contain the
+	 * traffic class, the least significant 32 bits the arbitration key (if
+	 * identifier ordering is enabled). A lower value means a higher
+	 * priority.
+	 */
+	uint_least64_t prio;
+	/// The sequence number, used to order frames with the same priority.
+	uint_least64_t seq;
+	/// The time at which the frame was queued.
+	struct timespec time;
+};
+
+/// The indices of the statistics counters of a CAN network interface.
+enum {
+	IO_CAN_NET_STAT_RX_FRAMES,
+	IO_CAN_NET_STAT_RX_BYTES,
+	IO_CAN_NET_STAT_RX_BITS,
+	IO_CAN_NET_STAT_TX_FRAMES,
+	IO_CAN_NET_STAT_TX_BYTES,
+	IO_CAN_NET_STAT_TX_BITS,
+	IO_CAN_NET_STAT_TX_HWM,
+	IO_CAN_NET_STAT_TX_LATENCY,
+	IO_CAN_NET_STAT_RX_LATENCY =
+			IO_CAN_NET_STAT_TX_LATENCY + IO_CAN_NET_STATS_NBIN,
+	IO_CAN_NET_NSTAT = IO_CAN_NET_STAT_RX_LATENCY + IO_CAN_NET_STATS_NBIN
+};
+
+#if !LELY_NO_THREADS && !LELY_NO_ATOMICS
+typedef atomic_uint_least64_t io_can_net_stat_t;
+#else
+typedef uint_least64_t io_can_net_stat_t;
+#endif
+
 static void io_can_net_svc_shutdown(struct io_svc *svc);
 
 // clang-format off
@@ -91,7 +131,10 @@ struct io_can_net {
 	struct can_msg read_msg;
 	/// The CAN error frame being read.
 	struct can_err read_err;
-	/// The operation used to read CAN frames.
+	/**
+	 * The operation used to read CAN frames. A vectored read is not used,
+	 * since it discards the error frames that track the CAN bus state.
+	 */
 	struct io_can_chan_read read;
 	/// The error code of the last read operation.
 	int read_errc;
@@ -101,18 +144,42 @@ struct io_can_net {
 	int state;
 	/// The CAN frame being written.
 	struct can_msg write_msg;
-	/// The operation used to write CAN frames.
+	/**
+	 * The operation used to write CAN frames. Frames are written one at a
+	 * time, so a higher-priority frame can overtake the frames remaining in
+	 * the transmit queue, and each frame is confirmed individually.
+	 */
 	struct io_can_chan_write write;
 	/// The error code of the last write operation.
 	int write_errc;
 	/// The number of errors since the last successful write operation.
 	size_t write_errcnt;
-	/// The ring buffer used to control the transmit queue.
-	struct spscring tx_ring;
-	/// The transmit queue.
-	struct can_msg *tx_buf;
+	/**
+	 * The transmit queue, a binary min-heap of frames ordered by priority
+	 * and sequence number.
+	 */
+	struct io_can_net_txent *tx_heap;
+	/// The maximum number of frames in #tx_heap.
+	size_t txlen;
+	/// The number of frames in #tx_heap.
+	size_t tx_n;
+	/// The sequence number of the next frame added to #tx_heap.
+	uint_least64_t tx_seq;
+	/// The number of frames in each traffic class of #tx_heap.
+	size_t tx_nclass[IO_CAN_NET_NTXCLASS];
+	/// The maximum number of frames in each traffic class (0 if unlimited).
+	size_t tx_depth[IO_CAN_NET_NTXCLASS];
+	/// The number of frames dropped in each traffic class.
+	size_t tx_dropped[IO_CAN_NET_NTXCLASS];
 	/// The number of frames dropped due to the transmit queue being full.
 	size_t tx_errcnt;
+	/// The time at which #write_msg was queued.
+	struct timespec write_time;
+	/**
+	 * The statistics counters. The counters are only modified with #mtx
+	 * locked, but can be read without.
+	 */
+	io_can_net_stat_t stats[IO_CAN_NET_NSTAT];
 #if !LELY_NO_THREADS
 	/**
 	 * The mutex protecting the callbacks, flags and internal CAN network
@@ -144,6 +211,13 @@ struct io_can_net {
 	io_can_net_on_error_func_t *on_write_error_func;
 	/// The user-specified argument for #on_write_error_func.
 	void *on_write_error_arg;
+	/**
+	 * A pointer to the function invoked when a CAN frame has been written
+	 * successfully.
+	 */
+	io_can_net_on_write_func_t *on_write_func;
+	/// The user-specified argument for #on_write_func.
+	void *on_write_arg;
 	/**
 	 * A pointer to the function to be invoked when a CAN bus state change
 	 * is detected.
@@ -158,6 +232,17 @@ struct io_can_net {
 	io_can_net_on_can_error_func_t *on_can_error_func;
 	/// The user-specified argument for #on_error_func.
 	void *on_can_error_arg;
+	/// A pointer to the function used to determine the traffic class.
+	io_can_net_txclass_func_t *txclass_func;
+	/// The user-specified argument for #txclass_func.
+	void *txclass_arg;
+	/// A flag indicating whether frames are ordered by identifier.
+	int txprio;
+	/**
+	 * A pointer to the function used to install acceptance filters on
+	 * #chan.
+	 */
+	io_can_net_filter_func_t *filter_func;
 	/// A flag indicating wheter the CAN network interface has been started.
 	unsigned started : 1;
 	/// A flag indicating whether the I/O service has been shut down.
@@ -183,14 +268,71 @@ static void io_can_net_write_func(struct ev_task *task);
 
 static int io_can_net_next_func(const struct timespec *tp, void *data);
 static int io_can_net_send_func(const struct can_msg *msg, void *data);
-
-static void io_can_net_c_wait_func(struct spscring *ring, void *arg);
+static int io_can_net_filter_func(
+		const struct can_net_filter *filters, size_t n, void *data);
 
 static inline io_can_net_t *io_can_net_from_svc(const struct io_svc *svc);
 
-static int io_can_net_do_wait(io_can_net_t *net);
+/**
+ * Adds a CAN frame to the transmit queue of a CAN network interface.
+ *
+ * @returns 0 on success, or -1 if the transmit queue, or the traffic class of
+ * the frame, is full.
+ */
+static int io_can_net_tx_push(io_can_net_t *net, const struct can_msg *msg);
+
+/**
+ * Removes the CAN frame with the highest priority from the transmit queue of a
+ * CAN network interface and stores it in the write operation.
+ *
+ * @returns 1 if a frame was removed, and 0 if the queue is empty.
+ */
+static int io_can_net_tx_pop(io_can_net_t *net);
+
+/**
+ * Returns 1 if entry <b>a</b> in the transmit queue of a CAN network interface
+ * is to be sent before entry <b>b</b>, and 0 if not.
+ */
+static inline int io_can_net_txent_before(const struct io_can_net_txent *a,
+		const struct io_can_net_txent *b);
+
+/**
+ * Returns the arbitration key of a CAN frame. A frame with a lower key wins
+ * arbitration on the CAN bus.
+ */
+static inline uint_least32_t can_msg_arb_key(const struct can_msg *msg);
+
+/**
+ * Sends the next CAN frame in the transmit queue of a CAN network interface,
+ * if no write operation is in progress.
+ */
+static void io_can_net_do_next(io_can_net_t *net);
 static void io_can_net_do_write(io_can_net_t *net);
 
+static inline uint_least64_t io_can_net_stat_get(
+		const io_can_net_t *net, int i);
+static inline void io_can_net_stat_set(
+		io_can_net_t *net, int i, uint_least64_t value);
+static inline void io_can_net_stat_add(
+		io_can_net_t *net, int i, uint_least64_t n);
+
+/**
+ * Updates the frame, byte and bit counters of a CAN network interface,
+ * starting at counter <b>i</b>, with a received or written CAN frame.
+ */
+static void io_can_net_stat_msg(
+		io_can_net_t *net, int i, const struct can_msg *msg);
+
+/**
+ * Records the latency between <b>t1</b> and <b>t2</b> in the histogram of a CAN
+ * network interface starting at counter <b>i</b>.
+ */
+static void io_can_net_stat_latency(io_can_net_t *net, int i,
+		const struct timespec *t1, const struct timespec *t2);
+
+/// Returns the histogram bin for a latency of <b>usec</b> microseconds.
+static int io_can_net_stats_bin(uint_least64_t usec);
+
 #if !LELY_NO_THREADS
 static size_t io_can_net_do_abort_tasks(io_can_net_t *net);
 #endif
@@ -272,13 +414,23 @@ io_can_net_init(io_can_net_t *net, ev_exec_t *exec, io_timer_t *timer,
 	net->write_errc = 0;
 	net->write_errcnt = 0;
 
-	spscring_init(&net->tx_ring, txlen);
-	net->tx_buf = calloc(txlen, sizeof(struct can_msg));
-	if (!net->tx_buf) {
+	net->tx_heap = calloc(txlen, sizeof(struct io_can_net_txent));
+	if (!net->tx_heap) {
 		errc = get_errc();
-		goto error_alloc_tx_buf;
+		goto error_alloc_tx_heap;
+	}
+	net->txlen = txlen;
+	net->tx_n = 0;
+	net->tx_seq = 0;
+	for (int i = 0; i < IO_CAN_NET_NTXCLASS; i++) {
+		net->tx_nclass[i] = 0;
+		net->tx_depth[i] = 0;
+		net->tx_dropped[i] = 0;
 	}
 	net->tx_errcnt = 0;
+	net->write_time = (struct timespec){ 0, 0 };
+	for (int i = 0; i < IO_CAN_NET_NSTAT; i++)
+		io_can_net_stat_set(net, i, 0);
 
 #if !LELY_NO_THREADS
 	if (mtx_init(&net->mtx, mtx_plain) != thrd_success) {
@@ -293,10 +445,16 @@ io_can_net_init(io_can_net_t *net, ev_exec_t *exec, io_timer_t *timer,
 	net->on_queue_error_arg = NULL;
 	net->on_write_error_func = &default_on_write_error_func;
 	net->on_write_error_arg = NULL;
+	net->on_write_func = NULL;
+	net->on_write_arg = NULL;
 	net->on_can_state_func = &default_on_can_state_func;
 	net->on_can_state_arg = NULL;
 	net->on_can_error_func = &default_on_can_error_func;
 	net->on_can_error_arg = NULL;
+	net->txclass_func = NULL;
+	net->txclass_arg = NULL;
+	net->txprio = 0;
+	net->filter_func = NULL;
 
 	net->started = 0;
 	net->shutdown = 0;
@@ -335,8 +493,8 @@ error_create_net:
 	mtx_destroy(&net->mtx);
 error_init_mtx:
 #endif
-	free(net->tx_buf);
-error_alloc_tx_buf:
+	free(net->tx_heap);
+error_alloc_tx_heap:
 	io_tqueue_destroy(net->tq);
 error_create_tq:
 	set_errc(errc);
@@ -376,7 +534,7 @@ io_can_net_fini(io_can_net_t *net)
 #if !LELY_NO_THREADS
 	mtx_destroy(&net->mtx);
 #endif
-	free(net->tx_buf);
+	free(net->tx_heap);
 	io_tqueue_destroy(net->tq);
 }
 
@@ -429,9 +587,9 @@ io_can_net_start(io_can_net_t *net)
 	if (!net->started && !net->shutdown) {
 		net->started = 1;
 
-		// Start waiting for CAN frames to be put into the transmit
-		// queue.
-		io_can_net_do_wait(net);
+		// Send the CAN frames queued before the network interface was
+		// started.
+		io_can_net_do_next(net);
 
 		assert(!net->read_submitted);
 		net->read_submitted = 1;
@@ -577,6 +735,40 @@ io_can_net_set_on_write_error_func(
 #endif
 }
 
+void
+io_can_net_get_on_write_func(const io_can_net_t *net,
+		io_can_net_on_write_func_t **pfunc, void **parg)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	if (pfunc)
+		*pfunc = net->on_write_func;
+	if (parg)
+		*parg = net->on_write_arg;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+}
+
+void
+io_can_net_set_on_write_func(
+		io_can_net_t *net, io_can_net_on_write_func_t *func, void *arg)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	net->on_write_func = func;
+	net->on_write_arg = func ? arg : NULL;
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+}
+
 void
 io_can_net_get_on_can_state_func(const io_can_net_t *net,
 		io_can_net_on_can_state_func_t **pfunc, void **parg)
@@ -645,6 +837,220 @@ io_can_net_set_on_can_error_func(io_can_net_t *net,
 #endif
 }
 
+io_can_net_filter_func_t *
+io_can_net_get_filter_func(const io_can_net_t *net)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	io_can_net_filter_func_t *func = net->filter_func;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+	return func;
+}
+
+int
+io_can_net_set_filter_func(io_can_net_t *net, io_can_net_filter_func_t *func)
+{
+	assert(net);
+
+	int result = 0;
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	io_can_net_filter_func_t *old_func = net->filter_func;
+	net->filter_func = func;
+	if (func) {
+		result = can_net_set_filter_func(
+				net->net, &io_can_net_filter_func, net);
+	} else if (old_func) {
+		can_net_set_filter_func(net->net, NULL, NULL);
+		// Accept all CAN frames.
+		result = old_func(net->chan, NULL, 0);
+	}
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+	return result;
+}
+
+void
+io_can_net_get_txclass_func(const io_can_net_t *net,
+		io_can_net_txclass_func_t **pfunc, void **parg)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	if (pfunc)
+		*pfunc = net->txclass_func;
+	if (parg)
+		*parg = net->txclass_arg;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+}
+
+void
+io_can_net_set_txclass_func(io_can_net_t *net,
+		io_can_net_txclass_func_t *func, void *arg)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	net->txclass_func = func;
+	net->txclass_arg = func ? arg : NULL;
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+}
+
+int
+io_can_net_get_txprio(const io_can_net_t *net)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	int txprio = net->txprio;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+	return txprio;
+}
+
+void
+io_can_net_set_txprio(io_can_net_t *net, int txprio)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	net->txprio = !!txprio;
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+}
+
+size_t
+io_can_net_get_txdepth(const io_can_net_t *net, int txclass)
+{
+	assert(net);
+
+	if (txclass < 0 || txclass >= IO_CAN_NET_NTXCLASS)
+		return 0;
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	size_t depth = net->tx_depth[txclass];
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+	return depth;
+}
+
+int
+io_can_net_set_txdepth(io_can_net_t *net, int txclass, size_t depth)
+{
+	assert(net);
+
+	if (txclass < 0 || txclass >= IO_CAN_NET_NTXCLASS) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	net->tx_depth[txclass] = depth;
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+	return 0;
+}
+
+size_t
+io_can_net_get_txdropped(const io_can_net_t *net, int txclass)
+{
+	assert(net);
+
+	if (txclass < 0 || txclass >= IO_CAN_NET_NTXCLASS)
+		return 0;
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	size_t ndropped = net->tx_dropped[txclass];
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+	return ndropped;
+}
+
+void
+io_can_net_get_stats(const io_can_net_t *net, struct io_can_net_stats *stats)
+{
+	assert(net);
+	assert(stats);
+
+#if !LELY_NO_THREADS && LELY_NO_ATOMICS
+	mtx_lock((mtx_t *)&net->mtx);
+#endif
+	stats->rx_frames = io_can_net_stat_get(net, IO_CAN_NET_STAT_RX_FRAMES);
+	stats->rx_bytes = io_can_net_stat_get(net, IO_CAN_NET_STAT_RX_BYTES);
+	stats->rx_bits = io_can_net_stat_get(net, IO_CAN_NET_STAT_RX_BITS);
+	stats->tx_frames = io_can_net_stat_get(net, IO_CAN_NET_STAT_TX_FRAMES);
+	stats->tx_bytes = io_can_net_stat_get(net, IO_CAN_NET_STAT_TX_BYTES);
+	stats->tx_bits = io_can_net_stat_get(net, IO_CAN_NET_STAT_TX_BITS);
+	stats->tx_hwm = io_can_net_stat_get(net, IO_CAN_NET_STAT_TX_HWM);
+	for (int i = 0; i < IO_CAN_NET_STATS_NBIN; i++) {
+		stats->tx_latency[i] = io_can_net_stat_get(
+				net, IO_CAN_NET_STAT_TX_LATENCY + i);
+		stats->rx_latency[i] = io_can_net_stat_get(
+				net, IO_CAN_NET_STAT_RX_LATENCY + i);
+	}
+#if !LELY_NO_THREADS && LELY_NO_ATOMICS
+	mtx_unlock((mtx_t *)&net->mtx);
+#endif
+}
+
+void
+io_can_net_reset_stats(io_can_net_t *net)
+{
+	assert(net);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&net->mtx);
+#endif
+	for (int i = 0; i < IO_CAN_NET_NSTAT; i++)
+		io_can_net_stat_set(net, i, 0);
+	io_can_net_stat_set(net, IO_CAN_NET_STAT_TX_HWM, net->tx_n);
+#if !LELY_NO_THREADS
+	mtx_unlock(&net->mtx);
+#endif
+}
+
+uint_least64_t
+io_can_net_stats_bin_min(int bin)
+{
+	if (bin < 0 || bin >= IO_CAN_NET_STATS_NBIN)
+		return 0;
+	if (bin < 4)
+		return bin;
+	// The bin contains 1/4th of the range [2^e, 2^(e + 1)).
+	int e = bin / 4 + 1;
+	return (uint_least64_t)(4 + bin % 4) << (e - 2);
+}
+
 int
 io_can_net_lock(io_can_net_t *net)
 {
@@ -699,14 +1105,10 @@ io_can_net_svc_shutdown(struct io_svc *svc)
 #if !LELY_NO_THREADS
 	mtx_lock(&net->mtx);
 #endif
-	int shutdown = !net->shutdown;
 	net->shutdown = 1;
 #if !LELY_NO_THREADS
 	mtx_unlock(&net->mtx);
 #endif
-
-	if (shutdown)
-		spscring_c_abort_wait(&net->tx_ring);
 }
 
 static void
@@ -797,10 +1199,19 @@ io_can_net_read_func(struct ev_task *task)
 	}
 
 	if (read->r.result == 1) {
+		io_can_net_stat_msg(net, IO_CAN_NET_STAT_RX_FRAMES,
+				&net->read_msg);
 		// Update the internal clock before processing the incoming CAN
 		// frame.
-		io_can_net_set_time(net);
+		io_clock_t *clock = io_can_net_get_clock(net);
+		struct timespec t1 = { 0, 0 };
+		io_clock_gettime(clock, &t1);
+		can_net_set_time(net->net, &t1);
 		can_net_recv(net->net, &net->read_msg);
+		struct timespec t2 = { 0, 0 };
+		io_clock_gettime(clock, &t2);
+		io_can_net_stat_latency(
+				net, IO_CAN_NET_STAT_RX_LATENCY, &t1, &t2);
 	} else if (read->r.result == 0) {
 		if (net->read_err.state != net->state) {
 			int new_state = net->read_err.state;
@@ -863,17 +1274,28 @@ io_can_net_write_func(struct ev_task *task)
 		net->write_errcnt = 0;
 	}
 
-	// Remove the frame from the transmit queue, unless the write operation
-	// was canceled, in which we discard the entire queue.
-	assert(spscring_c_capacity(&net->tx_ring) >= 1);
-	size_t n = 1;
+	if (!write->errc) {
+		io_can_net_stat_msg(net, IO_CAN_NET_STAT_TX_FRAMES,
+				&net->write_msg);
+		struct timespec now = { 0, 0 };
+		io_clock_gettime(io_can_net_get_clock(net), &now);
+		io_can_net_stat_latency(net, IO_CAN_NET_STAT_TX_LATENCY,
+				&net->write_time, &now);
+		if (net->on_write_func)
+			net->on_write_func(&net->write_msg, &now,
+					net->on_write_arg);
+	}
+
+	// If the write operation was canceled, discard the entire transmit
+	// queue.
 	if (errc2num(write->errc) == ERRNUM_CANCELED) {
-		n = spscring_c_capacity(&net->tx_ring);
-		// Track the number of dropped frames. The first frame has
-		// already been accounted for.
-		net->write_errcnt += n - 1;
+		// Track the number of dropped frames. The frame being written
+		// has already been accounted for.
+		net->write_errcnt += net->tx_n;
+		net->tx_n = 0;
+		for (int i = 0; i < IO_CAN_NET_NTXCLASS; i++)
+			net->tx_nclass[i] = 0;
 	}
-	spscring_c_commit(&net->tx_ring, n);
 
 	// Stop the timeout after receiving a write confirmation (or write
 	// error).
@@ -883,8 +1305,7 @@ io_can_net_write_func(struct ev_task *task)
 
 	// Write the next frame, if available.
 	net->write_submitted = 0;
-	if (!net->shutdown && !io_can_net_do_wait(net))
-		io_can_net_do_write(net);
+	io_can_net_do_next(net);
 
 #if !LELY_NO_THREADS
 	mtx_unlock(&net->mtx);
@@ -929,11 +1350,8 @@ io_can_net_send_func(const struct can_msg *msg, void *data)
 	io_can_net_t *net = data;
 	assert(net);
 
-	size_t n = 1;
-	size_t i = spscring_p_alloc(&net->tx_ring, &n);
-	if (n) {
-		net->tx_buf[i] = *msg;
-		spscring_p_commit(&net->tx_ring, n);
+	if (!io_can_net_tx_push(net, msg)) {
+		io_can_net_do_next(net);
 		if (net->tx_errcnt) {
 			assert(net->on_queue_error_func);
 			net->on_queue_error_func(0, net->tx_errcnt,
@@ -955,16 +1373,15 @@ io_can_net_send_func(const struct can_msg *msg, void *data)
 	}
 }
 
-static void
-io_can_net_c_wait_func(struct spscring *ring, void *arg)
+static int
+io_can_net_filter_func(
+		const struct can_net_filter *filters, size_t n, void *data)
 {
-	(void)ring;
-	io_can_net_t *net = arg;
+	io_can_net_t *net = data;
 	assert(net);
+	assert(net->filter_func);
 
-	// A frame was just added to the transmit queue; try to send it.
-	if (!io_can_net_do_wait(net))
-		io_can_net_do_write(net);
+	return net->filter_func(net->chan, filters, n);
 }
 
 static inline io_can_net_t *
@@ -976,31 +1393,130 @@ io_can_net_from_svc(const struct io_svc *svc)
 }
 
 static int
-io_can_net_do_wait(io_can_net_t *net)
+io_can_net_tx_push(io_can_net_t *net, const struct can_msg *msg)
 {
 	assert(net);
+	assert(msg);
 
-	// Wait for next frame to become available.
-	// clang-format off
-	if (spscring_c_submit_wait(
-			&net->tx_ring, 1, &io_can_net_c_wait_func, net))
-		// clang-format on
-		return 1;
+	int txclass = 0;
+	if (net->txclass_func) {
+		txclass = net->txclass_func(msg, net->txclass_arg);
+		if (txclass < 0)
+			txclass = 0;
+		else if (txclass >= IO_CAN_NET_NTXCLASS)
+			txclass = IO_CAN_NET_NTXCLASS - 1;
+	}
 
-	// Extract the frame from the transmit queue.
-	size_t n = 1;
-	size_t i = spscring_c_alloc(&net->tx_ring, &n);
-	assert(n == 1);
-	net->write_msg = net->tx_buf[i];
+	size_t depth = net->tx_depth[txclass];
+	if (net->tx_n >= net->txlen
+			|| (depth && net->tx_nclass[txclass] >= depth)) {
+		net->tx_dropped[txclass] += net->tx_dropped[txclass] < SIZE_MAX;
+		return -1;
+	}
+
+	struct io_can_net_txent ent = { .msg = *msg,
+		.prio = (uint_least64_t)txclass << 32,
+		.seq = net->tx_seq++ };
+	if (net->txprio)
+		ent.prio |= can_msg_arb_key(msg);
+	io_clock_gettime(io_can_net_get_clock(net), &ent.time);
+	net->tx_nclass[txclass]++;
+
+	// Sift up.
+	struct io_can_net_txent *heap = net->tx_heap;
+	size_t i = net->tx_n++;
+	while (i) {
+		size_t parent = (i - 1) / 2;
+		if (!io_can_net_txent_before(&ent, &heap[parent]))
+			break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = ent;
+
+	if (net->tx_n > io_can_net_stat_get(net, IO_CAN_NET_STAT_TX_HWM))
+		io_can_net_stat_set(net, IO_CAN_NET_STAT_TX_HWM, net->tx_n);
 
 	return 0;
 }
 
+static int
+io_can_net_tx_pop(io_can_net_t *net)
+{
+	assert(net);
+
+	if (!net->tx_n)
+		return 0;
+
+	struct io_can_net_txent *heap = net->tx_heap;
+	net->write_msg = heap[0].msg;
+	net->write_time = heap[0].time;
+	net->tx_nclass[heap[0].prio >> 32]--;
+
+	// Sift down the last entry.
+	size_t n = --net->tx_n;
+	const struct io_can_net_txent *last = &heap[n];
+	size_t i = 0;
+	for (size_t child; (child = 2 * i + 1) < n; i = child) {
+		if (child + 1 < n
+				&& io_can_net_txent_before(
+						&heap[child + 1], &heap[child]))
+			child++;
+		if (!io_can_net_txent_before(&heap[child], last))
+			break;
+		heap[i] = heap[child];
+	}
+	if (i < n)
+		heap[i] = heap[n];
+
+	return 1;
+}
+
+static inline int
+io_can_net_txent_before(const struct io_can_net_txent *a,
+		const struct io_can_net_txent *b)
+{
+	assert(a);
+	assert(b);
+
+	return a->prio < b->prio || (a->prio == b->prio && a->seq < b->seq);
+}
+
+static inline uint_least32_t
+can_msg_arb_key(const struct can_msg *msg)
+{
+	assert(msg);
+
+	// The identifier bits in the order in which they are transmitted: the
+	// 11-bit base identifier, the RTR (or SRR) bit, the IDE bit, the 18-bit
+	// identifier extension and, for extended frames, the RTR bit. Since the
+	// SRR bit is recessive, base frames win arbitration against extended
+	// frames with the same base identifier.
+	uint_least32_t rtr = !!(msg->flags & CAN_FLAG_RTR);
+	if (msg->flags & CAN_FLAG_IDE) {
+		uint_least32_t id = msg->id & CAN_MASK_EID;
+		return ((id >> 18) << 21) | (UINT32_C(3) << 19)
+				| ((id & 0x3ffff) << 1) | rtr;
+	} else {
+		uint_least32_t id = msg->id & CAN_MASK_BID;
+		return (id << 21) | (rtr << 20);
+	}
+}
+
+static void
+io_can_net_do_next(io_can_net_t *net)
+{
+	assert(net);
+
+	if (net->started && !net->shutdown && !net->write_submitted
+			&& io_can_net_tx_pop(net))
+		io_can_net_do_write(net);
+}
+
 static void
 io_can_net_do_write(io_can_net_t *net)
 {
 	assert(net);
-	assert(spscring_c_capacity(&net->tx_ring) >= 1);
 	assert(!net->write_submitted);
 
 	// Send the frame.
@@ -1020,6 +1536,81 @@ io_can_net_do_write(io_can_net_t *net)
 	}
 }
 
+static inline uint_least64_t
+io_can_net_stat_get(const io_can_net_t *net, int i)
+{
+	assert(net);
+	assert(i >= 0 && i < IO_CAN_NET_NSTAT);
+
+#if !LELY_NO_THREADS && !LELY_NO_ATOMICS
+	return atomic_load_explicit((io_can_net_stat_t *)&net->stats[i],
+			memory_order_relaxed);
+#else
+	return net->stats[i];
+#endif
+}
+
+static inline void
+io_can_net_stat_set(io_can_net_t *net, int i, uint_least64_t value)
+{
+	assert(net);
+	assert(i >= 0 && i < IO_CAN_NET_NSTAT);
+
+#if !LELY_NO_THREADS && !LELY_NO_ATOMICS
+	atomic_store_explicit(&net->stats[i], value, memory_order_relaxed);
+#else
+	net->stats[i] = value;
+#endif
+}
+
+static inline void
+io_can_net_stat_add(io_can_net_t *net, int i, uint_least64_t n)
+{
+	// The counters are only modified with the mutex locked, so there is no
+	// need for an atomic read-modify-write operation.
+	io_can_net_stat_set(net, i, io_can_net_stat_get(net, i) + n);
+}
+
+static void
+io_can_net_stat_msg(io_can_net_t *net, int i, const struct can_msg *msg)
+{
+	assert(msg);
+
+	io_can_net_stat_add(net, i, 1);
+	io_can_net_stat_add(net, i + 1, msg->len);
+#if !LELY_NO_CANFD
+	// The size of CAN FD format frames depends on the data bitrate.
+	if (msg->flags & CAN_FLAG_EDL)
+		return;
+#endif
+	int bits = can_msg_bits(msg, CAN_MSG_BITS_MODE_NO_STUFF);
+	if (bits > 0)
+		io_can_net_stat_add(net, i + 2, bits);
+}
+
+static void
+io_can_net_stat_latency(io_can_net_t *net, int i, const struct timespec *t1,
+		const struct timespec *t2)
+{
+	int_least64_t usec = timespec_diff_usec(t2, t1);
+	int bin = io_can_net_stats_bin(usec > 0 ? usec : 0);
+	io_can_net_stat_add(net, i + bin, 1);
+}
+
+static int
+io_can_net_stats_bin(uint_least64_t usec)
+{
+	if (usec < 4)
+		return usec;
+	// Find the most significant bit, e, and use the next two bits to
+	// select one of the four bins for [2^e, 2^(e + 1)).
+	int e = 2;
+	while (e < 63 && usec >> (e + 1))
+		e++;
+	int bin = 4 * (e - 1) + ((usec >> (e - 2)) & 3);
+	return MIN(bin, IO_CAN_NET_STATS_NBIN - 1);
+}
+
 #if !LELY_NO_THREADS
 static size_t
 io_can_net_do_abort_tasks(io_can_net_t *net)
@@ -38,6 +38,30 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#ifndef LELY_IO_CAN_RT_HASH_BITS
+/**
+ * The binary logarithm of the number of buckets in the hash table used to look
+ * up read operations for CAN frames with a 29-bit identifier.
+ */
+#define LELY_IO_CAN_RT_HASH_BITS 8
+#endif
+
+#ifndef LELY_IO_CAN_RT_BURST
+/**
+ * The maximum number of CAN frames processed by the CAN frame router before it
+ * yields to the executor.
+ */
+#define LELY_IO_CAN_RT_BURST 64
+#endif
+
+/**
+ * The number of buckets in the lookup table for read operations. The first
+ * (#CAN_MASK_BID + 1) buckets are indexed directly by the 11-bit identifier of
+ * a CAN frame, the remaining buckets by the hash of the 29-bit identifier.
+ */
+#define IO_CAN_RT_NBUCKET \
+	(CAN_MASK_BID + 1 + ((size_t)1 << LELY_IO_CAN_RT_HASH_BITS))
+
 static io_ctx_t *io_can_rt_dev_get_ctx(const io_dev_t *dev);
 static ev_exec_t *io_can_rt_dev_get_exec(const io_dev_t *dev);
 static size_t io_can_rt_dev_cancel(io_dev_t *dev, struct ev_task *task);
@@ -76,7 +100,15 @@ struct io_can_rt {
 #endif
 	unsigned shutdown : 1;
 	unsigned submitted : 1;
-	struct rbtree msg_queue;
+	/**
+	 * The lookup table for CAN frame read operations. Each bucket contains
+	 * at most one read operation for each combination of identifier and
+	 * flags; subsequent operations are stored in its <b>_queue</b>.
+	 */
+	struct dllist *msg_tab;
+	/// The number of read operations in #msg_tab.
+	size_t nmsg;
+	struct sllist filter_queue;
 	struct sllist err_queue;
 };
 
@@ -86,10 +118,23 @@ static void io_can_rt_task_func(struct ev_task *task);
 static inline io_can_rt_t *io_can_rt_from_dev(const io_dev_t *dev);
 static inline io_can_rt_t *io_can_rt_from_svc(const struct io_svc *svc);
 
+static inline size_t io_can_rt_hash(uint_least32_t id, uint_least8_t flags);
+static struct io_can_rt_read_msg *io_can_rt_find_read_msg(
+		const io_can_rt_t *rt, uint_least32_t id, uint_least8_t flags);
+static inline int io_can_rt_empty(const io_can_rt_t *rt);
+
+static int io_can_rt_do_read_msg(io_can_rt_t *rt, struct sllist *msg_queue,
+		struct sllist *filter_queue, const struct can_msg *msg);
+static int io_can_rt_do_read_err(io_can_rt_t *rt, struct sllist *queue);
+
 static void io_can_rt_do_pop(io_can_rt_t *rt, struct sllist *msg_queue,
-		struct sllist *err_queue, struct ev_task *task);
+		struct sllist *filter_queue, struct sllist *err_queue,
+		struct ev_task *task);
 static void io_can_rt_do_pop_read_msg(io_can_rt_t *rt, struct sllist *queue,
 		struct io_can_rt_read_msg *read_msg);
+static void io_can_rt_do_pop_read_filter(io_can_rt_t *rt,
+		struct sllist *queue,
+		struct io_can_rt_read_filter *read_filter);
 static void io_can_rt_do_pop_read_err(io_can_rt_t *rt, struct sllist *queue,
 		struct io_can_rt_read_err *read_err);
 
@@ -98,13 +143,17 @@ static void io_can_rt_read_msg_post(struct io_can_rt_read_msg *read_msg,
 static size_t io_can_rt_read_msg_queue_post(
 		struct sllist *queue, const struct can_msg *msg, int errc);
 
+static void io_can_rt_read_filter_post(
+		struct io_can_rt_read_filter *read_filter,
+		const struct can_msg *msg, int errc);
+static size_t io_can_rt_read_filter_queue_post(
+		struct sllist *queue, const struct can_msg *msg, int errc);
+
 static void io_can_rt_read_err_post(struct io_can_rt_read_err *read_err,
 		const struct can_err *err, int errc);
 static size_t io_can_rt_read_err_queue_post(
 		struct sllist *queue, const struct can_err *err, int errc);
 
-static int io_can_rt_read_msg_cmp(const void *p1, const void *p2);
-
 struct io_can_rt_async_read_msg {
 	ev_promise_t *promise;
 	struct io_can_rt_read_msg read_msg;
@@ -113,6 +162,14 @@ struct io_can_rt_async_read_msg {
 
 static void io_can_rt_async_read_msg_func(struct ev_task *task);
 
+struct io_can_rt_async_read_filter {
+	ev_promise_t *promise;
+	struct io_can_rt_read_filter read_filter;
+	struct can_msg msg;
+};
+
+static void io_can_rt_async_read_filter_func(struct ev_task *task);
+
 struct io_can_rt_async_read_err {
 	ev_promise_t *promise;
 	struct io_can_rt_read_err read_err;
@@ -173,6 +230,17 @@ io_can_rt_init(io_can_rt_t *rt, io_can_chan_t *chan, ev_exec_t *exec)
 		goto error_create_strand;
 	}
 
+	rt->msg_tab = malloc(IO_CAN_RT_NBUCKET * sizeof(struct dllist));
+	if (!rt->msg_tab) {
+#if !LELY_NO_ERRNO
+		errc = errno2c(errno);
+#endif
+		goto error_alloc_msg_tab;
+	}
+	for (size_t i = 0; i < IO_CAN_RT_NBUCKET; i++)
+		dllist_init(&rt->msg_tab[i]);
+	rt->nmsg = 0;
+
 	rt->msg = (struct can_msg)CAN_MSG_INIT;
 	rt->err = (struct can_err)CAN_ERR_INIT;
 	rt->read = (struct io_can_chan_read)IO_CAN_CHAN_READ_INIT(&rt->msg,
@@ -190,7 +258,7 @@ io_can_rt_init(io_can_rt_t *rt, io_can_chan_t *chan, ev_exec_t *exec)
 	rt->shutdown = 0;
 	rt->submitted = 0;
 
-	rbtree_init(&rt->msg_queue, &io_can_rt_read_msg_cmp);
+	sllist_init(&rt->filter_queue);
 	sllist_init(&rt->err_queue);
 
 	io_ctx_insert(rt->ctx, &rt->svc);
@@ -201,6 +269,8 @@ io_can_rt_init(io_can_rt_t *rt, io_can_chan_t *chan, ev_exec_t *exec)
 	// mtx_destroy(&rt->mtx);
 error_init_mtx:
 #endif
+	free(rt->msg_tab);
+error_alloc_msg_tab:
 	ev_strand_destroy(rt->exec);
 error_create_strand:
 	set_errc(errc);
@@ -218,6 +288,8 @@ io_can_rt_fini(io_can_rt_t *rt)
 	mtx_destroy(&rt->mtx);
 #endif
 
+	free(rt->msg_tab);
+
 	ev_strand_destroy(rt->exec);
 }
 
@@ -293,16 +365,18 @@ io_can_rt_submit_read_msg(io_can_rt_t *rt, struct io_can_rt_read_msg *read_msg)
 		io_can_rt_read_msg_post(
 				read_msg, NULL, errnum2c(ERRNUM_CANCELED));
 	} else {
-		task->_data = &rt->msg_queue;
-		struct rbnode *node = rbtree_find(&rt->msg_queue, read_msg);
-		if (node) {
-			read_msg = structof(
-					node, struct io_can_rt_read_msg, _node);
-			sllist_push_back(&read_msg->_queue, &task->_node);
+		task->_data = &rt->msg_tab;
+		struct io_can_rt_read_msg *head = io_can_rt_find_read_msg(
+				rt, read_msg->id, read_msg->flags);
+		if (head) {
+			sllist_push_back(&head->_queue, &task->_node);
 		} else {
-			rbnode_init(&read_msg->_node, read_msg);
 			sllist_init(&read_msg->_queue);
-			rbtree_insert(&rt->msg_queue, &read_msg->_node);
+			dllist_push_back(&rt->msg_tab[io_can_rt_hash(
+							read_msg->id,
+							read_msg->flags)],
+					&read_msg->_node);
+			rt->nmsg++;
 		}
 		int submit = !rt->submitted;
 		if (submit)
@@ -329,7 +403,7 @@ io_can_rt_cancel_read_msg(io_can_rt_t *rt, struct io_can_rt_read_msg *read_msg)
 #if !LELY_NO_THREADS
 	mtx_lock(&rt->mtx);
 #endif
-	if (task->_data == &rt->msg_queue)
+	if (task->_data == &rt->msg_tab)
 		io_can_rt_do_pop_read_msg(rt, &queue, read_msg);
 #if !LELY_NO_THREADS
 	mtx_unlock(&rt->mtx);
@@ -352,7 +426,7 @@ io_can_rt_abort_read_msg(io_can_rt_t *rt, struct io_can_rt_read_msg *read_msg)
 #if !LELY_NO_THREADS
 	mtx_lock(&rt->mtx);
 #endif
-	if (task->_data == &rt->msg_queue)
+	if (task->_data == &rt->msg_tab)
 		io_can_rt_do_pop_read_msg(rt, &queue, read_msg);
 #if !LELY_NO_THREADS
 	mtx_unlock(&rt->mtx);
@@ -387,6 +461,117 @@ io_can_rt_async_read_msg(io_can_rt_t *rt, uint_least32_t id,
 	return future;
 }
 
+void
+io_can_rt_submit_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter)
+{
+	assert(rt);
+	assert(read_filter);
+	struct ev_task *task = &read_filter->task;
+
+	task->exec = rt->exec;
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&rt->mtx);
+#endif
+	if (rt->shutdown) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&rt->mtx);
+#endif
+		io_can_rt_read_filter_post(
+				read_filter, NULL, errnum2c(ERRNUM_CANCELED));
+	} else {
+		task->_data = &rt->filter_queue;
+		sllist_push_back(&rt->filter_queue, &task->_node);
+		int submit = !rt->submitted;
+		if (submit)
+			rt->submitted = 1;
+#if !LELY_NO_THREADS
+		mtx_unlock(&rt->mtx);
+#endif
+		// cppcheck-suppress duplicateCondition
+		if (submit)
+			io_can_chan_submit_read(rt->chan, &rt->read);
+	}
+}
+
+size_t
+io_can_rt_cancel_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter)
+{
+	assert(rt);
+	assert(read_filter);
+	struct ev_task *task = &read_filter->task;
+
+	struct sllist queue;
+	sllist_init(&queue);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&rt->mtx);
+#endif
+	if (task->_data == &rt->filter_queue)
+		io_can_rt_do_pop_read_filter(rt, &queue, read_filter);
+#if !LELY_NO_THREADS
+	mtx_unlock(&rt->mtx);
+#endif
+
+	return io_can_rt_read_filter_queue_post(
+			&queue, NULL, errnum2c(ERRNUM_CANCELED));
+}
+
+size_t
+io_can_rt_abort_read_filter(
+		io_can_rt_t *rt, struct io_can_rt_read_filter *read_filter)
+{
+	assert(rt);
+	assert(read_filter);
+	struct ev_task *task = &read_filter->task;
+
+	struct sllist queue;
+	sllist_init(&queue);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&rt->mtx);
+#endif
+	if (task->_data == &rt->filter_queue)
+		io_can_rt_do_pop_read_filter(rt, &queue, read_filter);
+#if !LELY_NO_THREADS
+	mtx_unlock(&rt->mtx);
+#endif
+
+	return ev_task_queue_abort(&queue);
+}
+
+ev_future_t *
+io_can_rt_async_read_filter(io_can_rt_t *rt, uint_least32_t first,
+		uint_least32_t last, uint_least32_t mask, uint_least8_t flags,
+		struct io_can_rt_read_filter **pread_filter)
+{
+	ev_promise_t *promise = ev_promise_create(
+			sizeof(struct io_can_rt_async_read_filter), NULL);
+	if (!promise)
+		return NULL;
+	ev_future_t *future = ev_promise_get_future(promise);
+
+	struct io_can_rt_async_read_filter *async_read_filter =
+			ev_promise_data(promise);
+	async_read_filter->promise = promise;
+	// clang-format off
+	async_read_filter->read_filter = (struct io_can_rt_read_filter)
+			IO_CAN_RT_READ_FILTER_INIT(first, last, mask, flags,
+					&io_can_rt_async_read_filter_func);
+	// clang-format on
+	async_read_filter->msg = (struct can_msg)CAN_MSG_INIT;
+
+	io_can_rt_submit_read_filter(rt, &async_read_filter->read_filter);
+
+	if (pread_filter)
+		*pread_filter = &async_read_filter->read_filter;
+
+	return future;
+}
+
 void
 io_can_rt_submit_read_err(io_can_rt_t *rt, struct io_can_rt_read_err *read_err)
 {
@@ -518,6 +703,12 @@ io_can_rt_read_msg_from_task(struct ev_task *task)
 	return task ? structof(task, struct io_can_rt_read_msg, task) : NULL;
 }
 
+struct io_can_rt_read_filter *
+io_can_rt_read_filter_from_task(struct ev_task *task)
+{
+	return task ? structof(task, struct io_can_rt_read_filter, task) : NULL;
+}
+
 struct io_can_rt_read_err *
 io_can_rt_read_err_from_task(struct ev_task *task)
 {
@@ -545,19 +736,23 @@ io_can_rt_dev_cancel(io_dev_t *dev, struct ev_task *task)
 {
 	io_can_rt_t *rt = io_can_rt_from_dev(dev);
 
-	struct sllist msg_queue, err_queue;
+	struct sllist msg_queue, filter_queue, err_queue;
 	sllist_init(&msg_queue);
+	sllist_init(&filter_queue);
 	sllist_init(&err_queue);
 
 #if !LELY_NO_THREADS
 	mtx_lock(&rt->mtx);
 #endif
-	io_can_rt_do_pop(rt, &msg_queue, &err_queue, task);
+	io_can_rt_do_pop(rt, &msg_queue, &filter_queue, &err_queue, task);
 #if !LELY_NO_THREADS
 	mtx_unlock(&rt->mtx);
 #endif
 	size_t nmsg = io_can_rt_read_msg_queue_post(
 			&msg_queue, NULL, errnum2c(ERRNUM_CANCELED));
+	size_t nfilter = io_can_rt_read_filter_queue_post(
+			&filter_queue, NULL, errnum2c(ERRNUM_CANCELED));
+	nmsg = nfilter < SIZE_MAX - nmsg ? nmsg + nfilter : SIZE_MAX;
 	size_t nerr = io_can_rt_read_err_queue_post(
 			&err_queue, NULL, errnum2c(ERRNUM_CANCELED));
 	return nerr < SIZE_MAX - nmsg ? nmsg + nerr : SIZE_MAX;
@@ -574,7 +769,7 @@ io_can_rt_dev_abort(io_dev_t *dev, struct ev_task *task)
 #if !LELY_NO_THREADS
 	mtx_lock(&rt->mtx);
 #endif
-	io_can_rt_do_pop(rt, &queue, &queue, task);
+	io_can_rt_do_pop(rt, &queue, &queue, &queue, task);
 #if !LELY_NO_THREADS
 	mtx_unlock(&rt->mtx);
 #endif
@@ -612,51 +807,61 @@ io_can_rt_read_func(struct ev_task *task)
 	struct io_can_chan_read *read = io_can_chan_read_from_task(task);
 	io_can_rt_t *rt = structof(read, io_can_rt_t, read);
 
-	if (rt->read.r.result > 0) {
-		struct sllist queue;
-		sllist_init(&queue);
-		struct io_can_rt_read_msg key;
-		key.id = rt->read.msg->id;
-		key.flags = rt->read.msg->flags;
+	struct sllist msg_queue, filter_queue, err_queue;
+	sllist_init(&msg_queue);
+	sllist_init(&filter_queue);
+	sllist_init(&err_queue);
+
+	if (rt->read.r.result >= 0) {
+		int errsv = get_errc();
 #if !LELY_NO_THREADS
 		mtx_lock(&rt->mtx);
 #endif
-		struct rbnode *node = rbtree_find(&rt->msg_queue, &key);
-		if (node) {
-			rbtree_remove(&rt->msg_queue, node);
-			struct io_can_rt_read_msg *read_msg = structof(
-					node, struct io_can_rt_read_msg, _node);
-			sllist_push_back(&queue, &read_msg->task._node);
-			sllist_append(&queue, &read_msg->_queue);
+		// Process the CAN frames buffered by the channel until one of
+		// them completes a read operation. We cannot continue after
+		// that, since the completion tasks may submit new read
+		// operations for the next frame. Frames without a matching read
+		// operation are discarded without a round trip through the
+		// executor. A vectored read is not used, since it would discard
+		// error frames and read ahead of the frame that completes an
+		// operation.
+		int result = rt->read.r.result;
+		for (int n = 1;; n++) {
+			if (result > 0 ? io_can_rt_do_read_msg(rt, &msg_queue,
+						    &filter_queue,
+						    rt->read.msg)
+				       : io_can_rt_do_read_err(
+						       rt, &err_queue))
+				break;
+			if (n >= LELY_IO_CAN_RT_BURST || rt->shutdown
+					|| io_can_rt_empty(rt))
+				break;
+			result = io_can_chan_read(rt->chan, rt->read.msg,
+					rt->read.err, NULL, 0);
+			if (result < 0)
+				break;
 		}
 #if !LELY_NO_THREADS
 		mtx_unlock(&rt->mtx);
 #endif
-		io_can_rt_read_msg_queue_post(&queue, rt->read.msg, 0);
-	} else if (!rt->read.r.result) {
-		struct sllist queue;
-		sllist_init(&queue);
-#if !LELY_NO_THREADS
-		mtx_lock(&rt->mtx);
-#endif
-		sllist_append(&queue, &rt->err_queue);
-#if !LELY_NO_THREADS
-		mtx_unlock(&rt->mtx);
-#endif
-		io_can_rt_read_err_queue_post(&queue, rt->read.err, 0);
+		set_errc(errsv);
+		io_can_rt_read_msg_queue_post(&msg_queue, rt->read.msg, 0);
+		io_can_rt_read_filter_queue_post(
+				&filter_queue, rt->read.msg, 0);
+		io_can_rt_read_err_queue_post(&err_queue, rt->read.err, 0);
 	} else if (rt->read.r.errc) {
-		struct sllist msg_queue, err_queue;
-		sllist_init(&msg_queue);
-		sllist_init(&err_queue);
 #if !LELY_NO_THREADS
 		mtx_lock(&rt->mtx);
 #endif
-		io_can_rt_do_pop(rt, &msg_queue, &err_queue, NULL);
+		io_can_rt_do_pop(rt, &msg_queue, &filter_queue, &err_queue,
+				NULL);
 #if !LELY_NO_THREADS
 		mtx_unlock(&rt->mtx);
 #endif
 		io_can_rt_read_msg_queue_post(
 				&msg_queue, NULL, rt->read.r.errc);
+		io_can_rt_read_filter_queue_post(
+				&filter_queue, NULL, rt->read.r.errc);
 		io_can_rt_read_err_queue_post(
 				&err_queue, NULL, rt->read.r.errc);
 	}
@@ -674,10 +879,7 @@ io_can_rt_task_func(struct ev_task *task)
 	mtx_lock(&rt->mtx);
 #endif
 	assert(rt->submitted);
-	int submit = rt->submitted =
-			(!rbtree_empty(&rt->msg_queue)
-					|| !sllist_empty(&rt->err_queue))
-			&& !rt->shutdown;
+	int submit = rt->submitted = !io_can_rt_empty(rt) && !rt->shutdown;
 #if !LELY_NO_THREADS
 	mtx_unlock(&rt->mtx);
 #endif
@@ -702,28 +904,136 @@ io_can_rt_from_svc(const struct io_svc *svc)
 	return structof(svc, io_can_rt_t, svc);
 }
 
+static inline size_t
+io_can_rt_hash(uint_least32_t id, uint_least8_t flags)
+{
+	// Read operations for 11-bit identifiers are stored in a direct table.
+	if (!(flags & CAN_FLAG_IDE))
+		return id & CAN_MASK_BID;
+	// Use Fibonacci hashing for 29-bit identifiers.
+	uint_least32_t h = (id * UINT32_C(0x9e3779b9)) & UINT32_C(0xffffffff);
+	return CAN_MASK_BID + 1 + (h >> (32 - LELY_IO_CAN_RT_HASH_BITS));
+}
+
+static struct io_can_rt_read_msg *
+io_can_rt_find_read_msg(
+		const io_can_rt_t *rt, uint_least32_t id, uint_least8_t flags)
+{
+	assert(rt);
+
+	if (!rt->nmsg)
+		return NULL;
+
+	dllist_foreach (&rt->msg_tab[io_can_rt_hash(id, flags)], node) {
+		struct io_can_rt_read_msg *read_msg = structof(
+				node, struct io_can_rt_read_msg, _node);
+		if (read_msg->id == id && read_msg->flags == flags)
+			return read_msg;
+	}
+	return NULL;
+}
+
+static inline int
+io_can_rt_empty(const io_can_rt_t *rt)
+{
+	assert(rt);
+
+	return !rt->nmsg && sllist_empty(&rt->filter_queue)
+			&& sllist_empty(&rt->err_queue);
+}
+
+static int
+io_can_rt_do_read_msg(io_can_rt_t *rt, struct sllist *msg_queue,
+		struct sllist *filter_queue, const struct can_msg *msg)
+{
+	assert(rt);
+	assert(msg_queue);
+	assert(filter_queue);
+	assert(msg);
+
+	int found = 0;
+
+	struct io_can_rt_read_msg *read_msg =
+			io_can_rt_find_read_msg(rt, msg->id, msg->flags);
+	if (read_msg) {
+		dllist_remove(&rt->msg_tab[io_can_rt_hash(msg->id, msg->flags)],
+				&read_msg->_node);
+		rt->nmsg--;
+		sllist_push_back(msg_queue, &read_msg->task._node);
+		sllist_append(msg_queue, &read_msg->_queue);
+		found = 1;
+	}
+
+	if (!sllist_empty(&rt->filter_queue)) {
+		struct sllist queue;
+		sllist_init(&queue);
+		sllist_append(&queue, &rt->filter_queue);
+		struct slnode *node;
+		while ((node = sllist_pop_front(&queue))) {
+			struct io_can_rt_read_filter *read_filter =
+					io_can_rt_read_filter_from_task(
+							ev_task_from_node(
+									node));
+			uint_least32_t id = msg->id & read_filter->mask;
+			if (msg->flags == read_filter->flags
+					&& id >= read_filter->first
+					&& id <= read_filter->last) {
+				sllist_push_back(filter_queue, node);
+				found = 1;
+			} else {
+				sllist_push_back(&rt->filter_queue, node);
+			}
+		}
+	}
+
+	return found;
+}
+
+static int
+io_can_rt_do_read_err(io_can_rt_t *rt, struct sllist *queue)
+{
+	assert(rt);
+	assert(queue);
+
+	if (sllist_empty(&rt->err_queue))
+		return 0;
+	sllist_append(queue, &rt->err_queue);
+	return 1;
+}
+
 static void
 io_can_rt_do_pop(io_can_rt_t *rt, struct sllist *msg_queue,
-		struct sllist *err_queue, struct ev_task *task)
+		struct sllist *filter_queue, struct sllist *err_queue,
+		struct ev_task *task)
 {
 	assert(rt);
 	assert(msg_queue);
+	assert(filter_queue);
 	assert(err_queue);
 
 	if (!task) {
-		rbtree_foreach (&rt->msg_queue, node) {
-			rbtree_remove(&rt->msg_queue, node);
-			struct io_can_rt_read_msg *read_msg = structof(
-					node, struct io_can_rt_read_msg, _node);
-			sllist_push_back(msg_queue, &read_msg->task._node);
-			sllist_append(msg_queue, &read_msg->_queue);
+		for (size_t i = 0; rt->nmsg && i < IO_CAN_RT_NBUCKET; i++) {
+			struct dlnode *node;
+			while ((node = dllist_pop_front(&rt->msg_tab[i]))) {
+				struct io_can_rt_read_msg *read_msg = structof(
+						node, struct io_can_rt_read_msg,
+						_node);
+				sllist_push_back(msg_queue,
+						&read_msg->task._node);
+				sllist_append(msg_queue, &read_msg->_queue);
+				rt->nmsg--;
+			}
 		}
+		sllist_append(filter_queue, &rt->filter_queue);
 		sllist_append(err_queue, &rt->err_queue);
 		if (rt->submitted)
 			io_can_chan_cancel_read(rt->chan, &rt->read);
-	} else if (task->_data == &rt->msg_queue) {
+	} else if (task->_data == &rt->msg_tab) {
 		io_can_rt_do_pop_read_msg(rt, msg_queue,
 				io_can_rt_read_msg_from_task(task));
+	} else if (task->_data == &rt->filter_queue) {
+		io_can_rt_do_pop_read_filter(rt, filter_queue,
+				io_can_rt_read_filter_from_task(task));
 	} else if (task->_data == &rt->err_queue) {
 		io_can_rt_do_pop_read_err(rt, err_queue,
 				io_can_rt_read_err_from_task(task));
@@ -738,35 +1048,59 @@ io_can_rt_do_pop_read_msg(io_can_rt_t *rt, struct sllist *queue,
 	assert(queue);
 	assert(read_msg);
 	struct ev_task *task = &read_msg->task;
-	assert(task->_data == &rt->msg_queue);
+	assert(task->_data == &rt->msg_tab);
 
-	struct rbnode *node = rbtree_find(&rt->msg_queue, read_msg);
-	if (node == &read_msg->_node) {
-		rbtree_remove(&rt->msg_queue, &read_msg->_node);
+	struct io_can_rt_read_msg *head = io_can_rt_find_read_msg(
+			rt, read_msg->id, read_msg->flags);
+	if (head == read_msg) {
+		struct dllist *bucket = &rt->msg_tab[io_can_rt_hash(
+				read_msg->id, read_msg->flags)];
 		if (!sllist_empty(&read_msg->_queue)) {
+			// Replace the operation by the next one in its queue.
 			struct sllist queue = read_msg->_queue;
-			read_msg = io_can_rt_read_msg_from_task(
-					ev_task_from_node(sllist_pop_front(
-							&queue)));
-			rbnode_init(&read_msg->_node, read_msg);
-			sllist_init(&read_msg->_queue);
-			sllist_append(&read_msg->_queue, &queue);
-			rbtree_insert(&rt->msg_queue, &read_msg->_node);
-		} else if (rt->submitted && rbtree_empty(&rt->msg_queue)
-				&& sllist_empty(&rt->err_queue)) {
-			io_can_chan_cancel_read(rt->chan, &rt->read);
+			struct ev_task *next_task = ev_task_from_node(
+					sllist_pop_front(&queue));
+			struct io_can_rt_read_msg *next =
+					io_can_rt_read_msg_from_task(next_task);
+			sllist_init(&next->_queue);
+			sllist_append(&next->_queue, &queue);
+			dllist_insert_after(bucket, &read_msg->_node,
+					&next->_node);
+			dllist_remove(bucket, &read_msg->_node);
+		} else {
+			dllist_remove(bucket, &read_msg->_node);
+			rt->nmsg--;
+			if (rt->submitted && io_can_rt_empty(rt))
+				io_can_chan_cancel_read(rt->chan, &rt->read);
 		}
 		task->_data = NULL;
 		sllist_push_back(queue, &task->_node);
-	} else if (node) {
-		read_msg = structof(node, struct io_can_rt_read_msg, _node);
-		if (sllist_remove(&read_msg->_queue, &task->_node)) {
+	} else if (head) {
+		if (sllist_remove(&head->_queue, &task->_node)) {
 			task->_data = NULL;
 			sllist_push_back(queue, &task->_node);
 		}
 	}
 }
 
+static void
+io_can_rt_do_pop_read_filter(io_can_rt_t *rt, struct sllist *queue,
+		struct io_can_rt_read_filter *read_filter)
+{
+	assert(rt);
+	assert(queue);
+	assert(read_filter);
+	struct ev_task *task = &read_filter->task;
+	assert(task->_data == &rt->filter_queue);
+
+	if (sllist_remove(&rt->filter_queue, &task->_node)) {
+		if (rt->submitted && io_can_rt_empty(rt))
+			io_can_chan_cancel_read(rt->chan, &rt->read);
+		task->_data = NULL;
+		sllist_push_back(queue, &task->_node);
+	}
+}
+
 static void
 io_can_rt_do_pop_read_err(io_can_rt_t *rt, struct sllist *queue,
 		struct io_can_rt_read_err *read_err)
@@ -778,8 +1112,7 @@ io_can_rt_do_pop_read_err(io_can_rt_t *rt, struct sllist *queue,
 	assert(task->_data == &rt->err_queue);
 
 	if (sllist_remove(&rt->err_queue, &task->_node)) {
-		if (rt->submitted && rbtree_empty(&rt->msg_queue)
-				&& sllist_empty(&rt->err_queue))
+		if (rt->submitted && io_can_rt_empty(rt))
 			io_can_chan_cancel_read(rt->chan, &rt->read);
 		task->_data = NULL;
 		sllist_push_back(queue, &task->_node);
@@ -816,6 +1149,36 @@ io_can_rt_read_msg_queue_post(
 	return n;
 }
 
+static void
+io_can_rt_read_filter_post(struct io_can_rt_read_filter *read_filter,
+		const struct can_msg *msg, int errc)
+{
+	read_filter->r.msg = msg;
+	read_filter->r.errc = errc;
+
+	ev_exec_t *exec = read_filter->task.exec;
+	ev_exec_post(exec, &read_filter->task);
+	ev_exec_on_task_fini(exec);
+}
+
+static size_t
+io_can_rt_read_filter_queue_post(
+		struct sllist *queue, const struct can_msg *msg, int errc)
+{
+	size_t n = 0;
+
+	struct slnode *node;
+	while ((node = sllist_pop_front(queue))) {
+		struct ev_task *task = ev_task_from_node(node);
+		struct io_can_rt_read_filter *read_filter =
+				io_can_rt_read_filter_from_task(task);
+		io_can_rt_read_filter_post(read_filter, msg, errc);
+		n += n < SIZE_MAX;
+	}
+
+	return n;
+}
+
 static void
 io_can_rt_read_err_post(struct io_can_rt_read_err *read_err,
 		const struct can_err *err, int errc)
@@ -846,20 +1209,6 @@ io_can_rt_read_err_queue_post(
 	return n;
 }
 
-static int
-io_can_rt_read_msg_cmp(const void *p1, const void *p2)
-{
-	const struct io_can_rt_read_msg *r1 = p1;
-	assert(r1);
-	const struct io_can_rt_read_msg *r2 = p2;
-	assert(r2);
-
-	int cmp = (r2->id < r1->id) - (r1->id < r2->id);
-	if (!cmp)
-		cmp = (r2->flags < r1->flags) - (r1->flags < r2->flags);
-	return cmp;
-}
-
 static void
 io_can_rt_async_read_msg_func(struct ev_task *task)
 {
@@ -879,6 +1228,28 @@ io_can_rt_async_read_msg_func(struct ev_task *task)
 	ev_promise_release(async_read_msg->promise);
 }
 
+static void
+io_can_rt_async_read_filter_func(struct ev_task *task)
+{
+	assert(task);
+	struct io_can_rt_read_filter *read_filter =
+			io_can_rt_read_filter_from_task(task);
+	struct io_can_rt_async_read_filter *async_read_filter =
+			structof(read_filter,
+					struct io_can_rt_async_read_filter,
+					read_filter);
+
+	if (ev_promise_set_acquire(async_read_filter->promise)) {
+		if (read_filter->r.msg) {
+			async_read_filter->msg = *read_filter->r.msg;
+			read_filter->r.msg = &async_read_filter->msg;
+		}
+		ev_promise_set_release(
+				async_read_filter->promise, &read_filter->r);
+	}
+	ev_promise_release(async_read_filter->promise);
+}
+
 static void
 io_can_rt_async_read_err_func(struct ev_task *task)
 {
@@ -26,6 +26,7 @@
 #if !LELY_NO_STDIO && defined(__linux__)
 
 #include "../can.h"
+#include <lely/can/net.h>
 #include <lely/io2/ctx.h>
 #include <lely/io2/linux/can.h>
 #include <lely/io2/posix/poll.h>
@@ -108,6 +109,10 @@ static int io_can_chan_impl_write(
 		io_can_chan_t *chan, const struct can_msg *msg, int timeout);
 static void io_can_chan_impl_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write);
+static void io_can_chan_impl_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+static void io_can_chan_impl_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
 
 // clang-format off
 static const struct io_can_chan_vtbl io_can_chan_impl_vtbl = {
@@ -116,7 +121,9 @@ static const struct io_can_chan_vtbl io_can_chan_impl_vtbl = {
 	&io_can_chan_impl_read,
 	&io_can_chan_impl_submit_read,
 	&io_can_chan_impl_write,
-	&io_can_chan_impl_submit_write
+	&io_can_chan_impl_submit_write,
+	&io_can_chan_impl_submit_readv,
+	&io_can_chan_impl_submit_writev
 };
 // clang-format on
 
@@ -211,12 +218,22 @@ static inline struct io_can_chan_impl *io_can_chan_impl_from_svc(
 
 static void io_can_chan_impl_c_signal(struct spscring *ring, void *arg);
 
+static void io_can_chan_impl_submit_read_task(
+		io_can_chan_t *chan, struct ev_task *task);
+static void io_can_chan_impl_submit_write_task(
+		io_can_chan_t *chan, struct ev_task *task, int flags);
+static const struct can_msg *io_can_chan_impl_confirm_msg(
+		struct ev_task *task);
+static int io_can_chan_impl_txwait(const struct io_can_chan_impl *impl);
+
 static void io_can_chan_impl_do_pop(struct io_can_chan_impl *impl,
 		struct sllist *read_queue, struct sllist *write_queue,
 		struct sllist *confirm_queue, struct ev_task *task);
 
 static void io_can_chan_impl_do_read(struct io_can_chan_impl *impl,
 		struct sllist *queue, int *pwouldblock);
+static size_t io_can_chan_impl_do_readv(struct io_can_chan_impl *impl,
+		struct can_msg *msgs, struct timespec *tps, size_t n);
 static void io_can_chan_impl_do_confirm(struct io_can_chan_impl *impl,
 		struct sllist *queue, const struct can_msg *msg);
 
@@ -582,6 +599,74 @@ io_can_chan_close(io_can_chan_t *chan)
 	return fd != -1 ? close(fd) : 0;
 }
 
+int
+io_can_chan_set_filter(io_can_chan_t *chan,
+		const struct can_net_filter *filters, size_t n)
+{
+	struct io_can_chan_impl *impl = io_can_chan_impl_from_chan(chan);
+
+	// Our own frames are needed for write confirmations.
+	if (filters && impl->txwait) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	// Accept all frames if no filters are specified.
+	struct can_filter filter = { 0, 0 };
+	struct can_filter *buf = &filter;
+	socklen_t optlen = sizeof(filter);
+	if (filters) {
+		if (n > CAN_RAW_FILTER_MAX) {
+			errno = EINVAL;
+			return -1;
+		}
+		buf = NULL;
+		optlen = n * sizeof(struct can_filter);
+		if (n && !(buf = malloc(optlen)))
+			return -1;
+		for (size_t i = 0; i < n; i++) {
+			canid_t id = filters[i].id & CAN_EFF_MASK;
+			if (filters[i].flags & CAN_FLAG_IDE)
+				id |= CAN_EFF_FLAG;
+			if (filters[i].flags & CAN_FLAG_RTR)
+				id |= CAN_RTR_FLAG;
+			buf[i].can_id = id;
+			// Always compare the IDE and RTR flags. This allows
+			// the kernel to use a direct lookup for 11-bit
+			// identifiers.
+			buf[i].can_mask = (filters[i].mask & CAN_EFF_MASK)
+					| CAN_EFF_FLAG | CAN_RTR_FLAG;
+		}
+	}
+
+	int result = 0;
+	int errsv = 0;
+#if !LELY_NO_THREADS
+	pthread_mutex_lock(&impl->mtx);
+#endif
+	if (impl->fd == -1) {
+		errsv = EBADF;
+		result = -1;
+	} else {
+		// clang-format off
+		if (setsockopt(impl->fd, SOL_CAN_RAW, CAN_RAW_FILTER, buf,
+				optlen) == -1) {
+			// clang-format on
+			errsv = errno;
+			result = -1;
+		}
+	}
+#if !LELY_NO_THREADS
+	pthread_mutex_unlock(&impl->mtx);
+#endif
+
+	if (buf != &filter)
+		free(buf);
+	if (result == -1)
+		errno = errsv;
+	return result;
+}
+
 static int
 io_can_fd_set_default(int fd, int txwait)
 {
@@ -904,36 +989,9 @@ io_can_chan_impl_read(io_can_chan_t *chan, struct can_msg *msg,
 static void
 io_can_chan_impl_submit_read(io_can_chan_t *chan, struct io_can_chan_read *read)
 {
-	struct io_can_chan_impl *impl = io_can_chan_impl_from_chan(chan);
 	assert(read);
-	struct ev_task *task = &read->task;
-
-	if (!task->exec)
-		task->exec = impl->exec;
-	assert(task->exec);
-	ev_exec_on_task_init(task->exec);
 
-#if !LELY_NO_THREADS
-	pthread_mutex_lock(&impl->mtx);
-#endif
-	if (impl->shutdown) {
-#if !LELY_NO_THREADS
-		pthread_mutex_unlock(&impl->mtx);
-#endif
-		io_can_chan_read_post(read, -1, ECANCELED);
-	} else {
-		int post_read = !impl->read_posted
-				&& sllist_empty(&impl->read_queue);
-		sllist_push_back(&impl->read_queue, &task->_node);
-		if (post_read)
-			impl->read_posted = 1;
-#if !LELY_NO_THREADS
-		pthread_mutex_unlock(&impl->mtx);
-#endif
-		assert(impl->read_task.exec);
-		if (post_read)
-			ev_exec_post(impl->read_task.exec, &impl->read_task);
-	}
+	io_can_chan_impl_submit_read_task(chan, &read->task);
 }
 
 static int
@@ -974,52 +1032,47 @@ static void
 io_can_chan_impl_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write)
 {
-	struct io_can_chan_impl *impl = io_can_chan_impl_from_chan(chan);
 	assert(write);
 	assert(write->msg);
-	struct ev_task *task = &write->task;
 
-#if !LELY_NO_CANFD
 	int flags = 0;
+#if !LELY_NO_CANFD
 	if (write->msg->flags & CAN_FLAG_FDF)
 		flags |= IO_CAN_BUS_FLAG_FDF;
 	if (write->msg->flags & CAN_FLAG_BRS)
 		flags |= IO_CAN_BUS_FLAG_BRS;
 #endif
 
-	if (!task->exec)
-		task->exec = impl->exec;
-	assert(task->exec);
-	ev_exec_on_task_init(task->exec);
+	io_can_chan_impl_submit_write_task(chan, &write->task, flags);
+}
 
-#if !LELY_NO_THREADS
-	pthread_mutex_lock(&impl->mtx);
-#endif
-	if (impl->shutdown) {
-#if !LELY_NO_THREADS
-		pthread_mutex_unlock(&impl->mtx);
-#endif
-		io_can_chan_write_post(write, ECANCELED);
+static void
+io_can_chan_impl_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	assert(readv);
+
+	io_can_chan_impl_submit_read_task(chan, &readv->task);
+}
+
+static void
+io_can_chan_impl_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	assert(writev);
+	assert(writev->msgs || !writev->n);
+
+	int flags = 0;
 #if !LELY_NO_CANFD
-	} else if ((flags & impl->flags) != flags) {
-#if !LELY_NO_THREADS
-		pthread_mutex_unlock(&impl->mtx);
-#endif
-		io_can_chan_write_post(write, EINVAL);
-#endif
-	} else {
-		int post_write = !impl->write_posted
-				&& sllist_empty(&impl->write_queue);
-		sllist_push_back(&impl->write_queue, &task->_node);
-		if (post_write)
-			impl->write_posted = 1;
-#if !LELY_NO_THREADS
-		pthread_mutex_unlock(&impl->mtx);
-#endif
-		assert(impl->write_task.exec);
-		if (post_write)
-			ev_exec_post(impl->write_task.exec, &impl->write_task);
+	for (size_t i = 0; i < writev->n; i++) {
+		if (writev->msgs[i].flags & CAN_FLAG_FDF)
+			flags |= IO_CAN_BUS_FLAG_FDF;
+		if (writev->msgs[i].flags & CAN_FLAG_BRS)
+			flags |= IO_CAN_BUS_FLAG_BRS;
 	}
+#endif
+
+	io_can_chan_impl_submit_write_task(chan, &writev->task, flags);
 }
 
 static void
@@ -1129,7 +1182,7 @@ io_can_chan_impl_rxbuf_task_func(struct ev_task *task)
 	// clang-format off
 	while ((!sllist_empty(&impl->read_queue)
 				&& spscring_p_capacity(&impl->rxring))
-			|| !sllist_empty(&impl->confirm_queue)) {
+			|| io_can_chan_impl_txwait(impl)) {
 		// clang-format on
 		int fd = impl->fd;
 #if !LELY_NO_THREADS
@@ -1186,16 +1239,25 @@ io_can_chan_impl_rxbuf_task_func(struct ev_task *task)
 		io_can_chan_impl_do_read(impl, &queue, NULL);
 		while ((task = ev_task_from_node(
 					sllist_pop_front(&impl->read_queue)))) {
-			struct io_can_chan_read *read =
-					io_can_chan_read_from_task(task);
-			read->r.result = result;
-			read->r.errc = errc;
+			if (io_can_chan_task_is_vec(task)) {
+				struct io_can_chan_readv *readv =
+						io_can_chan_readv_from_task(
+								task);
+				readv->r.n = 0;
+				readv->r.errc = errc;
+			} else {
+				struct io_can_chan_read *read =
+						io_can_chan_read_from_task(
+								task);
+				read->r.result = result;
+				read->r.errc = errc;
+			}
 			sllist_push_back(&queue, &task->_node);
 		}
 	}
 	// clang-format off
-	int post_rxbuf = !(sllist_empty(&impl->read_queue)
-					&& sllist_empty(&impl->confirm_queue))
+	int post_rxbuf = (!sllist_empty(&impl->read_queue)
+					|| io_can_chan_impl_txwait(impl))
 			&& impl->fd != -1 && !impl->shutdown;
 	// clang-format on
 	// If a read operation would block, start monitoring the file descriptor
@@ -1299,25 +1361,29 @@ io_can_chan_impl_write_task_func(struct ev_task *task)
 	// blocking mode.
 	while ((task = impl->current_write = ev_task_from_node(
 				sllist_pop_front(&impl->write_queue)))) {
-		int fd = impl->fd;
 #if !LELY_NO_THREADS
 		pthread_mutex_unlock(&impl->mtx);
 #endif
-		struct io_can_chan_write *write =
-				io_can_chan_write_from_task(task);
-		int result = io_can_fd_write_msg(fd, write->msg,
-				impl->poll ? 0 : LELY_IO_TX_TIMEOUT);
+		int result = io_can_chan_task_write(&impl->chan_vptr, task,
+				impl->poll ? 0 : LELY_IO_TX_TIMEOUT,
+				&io_can_chan_impl_write);
 		int errc = !result ? 0 : errno;
 		wouldblock = errc == EAGAIN || errc == EWOULDBLOCK;
+		// Only wait for a write confirmation if there is a frame to be
+		// confirmed. The frames of a partially written vectored write
+		// operation may already have been confirmed while it was
+		// waiting to be resumed.
+		int txwait = impl->txwait && !errc
+				&& io_can_chan_impl_confirm_msg(task);
 		// Submit the completion task if the operation succeeded and we
 		// don't need to wait for a write confirmation, or if it failed
 		// immediately.
-		if ((!errc && !impl->txwait) || (!wouldblock && errc))
-			io_can_chan_write_post(write, errc);
+		if ((!errc && !txwait) || (!wouldblock && errc))
+			io_can_chan_write_task_post(task, errc);
 #if !LELY_NO_THREADS
 		pthread_mutex_lock(&impl->mtx);
 #endif
-		if (!errc && impl->txwait) {
+		if (!errc && txwait) {
 			// Wait for the write confirmation.
 			sllist_push_back(&impl->confirm_queue, &task->_node);
 		}
@@ -1339,7 +1405,7 @@ io_can_chan_impl_write_task_func(struct ev_task *task)
 	// If we're waiting for a write confirmation, start reading more CAN
 	// frames, unless we're already waiting for one.
 	int post_rxbuf = !impl->rxbuf_posted
-			&& !sllist_empty(&impl->confirm_queue)
+			&& io_can_chan_impl_txwait(impl)
 			&& !(impl->events & IO_EVENT_IN) && impl->fd != -1
 			&& !impl->shutdown;
 	if (post_rxbuf)
@@ -1369,8 +1435,7 @@ io_can_chan_impl_write_task_func(struct ev_task *task)
 	if (task && wouldblock)
 		// The operation would block but was canceled before it could be
 		// requeued.
-		io_can_chan_write_post(
-				io_can_chan_write_from_task(task), ECANCELED);
+		io_can_chan_write_task_post(task, ECANCELED);
 
 	if (post_rxbuf)
 		ev_exec_post(impl->rxbuf_task.exec, &impl->rxbuf_task);
@@ -1427,6 +1492,117 @@ io_can_chan_impl_c_signal(struct spscring *ring, void *arg)
 		ev_exec_post(impl->read_task.exec, &impl->read_task);
 }
 
+static void
+io_can_chan_impl_submit_read_task(io_can_chan_t *chan, struct ev_task *task)
+{
+	struct io_can_chan_impl *impl = io_can_chan_impl_from_chan(chan);
+	assert(task);
+
+	if (!task->exec)
+		task->exec = impl->exec;
+	assert(task->exec);
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	pthread_mutex_lock(&impl->mtx);
+#endif
+	if (impl->shutdown) {
+#if !LELY_NO_THREADS
+		pthread_mutex_unlock(&impl->mtx);
+#endif
+		io_can_chan_read_task_post(task, -1, ECANCELED);
+	} else {
+		int post_read = !impl->read_posted
+				&& sllist_empty(&impl->read_queue);
+		sllist_push_back(&impl->read_queue, &task->_node);
+		if (post_read)
+			impl->read_posted = 1;
+#if !LELY_NO_THREADS
+		pthread_mutex_unlock(&impl->mtx);
+#endif
+		assert(impl->read_task.exec);
+		if (post_read)
+			ev_exec_post(impl->read_task.exec, &impl->read_task);
+	}
+}
+
+static void
+io_can_chan_impl_submit_write_task(
+		io_can_chan_t *chan, struct ev_task *task, int flags)
+{
+	struct io_can_chan_impl *impl = io_can_chan_impl_from_chan(chan);
+	assert(task);
+#if LELY_NO_CANFD
+	(void)flags;
+#endif
+
+	if (!task->exec)
+		task->exec = impl->exec;
+	assert(task->exec);
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	pthread_mutex_lock(&impl->mtx);
+#endif
+	if (impl->shutdown) {
+#if !LELY_NO_THREADS
+		pthread_mutex_unlock(&impl->mtx);
+#endif
+		io_can_chan_write_task_post(task, ECANCELED);
+#if !LELY_NO_CANFD
+	} else if ((flags & impl->flags) != flags) {
+#if !LELY_NO_THREADS
+		pthread_mutex_unlock(&impl->mtx);
+#endif
+		io_can_chan_write_task_post(task, EINVAL);
+#endif
+	} else {
+		int post_write = !impl->write_posted
+				&& sllist_empty(&impl->write_queue);
+		sllist_push_back(&impl->write_queue, &task->_node);
+		if (post_write)
+			impl->write_posted = 1;
+#if !LELY_NO_THREADS
+		pthread_mutex_unlock(&impl->mtx);
+#endif
+		assert(impl->write_task.exec);
+		if (post_write)
+			ev_exec_post(impl->write_task.exec, &impl->write_task);
+	}
+}
+
+static const struct can_msg *
+io_can_chan_impl_confirm_msg(struct ev_task *task)
+{
+	assert(task);
+
+	if (!io_can_chan_task_is_vec(task))
+		return io_can_chan_write_from_task(task)->msg;
+
+	// A vectored write operation waits for the confirmation of each of the
+	// frames written so far, in turn.
+	struct io_can_chan_writev *writev = io_can_chan_writev_from_task(task);
+	return writev->_nconfirm < writev->r.n
+			? &writev->msgs[writev->_nconfirm]
+			: NULL;
+}
+
+static int
+io_can_chan_impl_txwait(const struct io_can_chan_impl *impl)
+{
+	assert(impl);
+
+	if (!sllist_empty(&impl->confirm_queue))
+		return 1;
+
+	// A vectored write operation that was partially written before it
+	// would block waits for confirmations at the front of the write queue.
+	struct ev_task *task = ev_task_from_node(
+			sllist_first(&impl->write_queue));
+	return impl->txwait && task && io_can_chan_task_is_vec(task)
+			&& io_can_chan_impl_confirm_msg(task);
+}
+
 static void
 io_can_chan_impl_do_pop(struct io_can_chan_impl *impl,
 		struct sllist *read_queue, struct sllist *write_queue,
@@ -1464,13 +1640,35 @@ io_can_chan_impl_do_read(struct io_can_chan_impl *impl, struct sllist *queue,
 	struct slnode *node;
 	while ((node = sllist_first(&impl->read_queue))) {
 		struct ev_task *task = ev_task_from_node(node);
-		struct io_can_chan_read *read =
-				io_can_chan_read_from_task(task);
 
 #if !LELY_NO_THREADS
 		pthread_mutex_lock(&impl->c_mtx);
 #endif
 
+		if (io_can_chan_task_is_vec(task)) {
+			struct io_can_chan_readv *readv =
+					io_can_chan_readv_from_task(task);
+			size_t nmsg = io_can_chan_impl_do_readv(impl,
+					readv->msgs, readv->tps, readv->n);
+#if !LELY_NO_THREADS
+			pthread_mutex_unlock(&impl->c_mtx);
+#endif
+			if (!nmsg && readv->n) {
+				wouldblock = 1;
+				break;
+			}
+
+			readv->r.n = nmsg;
+			readv->r.errc = 0;
+
+			sllist_pop_front(&impl->read_queue);
+			sllist_push_back(queue, node);
+			continue;
+		}
+
+		struct io_can_chan_read *read =
+				io_can_chan_read_from_task(task);
+
 		// Check if a frame is available in the receive queue.
 		size_t n = 1;
 		size_t i = spscring_c_alloc(&impl->rxring, &n);
@@ -1515,6 +1713,42 @@ io_can_chan_impl_do_read(struct io_can_chan_impl *impl, struct sllist *queue,
 	errno = errsv;
 }
 
+static size_t
+io_can_chan_impl_do_readv(struct io_can_chan_impl *impl, struct can_msg *msgs,
+		struct timespec *tps, size_t n)
+{
+	assert(impl);
+	assert(msgs || !n);
+
+	size_t nmsg = 0;
+	while (nmsg < n) {
+		// Obtain as many contiguous frames as possible from the receive
+		// queue.
+		size_t nframe = n - nmsg;
+		size_t i = spscring_c_alloc(&impl->rxring, &nframe);
+		if (!nframe)
+			break;
+		for (struct io_can_frame *frame = &impl->rxbuf[i];
+				frame < &impl->rxbuf[i + nframe]; frame++) {
+			void *data = &frame->frame;
+			// Discard error frames.
+			if (can_frame2can_err(data, NULL))
+				continue;
+#if !LELY_NO_CANFD
+			if (frame->nbytes == CANFD_MTU)
+				canfd_frame2can_msg(data, &msgs[nmsg]);
+			else
+#endif
+				can_frame2can_msg(data, &msgs[nmsg]);
+			if (tps)
+				tps[nmsg] = frame->ts;
+			nmsg++;
+		}
+		spscring_c_commit(&impl->rxring, nframe);
+	}
+	return nmsg;
+}
+
 static void
 io_can_chan_impl_do_confirm(struct io_can_chan_impl *impl, struct sllist *queue,
 		const struct can_msg *msg)
@@ -1527,30 +1761,55 @@ io_can_chan_impl_do_confirm(struct io_can_chan_impl *impl, struct sllist *queue,
 	// Find the matching write operation.
 	struct slnode *node = sllist_first(&impl->confirm_queue);
 	while (node) {
-		struct io_can_chan_write *write = io_can_chan_write_from_task(
-				ev_task_from_node(node));
-		if (!can_msg_cmp(msg, write->msg))
+		const struct can_msg *confirm_msg =
+				io_can_chan_impl_confirm_msg(
+						ev_task_from_node(node));
+		if (confirm_msg && !can_msg_cmp(msg, confirm_msg))
 			break;
 		node = node->next;
 	}
-	if (!node)
-		return;
-
-	// Complete the matching write operation. Any preceding write operations
-	// waiting for confirmation are considered to have failed.
-	struct ev_task *task;
-	while ((task = ev_task_from_node(
-				sllist_pop_front(&impl->confirm_queue)))) {
-		sllist_push_front(queue, &task->_node);
-		struct io_can_chan_write *write =
-				io_can_chan_write_from_task(task);
-		if (&task->_node == node) {
-			write->errc = 0;
-			break;
-		} else {
-			write->errc = EIO;
-		}
+	if (!node) {
+		// The frames of a vectored write operation that would block
+		// after being partially written are confirmed while it waits at
+		// the front of the write queue to be resumed.
+		node = sllist_first(&impl->write_queue);
+		struct ev_task *task = ev_task_from_node(node);
+		if (!task || !io_can_chan_task_is_vec(task))
+			return;
+		const struct can_msg *confirm_msg =
+				io_can_chan_impl_confirm_msg(task);
+		if (!confirm_msg || can_msg_cmp(msg, confirm_msg))
+			return;
+	}
+
+	// Any write operations waiting for confirmation before the matching
+	// one are considered to have failed.
+	struct slnode *first;
+	while ((first = sllist_first(&impl->confirm_queue)) && first != node) {
+		sllist_pop_front(&impl->confirm_queue);
+		sllist_push_front(queue, first);
+		struct ev_task *task = ev_task_from_node(first);
+		if (io_can_chan_task_is_vec(task))
+			io_can_chan_writev_from_task(task)->r.errc = EIO;
+		else
+			io_can_chan_write_from_task(task)->errc = EIO;
+	}
+	struct ev_task *task = ev_task_from_node(node);
+
+	// A vectored write operation only completes once all of its frames
+	// have been written and confirmed. A partially written operation is
+	// never complete.
+	if (io_can_chan_task_is_vec(task)) {
+		struct io_can_chan_writev *writev =
+				io_can_chan_writev_from_task(task);
+		if (++writev->_nconfirm < writev->n)
+			return;
+		writev->r.errc = 0;
+	} else {
+		io_can_chan_write_from_task(task)->errc = 0;
 	}
+	sllist_pop_front(&impl->confirm_queue);
+	sllist_push_front(queue, &task->_node);
 }
 
 static size_t
@@ -80,6 +80,10 @@ static int io_user_can_chan_write(
 		io_can_chan_t *chan, const struct can_msg *msg, int timeout);
 static void io_user_can_chan_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write);
+static void io_user_can_chan_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+static void io_user_can_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
 
 // clang-format off
 static const struct io_can_chan_vtbl io_user_can_chan_vtbl = {
@@ -88,7 +92,9 @@ static const struct io_can_chan_vtbl io_user_can_chan_vtbl = {
 	&io_user_can_chan_read,
 	&io_user_can_chan_submit_read,
 	&io_user_can_chan_write,
-	&io_user_can_chan_submit_write
+	&io_user_can_chan_submit_write,
+	&io_user_can_chan_submit_readv,
+	&io_user_can_chan_submit_writev
 };
 // clang-format on
 
@@ -186,6 +192,11 @@ static int io_user_can_chan_on_frame(struct io_user_can_chan *user,
 static void io_user_can_chan_p_signal(struct spscring *ring, void *arg);
 static void io_user_can_chan_c_signal(struct spscring *ring, void *arg);
 
+static void io_user_can_chan_submit_read_task(
+		io_can_chan_t *chan, struct ev_task *task);
+static void io_user_can_chan_submit_write_task(
+		io_can_chan_t *chan, struct ev_task *task, int flags);
+
 static void io_user_can_chan_do_pop(struct io_user_can_chan *user,
 		struct sllist *read_queue, struct sllist *write_queue,
 		struct ev_task *task);
@@ -630,35 +641,9 @@ io_user_can_chan_read(io_can_chan_t *chan, struct can_msg *msg,
 static void
 io_user_can_chan_submit_read(io_can_chan_t *chan, struct io_can_chan_read *read)
 {
-	struct io_user_can_chan *user = io_user_can_chan_from_chan(chan);
 	assert(read);
-	struct ev_task *task = &read->task;
-
-	if (!task->exec)
-		task->exec = user->exec;
-	ev_exec_on_task_init(task->exec);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&user->mtx);
-#endif
-	if (user->shutdown) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		io_can_chan_read_post(read, -1, errnum2c(ERRNUM_CANCELED));
-	} else {
-		int post_read = !user->read_posted
-				&& sllist_empty(&user->read_queue);
-		sllist_push_back(&user->read_queue, &task->_node);
-		if (post_read)
-			user->read_posted = 1;
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		// cppcheck-suppress duplicateCondition
-		if (post_read)
-			ev_exec_post(user->read_task.exec, &user->read_task);
-	}
+	io_user_can_chan_submit_read_task(chan, &read->task);
 }
 
 static int
@@ -692,55 +677,45 @@ static void
 io_user_can_chan_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write)
 {
-	struct io_user_can_chan *user = io_user_can_chan_from_chan(chan);
 	assert(write);
-	struct ev_task *task = &write->task;
 
-#if !LELY_NO_CANFD
 	int flags = 0;
+#if !LELY_NO_CANFD
 	if (write->msg->flags & CAN_FLAG_FDF)
 		flags |= IO_CAN_BUS_FLAG_FDF;
 	if (write->msg->flags & CAN_FLAG_BRS)
 		flags |= IO_CAN_BUS_FLAG_BRS;
 #endif
 
-	if (!task->exec)
-		task->exec = user->exec;
-	ev_exec_on_task_init(task->exec);
+	io_user_can_chan_submit_write_task(chan, &write->task, flags);
+}
 
-#if !LELY_NO_THREADS
-	mtx_lock(&user->mtx);
-#endif
-	if (user->shutdown) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_CANCELED));
+static void
+io_user_can_chan_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	assert(readv);
+
+	io_user_can_chan_submit_read_task(chan, &readv->task);
+}
+
+static void
+io_user_can_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	assert(writev);
+
+	int flags = 0;
 #if !LELY_NO_CANFD
-	} else if ((flags & user->flags) != flags) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_INVAL));
-#endif
-	} else if (!user->func) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_NOSYS));
-	} else {
-		int post_write = !user->write_posted
-				&& sllist_empty(&user->write_queue);
-		sllist_push_back(&user->write_queue, &task->_node);
-		if (post_write)
-			user->write_posted = 1;
-#if !LELY_NO_THREADS
-		mtx_unlock(&user->mtx);
-#endif
-		// cppcheck-suppress duplicateCondition
-		if (post_write)
-			ev_exec_post(user->write_task.exec, &user->write_task);
+	for (size_t i = 0; i < writev->n; i++) {
+		if (writev->msgs[i].flags & CAN_FLAG_FDF)
+			flags |= IO_CAN_BUS_FLAG_FDF;
+		if (writev->msgs[i].flags & CAN_FLAG_BRS)
+			flags |= IO_CAN_BUS_FLAG_BRS;
 	}
+#endif
+
+	io_user_can_chan_submit_write_task(chan, &writev->task, flags);
 }
 
 static void
@@ -788,16 +763,14 @@ io_user_can_chan_read_task_func(struct ev_task *task)
 #if !LELY_NO_THREADS
 		mtx_unlock(&user->mtx);
 #endif
-		struct io_can_chan_read *read =
-				io_can_chan_read_from_task(task);
-		int result = io_user_can_chan_read(
-				chan, read->msg, read->err, read->tp, 0);
+		int result = io_can_chan_task_read(
+				chan, task, &io_user_can_chan_read);
 		int errc = result >= 0 ? 0 : get_errc();
 		wouldblock = errc == errnum2c(ERRNUM_AGAIN)
 				|| errc == errnum2c(ERRNUM_WOULDBLOCK);
 		if (!wouldblock)
 			// The operation succeeded or failed immediately.
-			io_can_chan_read_post(read, result, errc);
+			io_can_chan_read_task_post(task, result, errc);
 #if !LELY_NO_THREADS
 		mtx_lock(&user->mtx);
 #endif
@@ -839,8 +812,8 @@ io_user_can_chan_read_task_func(struct ev_task *task)
 	if (task && wouldblock)
 		// The operation would block but was canceled before it could be
 		// requeued.
-		io_can_chan_read_post(io_can_chan_read_from_task(task), -1,
-				errnum2c(ERRNUM_CANCELED));
+		io_can_chan_read_task_post(
+				task, -1, errnum2c(ERRNUM_CANCELED));
 
 	if (post_read)
 		ev_exec_post(user->read_task.exec, &user->read_task);
@@ -870,16 +843,14 @@ io_user_can_chan_write_task_func(struct ev_task *task)
 #if !LELY_NO_THREADS
 		mtx_unlock(&user->mtx);
 #endif
-		struct io_can_chan_write *write =
-				io_can_chan_write_from_task(task);
-		int result = io_user_can_chan_write(
-				chan, write->msg, user->txtimeo);
+		int result = io_can_chan_task_write(chan, task, user->txtimeo,
+				&io_user_can_chan_write);
 		int errc = !result ? 0 : get_errc();
 		wouldblock = errc == errnum2c(ERRNUM_AGAIN)
 				|| errc == errnum2c(ERRNUM_WOULDBLOCK);
 		if (!wouldblock)
 			// The operation succeeded or failed immediately.
-			io_can_chan_write_post(write, errc);
+			io_can_chan_write_task_post(task, errc);
 #if !LELY_NO_THREADS
 		mtx_lock(&user->mtx);
 #endif
@@ -904,8 +875,7 @@ io_user_can_chan_write_task_func(struct ev_task *task)
 	if (task && wouldblock)
 		// The operation would block but was canceled before it could be
 		// requeued.
-		io_can_chan_write_post(io_can_chan_write_from_task(task),
-				errnum2c(ERRNUM_CANCELED));
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_CANCELED));
 
 	if (post_write)
 		ev_exec_post(user->write_task.exec, &user->write_task);
@@ -1059,6 +1029,89 @@ io_user_can_chan_c_signal(struct spscring *ring, void *arg)
 		ev_exec_post(user->read_task.exec, &user->read_task);
 }
 
+static void
+io_user_can_chan_submit_read_task(io_can_chan_t *chan, struct ev_task *task)
+{
+	struct io_user_can_chan *user = io_user_can_chan_from_chan(chan);
+	assert(task);
+
+	if (!task->exec)
+		task->exec = user->exec;
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&user->mtx);
+#endif
+	if (user->shutdown) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		io_can_chan_read_task_post(
+				task, -1, errnum2c(ERRNUM_CANCELED));
+	} else {
+		int post_read = !user->read_posted
+				&& sllist_empty(&user->read_queue);
+		sllist_push_back(&user->read_queue, &task->_node);
+		if (post_read)
+			user->read_posted = 1;
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		// cppcheck-suppress duplicateCondition
+		if (post_read)
+			ev_exec_post(user->read_task.exec, &user->read_task);
+	}
+}
+
+static void
+io_user_can_chan_submit_write_task(
+		io_can_chan_t *chan, struct ev_task *task, int flags)
+{
+	struct io_user_can_chan *user = io_user_can_chan_from_chan(chan);
+	assert(task);
+#if LELY_NO_CANFD
+	(void)flags;
+#endif
+
+	if (!task->exec)
+		task->exec = user->exec;
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&user->mtx);
+#endif
+	if (user->shutdown) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_CANCELED));
+#if !LELY_NO_CANFD
+	} else if ((flags & user->flags) != flags) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_INVAL));
+#endif
+	} else if (!user->func) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_NOSYS));
+	} else {
+		int post_write = !user->write_posted
+				&& sllist_empty(&user->write_queue);
+		sllist_push_back(&user->write_queue, &task->_node);
+		if (post_write)
+			user->write_posted = 1;
+#if !LELY_NO_THREADS
+		mtx_unlock(&user->mtx);
+#endif
+		// cppcheck-suppress duplicateCondition
+		if (post_write)
+			ev_exec_post(user->write_task.exec, &user->write_task);
+	}
+}
+
 static void
 io_user_can_chan_do_pop(struct io_user_can_chan *user,
 		struct sllist *read_queue, struct sllist *write_queue,
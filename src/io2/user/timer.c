@@ -539,7 +539,7 @@ io_user_timer_do_settime(struct io_user_timer *user)
 
 		if (period->tv_sec || period->tv_nsec) {
 			user->overrun = -1;
-			while (timespec_cmp(expiry, &user->now) < 0) {
+			while (timespec_cmp(expiry, &user->now) <= 0) {
 				timespec_add(expiry, period);
 				user->overrun++;
 			}
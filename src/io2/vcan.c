@@ -31,13 +31,13 @@
 #include <lely/io2/ctx.h>
 #include <lely/io2/vcan.h>
 #include <lely/util/diag.h>
-#include <lely/util/spscring.h>
 #include <lely/util/time.h>
 #include <lely/util/util.h>
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef LELY_IO_VCAN_BITRATE
 /// The default bitrate of a virtual CAN bus.
@@ -46,21 +46,52 @@
 
 #ifndef LELY_IO_VCAN_RXLEN
 /**
- * The default receive queue length (in number of CAN frames) of a vritual CAN
- * channel.
+ * The default maximum number of unread CAN frames of a virtual CAN channel.
+ * This is also the initial length of the shared receive queue of a virtual CAN
+ * controller.
  */
 #define LELY_IO_VCAN_RXLEN 1024
 #endif
 
+#ifndef LELY_IO_VCAN_TXLEN
+/**
+ * The default maximum number of CAN frames queued for transmission by a virtual
+ * CAN controller when the bus timing simulation is enabled.
+ */
+#define LELY_IO_VCAN_TXLEN 256
+#endif
+
+/// A CAN (error) frame in the shared receive queue of a virtual CAN controller.
 struct io_vcan_frame {
+	/// A flag indicating whether this is an error frame.
 	int is_err;
+	/// The CAN frame or error frame.
 	union {
 		struct can_msg msg;
 		struct can_err err;
 	} u;
+	/// The time at which the frame was put on the bus.
 	struct timespec ts;
+	/// A pointer to the sending channel, or NULL if sent by the controller.
+	const io_can_chan_t *chan;
 };
 
+/// A CAN frame queued for transmission on a simulated CAN bus.
+struct io_vcan_sim_frame {
+	/// The CAN frame.
+	struct can_msg msg;
+	/// The time at which the frame was queued.
+	struct timespec ts;
+	/// A pointer to the sending channel, or NULL if sent by the controller.
+	const io_can_chan_t *chan;
+	/// The value of the arbitration field. Lower values win arbitration.
+	uint_least32_t key;
+	/// The time (in nanoseconds) the frame occupies the bus.
+	uint_least64_t nsec;
+};
+
+static uint_least32_t io_vcan_sim_key(const struct can_msg *msg);
+
 static int io_vcan_ctrl_stop(io_can_ctrl_t *ctrl);
 static int io_vcan_ctrl_stopped(const io_can_ctrl_t *ctrl);
 static int io_vcan_ctrl_restart(io_can_ctrl_t *ctrl);
@@ -113,6 +144,46 @@ struct io_vcan_ctrl {
 	int state;
 	/// The list of registered virtual CAN channels.
 	struct sllist list;
+#if !LELY_NO_THREADS
+	/**
+	 * The mutex protecting the shared receive queue and the read positions
+	 * of the registered channels. This mutex is always locked last.
+	 */
+	mtx_t rxmtx;
+#endif
+	/**
+	 * The shared receive queue. Each frame is stored once, at index
+	 * `seq % rxlen`, where `seq` is its sequence number.
+	 */
+	struct io_vcan_frame *rxbuf;
+	/// The number of frames in #rxbuf.
+	size_t rxlen;
+	/// The sequence number of the next frame to be written to #rxbuf.
+	uint_least64_t rxhead;
+	/// A flag indicating whether the bus timing simulation is enabled.
+	int sim;
+	/// The frames queued for transmission, in order of arrival.
+	struct io_vcan_sim_frame *sim_buf;
+	/// The maximum number of frames in #sim_buf.
+	size_t sim_len;
+	/// The number of frames in #sim_buf.
+	size_t sim_n;
+	/// A flag indicating whether #sim_cur is being transmitted.
+	int sim_busy;
+	/// The frame currently being transmitted.
+	struct io_vcan_sim_frame sim_cur;
+	/// The time at which the transmission of #sim_cur started.
+	struct timespec sim_start;
+	/// The time at which the bus last became idle.
+	struct timespec sim_idle;
+	/// The time at which the simulation was enabled.
+	struct timespec sim_begin;
+	/// The last time the simulation was advanced.
+	struct timespec sim_now;
+	/// The statistics of the simulation.
+	struct io_vcan_sim_stats sim_stats;
+	/// The statistics for each 11-bit CAN-ID.
+	struct io_vcan_sim_id_stats *sim_id_stats;
 };
 
 static inline struct io_vcan_ctrl *io_vcan_ctrl_from_ctrl(
@@ -121,7 +192,9 @@ static inline struct io_vcan_ctrl *io_vcan_ctrl_from_ctrl(
 static void io_vcan_ctrl_insert(io_can_ctrl_t *ctrl, io_can_chan_t *chan);
 static void io_vcan_ctrl_remove(io_can_ctrl_t *ctrl, io_can_chan_t *chan);
 
-static void io_vcan_ctrl_signal(struct spscring *ring, void *arg);
+static void io_vcan_ctrl_do_signal(struct io_vcan_ctrl *vcan);
+static void io_vcan_ctrl_do_put(struct io_vcan_ctrl *vcan,
+		const struct io_vcan_frame *frame);
 
 static int io_vcan_ctrl_write(io_can_ctrl_t *ctrl, io_can_chan_t *chan,
 		const struct can_msg *msg, const struct can_err *err,
@@ -129,6 +202,14 @@ static int io_vcan_ctrl_write(io_can_ctrl_t *ctrl, io_can_chan_t *chan,
 
 static void io_vcan_ctrl_do_stop(struct io_vcan_ctrl *vcan_ctrl);
 
+static uint_least64_t io_vcan_ctrl_sim_nsec(
+		const struct io_vcan_ctrl *vcan, const struct can_msg *msg);
+static void io_vcan_ctrl_sim_do_flush(
+		struct io_vcan_ctrl *vcan, const struct timespec *now);
+static void io_vcan_ctrl_sim_do_put(struct io_vcan_ctrl *vcan,
+		const struct io_vcan_sim_frame *frame,
+		const struct timespec *ts);
+
 static io_ctx_t *io_vcan_chan_dev_get_ctx(const io_dev_t *dev);
 static ev_exec_t *io_vcan_chan_dev_get_exec(const io_dev_t *dev);
 static size_t io_vcan_chan_dev_cancel(io_dev_t *dev, struct ev_task *task);
@@ -153,6 +234,10 @@ static int io_vcan_chan_write(
 		io_can_chan_t *chan, const struct can_msg *msg, int timeout);
 static void io_vcan_chan_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write);
+static void io_vcan_chan_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+static void io_vcan_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
 
 // clang-format off
 static const struct io_can_chan_vtbl io_vcan_chan_vtbl = {
@@ -161,7 +246,9 @@ static const struct io_can_chan_vtbl io_vcan_chan_vtbl = {
 	&io_vcan_chan_read,
 	&io_vcan_chan_submit_read,
 	&io_vcan_chan_write,
-	&io_vcan_chan_submit_write
+	&io_vcan_chan_submit_write,
+	&io_vcan_chan_submit_readv,
+	&io_vcan_chan_submit_writev
 };
 // clang-format on
 
@@ -190,10 +277,34 @@ struct io_vcan_chan {
 	struct ev_task read_task;
 	/// The task responsible for initiating write operations.
 	struct ev_task write_task;
-	/// The ring buffer used to control the receive queue.
-	struct spscring rxring;
-	/// The receive queue.
-	struct io_vcan_frame *rxbuf;
+	/**
+	 * The maximum number of unread frames in the shared receive queue of
+	 * the controller. If a channel falls further behind, its oldest frames
+	 * are dropped.
+	 */
+	size_t rxlen;
+	/**
+	 * The sequence number of the next frame to be read from the shared
+	 * receive queue. #rxtail is protected by the receive queue mutex in
+	 * #io_vcan_ctrl.
+	 */
+	uint_least64_t rxtail;
+	/**
+	 * The number of frames dropped because the channel fell behind. #rxdrop
+	 * is protected by the receive queue mutex in #io_vcan_ctrl.
+	 */
+	size_t rxdrop;
+	/**
+	 * A flag indicating whether a read operation is waiting for a frame.
+	 * #rxwait is protected by the receive queue mutex in #io_vcan_ctrl.
+	 */
+	int rxwait;
+	/**
+	 * A flag indicating whether the channel has to be signaled after a
+	 * frame is written. #rxsignal is protected by the mutex in
+	 * #io_vcan_ctrl.
+	 */
+	int rxsignal;
 #if !LELY_NO_THREADS
 	/**
 	 * The mutex protecting the channel and the queues of pending
@@ -241,7 +352,16 @@ static inline struct io_vcan_chan *io_vcan_chan_from_chan(
 static inline struct io_vcan_chan *io_vcan_chan_from_svc(
 		const struct io_svc *svc);
 
-static void io_vcan_chan_signal(struct spscring *ring, void *arg);
+static void io_vcan_chan_do_signal(struct io_vcan_chan *vcan);
+static int io_vcan_chan_do_get(
+		struct io_vcan_chan *vcan, struct io_vcan_frame *frame);
+static size_t io_vcan_chan_do_getv(struct io_vcan_chan *vcan,
+		struct can_msg *msgs, struct timespec *tps, size_t n);
+
+static void io_vcan_chan_submit_read_task(
+		io_can_chan_t *chan, struct ev_task *task);
+static void io_vcan_chan_submit_write_task(
+		io_can_chan_t *chan, struct ev_task *task);
 
 static void io_vcan_chan_do_pop(struct io_vcan_chan *vcan,
 		struct sllist *read_queue, struct sllist *write_queue,
@@ -288,9 +408,7 @@ io_vcan_ctrl_init(io_can_ctrl_t *ctrl, io_clock_t *clock, int flags,
 	(void)data;
 #endif
 
-#if !LELY_NO_THREADS
 	int errc = 0;
-#endif
 
 	vcan->ctrl_vptr = &io_vcan_ctrl_vtbl;
 
@@ -308,8 +426,23 @@ io_vcan_ctrl_init(io_can_ctrl_t *ctrl, io_clock_t *clock, int flags,
 		errc = get_errc();
 		goto error_init_cond;
 	}
+
+	if (mtx_init(&vcan->rxmtx, mtx_plain) != thrd_success) {
+		errc = get_errc();
+		goto error_init_rxmtx;
+	}
 #endif
 
+	vcan->rxlen = LELY_IO_VCAN_RXLEN;
+	vcan->rxbuf = calloc(vcan->rxlen, sizeof(struct io_vcan_frame));
+	if (!vcan->rxbuf) {
+#if !LELY_NO_ERRNO
+		errc = errno2c(errno);
+#endif
+		goto error_alloc_rxbuf;
+	}
+	vcan->rxhead = 0;
+
 	vcan->stopped = state == CAN_STATE_STOPPED;
 	vcan->nominal = nominal;
 	vcan->data = 0;
@@ -321,16 +454,32 @@ io_vcan_ctrl_init(io_can_ctrl_t *ctrl, io_clock_t *clock, int flags,
 
 	sllist_init(&vcan->list);
 
+	vcan->sim = 0;
+	vcan->sim_buf = NULL;
+	vcan->sim_len = 0;
+	vcan->sim_n = 0;
+	vcan->sim_busy = 0;
+	vcan->sim_start = (struct timespec){ 0, 0 };
+	vcan->sim_idle = (struct timespec){ 0, 0 };
+	vcan->sim_begin = (struct timespec){ 0, 0 };
+	vcan->sim_now = (struct timespec){ 0, 0 };
+	vcan->sim_stats = (struct io_vcan_sim_stats){ 0, 0, 0, 0, 0, 0 };
+	vcan->sim_id_stats = NULL;
+
 	return ctrl;
 
+	// free(vcan->rxbuf);
+error_alloc_rxbuf:
 #if !LELY_NO_THREADS
-	// cnd_destroy(&vcan->cond);
+	mtx_destroy(&vcan->rxmtx);
+error_init_rxmtx:
+	cnd_destroy(&vcan->cond);
 error_init_cond:
 	mtx_destroy(&vcan->mtx);
 error_init_mtx:
+#endif
 	set_errc(errc);
 	return NULL;
-#endif
 }
 
 void
@@ -340,9 +489,13 @@ io_vcan_ctrl_fini(io_can_ctrl_t *ctrl)
 
 	assert(sllist_empty(&vcan->list));
 
-#if LELY_NO_THREADS
-	(void)vcan;
-#else
+	free(vcan->sim_id_stats);
+	free(vcan->sim_buf);
+
+	free(vcan->rxbuf);
+
+#if !LELY_NO_THREADS
+	mtx_destroy(&vcan->rxmtx);
 	cnd_destroy(&vcan->cond);
 	mtx_destroy(&vcan->mtx);
 #endif
@@ -429,6 +582,170 @@ io_vcan_ctrl_write_err(
 	return io_vcan_ctrl_write(ctrl, NULL, NULL, err, timeout);
 }
 
+int
+io_vcan_ctrl_enable_sim(io_can_ctrl_t *ctrl, size_t txlen)
+{
+	struct io_vcan_ctrl *vcan = io_vcan_ctrl_from_ctrl(ctrl);
+
+	if (!txlen)
+		txlen = LELY_IO_VCAN_TXLEN;
+
+	int errc = 0;
+
+	struct timespec now = { 0, 0 };
+	if (io_clock_gettime(vcan->clock, &now) == -1)
+		return -1;
+
+	struct io_vcan_sim_id_stats *sim_id_stats = calloc(
+			CAN_MASK_BID + 1, sizeof(struct io_vcan_sim_id_stats));
+	if (!sim_id_stats) {
+#if !LELY_NO_ERRNO
+		errc = errno2c(errno);
+#endif
+		goto error_alloc_sim_id_stats;
+	}
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->mtx);
+#endif
+	if (!vcan->sim || vcan->sim_len < txlen) {
+		struct io_vcan_sim_frame *sim_buf = realloc(
+				vcan->sim_buf, txlen * sizeof(*sim_buf));
+		if (!sim_buf) {
+#if !LELY_NO_ERRNO
+			errc = errno2c(errno);
+#endif
+			goto error_alloc_sim_buf;
+		}
+		vcan->sim_buf = sim_buf;
+	}
+	if (!vcan->sim) {
+		vcan->sim = 1;
+		vcan->sim_n = 0;
+		vcan->sim_busy = 0;
+		vcan->sim_idle = now;
+	}
+	vcan->sim_len = txlen;
+
+	vcan->sim_begin = now;
+	vcan->sim_now = now;
+	vcan->sim_stats = (struct io_vcan_sim_stats){ 0, 0, 0, 0, 0, 0 };
+	vcan->sim_stats.npending = vcan->sim_n + vcan->sim_busy;
+	free(vcan->sim_id_stats);
+	vcan->sim_id_stats = sim_id_stats;
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan->mtx);
+#endif
+
+	return 0;
+
+error_alloc_sim_buf:
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan->mtx);
+#endif
+	free(sim_id_stats);
+error_alloc_sim_id_stats:
+	set_errc(errc);
+	return -1;
+}
+
+void
+io_vcan_ctrl_disable_sim(io_can_ctrl_t *ctrl)
+{
+	struct io_vcan_ctrl *vcan = io_vcan_ctrl_from_ctrl(ctrl);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->mtx);
+#endif
+	if (vcan->sim) {
+		// Deliver all queued frames.
+		io_vcan_ctrl_sim_do_flush(vcan, NULL);
+		vcan->sim = 0;
+		// Wake up any blocked writers, so they can continue without
+		// the simulation.
+		io_vcan_ctrl_do_signal(vcan);
+	}
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan->mtx);
+#endif
+}
+
+int
+io_vcan_ctrl_sim_flush(io_can_ctrl_t *ctrl, struct timespec *next)
+{
+	struct io_vcan_ctrl *vcan = io_vcan_ctrl_from_ctrl(ctrl);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->mtx);
+#endif
+	int result = 0;
+	if (vcan->sim) {
+		// Obtain the current time while holding the lock, so it cannot
+		// precede the arrival time of any queued frame.
+		struct timespec now = { 0, 0 };
+		if (io_clock_gettime(vcan->clock, &now) == -1) {
+#if !LELY_NO_THREADS
+			mtx_unlock(&vcan->mtx);
+#endif
+			return -1;
+		}
+		io_vcan_ctrl_sim_do_flush(vcan, &now);
+		// If any frames are still queued, one of them is on the bus.
+		assert(vcan->sim_busy || !vcan->sim_n);
+		if ((result = vcan->sim_busy) && next) {
+			*next = vcan->sim_start;
+			timespec_add_nsec(next, vcan->sim_cur.nsec);
+		}
+	}
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan->mtx);
+#endif
+
+	return result;
+}
+
+void
+io_vcan_ctrl_get_sim_stats(
+		const io_can_ctrl_t *ctrl, struct io_vcan_sim_stats *stats)
+{
+	const struct io_vcan_ctrl *vcan = io_vcan_ctrl_from_ctrl(ctrl);
+	assert(stats);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&vcan->mtx);
+#endif
+	*stats = vcan->sim_stats;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&vcan->mtx);
+#endif
+}
+
+int
+io_vcan_ctrl_get_sim_id_stats(const io_can_ctrl_t *ctrl, uint_least32_t id,
+		struct io_vcan_sim_id_stats *stats)
+{
+	const struct io_vcan_ctrl *vcan = io_vcan_ctrl_from_ctrl(ctrl);
+	assert(stats);
+
+	if (id > CAN_MASK_BID) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&vcan->mtx);
+#endif
+	if (vcan->sim_id_stats)
+		*stats = vcan->sim_id_stats[id];
+	else
+		*stats = (struct io_vcan_sim_id_stats){ 0, 0, 0 };
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&vcan->mtx);
+#endif
+
+	return 0;
+}
+
 void *
 io_vcan_chan_alloc(void)
 {
@@ -463,7 +780,9 @@ io_vcan_chan_init(io_can_chan_t *chan, io_ctx_t *ctx, ev_exec_t *exec,
 	if (!rxlen)
 		rxlen = LELY_IO_VCAN_RXLEN;
 
+#if !LELY_NO_THREADS
 	int errc = 0;
+#endif
 
 	vcan->dev_vptr = &io_vcan_chan_dev_vtbl;
 	vcan->chan_vptr = &io_vcan_chan_vtbl;
@@ -478,14 +797,11 @@ io_vcan_chan_init(io_can_chan_t *chan, io_ctx_t *ctx, ev_exec_t *exec,
 	vcan->write_task = (struct ev_task)EV_TASK_INIT(
 			vcan->exec, &io_vcan_chan_write_task_func);
 
-	spscring_init(&vcan->rxring, rxlen);
-	vcan->rxbuf = calloc(rxlen, sizeof(struct io_vcan_frame));
-	if (!vcan->rxbuf) {
-#if !LELY_NO_ERRNO
-		errc = errno2c(errno);
-#endif
-		goto error_alloc_rxbuf;
-	}
+	vcan->rxlen = rxlen;
+	vcan->rxtail = 0;
+	vcan->rxdrop = 0;
+	vcan->rxwait = 0;
+	vcan->rxsignal = 0;
 
 #if !LELY_NO_THREADS
 	if (mtx_init(&vcan->mtx, mtx_plain) != thrd_success) {
@@ -520,11 +836,9 @@ io_vcan_chan_init(io_can_chan_t *chan, io_ctx_t *ctx, ev_exec_t *exec,
 error_init_cond:
 	mtx_destroy(&vcan->mtx);
 error_init_mtx:
-#endif
-	free(vcan->rxbuf);
-error_alloc_rxbuf:
 	set_errc(errc);
 	return NULL;
+#endif
 }
 
 void
@@ -539,10 +853,6 @@ io_vcan_chan_fini(io_can_chan_t *chan)
 	// Cancel all pending tasks.
 	io_vcan_chan_svc_shutdown(&vcan->svc);
 
-	// Abort any consumer wait operation. Any producer wait operation was
-	// canceled when the channel was closed.
-	spscring_c_abort_wait(&vcan->rxring);
-
 #if !LELY_NO_THREADS
 	int warning = 0;
 	mtx_lock(&vcan->mtx);
@@ -565,8 +875,6 @@ io_vcan_chan_fini(io_can_chan_t *chan)
 	cnd_destroy(&vcan->cond);
 	mtx_destroy(&vcan->mtx);
 #endif
-
-	free(vcan->rxbuf);
 }
 
 io_can_chan_t *
@@ -621,6 +929,28 @@ io_vcan_chan_get_ctrl(const io_can_chan_t *chan)
 	return ctrl;
 }
 
+size_t
+io_vcan_chan_get_ndropped(const io_can_chan_t *chan)
+{
+	const struct io_vcan_chan *vcan = io_vcan_chan_from_chan(chan);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&vcan->mtx);
+	struct io_vcan_ctrl *ctrl =
+			vcan->ctrl ? io_vcan_ctrl_from_ctrl(vcan->ctrl) : NULL;
+	if (ctrl)
+		mtx_lock(&ctrl->rxmtx);
+#endif
+	size_t ndropped = vcan->rxdrop;
+#if !LELY_NO_THREADS
+	if (ctrl)
+		mtx_unlock(&ctrl->rxmtx);
+	mtx_unlock((mtx_t *)&vcan->mtx);
+#endif
+
+	return ndropped;
+}
+
 void
 io_vcan_chan_open(io_can_chan_t *chan, io_can_ctrl_t *ctrl)
 {
@@ -791,9 +1121,36 @@ io_vcan_ctrl_insert(io_can_ctrl_t *ctrl, io_can_chan_t *chan)
 #if !LELY_NO_THREADS
 	mtx_lock(&vcan_ctrl->mtx);
 #endif
+	// Grow the shared receive queue if the channel allows more unread
+	// frames than it can hold. If this fails, the number of unread frames
+	// is limited by the current length of the queue.
+	size_t rxlen = vcan_ctrl->rxlen;
+	struct io_vcan_frame *rxbuf = NULL;
+	if (vcan_chan->rxlen > rxlen) {
+		rxlen = vcan_chan->rxlen;
+		rxbuf = calloc(rxlen, sizeof(struct io_vcan_frame));
+	}
 	sllist_push_back(&vcan_ctrl->list, &vcan_chan->node);
 #if !LELY_NO_THREADS
 	mtx_lock(&vcan_chan->mtx);
+	mtx_lock(&vcan_ctrl->rxmtx);
+#endif
+	if (rxbuf) {
+		// Move the most recent frames to the new queue.
+		uint_least64_t seq = vcan_ctrl->rxhead > vcan_ctrl->rxlen
+				? vcan_ctrl->rxhead - vcan_ctrl->rxlen
+				: 0;
+		for (; seq < vcan_ctrl->rxhead; seq++)
+			rxbuf[seq % rxlen] = vcan_ctrl->rxbuf
+					[seq % vcan_ctrl->rxlen];
+		free(vcan_ctrl->rxbuf);
+		vcan_ctrl->rxbuf = rxbuf;
+		vcan_ctrl->rxlen = rxlen;
+	}
+	// The channel only receives frames written after it was registered.
+	vcan_chan->rxtail = vcan_ctrl->rxhead;
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan_ctrl->rxmtx);
 #endif
 	vcan_chan->ctrl = ctrl;
 	vcan_chan->stopped = vcan_ctrl->stopped;
@@ -819,8 +1176,6 @@ io_vcan_ctrl_remove(io_can_ctrl_t *ctrl, io_can_chan_t *chan)
 	mtx_lock(&vcan_ctrl->mtx);
 #endif
 	if (sllist_remove(&vcan_ctrl->list, &vcan_chan->node)) {
-		// Abort any wait operation started by io_vcan_ctrl_write().
-		spscring_p_abort_wait(&vcan_chan->rxring);
 #if !LELY_NO_THREADS
 		mtx_lock(&vcan_chan->mtx);
 #endif
@@ -842,15 +1197,10 @@ io_vcan_ctrl_remove(io_can_ctrl_t *ctrl, io_can_chan_t *chan)
 }
 
 static void
-io_vcan_ctrl_signal(struct spscring *ring, void *arg)
+io_vcan_ctrl_do_signal(struct io_vcan_ctrl *vcan)
 {
-	(void)ring;
-	struct io_vcan_ctrl *vcan = arg;
 	assert(vcan);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&vcan->mtx);
-#endif
 	// Post the write tasks of all channels, if necessary, to process any
 	// pending write operations.
 	sllist_foreach (&vcan->list, node) {
@@ -870,10 +1220,58 @@ io_vcan_ctrl_signal(struct spscring *ring, void *arg)
 #if !LELY_NO_THREADS
 	// Wake up all threads waiting for this signal.
 	cnd_broadcast(&vcan->cond);
-	mtx_unlock(&vcan->mtx);
 #endif
 }
 
+static void
+io_vcan_ctrl_do_put(
+		struct io_vcan_ctrl *vcan, const struct io_vcan_frame *frame)
+{
+	assert(vcan);
+	assert(frame);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->rxmtx);
+#endif
+	sllist_foreach (&vcan->list, node) {
+		struct io_vcan_chan *chan =
+				structof(node, struct io_vcan_chan, node);
+		// Like a real CAN controller, do not wait for slow readers.
+		// Instead, drop the oldest unread frame if the channel has
+		// fallen too far behind.
+		size_t rxlen = MIN(chan->rxlen, vcan->rxlen);
+		if (vcan->rxhead - chan->rxtail >= rxlen) {
+			const struct io_vcan_frame *tail = &vcan->rxbuf
+					[chan->rxtail++ % vcan->rxlen];
+			// A channel does not receive its own frames, so those
+			// are not lost.
+			if (tail->chan != &chan->chan_vptr) {
+				chan->rxdrop++;
+				if (vcan->sim)
+					vcan->sim_stats.ndropped++;
+			}
+		}
+		// Only signal the channels waiting for a frame.
+		if (chan->rxwait && frame->chan != &chan->chan_vptr) {
+			chan->rxwait = 0;
+			chan->rxsignal = 1;
+		}
+	}
+	vcan->rxbuf[vcan->rxhead++ % vcan->rxlen] = *frame;
+#if !LELY_NO_THREADS
+	mtx_unlock(&vcan->rxmtx);
+#endif
+
+	sllist_foreach (&vcan->list, node) {
+		struct io_vcan_chan *chan =
+				structof(node, struct io_vcan_chan, node);
+		if (chan->rxsignal) {
+			chan->rxsignal = 0;
+			io_vcan_chan_do_signal(chan);
+		}
+	}
+}
+
 static int
 io_vcan_ctrl_write(io_can_ctrl_t *ctrl, io_can_chan_t *chan,
 		const struct can_msg *msg, const struct can_err *err,
@@ -932,71 +1330,68 @@ io_vcan_ctrl_write(io_can_ctrl_t *ctrl, io_can_chan_t *chan,
 		return -1;
 	}
 
-	// Check if all registered channels have a slot available in their
-	// receive queue.
-	for (;;) {
-		struct io_vcan_chan *vcan_chan = NULL;
-		int wouldblock = 0;
-		sllist_foreach (&vcan_ctrl->list, node) {
-			vcan_chan = structof(node, struct io_vcan_chan, node);
-			// Skip the sending channel.
-			if (chan && chan == &vcan_chan->chan_vptr)
-				continue;
-			// Try to allocate a single slot.
-			size_t n = 1;
-			spscring_p_alloc(&vcan_chan->rxring, &n);
-			if (!n) {
-				wouldblock = 1;
-				break;
-			}
-		}
-		// If all channels are ready, continue below with writing the
-		// frame.
-		if (!wouldblock)
-			break;
-		// Always submit a wait operation, even when timeout is 0, so
-		// pending write operations will be signaled once the blocked
-		// channel becomes ready.
-		// clang-format off
-		if (!spscring_p_submit_wait(&vcan_chan->rxring, 1,
-				&io_vcan_ctrl_signal, vcan_ctrl))
-			// clang-format on
-			// If the wait condition was already sastisfied, try
-			// again.
-			continue;
-		// Wait for the blocked channel to signal it is ready, or time
-		// out if that takes too long.
-		if (!timeout) {
+	// If the bus timing simulation is enabled, queue the frame for
+	// transmission instead of delivering it immediately.
+	while (msg && vcan_ctrl->sim) {
+		struct timespec now = { 0, 0 };
+		if (io_clock_gettime(vcan_ctrl->clock, &now) == -1) {
 #if !LELY_NO_THREADS
 			mtx_unlock(&vcan_ctrl->mtx);
 #endif
-			set_errnum(ERRNUM_AGAIN);
 			return -1;
 		}
+		io_vcan_ctrl_sim_do_flush(vcan_ctrl, &now);
+		if (vcan_ctrl->sim_n < vcan_ctrl->sim_len) {
+			vcan_ctrl->sim_buf[vcan_ctrl->sim_n++] =
+					(struct io_vcan_sim_frame){
+						.msg = *msg,
+						.ts = now,
+						.chan = chan,
+						.key = io_vcan_sim_key(msg),
+						.nsec = io_vcan_ctrl_sim_nsec(
+								vcan_ctrl, msg)
+					};
+			vcan_ctrl->sim_stats.npending++;
+			// Start the transmission if the bus is idle.
+			io_vcan_ctrl_sim_do_flush(vcan_ctrl, &now);
 #if !LELY_NO_THREADS
-		int result;
+			mtx_unlock(&vcan_ctrl->mtx);
+#endif
+			return 0;
+		}
+		// Wait for the transmission queue to drain, or time out if
+		// that takes too long.
+#if !LELY_NO_THREADS
+		int result = thrd_timedout;
+		if (timeout) {
 #if !LELY_NO_TIMEOUT
-		if (timeout > 0)
-			result = cnd_timedwait(
-					&vcan_ctrl->cond, &vcan_ctrl->mtx, &ts);
-		else
+			if (timeout > 0)
+				result = cnd_timedwait(&vcan_ctrl->cond,
+						&vcan_ctrl->mtx, &ts);
+			else
 #endif
-			result = cnd_wait(&vcan_ctrl->cond, &vcan_ctrl->mtx);
+				result = cnd_wait(&vcan_ctrl->cond,
+						&vcan_ctrl->mtx);
+		}
 		if (result != thrd_success) {
 			mtx_unlock(&vcan_ctrl->mtx);
-#if !LELY_NO_TIMEOUT
 			if (result == thrd_timedout)
 				set_errnum(ERRNUM_AGAIN);
-#endif
 			return -1;
 		}
+		if (vcan_ctrl->stopped) {
+			mtx_unlock(&vcan_ctrl->mtx);
+			set_errnum(ERRNUM_NETDOWN);
+			return -1;
+		}
+#else
+		set_errnum(ERRNUM_AGAIN);
+		return -1;
 #endif
 	}
 
-	// Obtain a timestamp for the CAN frame. We obtain it here, after
-	// waiting above, so the timestamp reflects the actual time the frame
-	// was put on the bus. This guarantees that all frames are ordered in
-	// time.
+	// Obtain a timestamp for the CAN frame. We obtain it while holding the
+	// mutex, so all frames are ordered in time.
 	if (io_clock_gettime(vcan_ctrl->clock, &ts) == -1) {
 #if !LELY_NO_THREADS
 		mtx_unlock(&vcan_ctrl->mtx);
@@ -1004,29 +1399,20 @@ io_vcan_ctrl_write(io_can_ctrl_t *ctrl, io_can_chan_t *chan,
 		return -1;
 	}
 
-	// Put the frame in the receive queue of every channel.
-	sllist_foreach (&vcan_ctrl->list, node) {
-		struct io_vcan_chan *vcan_chan =
-				structof(node, struct io_vcan_chan, node);
-		// Skip the sending channel.
-		if (chan && chan == &vcan_chan->chan_vptr)
-			continue;
-
-		size_t n = 1;
-		size_t i = spscring_p_alloc(&vcan_chan->rxring, &n);
-		// We did not release the mutex after checking that all channels
-		// are ready, so this cannot fail.
-		assert(n == 1);
-		if (msg)
-			vcan_chan->rxbuf[i] = (struct io_vcan_frame){
-				.is_err = 0, .u.msg = *msg, .ts = ts
-			};
-		else
-			vcan_chan->rxbuf[i] = (struct io_vcan_frame){
-				.is_err = 1, .u.err = *err, .ts = ts
-			};
-		spscring_p_commit(&vcan_chan->rxring, n);
-	}
+	// Put the frame in the shared receive queue. This never blocks;
+	// channels that cannot keep up lose their oldest frames instead.
+	if (msg)
+		io_vcan_ctrl_do_put(vcan_ctrl,
+				&(struct io_vcan_frame){ .is_err = 0,
+						.u.msg = *msg,
+						.ts = ts,
+						.chan = chan });
+	else
+		io_vcan_ctrl_do_put(vcan_ctrl,
+				&(struct io_vcan_frame){ .is_err = 1,
+						.u.err = *err,
+						.ts = ts,
+						.chan = chan });
 
 #if !LELY_NO_THREADS
 	mtx_unlock(&vcan_ctrl->mtx);
@@ -1043,6 +1429,11 @@ io_vcan_ctrl_do_stop(struct io_vcan_ctrl *vcan_ctrl)
 	vcan_ctrl->stopped = 1;
 	vcan_ctrl->state = CAN_STATE_STOPPED;
 
+	// Discard all frames queued for transmission.
+	vcan_ctrl->sim_n = 0;
+	vcan_ctrl->sim_busy = 0;
+	vcan_ctrl->sim_stats.npending = 0;
+
 	struct sllist read_queue, write_queue;
 	sllist_init(&read_queue);
 	sllist_init(&write_queue);
@@ -1067,6 +1458,151 @@ io_vcan_ctrl_do_stop(struct io_vcan_ctrl *vcan_ctrl)
 	io_can_chan_write_queue_post(&write_queue, errnum2c(ERRNUM_NETDOWN));
 }
 
+static uint_least64_t
+io_vcan_ctrl_sim_nsec(
+		const struct io_vcan_ctrl *vcan, const struct can_msg *msg)
+{
+	assert(vcan);
+	assert(msg);
+
+	// The number of bits transmitted at the nominal bitrate and, for CAN
+	// FD frames with bitrate switching, at the data bitrate.
+	uint_least64_t nominal = 0;
+	uint_least64_t data = 0;
+#if !LELY_NO_CANFD
+	if (msg->flags & CAN_FLAG_FDF) {
+		// Estimate the size of a CAN FD frame: the arbitration field,
+		// the trailer and the interframe space are transmitted at the
+		// nominal bitrate. The data phase (ESI, DLC, data, stuff count
+		// and CRC) is transmitted at the data bitrate and, like the
+		// rest of the frame, is assumed to contain 20% stuff bits.
+		nominal = (msg->flags & CAN_FLAG_IDE) ? 36 : 17;
+		nominal += 13;
+		data = 5 + msg->len * 8 + 4 + (msg->len > 16 ? 21 : 17);
+		if (msg->flags & CAN_FLAG_BRS && vcan->data) {
+			nominal = nominal * 6 / 5;
+			data = data * 6 / 5;
+		} else {
+			nominal = (nominal + data) * 6 / 5;
+			data = 0;
+		}
+	} else {
+#endif
+		int bits = can_msg_bits(msg, CAN_MSG_BITS_MODE_EXACT);
+		nominal = bits > 0 ? (uint_least64_t)bits : 0;
+#if !LELY_NO_CANFD
+	}
+#endif
+
+	uint_least64_t nsec = 0;
+	if (vcan->nominal > 0)
+		nsec += (nominal * 1000000000u + vcan->nominal - 1)
+				/ vcan->nominal;
+	if (data && vcan->data > 0)
+		nsec += (data * 1000000000u + vcan->data - 1) / vcan->data;
+	return nsec;
+}
+
+static void
+io_vcan_ctrl_sim_do_flush(struct io_vcan_ctrl *vcan, const struct timespec *now)
+{
+	assert(vcan);
+	assert(vcan->sim);
+
+	// Frames are only delivered when this function is invoked; the user is
+	// responsible for invoking io_vcan_ctrl_sim_flush() when the
+	// transmission of the current frame completes.
+	if (now && timespec_cmp(now, &vcan->sim_now) > 0)
+		vcan->sim_now = *now;
+
+	int released = 0;
+	for (;;) {
+		if (!vcan->sim_busy) {
+			if (!vcan->sim_n)
+				break;
+			// The next transmission starts once the bus is idle
+			// and the oldest queued frame has arrived.
+			struct timespec start = vcan->sim_idle;
+			if (timespec_cmp(&vcan->sim_buf[0].ts, &start) > 0)
+				start = vcan->sim_buf[0].ts;
+			if (now && timespec_cmp(&start, now) > 0)
+				break;
+			// All frames queued before the start of the
+			// transmission take part in the arbitration. Frames
+			// with the same arbitration field are sent in order of
+			// arrival.
+			size_t k = 0;
+			for (size_t i = 1; i < vcan->sim_n; i++) {
+				const struct io_vcan_sim_frame *frame =
+						&vcan->sim_buf[i];
+				if (timespec_cmp(&frame->ts, &start) > 0)
+					break;
+				if (frame->key < vcan->sim_buf[k].key)
+					k = i;
+			}
+			vcan->sim_cur = vcan->sim_buf[k];
+			size_t n = vcan->sim_n - k - 1;
+			memmove(vcan->sim_buf + k, vcan->sim_buf + k + 1,
+					n * sizeof(*vcan->sim_buf));
+			vcan->sim_n--;
+			vcan->sim_busy = 1;
+			vcan->sim_start = start;
+			released = 1;
+		}
+
+		struct timespec end = vcan->sim_start;
+		timespec_add_nsec(&end, vcan->sim_cur.nsec);
+		if (now && timespec_cmp(&end, now) > 0)
+			break;
+		vcan->sim_busy = 0;
+		vcan->sim_idle = end;
+		if (timespec_cmp(&end, &vcan->sim_now) > 0)
+			vcan->sim_now = end;
+
+		// Update the statistics.
+		uint_least64_t delay = (uint_least64_t)timespec_diff_nsec(
+				&vcan->sim_start, &vcan->sim_cur.ts);
+		struct io_vcan_sim_stats *stats = &vcan->sim_stats;
+		stats->nframes++;
+		stats->npending--;
+		stats->busy_nsec += vcan->sim_cur.nsec;
+		if (delay > stats->max_delay_nsec)
+			stats->max_delay_nsec = delay;
+		if (!(vcan->sim_cur.msg.flags & CAN_FLAG_IDE)) {
+			struct io_vcan_sim_id_stats *id_stats =
+					&vcan->sim_id_stats[vcan->sim_cur.msg.id
+							& CAN_MASK_BID];
+			id_stats->nframes++;
+			id_stats->delay_nsec += delay;
+			if (delay > id_stats->max_delay_nsec)
+				id_stats->max_delay_nsec = delay;
+		}
+
+		io_vcan_ctrl_sim_do_put(vcan, &vcan->sim_cur, &end);
+	}
+	vcan->sim_stats.elapsed_nsec = (uint_least64_t)timespec_diff_nsec(
+			&vcan->sim_now, &vcan->sim_begin);
+
+	// Wake up any writers waiting for a slot in the transmission queue.
+	if (released)
+		io_vcan_ctrl_do_signal(vcan);
+}
+
+static void
+io_vcan_ctrl_sim_do_put(struct io_vcan_ctrl *vcan,
+		const struct io_vcan_sim_frame *frame,
+		const struct timespec *ts)
+{
+	assert(vcan);
+	assert(frame);
+	assert(ts);
+
+	io_vcan_ctrl_do_put(vcan, &(struct io_vcan_frame){ .is_err = 0,
+						.u.msg = frame->msg,
+						.ts = *ts,
+						.chan = frame->chan });
+}
+
 static io_ctx_t *
 io_vcan_chan_dev_get_ctx(const io_dev_t *dev)
 {
@@ -1178,12 +1714,12 @@ io_vcan_chan_read(io_can_chan_t *chan, struct can_msg *msg, struct can_err *err,
 #if !LELY_NO_THREADS
 	mtx_lock(&vcan->mtx);
 #endif
-	size_t i = 0;
+	struct io_vcan_frame frame;
 	for (;;) {
-		// Check if a frame is available in the receive queue.
-		size_t n = 1;
-		i = spscring_c_alloc(&vcan->rxring, &n);
-		if (n)
+		// Check if a frame is available in the receive queue. If not,
+		// this registers a wait operation, so pending read operations
+		// will be signaled once a frame is available.
+		if (io_vcan_chan_do_get(vcan, &frame))
 			break;
 		// Return the same error as SocketCAN when the channel is
 		// closed.
@@ -1203,18 +1739,8 @@ io_vcan_chan_read(io_can_chan_t *chan, struct can_msg *msg, struct can_err *err,
 			set_errnum(ERRNUM_NETDOWN);
 			return -1;
 		}
-		// Always submit a wait operation, even when timeout is 0, so
-		// pending read operations will be signaled once a frame is
-		// available.
-		// clang-format off
-		if (!spscring_c_submit_wait(&vcan->rxring, 1,
-				&io_vcan_chan_signal, vcan))
-			// clang-format on
-			// If the wait condition was already satisfied, try
-			// again.
-			continue;
-		// Wait for the buffer to signal that a frame is available, or
-		// time out if that takes too long.
+		// Wait for the controller to signal that a frame is available,
+		// or time out if that takes too long.
 		if (!timeout) {
 #if !LELY_NO_THREADS
 			mtx_unlock(&vcan->mtx);
@@ -1240,65 +1766,27 @@ io_vcan_chan_read(io_can_chan_t *chan, struct can_msg *msg, struct can_err *err,
 		}
 #endif
 	}
-	// Copy the frame from the buffer.
-	struct io_vcan_frame *frame = &vcan->rxbuf[i];
-	int is_err = frame->is_err;
-	if (!is_err && msg)
-		*msg = frame->u.msg;
-	else if (is_err && err)
-		*err = frame->u.err;
-	if (tp)
-		*tp = frame->ts;
-	spscring_c_commit(&vcan->rxring, 1);
 #if !LELY_NO_THREADS
 	mtx_unlock(&vcan->mtx);
 #endif
 
+	int is_err = frame.is_err;
+	if (!is_err && msg)
+		*msg = frame.u.msg;
+	else if (is_err && err)
+		*err = frame.u.err;
+	if (tp)
+		*tp = frame.ts;
+
 	return !is_err;
 }
 
 static void
 io_vcan_chan_submit_read(io_can_chan_t *chan, struct io_can_chan_read *read)
 {
-	struct io_vcan_chan *vcan = io_vcan_chan_from_chan(chan);
 	assert(read);
-	struct ev_task *task = &read->task;
-
-	if (!task->exec)
-		task->exec = vcan->exec;
-	ev_exec_on_task_init(task->exec);
 
-#if !LELY_NO_THREADS
-	mtx_lock(&vcan->mtx);
-#endif
-	if (vcan->shutdown) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_read_post(read, -1, errnum2c(ERRNUM_CANCELED));
-	} else if (!vcan->ctrl) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_read_post(read, -1, errnum2c(ERRNUM_BADF));
-	} else if (vcan->stopped) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_read_post(read, -1, errnum2c(ERRNUM_NETDOWN));
-	} else {
-		int post_read = !vcan->read_posted
-				&& sllist_empty(&vcan->read_queue);
-		sllist_push_back(&vcan->read_queue, &task->_node);
-		if (post_read)
-			vcan->read_posted = 1;
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		// cppcheck-suppress duplicateCondition
-		if (post_read)
-			ev_exec_post(vcan->read_task.exec, &vcan->read_task);
-	}
+	io_vcan_chan_submit_read_task(chan, &read->task);
 }
 
 static int
@@ -1315,45 +1803,26 @@ io_vcan_chan_write(io_can_chan_t *chan, const struct can_msg *msg, int timeout)
 static void
 io_vcan_chan_submit_write(io_can_chan_t *chan, struct io_can_chan_write *write)
 {
-	struct io_vcan_chan *vcan = io_vcan_chan_from_chan(chan);
 	assert(write);
-	struct ev_task *task = &write->task;
 
-	if (!task->exec)
-		task->exec = vcan->exec;
-	ev_exec_on_task_init(task->exec);
+	io_vcan_chan_submit_write_task(chan, &write->task);
+}
 
-#if !LELY_NO_THREADS
-	mtx_lock(&vcan->mtx);
-#endif
-	if (vcan->shutdown) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_CANCELED));
-	} else if (!vcan->ctrl) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_BADF));
-	} else if (vcan->stopped) {
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		io_can_chan_write_post(write, errnum2c(ERRNUM_NETDOWN));
-	} else {
-		int post_write = !vcan->write_posted
-				&& sllist_empty(&vcan->write_queue);
-		sllist_push_back(&vcan->write_queue, &task->_node);
-		if (post_write)
-			vcan->write_posted = 1;
-#if !LELY_NO_THREADS
-		mtx_unlock(&vcan->mtx);
-#endif
-		// cppcheck-suppress duplicateCondition
-		if (post_write)
-			ev_exec_post(vcan->write_task.exec, &vcan->write_task);
-	}
+static void
+io_vcan_chan_submit_readv(io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	assert(readv);
+
+	io_vcan_chan_submit_read_task(chan, &readv->task);
+}
+
+static void
+io_vcan_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	assert(writev);
+
+	io_vcan_chan_submit_write_task(chan, &writev->task);
 }
 
 static void
@@ -1393,33 +1862,37 @@ io_vcan_chan_read_task_func(struct ev_task *task)
 	vcan->read_posted = 0;
 	// Try to process all pending read operations at once.
 	while ((task = ev_task_from_node(sllist_first(&vcan->read_queue)))) {
-		// Check if a frame is available in the receive queue.
-		size_t n = 1;
-		size_t i = spscring_c_alloc(&vcan->rxring, &n);
-		if (!n) {
-			// If the queue is empty, register a wait operation and
+		if (io_can_chan_task_is_vec(task)) {
+			// Copy as many frames as are available at once. If
+			// none are, a wait operation is registered and we
 			// return.
-			// clang-format off
-			if (!spscring_c_submit_wait(&vcan->rxring, 1,
-					io_vcan_chan_signal, vcan))
-				// clang-format on
-				continue;
-			break;
+			struct io_can_chan_readv *readv =
+					io_can_chan_readv_from_task(task);
+			size_t n = io_vcan_chan_do_getv(vcan, readv->msgs,
+					readv->tps, readv->n);
+			if (!n && readv->n)
+				break;
+			sllist_pop_front(&vcan->read_queue);
+			io_can_chan_readv_post(readv, n, 0);
+			continue;
 		}
+
+		// Check if a frame is available in the receive queue. If not,
+		// a wait operation is registered and we return.
+		struct io_vcan_frame frame;
+		if (!io_vcan_chan_do_get(vcan, &frame))
+			break;
 		sllist_pop_front(&vcan->read_queue);
-		struct io_vcan_frame *frame = &vcan->rxbuf[i];
 
 		struct io_can_chan_read *read =
 				io_can_chan_read_from_task(task);
-		if (!frame->is_err && read->msg)
-			*read->msg = frame->u.msg;
-		if (frame->is_err && read->err)
-			*read->err = frame->u.err;
+		if (!frame.is_err && read->msg)
+			*read->msg = frame.u.msg;
+		if (frame.is_err && read->err)
+			*read->err = frame.u.err;
 		if (read->tp)
-			*read->tp = frame->ts;
-		io_can_chan_read_post(read, !frame->is_err, 0);
-
-		spscring_c_commit(&vcan->rxring, 1);
+			*read->tp = frame.ts;
+		io_can_chan_read_post(read, !frame.is_err, 0);
 	}
 #if !LELY_NO_THREADS
 	mtx_unlock(&vcan->mtx);
@@ -1435,7 +1908,6 @@ io_vcan_chan_write_task_func(struct ev_task *task)
 
 	int errsv = get_errc();
 
-	struct io_can_chan_write *write = NULL;
 	int wouldblock = 0;
 
 #if !LELY_NO_THREADS
@@ -1445,19 +1917,18 @@ io_vcan_chan_write_task_func(struct ev_task *task)
 	// Try to process all pending write operations at once.
 	while ((task = vcan->current_write = ev_task_from_node(
 				sllist_pop_front(&vcan->write_queue)))) {
-		write = io_can_chan_write_from_task(task);
 #if !LELY_NO_THREADS
 		mtx_unlock(&vcan->mtx);
 #endif
 		// Perform a non-blocking write.
-		int result = io_vcan_chan_write(
-				&vcan->chan_vptr, write->msg, 0);
+		int result = io_can_chan_task_write(&vcan->chan_vptr, task, 0,
+				&io_vcan_chan_write);
 		int errc = !result ? 0 : get_errc();
 		wouldblock = errc == errnum2c(ERRNUM_AGAIN)
 				|| errc == errnum2c(ERRNUM_WOULDBLOCK);
 		if (!wouldblock)
 			// The operation succeeded or failed immediately.
-			io_can_chan_write_post(write, errc);
+			io_can_chan_write_task_post(task, errc);
 #if !LELY_NO_THREADS
 		mtx_lock(&vcan->mtx);
 #endif
@@ -1488,8 +1959,7 @@ io_vcan_chan_write_task_func(struct ev_task *task)
 	if (task && wouldblock)
 		// The operation would block but was canceled before it could be
 		// requeued.
-		io_can_chan_write_post(io_can_chan_write_from_task(task),
-				errnum2c(ERRNUM_CANCELED));
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_CANCELED));
 
 	if (post_write)
 		ev_exec_post(vcan->write_task.exec, &vcan->write_task);
@@ -1522,10 +1992,8 @@ io_vcan_chan_from_svc(const struct io_svc *svc)
 }
 
 static void
-io_vcan_chan_signal(struct spscring *ring, void *arg)
+io_vcan_chan_do_signal(struct io_vcan_chan *vcan)
 {
-	(void)ring;
-	struct io_vcan_chan *vcan = arg;
 	assert(vcan);
 
 #if !LELY_NO_THREADS
@@ -1543,6 +2011,163 @@ io_vcan_chan_signal(struct spscring *ring, void *arg)
 		ev_exec_post(vcan->read_task.exec, &vcan->read_task);
 }
 
+static int
+io_vcan_chan_do_get(struct io_vcan_chan *vcan, struct io_vcan_frame *frame)
+{
+	assert(vcan);
+	assert(frame);
+
+	if (!vcan->ctrl)
+		return 0;
+	struct io_vcan_ctrl *ctrl = io_vcan_ctrl_from_ctrl(vcan->ctrl);
+
+	int result = 0;
+#if !LELY_NO_THREADS
+	mtx_lock(&ctrl->rxmtx);
+#endif
+	// Skip the frames sent by this channel.
+	while (vcan->rxtail != ctrl->rxhead) {
+		const struct io_vcan_frame *tail =
+				&ctrl->rxbuf[vcan->rxtail++ % ctrl->rxlen];
+		if (tail->chan != &vcan->chan_vptr) {
+			*frame = *tail;
+			result = 1;
+			break;
+		}
+	}
+	// Register a wait operation if the queue is empty. The next writer
+	// will signal the channel.
+	if (!result)
+		vcan->rxwait = 1;
+#if !LELY_NO_THREADS
+	mtx_unlock(&ctrl->rxmtx);
+#endif
+	return result;
+}
+
+static size_t
+io_vcan_chan_do_getv(struct io_vcan_chan *vcan, struct can_msg *msgs,
+		struct timespec *tps, size_t n)
+{
+	assert(vcan);
+	assert(msgs || !n);
+
+	if (!vcan->ctrl)
+		return 0;
+	struct io_vcan_ctrl *ctrl = io_vcan_ctrl_from_ctrl(vcan->ctrl);
+
+	size_t i = 0;
+#if !LELY_NO_THREADS
+	mtx_lock(&ctrl->rxmtx);
+#endif
+	while (i < n && vcan->rxtail != ctrl->rxhead) {
+		const struct io_vcan_frame *tail =
+				&ctrl->rxbuf[vcan->rxtail++ % ctrl->rxlen];
+		// Skip the frames sent by this channel and error frames.
+		if (tail->chan == &vcan->chan_vptr || tail->is_err)
+			continue;
+		msgs[i] = tail->u.msg;
+		if (tps)
+			tps[i] = tail->ts;
+		i++;
+	}
+	if (!i)
+		vcan->rxwait = 1;
+#if !LELY_NO_THREADS
+	mtx_unlock(&ctrl->rxmtx);
+#endif
+	return i;
+}
+
+static void
+io_vcan_chan_submit_read_task(io_can_chan_t *chan, struct ev_task *task)
+{
+	struct io_vcan_chan *vcan = io_vcan_chan_from_chan(chan);
+	assert(task);
+
+	if (!task->exec)
+		task->exec = vcan->exec;
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->mtx);
+#endif
+	if (vcan->shutdown) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_read_task_post(
+				task, -1, errnum2c(ERRNUM_CANCELED));
+	} else if (!vcan->ctrl) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_read_task_post(
+				task, -1, errnum2c(ERRNUM_BADF));
+	} else if (vcan->stopped) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_read_task_post(
+				task, -1, errnum2c(ERRNUM_NETDOWN));
+	} else {
+		int post_read = !vcan->read_posted
+				&& sllist_empty(&vcan->read_queue);
+		sllist_push_back(&vcan->read_queue, &task->_node);
+		if (post_read)
+			vcan->read_posted = 1;
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		// cppcheck-suppress duplicateCondition
+		if (post_read)
+			ev_exec_post(vcan->read_task.exec, &vcan->read_task);
+	}
+}
+
+static void
+io_vcan_chan_submit_write_task(io_can_chan_t *chan, struct ev_task *task)
+{
+	struct io_vcan_chan *vcan = io_vcan_chan_from_chan(chan);
+	assert(task);
+
+	if (!task->exec)
+		task->exec = vcan->exec;
+	ev_exec_on_task_init(task->exec);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vcan->mtx);
+#endif
+	if (vcan->shutdown) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_CANCELED));
+	} else if (!vcan->ctrl) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_BADF));
+	} else if (vcan->stopped) {
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		io_can_chan_write_task_post(task, errnum2c(ERRNUM_NETDOWN));
+	} else {
+		int post_write = !vcan->write_posted
+				&& sllist_empty(&vcan->write_queue);
+		sllist_push_back(&vcan->write_queue, &task->_node);
+		if (post_write)
+			vcan->write_posted = 1;
+#if !LELY_NO_THREADS
+		mtx_unlock(&vcan->mtx);
+#endif
+		// cppcheck-suppress duplicateCondition
+		if (post_write)
+			ev_exec_post(vcan->write_task.exec, &vcan->write_task);
+	}
+}
+
 static void
 io_vcan_chan_do_pop(struct io_vcan_chan *vcan, struct sllist *read_queue,
 		struct sllist *write_queue, struct ev_task *task)
@@ -1589,4 +2214,23 @@ io_vcan_chan_do_abort_tasks(struct io_vcan_chan *vcan)
 	return n;
 }
 
+static uint_least32_t
+io_vcan_sim_key(const struct can_msg *msg)
+{
+	assert(msg);
+
+	// Construct the arbitration field as it appears on the bus, so frames
+	// can be compared bit by bit. For standard frames, this is the 11-bit
+	// identifier followed by the RTR and IDE bits. For extended frames, the
+	// base identifier is followed by the (recessive) SRR and IDE bits, the
+	// 18-bit identifier extension and the RTR bit.
+	uint_least32_t rtr = !!(msg->flags & CAN_FLAG_RTR);
+	if (msg->flags & CAN_FLAG_IDE)
+		return ((msg->id >> 18) & CAN_MASK_BID) << 21
+				| UINT32_C(3) << 19 | (msg->id & 0x3ffff) << 1
+				| rtr;
+	else
+		return (msg->id & CAN_MASK_BID) << 21 | rtr << 20;
+}
+
 #endif // !LELY_NO_MALLOC
@@ -0,0 +1,490 @@
+/**@file
+ * This file is part of the I/O library; it contains the implementation of the
+ * virtual clock.
+ *
+ * @see lely/io2/vclock.h
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "io2.h"
+
+#if !LELY_NO_MALLOC
+
+#if !LELY_NO_THREADS
+#include <lely/libc/threads.h>
+#endif
+#include <lely/io2/user/timer.h>
+#include <lely/io2/vcan.h>
+#include <lely/io2/vclock.h>
+#include <lely/util/errnum.h>
+#include <lely/util/time.h>
+#include <lely/util/util.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static int io_vclock_getres(const io_clock_t *clock, struct timespec *res);
+static int io_vclock_gettime(const io_clock_t *clock, struct timespec *tp);
+static int io_vclock_settime(io_clock_t *clock, const struct timespec *tp);
+
+// clang-format off
+static const struct io_clock_vtbl io_vclock_vtbl = {
+	&io_vclock_getres,
+	&io_vclock_gettime,
+	&io_vclock_settime
+};
+// clang-format on
+
+/// The implementation of a virtual clock.
+struct io_vclock {
+	/// A pointer to the virtual table for the clock interface.
+	const struct io_clock_vtbl *clock_vptr;
+#if !LELY_NO_THREADS
+	/// The mutex protecting #now and the expiration times of the timers.
+	mtx_t mtx;
+#endif
+	/// The current time.
+	struct timespec now;
+	/// The list of timers created by io_vclock_create_timer().
+	struct sllist timers;
+	/// The list of registered virtual CAN controllers.
+	struct sllist ctrls;
+};
+
+/// A timer driven by a virtual clock.
+struct io_vclock_timer {
+	/// The node of the timer in the list of the virtual clock.
+	struct slnode node;
+	/// A pointer to the virtual clock.
+	struct io_vclock *vclock;
+	/// A pointer to the user-defined timer.
+	io_timer_t *timer;
+	/// The next expiration time of the timer, or 0 if it is disarmed.
+	struct timespec next;
+};
+
+/// A virtual CAN controller registered with a virtual clock.
+struct io_vclock_ctrl {
+	/// The node of the controller in the list of the virtual clock.
+	struct slnode node;
+	/// A pointer to the virtual CAN controller.
+	io_can_ctrl_t *ctrl;
+};
+
+static inline struct io_vclock *io_vclock_from_clock(const io_clock_t *clock);
+
+static void io_vclock_timer_setnext(const struct timespec *tp, void *arg);
+
+static int io_vclock_do_settime(
+		struct io_vclock *vclock, const struct timespec *tp);
+
+void *
+io_vclock_alloc(void)
+{
+	struct io_vclock *vclock = malloc(sizeof(*vclock));
+	if (!vclock) {
+#if !LELY_NO_ERRNO
+		set_errc(errno2c(errno));
+#endif
+		return NULL;
+	}
+	// Suppress a GCC maybe-uninitialized warning.
+	vclock->clock_vptr = NULL;
+	// cppcheck-suppress memleak symbolName=vclock
+	return &vclock->clock_vptr;
+}
+
+void
+io_vclock_free(void *ptr)
+{
+	if (ptr)
+		free(io_vclock_from_clock(ptr));
+}
+
+io_clock_t *
+io_vclock_init(io_clock_t *clock, const struct timespec *start)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	vclock->clock_vptr = &io_vclock_vtbl;
+
+#if !LELY_NO_THREADS
+	if (mtx_init(&vclock->mtx, mtx_plain) != thrd_success)
+		return NULL;
+#endif
+
+	vclock->now = start ? *start : (struct timespec){ 0, 0 };
+
+	sllist_init(&vclock->timers);
+	sllist_init(&vclock->ctrls);
+
+	return clock;
+}
+
+void
+io_vclock_fini(io_clock_t *clock)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	assert(sllist_empty(&vclock->timers));
+	assert(sllist_empty(&vclock->ctrls));
+
+#if LELY_NO_THREADS
+	(void)vclock;
+#else
+	mtx_destroy(&vclock->mtx);
+#endif
+}
+
+io_clock_t *
+io_vclock_create(const struct timespec *start)
+{
+	int errc = 0;
+
+	io_clock_t *clock = io_vclock_alloc();
+	if (!clock) {
+		errc = get_errc();
+		goto error_alloc;
+	}
+
+	io_clock_t *tmp = io_vclock_init(clock, start);
+	if (!tmp) {
+		errc = get_errc();
+		goto error_init;
+	}
+	clock = tmp;
+
+	return clock;
+
+error_init:
+	io_vclock_free((void *)clock);
+error_alloc:
+	set_errc(errc);
+	return NULL;
+}
+
+void
+io_vclock_destroy(io_clock_t *clock)
+{
+	if (clock) {
+		io_vclock_fini(clock);
+		io_vclock_free((void *)clock);
+	}
+}
+
+io_timer_t *
+io_vclock_create_timer(io_clock_t *clock, io_ctx_t *ctx, ev_exec_t *exec)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	int errc = 0;
+
+	struct io_vclock_timer *vtimer = malloc(sizeof(*vtimer));
+	if (!vtimer) {
+#if !LELY_NO_ERRNO
+		errc = errno2c(errno);
+#endif
+		goto error_alloc;
+	}
+
+	slnode_init(&vtimer->node);
+	vtimer->vclock = vclock;
+	vtimer->next = (struct timespec){ 0, 0 };
+
+	vtimer->timer = io_user_timer_create(
+			ctx, exec, &io_vclock_timer_setnext, vtimer);
+	if (!vtimer->timer) {
+		errc = get_errc();
+		goto error_create_timer;
+	}
+
+	struct timespec now = { 0, 0 };
+	io_vclock_gettime(clock, &now);
+	if (io_clock_settime(io_timer_get_clock(vtimer->timer), &now) == -1) {
+		errc = get_errc();
+		goto error_settime;
+	}
+
+	sllist_push_back(&vclock->timers, &vtimer->node);
+
+	return vtimer->timer;
+
+error_settime:
+	io_user_timer_destroy(vtimer->timer);
+error_create_timer:
+	free(vtimer);
+error_alloc:
+	set_errc(errc);
+	return NULL;
+}
+
+void
+io_vclock_destroy_timer(io_clock_t *clock, io_timer_t *timer)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	if (!timer)
+		return;
+
+	sllist_foreach (&vclock->timers, node) {
+		struct io_vclock_timer *vtimer =
+				structof(node, struct io_vclock_timer, node);
+		if (vtimer->timer == timer) {
+			sllist_remove(&vclock->timers, node);
+			io_user_timer_destroy(timer);
+			free(vtimer);
+			return;
+		}
+	}
+}
+
+int
+io_vclock_insert_ctrl(io_clock_t *clock, io_can_ctrl_t *ctrl)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+	assert(ctrl);
+
+	struct io_vclock_ctrl *vctrl = malloc(sizeof(*vctrl));
+	if (!vctrl) {
+#if !LELY_NO_ERRNO
+		set_errc(errno2c(errno));
+#endif
+		return -1;
+	}
+
+	slnode_init(&vctrl->node);
+	vctrl->ctrl = ctrl;
+
+	sllist_push_back(&vclock->ctrls, &vctrl->node);
+
+	return 0;
+}
+
+void
+io_vclock_remove_ctrl(io_clock_t *clock, io_can_ctrl_t *ctrl)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	sllist_foreach (&vclock->ctrls, node) {
+		struct io_vclock_ctrl *vctrl =
+				structof(node, struct io_vclock_ctrl, node);
+		if (vctrl->ctrl == ctrl) {
+			sllist_remove(&vclock->ctrls, node);
+			free(vctrl);
+			return;
+		}
+	}
+}
+
+int
+io_vclock_get_next(io_clock_t *clock, struct timespec *next)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+	assert(next);
+
+	int result = 0;
+
+	// Deliver any pending CAN frames and obtain the time at which the next
+	// transmission completes.
+	sllist_foreach (&vclock->ctrls, node) {
+		struct io_vclock_ctrl *vctrl =
+				structof(node, struct io_vclock_ctrl, node);
+		struct timespec ts = { 0, 0 };
+		switch (io_vcan_ctrl_sim_flush(vctrl->ctrl, &ts)) {
+		case -1: return -1;
+		case 1:
+			if (!result || timespec_cmp(&ts, next) < 0)
+				*next = ts;
+			result = 1;
+			break;
+		}
+	}
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vclock->mtx);
+#endif
+	sllist_foreach (&vclock->timers, node) {
+		struct io_vclock_timer *vtimer =
+				structof(node, struct io_vclock_timer, node);
+		const struct timespec *ts = &vtimer->next;
+		if (!ts->tv_sec && !ts->tv_nsec)
+			continue;
+		if (!result || timespec_cmp(ts, next) < 0)
+			*next = *ts;
+		result = 1;
+	}
+#if !LELY_NO_THREADS
+	mtx_unlock(&vclock->mtx);
+#endif
+
+	return result;
+}
+
+int
+io_vclock_advance(io_clock_t *clock, const struct timespec *end)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+
+	struct timespec next = { 0, 0 };
+	int result = io_vclock_get_next(clock, &next);
+	if (result == -1)
+		return -1;
+	if (end && (!result || timespec_cmp(&next, end) > 0)) {
+		result = 0;
+		next = *end;
+	} else if (!result) {
+		return 0;
+	}
+
+	return io_vclock_do_settime(vclock, &next) == -1 ? -1 : result;
+}
+
+size_t
+io_vclock_run(io_clock_t *clock, ev_loop_t *const *loops, size_t nloops,
+		const struct timespec *end)
+{
+	assert(!nloops || loops);
+
+	size_t n = 0;
+	for (;;) {
+		// Run all tasks until every loop is idle.
+		size_t m;
+		do {
+			m = 0;
+			for (size_t i = 0; i < nloops; i++) {
+				ev_loop_restart(loops[i]);
+				m += ev_loop_poll(loops[i]);
+			}
+			n += m;
+		} while (m);
+		// Jump to the next point in time at which something happens.
+		int result = io_vclock_advance(clock, end);
+		if (result == -1)
+			return (size_t)-1;
+		if (!result)
+			break;
+	}
+	return n;
+}
+
+static int
+io_vclock_getres(const io_clock_t *clock, struct timespec *res)
+{
+	(void)clock;
+
+	if (res)
+		*res = (struct timespec){ 0, 1 };
+
+	return 0;
+}
+
+static int
+io_vclock_gettime(const io_clock_t *clock, struct timespec *tp)
+{
+	const struct io_vclock *vclock = io_vclock_from_clock(clock);
+	assert(tp);
+
+#if !LELY_NO_THREADS
+	mtx_lock((mtx_t *)&vclock->mtx);
+#endif
+	*tp = vclock->now;
+#if !LELY_NO_THREADS
+	mtx_unlock((mtx_t *)&vclock->mtx);
+#endif
+
+	return 0;
+}
+
+static int
+io_vclock_settime(io_clock_t *clock, const struct timespec *tp)
+{
+	struct io_vclock *vclock = io_vclock_from_clock(clock);
+	assert(tp);
+
+	if (tp->tv_nsec < 0 || tp->tv_nsec >= 1000000000l) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
+	return io_vclock_do_settime(vclock, tp);
+}
+
+static inline struct io_vclock *
+io_vclock_from_clock(const io_clock_t *clock)
+{
+	assert(clock);
+
+	return structof(clock, struct io_vclock, clock_vptr);
+}
+
+static void
+io_vclock_timer_setnext(const struct timespec *tp, void *arg)
+{
+	struct io_vclock_timer *vtimer = arg;
+	assert(vtimer);
+	struct io_vclock *vclock = vtimer->vclock;
+	assert(vclock);
+	assert(tp);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vclock->mtx);
+#endif
+	vtimer->next = *tp;
+#if !LELY_NO_THREADS
+	mtx_unlock(&vclock->mtx);
+#endif
+}
+
+static int
+io_vclock_do_settime(struct io_vclock *vclock, const struct timespec *tp)
+{
+	assert(vclock);
+	assert(tp);
+
+#if !LELY_NO_THREADS
+	mtx_lock(&vclock->mtx);
+#endif
+	vclock->now = *tp;
+#if !LELY_NO_THREADS
+	mtx_unlock(&vclock->mtx);
+#endif
+
+	// Update the timers without holding the lock, since they report their
+	// next expiration time through io_vclock_timer_setnext().
+	int result = 0;
+	sllist_foreach (&vclock->timers, node) {
+		struct io_vclock_timer *vtimer =
+				structof(node, struct io_vclock_timer, node);
+		io_clock_t *clock = io_timer_get_clock(vtimer->timer);
+		if (io_clock_settime(clock, tp) == -1)
+			result = -1;
+	}
+
+	// Deliver the CAN frames whose transmission completed.
+	sllist_foreach (&vclock->ctrls, node) {
+		struct io_vclock_ctrl *vctrl =
+				structof(node, struct io_vclock_ctrl, node);
+		if (io_vcan_ctrl_sim_flush(vctrl->ctrl, NULL) == -1)
+			result = -1;
+	}
+
+	return result;
+}
+
+#endif // !LELY_NO_MALLOC
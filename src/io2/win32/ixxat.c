@@ -162,6 +162,10 @@ static int io_ixxat_chan_write(
 		io_can_chan_t *chan, const struct can_msg *msg, int timeout);
 static void io_ixxat_chan_submit_write(
 		io_can_chan_t *chan, struct io_can_chan_write *write);
+static void io_ixxat_chan_submit_readv(
+		io_can_chan_t *chan, struct io_can_chan_readv *readv);
+static void io_ixxat_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev);
 
 // clang-format off
 static const struct io_can_chan_vtbl io_ixxat_chan_vtbl = {
@@ -170,7 +174,9 @@ static const struct io_can_chan_vtbl io_ixxat_chan_vtbl = {
 	&io_ixxat_chan_read,
 	&io_ixxat_chan_submit_read,
 	&io_ixxat_chan_write,
-	&io_ixxat_chan_submit_write
+	&io_ixxat_chan_submit_write,
+	&io_ixxat_chan_submit_readv,
+	&io_ixxat_chan_submit_writev
 };
 // clang-format on
 
@@ -1524,6 +1530,39 @@ io_ixxat_chan_submit_write(io_can_chan_t *chan, struct io_can_chan_write *write)
 	}
 }
 
+static void
+io_ixxat_chan_submit_readv(io_can_chan_t *chan, struct io_can_chan_readv *readv)
+{
+	struct io_ixxat_chan *ixxat = io_ixxat_chan_from_chan(chan);
+	assert(readv);
+	struct ev_task *task = &readv->task;
+
+	if (!task->exec)
+		task->exec = ixxat->exec;
+	assert(task->exec);
+	ev_exec_on_task_init(task->exec);
+
+	// Vectored operations are not (yet) supported by this driver.
+	io_can_chan_readv_post(readv, 0, ERROR_NOT_SUPPORTED);
+}
+
+static void
+io_ixxat_chan_submit_writev(
+		io_can_chan_t *chan, struct io_can_chan_writev *writev)
+{
+	struct io_ixxat_chan *ixxat = io_ixxat_chan_from_chan(chan);
+	assert(writev);
+	struct ev_task *task = &writev->task;
+
+	if (!task->exec)
+		task->exec = ixxat->exec;
+	assert(task->exec);
+	ev_exec_on_task_init(task->exec);
+
+	// Vectored operations are not (yet) supported by this driver.
+	io_can_chan_writev_post(writev, ERROR_NOT_SUPPORTED);
+}
+
 static void
 io_ixxat_chan_svc_shutdown(struct io_svc *svc)
 {
@@ -30,12 +30,29 @@
 
 #include "util.h"
 
+#ifndef LELY_FIBER_ASM
+#if !_WIN32 && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) \
+		&& (defined(__x86_64__) || defined(__aarch64__))
+/**
+ * Define to 1 to switch contexts with the hand-written assembly functions
+ * instead of `(sig)setjmp()`/`(sig)longjmp()`. Only the callee-saved registers
+ * are saved and restored.
+ */
+#define LELY_FIBER_ASM 1
+#else
+#define LELY_FIBER_ASM 0
+#endif
+#endif
+
 #if !LELY_NO_MALLOC
 
 #include <lely/libc/stddef.h>
+#if !LELY_NO_THREADS
+#include <lely/libc/threads.h>
+#endif
 #include <lely/util/errnum.h>
 #include <lely/util/fiber.h>
-#if !_WIN32
+#if !_WIN32 && !LELY_FIBER_ASM
 #include <lely/util/mkjmp.h>
 #endif
 #include <lely/util/util.h>
@@ -44,6 +61,7 @@
 #if !_WIN32 && !defined(__NEWLIB__)
 #include <fenv.h>
 #endif
+#include <stdint.h>
 #include <stdlib.h>
 
 #if _WIN32
@@ -73,22 +91,104 @@
 #define LELY_FIBER_STKSZ 131072
 #endif
 
+// <signal.h> is included after the definition of LELY_FIBER_MINSTKSZ, so the
+// minimum stack size does not depend on the context switch implementation.
+#if LELY_FIBER_ASM && _POSIX_C_SOURCE >= 200112L
+#include <signal.h>
+#endif
+
+/// The process-wide fiber stack allocator.
+static struct {
+	/// The maximum number of unused stacks in the pool.
+	size_t max_unused;
+	/// The flags provided to fiber_stack_pool_init().
+	int flags;
+	/// The list of unused stacks.
+	struct fiber_stack *unused;
+	/// The statistics of the allocator.
+	struct fiber_stack_stats stats;
+} fiber_stack_pool;
+
+#if !LELY_NO_THREADS
+/// The flag used to initialize #fiber_stack_mtx exactly once.
+static once_flag fiber_stack_once = ONCE_FLAG_INIT;
+/// The mutex protecting #fiber_stack_pool.
+static mtx_t fiber_stack_mtx;
+/// Initializes #fiber_stack_mtx.
+static void fiber_stack_mtx_init(void);
+#endif
+
+/// Locks #fiber_stack_pool.
+static inline void fiber_stack_lock(void);
+
+/// Unlocks #fiber_stack_pool.
+static inline void fiber_stack_unlock(void);
+
 #if !_WIN32 && _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
 
+/// The header of an unused stack in the pool, stored at the stack address.
+struct fiber_stack {
+	/// A pointer to the next unused stack.
+	struct fiber_stack *next;
+	/// The size of the stack, excluding the guard pages.
+	size_t size;
+};
+
 /*
  * The size (in bytes) of a memory page. The value is stored in a static
  * variable to prevent multiple calls to sysconf().
  */
 static long page_size;
 
+#ifdef MADV_HUGEPAGE
+/*
+ * The size (in bytes) of a transparent huge page, i.e., the memory mapped by a
+ * single page table. Only naturally aligned huge pages can be used.
+ */
+static size_t huge_page_size;
+#endif
+
+/**
+ * Allocates a guarded stack of the specified size, either by taking an unused
+ * stack of the same size from the pool, or by creating a new mapping.
+ *
+ * @param size    the size of the stack, excluding the guard pages.
+ * @param preused the address at which to store 1 if the stack was taken from
+ *                the pool, and 0 if not.
+ *
+ * @returns a pointer to the stack, or NULL on error. In the latter case, the
+ * error number can be obtained with get_errc().
+ *
+ * @see fiber_stack_free()
+ */
+static void *fiber_stack_alloc(size_t size, int *preused);
+
+/**
+ * Returns a stack allocated by fiber_stack_alloc() to the pool, or unmaps it if
+ * the pool is full.
+ */
+static void fiber_stack_free(void *addr, size_t size);
+
+/**
+ * Returns the number of bytes in use in the stack at <b>addr</b>, or 0 if the
+ * usage cannot be determined. The first page, which holds the header while the
+ * stack is in the pool, is not counted.
+ */
+static size_t fiber_stack_usage(void *addr, size_t size);
+
+/// Unmaps all stacks in the specified list.
+static void fiber_stack_unmap(struct fiber_stack *stack);
+
 /**
  * Creates an anonymous private mapping of the specified size, surrounded by
  * guard pages on either side.
  *
- * @param addr a hint for the address at which to create the mapping.
- * @param len  the length of the mapping, excluding the guard pages.
- * @param prot the desired memory protection of the mapping, excluding the guard
- *             pages.
+ * @param addr  a hint for the address at which to create the mapping.
+ * @param len   the length of the mapping, excluding the guard pages.
+ * @param prot  the desired memory protection of the mapping, excluding the
+ *              guard pages.
+ * @param flags any combination of #FIBER_STACK_HUGE_PAGES and
+ *              #FIBER_STACK_LAZY.
  *
  * @returns a pointer to the first usable byte in the mapping (i.e., after the
  * guard page), or NULL on error. In the latter case, the error number can be
@@ -96,7 +196,7 @@ static long page_size;
  *
  * @see guard_munmap()
  */
-static void *guard_mmap(void *addr, size_t len, int prot);
+static void *guard_mmap(void *addr, size_t len, int prot, int flags);
 
 /**
  * Unmaps an anonymous private mapping created by guard_mmap().
@@ -108,7 +208,36 @@ static void guard_munmap(void *addr, size_t len);
 
 #endif // !_WIN32 && _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
 
-#if !_WIN32
+#if LELY_FIBER_ASM
+
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#error Unsupported architecture for LELY_FIBER_ASM.
+#endif
+
+/**
+ * Saves the callee-saved registers on the current stack, stores the stack
+ * pointer at <b>from</b>, and restores the registers from the stack at
+ * <b>to</b>. This function returns when the saved context is restored by
+ * another call to fiber_switch(). This function is implemented in assembly.
+ */
+__attribute__((visibility("hidden"))) void fiber_switch(void **from, void *to);
+
+/**
+ * The entry point of a new context created by fiber_ctx_init(). This function
+ * is implemented in assembly and never returns.
+ */
+__attribute__((visibility("hidden"))) void fiber_entry(void);
+
+/**
+ * Constructs a context on the specified stack which, when restored by
+ * fiber_switch(), invokes `func(arg)`. <b>func</b> MUST NOT return.
+ *
+ * @returns the stack pointer of the new context.
+ */
+static void *fiber_ctx_init(
+		void *sp, size_t size, void (*func)(void *), void *arg);
+
+#elif !_WIN32
 #if _POSIX_C_SOURCE >= 200112L && (!defined(__NEWLIB__) || defined(__CYGWIN__))
 /**
  * Saves the <b>from</b> calling environment with `sigsetjmp(from, savemask)`
@@ -122,7 +251,7 @@ static inline void sigjmpto(sigjmp_buf from, sigjmp_buf to, int savemask);
  */
 static inline void jmpto(jmp_buf from, jmp_buf to);
 #endif
-#endif // !_WIN32
+#endif // LELY_FIBER_ASM
 
 struct fiber_thrd;
 
@@ -157,7 +286,14 @@ struct fiber {
 	/// The Valgrind stack id for the fiber stack.
 	unsigned id;
 #endif
-#if _POSIX_C_SOURCE >= 200112L && (!defined(__NEWLIB__) || defined(__CYGWIN__))
+#if LELY_FIBER_ASM
+	/**
+	 * The saved stack pointer. The callee-saved registers are stored on the
+	 * stack.
+	 */
+	void *sp;
+#elif _POSIX_C_SOURCE >= 200112L \
+		&& (!defined(__NEWLIB__) || defined(__CYGWIN__))
 	/// The saved registers and signal mask.
 	sigjmp_buf env;
 #else
@@ -289,6 +425,7 @@ fiber_create(fiber_func_t *func, void *arg, int flags, size_t data_size,
 #endif
 
 	int errc = 0;
+	int reused = 0;
 
 	fiber_t *fiber = malloc(size);
 	if (!fiber) {
@@ -322,8 +459,8 @@ fiber_create(fiber_func_t *func, void *arg, int flags, size_t data_size,
 		// although it does waste a page. If we know in which direction
 		// the stack grows, we could omit one of the pages.
 		fiber->stack_size = stack_size;
-		fiber->stack_addr = guard_mmap(NULL, fiber->stack_size,
-				PROT_READ | PROT_WRITE);
+		fiber->stack_addr = fiber_stack_alloc(
+				fiber->stack_size, &reused);
 		if (!fiber->stack_addr) {
 			errc = get_errc();
 			goto error_create_stack;
@@ -349,6 +486,8 @@ fiber_create(fiber_func_t *func, void *arg, int flags, size_t data_size,
 		errc = get_errc();
 		goto error_CreateFiberEx;
 	}
+#elif LELY_FIBER_ASM
+	fiber->sp = fiber_ctx_init(sp, stack_size, &fiber_start, fiber);
 #else
 #if _POSIX_C_SOURCE >= 200112L && (!defined(__NEWLIB__) || defined(__CYGWIN__))
 	// clang-format off
@@ -367,6 +506,11 @@ fiber_create(fiber_func_t *func, void *arg, int flags, size_t data_size,
 	// fiber stack. After setting up the stack it will return here.
 	fiber_resume_with(fiber, func, arg);
 
+	fiber_stack_lock();
+	fiber_stack_pool.stats.ncreated++;
+	fiber_stack_pool.stats.nreused += reused;
+	fiber_stack_unlock();
+
 	// Cppcheck gets confused by fiber_resume() and thinks we leak memory.
 	// cppcheck-suppress memleak
 	return fiber;
@@ -375,14 +519,16 @@ fiber_create(fiber_func_t *func, void *arg, int flags, size_t data_size,
 	// DeleteFiber(fiber->lpFiber);
 error_CreateFiberEx:
 #else
+#if !LELY_FIBER_ASM
 error_mkjmp:
 #if LELY_HAVE_VALGRIND
 	VALGRIND_STACK_DEREGISTER(fiber->id);
 #endif
+#endif
 #if _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
 error_create_stack:
 	if (fiber->stack_addr)
-		guard_munmap(fiber->stack_addr, fiber->stack_size);
+		fiber_stack_free(fiber->stack_addr, fiber->stack_size);
 #endif
 #endif
 	free(fiber);
@@ -405,7 +551,7 @@ fiber_destroy(fiber_t *fiber)
 #endif
 #if _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
 		if (fiber->stack_addr)
-			guard_munmap(fiber->stack_addr, fiber->stack_size);
+			fiber_stack_free(fiber->stack_addr, fiber->stack_size);
 #endif
 #endif
 		free(fiber);
@@ -482,6 +628,19 @@ fiber_resume_with(fiber_t *fiber, fiber_func_t *func, void *arg)
 #if _WIN32
 	assert(to->lpFiber);
 	SwitchToFiber(to->lpFiber);
+#elif LELY_FIBER_ASM
+#if _POSIX_C_SOURCE >= 200112L
+	// Save the signal mask of the current fiber, like sigsetjmp() would.
+	sigset_t mask;
+	int savemask = curr->flags & FIBER_SAVE_MASK;
+	if (savemask)
+		sigprocmask(SIG_BLOCK, NULL, &mask);
+#endif
+	fiber_switch(&curr->sp, to->sp);
+#if _POSIX_C_SOURCE >= 200112L
+	if (savemask)
+		sigprocmask(SIG_SETMASK, &mask, NULL);
+#endif
 #elif _POSIX_C_SOURCE >= 200112L \
 		&& (!defined(__NEWLIB__) || defined(__CYGWIN__))
 	sigjmpto(curr->env, to->env, curr->flags & FIBER_SAVE_MASK);
@@ -522,10 +681,199 @@ fiber_resume_with(fiber_t *fiber, fiber_func_t *func, void *arg)
 	return fiber;
 }
 
+int
+fiber_stack_pool_init(size_t max_unused, int flags)
+{
+	if (flags & ~(FIBER_STACK_HUGE_PAGES | FIBER_STACK_LAZY)) {
+		set_errnum(ERRNUM_INVAL);
+		return -1;
+	}
+
 #if !_WIN32 && _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
+	fiber_stack_lock();
+	fiber_stack_pool.max_unused = max_unused;
+	fiber_stack_pool.flags = flags;
+	// Remove the excess stacks from the pool.
+	struct fiber_stack *unused = NULL;
+	struct fiber_stack **pstack = &fiber_stack_pool.unused;
+	for (size_t i = 0; *pstack && i < max_unused; i++)
+		pstack = &(*pstack)->next;
+	unused = *pstack;
+	*pstack = NULL;
+	for (struct fiber_stack *stack = unused; stack; stack = stack->next) {
+		fiber_stack_pool.stats.nstacks--;
+		fiber_stack_pool.stats.nunused--;
+	}
+	fiber_stack_unlock();
+
+	fiber_stack_unmap(unused);
+
+	return 0;
+#else
+	if (max_unused) {
+		set_errnum(ERRNUM_NOSYS);
+		return -1;
+	}
+	return 0;
+#endif
+}
+
+void
+fiber_stack_pool_fini(void)
+{
+	fiber_stack_pool_init(0, 0);
+}
+
+void
+fiber_stack_get_stats(struct fiber_stack_stats *stats)
+{
+	assert(stats);
+
+	fiber_stack_lock();
+	*stats = fiber_stack_pool.stats;
+	fiber_stack_unlock();
+}
+
+#if !LELY_NO_THREADS
+static void
+fiber_stack_mtx_init(void)
+{
+	// There is no way to report an error here, but mtx_init() for a plain
+	// mutex cannot fail on any of the supported platforms.
+	mtx_init(&fiber_stack_mtx, mtx_plain);
+}
+#endif
+
+static inline void
+fiber_stack_lock(void)
+{
+#if !LELY_NO_THREADS
+	call_once(&fiber_stack_once, &fiber_stack_mtx_init);
+	mtx_lock(&fiber_stack_mtx);
+#endif
+}
+
+static inline void
+fiber_stack_unlock(void)
+{
+#if !LELY_NO_THREADS
+	mtx_unlock(&fiber_stack_mtx);
+#endif
+}
+
+#if !_WIN32 && _POSIX_MAPPED_FILES && defined(MAP_ANONYMOUS)
+
+static void *
+fiber_stack_alloc(size_t size, int *preused)
+{
+	assert(preused);
+
+	fiber_stack_lock();
+	// Look for an unused stack of the requested size.
+	struct fiber_stack **pstack = &fiber_stack_pool.unused;
+	while (*pstack && (*pstack)->size != size)
+		pstack = &(*pstack)->next;
+	struct fiber_stack *stack = *pstack;
+	if (stack) {
+		*pstack = stack->next;
+		fiber_stack_pool.stats.nunused--;
+	}
+	int flags = fiber_stack_pool.flags;
+	fiber_stack_unlock();
+
+	if ((*preused = stack != NULL))
+		return stack;
+
+	void *addr = guard_mmap(NULL, size, PROT_READ | PROT_WRITE, flags);
+	if (!addr)
+		return NULL;
+
+	fiber_stack_lock();
+	struct fiber_stack_stats *stats = &fiber_stack_pool.stats;
+	if (++stats->nstacks > stats->peak_nstacks)
+		stats->peak_nstacks = stats->nstacks;
+	fiber_stack_unlock();
+
+	return addr;
+}
+
+static void
+fiber_stack_free(void *addr, size_t size)
+{
+	assert(addr);
+
+	// Measure the stack usage before the stack is reused or unmapped.
+	size_t usage = fiber_stack_usage(addr, size);
+
+	fiber_stack_lock();
+	struct fiber_stack_stats *stats = &fiber_stack_pool.stats;
+	if (usage > stats->peak_usage)
+		stats->peak_usage = usage;
+	if (stats->nunused < fiber_stack_pool.max_unused) {
+#ifdef MADV_DONTNEED
+		// Release all but the first page, which holds the header.
+		if ((fiber_stack_pool.flags & FIBER_STACK_LAZY)
+				&& ALIGN(size, page_size) > (size_t)page_size)
+			madvise((char *)addr + page_size,
+					ALIGN(size, page_size) - page_size,
+					MADV_DONTNEED);
+#endif
+		struct fiber_stack *stack = addr;
+		stack->next = fiber_stack_pool.unused;
+		stack->size = size;
+		fiber_stack_pool.unused = stack;
+		stats->nunused++;
+		addr = NULL;
+	} else {
+		stats->nstacks--;
+	}
+	fiber_stack_unlock();
+
+	if (addr)
+		guard_munmap(addr, size);
+}
+
+static size_t
+fiber_stack_usage(void *addr, size_t size)
+{
+#if defined(__linux__) && defined(_DEFAULT_SOURCE)
+	assert(page_size > 0);
+
+	size_t n = ALIGN(size, page_size) / page_size;
+	size_t nresident = 0;
+	// Query the residency of the pages in chunks, skipping the first page.
+	for (size_t i = 1; i < n;) {
+		unsigned char vec[64];
+		size_t m = MIN(n - i, sizeof(vec));
+		if (mincore((char *)addr + i * page_size, m * page_size, vec)
+				== -1)
+			return 0;
+		for (size_t j = 0; j < m; j++)
+			nresident += vec[j] & 1;
+		i += m;
+	}
+	// Do not count the part of the last page beyond the end of the stack.
+	return MIN(nresident * page_size, size - MIN(size, (size_t)page_size));
+#else
+	(void)addr;
+	(void)size;
+
+	return 0;
+#endif
+}
+
+static void
+fiber_stack_unmap(struct fiber_stack *stack)
+{
+	while (stack) {
+		struct fiber_stack *next = stack->next;
+		guard_munmap(stack, stack->size);
+		stack = next;
+	}
+}
 
 static void *
-guard_mmap(void *addr, size_t len, int prot)
+guard_mmap(void *addr, size_t len, int prot, int flags)
 {
 	if (!page_size)
 		page_size = sysconf(_SC_PAGE_SIZE);
@@ -539,18 +887,56 @@ guard_mmap(void *addr, size_t len, int prot)
 	// Round the length up to the nearest multiple of the page size.
 	len = ALIGN(len, page_size);
 
+	// Reserve enough space to align the end of the stack, which is used
+	// first, to the huge page size. Stacks smaller than a huge page cannot
+	// use one.
+	size_t align = 0;
+#ifdef MADV_HUGEPAGE
+	if (!huge_page_size)
+		huge_page_size = (size_t)page_size / sizeof(void *) * page_size;
+	if ((flags & FIBER_STACK_HUGE_PAGES) && len >= huge_page_size)
+		align = huge_page_size - page_size;
+#endif
+
 	int errc = 0;
 
+	int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+	// Do not reserve swap space for lazily committed mappings.
+	if (flags & FIBER_STACK_LAZY)
+		mmap_flags |= MAP_NORESERVE;
+#endif
+
 	// Create a single anonymous private mapping that includes the guard
 	// pages.
-	addr = mmap(addr, len + 2 * page_size, prot,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	addr = mmap(addr, len + 2 * page_size + align, prot, mmap_flags, -1,
+			0);
 	if (addr == MAP_FAILED) {
 		errc = get_errc();
 		goto error_mmap;
 	}
 	addr = (char *)addr + page_size;
 
+#ifdef MADV_HUGEPAGE
+	if (align) {
+		// Move the stack to the aligned position and unmap the excess
+		// space on either side.
+		char *begin = (char *)addr - page_size;
+		char *end = begin + len + 2 * page_size + align;
+		addr = (char *)ALIGN((uintptr_t)addr + len, huge_page_size)
+				- len;
+		if ((char *)addr - page_size > begin)
+			munmap(begin, (char *)addr - page_size - begin);
+		if ((char *)addr + len + page_size < end)
+			munmap((char *)addr + len + page_size,
+					end - ((char *)addr + len + page_size));
+		// Huge pages are only a hint; ignore any errors.
+		madvise(addr, len, MADV_HUGEPAGE);
+	}
+#else
+	(void)flags;
+#endif
+
 	// Guard the page at the beginning.
 	if (mprotect((char *)addr - page_size, page_size, PROT_NONE) == -1) {
 		errc = get_errc();
@@ -586,7 +972,138 @@ guard_munmap(void *addr, size_t len)
 
 #endif // _POSIX_MAPPED_FILES && MAP_ANONYMOUS
 
-#if !_WIN32
+#if LELY_FIBER_ASM
+
+static void *
+fiber_ctx_init(void *sp, size_t size, void (*func)(void *), void *arg)
+{
+	// The stack grows down from a 16-byte aligned address.
+	uintptr_t top = ((uintptr_t)sp + size) & ~(uintptr_t)15;
+#if defined(__x86_64__)
+	// The frame is popped by fiber_switch(): the MXCSR register and x87
+	// control word, r15, r14, r13, r12, rbx, rbp and the return address.
+	// The offset ensures the stack is 16-byte aligned when fiber_entry()
+	// calls func.
+	uint64_t *frame = (uint64_t *)(top - 88);
+	frame[0] = 0;
+	// The default values of MXCSR and the x87 control word.
+	frame[1] = UINT64_C(0x1f80) | (UINT64_C(0x037f) << 32);
+	frame[2] = 0; // r15
+	frame[3] = 0; // r14
+	frame[4] = (uintptr_t)func; // r13
+	frame[5] = (uintptr_t)arg; // r12
+	frame[6] = 0; // rbx
+	frame[7] = 0; // rbp
+	frame[8] = (uintptr_t)&fiber_entry;
+	frame[9] = 0;
+#elif defined(__aarch64__)
+	// The frame is popped by fiber_switch(): d8-d15, x19-x28, x29 (the
+	// frame pointer), x30 (the link register) and the FPCR register (0,
+	// the default value), followed by 8 bytes of padding.
+	uint64_t *frame = (uint64_t *)(top - 176);
+	for (int i = 0; i < 22; i++)
+		frame[i] = 0;
+	frame[8] = (uintptr_t)arg; // x19
+	frame[9] = (uintptr_t)func; // x20
+	frame[19] = (uintptr_t)&fiber_entry; // x30
+#endif
+	return frame;
+}
+
+// clang-format off
+#if defined(__x86_64__)
+__asm__(
+	".text\n"
+	".globl fiber_switch\n"
+	".hidden fiber_switch\n"
+	".type fiber_switch, @function\n"
+	".p2align 4\n"
+"fiber_switch:\n"
+	"pushq   %rbp\n"
+	"pushq   %rbx\n"
+	"pushq   %r12\n"
+	"pushq   %r13\n"
+	"pushq   %r14\n"
+	"pushq   %r15\n"
+	"subq    $16, %rsp\n"
+	"stmxcsr 8(%rsp)\n"
+	"fnstcw  12(%rsp)\n"
+	"movq    %rsp, (%rdi)\n"
+	"movq    %rsi, %rsp\n"
+	"ldmxcsr 8(%rsp)\n"
+	"fldcw   12(%rsp)\n"
+	"addq    $16, %rsp\n"
+	"popq    %r15\n"
+	"popq    %r14\n"
+	"popq    %r13\n"
+	"popq    %r12\n"
+	"popq    %rbx\n"
+	"popq    %rbp\n"
+	"ret\n"
+	".size fiber_switch, .-fiber_switch\n"
+	".globl fiber_entry\n"
+	".hidden fiber_entry\n"
+	".type fiber_entry, @function\n"
+	".p2align 4\n"
+"fiber_entry:\n"
+	"movq    %r12, %rdi\n"
+	"callq   *%r13\n"
+	"ud2\n"
+	".size fiber_entry, .-fiber_entry\n"
+);
+#elif defined(__aarch64__)
+__asm__(
+	".text\n"
+	".globl fiber_switch\n"
+	".hidden fiber_switch\n"
+	".type fiber_switch, %function\n"
+	".p2align 4\n"
+"fiber_switch:\n"
+	"sub     sp, sp, #176\n"
+	"stp     d8, d9, [sp, #0]\n"
+	"stp     d10, d11, [sp, #16]\n"
+	"stp     d12, d13, [sp, #32]\n"
+	"stp     d14, d15, [sp, #48]\n"
+	"stp     x19, x20, [sp, #64]\n"
+	"stp     x21, x22, [sp, #80]\n"
+	"stp     x23, x24, [sp, #96]\n"
+	"stp     x25, x26, [sp, #112]\n"
+	"stp     x27, x28, [sp, #128]\n"
+	"stp     x29, x30, [sp, #144]\n"
+	"mrs     x9, fpcr\n"
+	"str     x9, [sp, #160]\n"
+	"mov     x9, sp\n"
+	"str     x9, [x0]\n"
+	"mov     sp, x1\n"
+	"ldr     x9, [sp, #160]\n"
+	"msr     fpcr, x9\n"
+	"ldp     d8, d9, [sp, #0]\n"
+	"ldp     d10, d11, [sp, #16]\n"
+	"ldp     d12, d13, [sp, #32]\n"
+	"ldp     d14, d15, [sp, #48]\n"
+	"ldp     x19, x20, [sp, #64]\n"
+	"ldp     x21, x22, [sp, #80]\n"
+	"ldp     x23, x24, [sp, #96]\n"
+	"ldp     x25, x26, [sp, #112]\n"
+	"ldp     x27, x28, [sp, #128]\n"
+	"ldp     x29, x30, [sp, #144]\n"
+	"add     sp, sp, #176\n"
+	"ret\n"
+	".size fiber_switch, .-fiber_switch\n"
+	".globl fiber_entry\n"
+	".hidden fiber_entry\n"
+	".type fiber_entry, %function\n"
+	".p2align 4\n"
+"fiber_entry:\n"
+	"mov     x0, x19\n"
+	"blr     x20\n"
+	"brk     #0\n"
+	".size fiber_entry, .-fiber_entry\n"
+);
+#endif
+// clang-format on
+
+#elif !_WIN32
 #if _POSIX_C_SOURCE >= 200112L && (!defined(__NEWLIB__) || defined(__CYGWIN__))
 static inline void
 sigjmpto(sigjmp_buf from, sigjmp_buf to, int savemask)
@@ -602,7 +1119,7 @@ jmpto(jmp_buf from, jmp_buf to)
 		longjmp(to, 1);
 }
 #endif
-#endif // !_WIN32
+#endif // LELY_FIBER_ASM
 
 #if _WIN32
 static _Noreturn void CALLBACK
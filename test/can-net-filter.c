@@ -0,0 +1,138 @@
+#include "test.h"
+#include <lely/can/net.h>
+
+#define NUM_RECV 100
+
+static struct can_net_filter filters[64];
+static size_t nfilter;
+static int nupdate;
+
+static int can_filter(
+		const struct can_net_filter *filters_, size_t n, void *data);
+static int can_recv(const struct can_msg *msg, void *data);
+static int accept(uint_least32_t id, uint_least8_t flags);
+
+int
+main(void)
+{
+	tap_plan(9);
+
+	can_net_t *net = can_net_create();
+	tap_assert(net);
+
+	can_recv_t *recv[NUM_RECV];
+	for (int i = 0; i < NUM_RECV; i++) {
+		recv[i] = can_recv_create();
+		tap_assert(recv[i]);
+		can_recv_set_func(recv[i], &can_recv, NULL);
+	}
+
+	can_net_set_filter_func(net, &can_filter, NULL);
+	tap_test(nupdate == 1 && !nfilter, "no receivers, no filters");
+
+	can_recv_start(recv[0], net, 0x123, 0);
+	tap_test(nupdate == 2 && nfilter == 1 && filters[0].id == 0x123
+					&& filters[0].mask == CAN_MASK_BID
+					&& !filters[0].flags,
+			"a new receiver adds an exact filter");
+
+	can_recv_start(recv[1], net, 0x123, 0);
+	tap_test(nupdate == 2, "a receiver for the same frame adds no filter");
+
+	can_recv_start(recv[2], net, 0x123, CAN_FLAG_RTR);
+	tap_test(nupdate == 3 && nfilter == 2 && accept(0x123, CAN_FLAG_RTR)
+					&& !accept(0x124, CAN_FLAG_RTR),
+			"a remote frame receiver adds a separate filter");
+
+	// Filters are only narrowed after enough receivers have been stopped.
+	for (int i = 0; i < 8; i++)
+		can_recv_start(recv[3 + i], net, 0x200 + i, 0);
+	int n = nupdate;
+	for (int i = 0; i < 7; i++)
+		can_recv_stop(recv[3 + i]);
+	int ok = nupdate == n && accept(0x200, 0);
+	can_recv_stop(recv[10]);
+	tap_test(ok && nupdate == n + 1 && nfilter == 2 && !accept(0x200, 0),
+			"filters are narrowed after 8 stale identifiers");
+
+	// Restarting the same identifiers leaves the filters unchanged.
+	can_recv_start(recv[3], net, 0x300, 0);
+	n = nupdate;
+	for (int i = 0; i < 8; i++) {
+		can_recv_stop(recv[3]);
+		can_recv_start(recv[3], net, 0x300, 0);
+	}
+	tap_test(nupdate == n && nfilter == 3 && accept(0x300, 0),
+			"filters are not reinstalled if they do not change");
+	can_recv_stop(recv[3]);
+
+	// More identifiers than filters are merged, but still accepted.
+	for (int i = 3; i < NUM_RECV; i++)
+		can_recv_start(recv[i], net, 0x400 + 3 * i, CAN_FLAG_IDE);
+	ok = nfilter <= 64 && accept(0x123, 0);
+	for (int i = 3; ok && i < NUM_RECV; i++)
+		ok = accept(0x400 + 3 * i, CAN_FLAG_IDE);
+	tap_test(ok, "%zu filters accept %d identifiers", nfilter, NUM_RECV);
+
+	// An identifier that is only accepted because filters were merged does
+	// not reclaim a stale identifier.
+	uint_least32_t id = 0x400 + 3 * 3 + 1;
+	while (id < 0x400 + 3 * NUM_RECV && !accept(id, CAN_FLAG_IDE))
+		id += 3;
+	tap_assert(id < 0x400 + 3 * NUM_RECV);
+	n = nupdate;
+	for (int i = 3; i < 10; i++)
+		can_recv_stop(recv[i]);
+	can_recv_start(recv[3], net, id, CAN_FLAG_IDE);
+	ok = nupdate == n;
+	can_recv_stop(recv[10]);
+	tap_test(ok && nupdate == n + 1,
+			"a newly accepted identifier reclaims no stale one");
+
+	can_net_set_filter_func(net, NULL, NULL);
+	n = nupdate;
+	for (int i = 0; i < NUM_RECV; i++)
+		can_recv_stop(recv[i]);
+	tap_test(nupdate == n, "no updates after the callback is cleared");
+
+	for (int i = 0; i < NUM_RECV; i++)
+		can_recv_destroy(recv[i]);
+
+	can_net_destroy(net);
+
+	return 0;
+}
+
+static int
+can_filter(const struct can_net_filter *filters_, size_t n, void *data)
+{
+	(void)data;
+
+	tap_assert(n <= sizeof(filters) / sizeof(*filters));
+	for (size_t i = 0; i < n; i++)
+		filters[i] = filters_[i];
+	nfilter = n;
+	nupdate++;
+
+	return 0;
+}
+
+static int
+can_recv(const struct can_msg *msg, void *data)
+{
+	(void)msg;
+	(void)data;
+
+	return 0;
+}
+
+static int
+accept(uint_least32_t id, uint_least8_t flags)
+{
+	for (size_t i = 0; i < nfilter; i++) {
+		if ((id & filters[i].mask) == (filters[i].id & filters[i].mask)
+				&& flags == filters[i].flags)
+			return 1;
+	}
+	return 0;
+}
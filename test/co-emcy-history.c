@@ -0,0 +1,140 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/dev.h>
+#include <lely/co/emcy.h>
+#include <lely/util/time.h>
+
+// The number of milliseconds to run after a burst of messages, which is longer
+// than the inhibit time of the messages in the burst.
+#define RUN_MSEC 1000
+
+static can_net_t *net;
+static struct co_test test;
+static struct timespec now;
+
+// The number of EMCY frames sent by the producer.
+static int nsent;
+
+static int send_func(const struct can_msg *msg, void *data);
+static void run(int msec);
+
+int
+main(void)
+{
+	tap_plan(8);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	net = can_net_create();
+	tap_assert(net);
+	co_test_init(&test, net, 0);
+	// Replace the send function to count the EMCY frames and to deliver
+	// them in virtual time.
+	can_net_set_send_func(net, &send_func, &test);
+	can_net_set_time(net, &now);
+
+	// The device is both the producer and the (only) consumer of the EMCY
+	// messages.
+	co_dev_t *dev = co_dev_create_from_dcf_file(TEST_SRCDIR "/co-emcy.dcf");
+	tap_assert(dev);
+	co_emcy_t *emcy = co_emcy_create(net, dev);
+	tap_assert(emcy);
+	tap_assert(!co_emcy_set_log_size(emcy, 8));
+
+	struct co_emcy_rec recs[8];
+
+	// Push a burst of messages onto a stack with a limited depth.
+	tap_assert(!co_emcy_set_depth(emcy, 3));
+	for (co_unsigned16_t eec = 0x1000; eec <= 0x5000; eec += 0x1000)
+		tap_assert(!co_emcy_push(emcy, eec, 0x01, NULL));
+	tap_test(co_dev_get_val_u8(dev, 0x1003, 0x00) == 3
+					&& co_emcy_find(emcy, 0x2000) == -1
+					&& co_emcy_find(emcy, 0x3000) == 2
+					&& co_emcy_find(emcy, 0x5000) == 0,
+			"oldest messages discarded from a full stack");
+
+	run(RUN_MSEC);
+	tap_test(nsent == 5, "all messages sent without coalescing");
+
+	int ok = co_emcy_read_log(emcy, 0x01, recs, 8) == 5;
+	for (int i = 0; ok && i < 5; i++)
+		ok = recs[i].eec == (i + 1) * 0x1000 && !recs[i].nlost;
+	tap_test(ok, "received messages logged in order");
+
+	// Push a burst of identical messages during the inhibit time.
+	tap_assert(!co_emcy_set_depth(emcy, 0));
+	co_emcy_set_coalesce(emcy, 1);
+	nsent = 0;
+	for (co_unsigned8_t i = 0; i < 4; i++) {
+		co_unsigned8_t msef[5] = { i, 0, 0, 0, 0 };
+		tap_assert(!co_emcy_push(emcy, 0x6000, 0x01, msef));
+	}
+	run(RUN_MSEC);
+	tap_test(nsent == 2 && co_dev_get_val_u8(dev, 0x1003, 0x00) == 7,
+			"repeated messages coalesced during the inhibit time");
+	ok = co_emcy_read_log(emcy, 0x01, recs, 8) == 2;
+	ok = ok && recs[0].eec == 0x6000 && !recs[0].msef[0];
+	ok = ok && recs[1].eec == 0x6000 && recs[1].msef[0] == 3;
+	tap_test(ok, "coalesced message contains the most recent data");
+	co_emcy_set_coalesce(emcy, 0);
+
+	tap_assert(!co_emcy_set_depth(emcy, 2));
+	tap_test(co_dev_get_val_u8(dev, 0x1003, 0x00) == 2,
+			"stack truncated when reducing the depth");
+
+	// Overflow the log of the consumer.
+	tap_assert(!co_emcy_set_log_size(emcy, 2));
+	nsent = 0;
+	for (co_unsigned16_t eec = 0x7000; eec < 0x7004; eec++)
+		tap_assert(!co_emcy_push(emcy, eec, 0x01, NULL));
+	run(RUN_MSEC);
+	tap_test(nsent == 4 && co_emcy_read_log(emcy, 0x01, recs, 8) == 2
+					&& recs[0].eec == 0x7000
+					&& recs[1].eec == 0x7001,
+			"log full after two messages");
+	tap_assert(!co_emcy_push(emcy, 0x7004, 0x01, NULL));
+	run(RUN_MSEC);
+	tap_test(co_emcy_read_log(emcy, 0x01, recs, 8) == 1
+					&& recs[0].eec == 0x7004
+					&& recs[0].nlost == 2,
+			"number of lost messages reported");
+
+	co_emcy_destroy(emcy);
+	co_dev_destroy(dev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	struct co_test *test = data;
+	tap_assert(test);
+
+	if (msg->id == 0x81)
+		nsent++;
+
+	return can_buf_write(&test->buf, msg, 1) ? 0 : -1;
+}
+
+static void
+run(int msec)
+{
+	// Deliver the queued frames with a latency of 1 ms.
+	for (int i = 0; i < msec; i++) {
+		timespec_add_msec(&now, 1);
+		can_net_set_time(net, &now);
+		for (size_t n = can_buf_size(&test.buf); n; n--) {
+			struct can_msg msg = CAN_MSG_INIT;
+			if (can_buf_read(&test.buf, &msg, 1) != 1)
+				break;
+			can_net_recv(net, &msg);
+		}
+	}
+}
@@ -0,0 +1,255 @@
+#include "co-test.h"
+#include <lely/co/csdo.h>
+#include <lely/co/dcf.h>
+#include <lely/co/dev.h>
+#include <lely/co/gw.h>
+#include <lely/co/nmt.h>
+#include <lely/util/endian.h>
+
+// The number of requests sent in a single burst.
+#define NREQ 4
+
+static struct co_test test;
+
+// The user-specified data of the requests, used to match the confirmations.
+static int tokens[NREQ];
+// The values of sub-indices 1..4 of the identity object of the slaves.
+static const co_unsigned32_t values[NREQ] = { 0x360, 1, 2, 3 };
+
+// The confirmations received from the gateway.
+static struct {
+	void *data;
+	int iec;
+	co_unsigned32_t ac;
+	co_unsigned32_t val;
+} cons[2 * NREQ];
+static int ncon;
+
+static void up_ind(const co_csdo_t *sdo, co_unsigned16_t idx,
+		co_unsigned8_t subidx, size_t size, size_t nbyte, void *data);
+static int send_func(const struct can_msg *msg, void *data);
+static int gw_send(const struct co_gw_srv *srv, void *data);
+static void up_req(co_gw_t *gw, co_unsigned8_t node, int i);
+static int hop(void);
+static int run(int n);
+static int check(int first, int n);
+
+int
+main(void)
+{
+	tap_plan(7);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	can_net_t *net = can_net_create();
+	tap_assert(net);
+	co_test_init(&test, net, 0);
+	// Replace the send function to deliver the CAN frames one round at a
+	// time.
+	can_net_set_send_func(net, &send_func, &test);
+
+	// The master has an additional Client-SDO (1280) for node 2.
+	co_dev_t *mdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-gw-sdo-master.dcf");
+	tap_assert(mdev);
+	co_nmt_t *master = co_nmt_create(net, mdev);
+	tap_assert(master);
+
+	// Node 2 supports an additional Server-SDO (1201).
+	co_dev_t *sdev2 = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-gw-sdo-slave.dcf");
+	tap_assert(sdev2);
+	co_dev_set_val_u32(sdev2, 0x1201, 0x01, 0x642);
+	co_dev_set_val_u32(sdev2, 0x1201, 0x02, 0x5c2);
+	co_nmt_t *slave2 = co_nmt_create(net, sdev2);
+	tap_assert(slave2);
+
+	// Node 3 only supports the default Server-SDO.
+	co_dev_t *sdev3 = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-gw-sdo-slave.dcf");
+	tap_assert(sdev3);
+	co_nmt_t *slave3 = co_nmt_create(net, sdev3);
+	tap_assert(slave3);
+	tap_assert(!co_nmt_set_id(slave3, 0x03));
+
+	co_gw_t *gw = co_gw_create();
+	tap_assert(gw);
+	co_gw_set_send_func(gw, &gw_send, NULL);
+	tap_assert(!co_gw_init_net(gw, 1, master));
+
+	tap_assert(!co_nmt_cs_ind(master, CO_NMT_CS_RESET_NODE));
+	tap_assert(!co_nmt_cs_ind(slave2, CO_NMT_CS_RESET_NODE));
+	tap_assert(!co_nmt_cs_ind(slave3, CO_NMT_CS_RESET_NODE));
+	while (hop())
+		;
+
+	// Each expedited upload takes two rounds; one for the request and one
+	// for the response.
+	for (int i = 0; i < NREQ; i++)
+		up_req(gw, 0x03, i);
+	int nhop = run(NREQ);
+	tap_test(nhop == 2 * NREQ && check(0, NREQ),
+			"requests for a node with a single SDO channel queued");
+
+	// The gateway borrows the additional Client-SDO service of the master
+	// and should not lose the indication function installed on it.
+	co_csdo_t *csdo = co_nmt_get_csdo(master, 1);
+	co_csdo_set_up_ind(csdo, &up_ind, &test);
+	for (int i = 0; i < NREQ; i++)
+		up_req(gw, 0x02, i);
+	nhop = run(NREQ);
+	tap_test(nhop == NREQ && check(0, NREQ),
+			"requests distributed over multiple SDO channels");
+	co_csdo_ind_t *ind = NULL;
+	void *ind_data = NULL;
+	co_csdo_get_up_ind(csdo, &ind, &ind_data);
+	tap_test(ind == &up_ind && ind_data == &test,
+			"indication function of a borrowed SDO restored");
+	co_csdo_set_up_ind(csdo, NULL, NULL);
+
+	co_gw_set_sdo_queue(gw, 1);
+	for (int i = 0; i < 3; i++)
+		up_req(gw, 0x03, i);
+	tap_test(ncon == 1 && cons[0].data == &tokens[2]
+					&& cons[0].iec == CO_GW_IEC_INTERN,
+			"request rejected when the queue is full");
+	run(3);
+	tap_test(check(1, 2), "queued request processed after a rejection");
+	co_gw_set_sdo_queue(gw, LELY_CO_GW_SDO_QUEUE);
+
+	co_gw_set_sdo_queue(gw, 0);
+	up_req(gw, 0x03, 0);
+	up_req(gw, 0x03, 1);
+	tap_test(ncon == 1 && cons[0].data == &tokens[1]
+					&& cons[0].iec == CO_GW_IEC_INTERN,
+			"requests not queued if the queue depth is 0");
+	run(2);
+	co_gw_set_sdo_queue(gw, LELY_CO_GW_SDO_QUEUE);
+
+	// Shut down the gateway with requests in progress and in the queue.
+	ncon = 0;
+	for (int i = 0; i < NREQ; i++) {
+		up_req(gw, 0x02, i);
+		up_req(gw, 0x03, i);
+	}
+	tap_assert(!co_gw_fini_net(gw, 1));
+	while (hop())
+		;
+	tap_test(!ncon && co_csdo_is_idle(co_nmt_get_csdo(master, 1)),
+			"pending requests discarded without confirmation");
+
+	co_gw_destroy(gw);
+
+	co_nmt_destroy(slave3);
+	co_dev_destroy(sdev3);
+	co_nmt_destroy(slave2);
+	co_dev_destroy(sdev2);
+	co_nmt_destroy(master);
+	co_dev_destroy(mdev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+static void
+up_ind(const co_csdo_t *sdo, co_unsigned16_t idx, co_unsigned8_t subidx,
+		size_t size, size_t nbyte, void *data)
+{
+	(void)sdo;
+	(void)idx;
+	(void)subidx;
+	(void)size;
+	(void)nbyte;
+	(void)data;
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	struct co_test *test = data;
+	tap_assert(test);
+
+	return can_buf_write(&test->buf, msg, 1) ? 0 : -1;
+}
+
+static int
+gw_send(const struct co_gw_srv *srv, void *data)
+{
+	(void)data;
+
+	if (srv->srv != CO_GW_SRV_SDO_UP)
+		return 0;
+
+	const struct co_gw_con *con = (const struct co_gw_con *)srv;
+	tap_assert(ncon < (int)(sizeof(cons) / sizeof(*cons)));
+	cons[ncon].data = con->data;
+	cons[ncon].iec = con->iec;
+	cons[ncon].ac = con->ac;
+	cons[ncon].val = 0;
+	if (!con->iec && !con->ac) {
+		const struct co_gw_con_sdo_up *up =
+				(const struct co_gw_con_sdo_up *)srv;
+		tap_assert(up->len == 4);
+		cons[ncon].val = ldle_u32(up->val);
+	}
+	ncon++;
+
+	return 0;
+}
+
+static void
+up_req(co_gw_t *gw, co_unsigned8_t node, int i)
+{
+	struct co_gw_req_sdo_up req = { .size = sizeof(req),
+		.srv = CO_GW_SRV_SDO_UP,
+		.data = &tokens[i],
+		.net = 1,
+		.node = node,
+		.idx = 0x1018,
+		.subidx = (co_unsigned8_t)(i + 1),
+		.type = CO_DEFTYPE_UNSIGNED32 };
+	tap_assert(!co_gw_recv(gw, (const struct co_gw_req *)&req));
+}
+
+static int
+hop(void)
+{
+	// Only deliver the frames that have been sent before this round.
+	size_t n = can_buf_size(&test.buf);
+	for (size_t i = 0; i < n; i++) {
+		struct can_msg msg = CAN_MSG_INIT;
+		tap_assert(can_buf_read(&test.buf, &msg, 1) == 1);
+		can_net_recv(test.net, &msg);
+	}
+	return n > 0;
+}
+
+static int
+run(int n)
+{
+	int nhop = 0;
+	while (ncon < n && hop())
+		nhop++;
+	return nhop;
+}
+
+static int
+check(int first, int n)
+{
+	// Check that the confirmations were received in the order of the
+	// requests.
+	int ok = ncon == first + n;
+	for (int i = first; ok && i < first + n; i++) {
+		int j = i - first;
+		ok = cons[i].data == &tokens[j] && !cons[i].iec && !cons[i].ac
+				&& cons[i].val == values[j];
+	}
+	// Reset the confirmations for the next test.
+	ncon = 0;
+	return ok;
+}
@@ -0,0 +1,200 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/dev.h>
+#include <lely/co/gw_bin.h>
+#include <lely/co/nmt.h>
+
+// The size (in bytes) of the small ring buffer used to test wrap-around.
+#define RING_SIZE 256
+
+// The number of times the user was notified by the binary gateway.
+static int nnotify;
+
+static int gw_send(const struct co_gw_srv *srv, void *data);
+static int gw_bin_send(const struct co_gw_req *req, void *data);
+static void gw_bin_notify(void *data);
+static void rpdo_ind(struct co_gw_ind_rpdo *ind, co_unsigned8_t n,
+		co_unsigned16_t num);
+
+int
+main(void)
+{
+	tap_plan(8);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	can_net_t *net = can_net_create();
+	tap_assert(net);
+
+	struct co_test test;
+	co_test_init(&test, net, 0);
+
+	co_dev_t *dev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-gw_txt-master.dcf");
+	tap_assert(dev);
+	co_nmt_t *nmt = co_nmt_create(net, dev);
+	tap_assert(nmt);
+
+	co_gw_t *gw = co_gw_create();
+	tap_assert(gw);
+	tap_assert(!co_gw_init_net(gw, 1, nmt));
+
+	struct co_gw_bin_ring *req = co_gw_bin_ring_create(4096);
+	tap_assert(req);
+	struct co_gw_bin_ring *ind = co_gw_bin_ring_create(4096);
+	tap_assert(ind);
+
+	co_gw_bin_t *gw_bin = co_gw_bin_create(req, ind);
+	tap_assert(gw_bin);
+	co_gw_set_send_func(gw, &gw_send, gw_bin);
+	co_gw_bin_set_send_func(gw_bin, &gw_bin_send, gw);
+	co_gw_bin_set_notify_func(gw_bin, &gw_bin_notify, NULL);
+
+	// Send a 'Get version' request through the request ring buffer, as a
+	// client would.
+	int token = 0;
+	struct co_gw_req_net req_net = { .size = sizeof(req_net),
+		.srv = CO_GW_SRV_GET_VERSION,
+		.data = &token,
+		.net = 1 };
+	tap_assert(!co_gw_bin_ring_write(req, (struct co_gw_srv *)&req_net));
+	tap_assert(co_gw_bin_send(gw_bin) == 1);
+
+	co_unsigned32_t vendor_id = co_dev_get_val_u32(dev, 0x1018, 0x01);
+	const struct co_gw_srv *srv = co_gw_bin_ring_peek(ind);
+	const struct co_gw_con_get_version *con = (const void *)srv;
+	tap_test(srv && srv->srv == CO_GW_SRV_GET_VERSION
+					&& srv->size == sizeof(*con)
+					&& con->data == &token && !con->iec
+					&& con->vendor_id == vendor_id,
+			"confirmation read in place from the ring buffer");
+	co_gw_bin_ring_pop(ind);
+	tap_test(nnotify == 1 && !co_gw_bin_ring_peek(ind),
+			"user notified immediately of a confirmation");
+
+	// Indications are batched.
+	co_gw_bin_set_batch(gw_bin, 4);
+	struct co_gw_ind_rpdo rpdo;
+	for (co_unsigned16_t num = 1; num <= 3; num++) {
+		rpdo_ind(&rpdo, (co_unsigned8_t)num, num);
+		tap_assert(!co_gw_bin_recv(gw_bin, (struct co_gw_srv *)&rpdo));
+	}
+	int ok = nnotify == 1;
+	rpdo_ind(&rpdo, 4, 4);
+	tap_assert(!co_gw_bin_recv(gw_bin, (struct co_gw_srv *)&rpdo));
+	tap_test(ok && nnotify == 2, "indications batched");
+
+	rpdo_ind(&rpdo, 5, 5);
+	tap_assert(!co_gw_bin_recv(gw_bin, (struct co_gw_srv *)&rpdo));
+	co_gw_bin_flush(gw_bin);
+	ok = nnotify == 3;
+	co_gw_bin_flush(gw_bin);
+	ok = ok && nnotify == 3;
+	for (co_unsigned16_t num = 1; ok && num <= 5; num++) {
+		const struct co_gw_ind_rpdo *p = (const void *)
+				co_gw_bin_ring_peek(ind);
+		ok = p && p->srv == CO_GW_SRV_RPDO && p->num == num
+				&& p->n == num && p->val[num - 1] == num;
+		co_gw_bin_ring_pop(ind);
+	}
+	tap_test(ok && !co_gw_bin_ring_peek(ind),
+			"pending indications flushed in order");
+
+	// Write records of varying sizes to a small ring buffer, such that
+	// they regularly wrap around.
+	struct co_gw_bin_ring *ring = co_gw_bin_ring_create(RING_SIZE);
+	tap_assert(ring);
+	ok = 1;
+	for (int i = 0; ok && i < 100; i++) {
+		co_unsigned8_t n = i % 7;
+		rpdo_ind(&rpdo, n, (co_unsigned16_t)i);
+		ok = !co_gw_bin_ring_write(ring, (struct co_gw_srv *)&rpdo);
+		const struct co_gw_ind_rpdo *p = (const void *)
+				co_gw_bin_ring_peek(ring);
+		ok = ok && p && p->size == rpdo.size && p->num == i
+				&& p->n == n;
+		for (co_unsigned8_t j = 0; ok && j < n; j++)
+			ok = p->val[j] == (co_unsigned64_t)j + 1;
+		co_gw_bin_ring_pop(ring);
+	}
+	tap_test(ok && !co_gw_bin_ring_peek(ring),
+			"records intact after wrapping around");
+
+	// Fill the ring buffer of the gateway.
+	co_gw_bin_t *gw_small = co_gw_bin_create(req, ring);
+	tap_assert(gw_small);
+	rpdo_ind(&rpdo, 8, 0);
+	int n = 0;
+	while (!co_gw_bin_recv(gw_small, (struct co_gw_srv *)&rpdo))
+		n++;
+	tap_test(n > 0 && get_errnum() == ERRNUM_AGAIN
+					&& co_gw_bin_get_lost(gw_small) == 1,
+			"records lost when the ring buffer is full");
+	while (co_gw_bin_ring_peek(ring)) {
+		co_gw_bin_ring_pop(ring);
+		n--;
+	}
+	tap_test(!n, "all written records read");
+
+	rpdo_ind(&rpdo, 0x40, 0);
+	tap_test(co_gw_bin_ring_write(ring, (struct co_gw_srv *)&rpdo) == -1
+					&& get_errnum() == ERRNUM_MSGSIZE,
+			"record larger than the ring buffer rejected");
+
+	co_gw_bin_destroy(gw_small);
+	co_gw_bin_ring_destroy(ring);
+
+	co_gw_bin_destroy(gw_bin);
+	co_gw_bin_ring_destroy(ind);
+	co_gw_bin_ring_destroy(req);
+
+	co_gw_destroy(gw);
+	co_nmt_destroy(nmt);
+	co_dev_destroy(dev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+static int
+gw_send(const struct co_gw_srv *srv, void *data)
+{
+	co_gw_bin_t *gw_bin = data;
+	tap_assert(gw_bin);
+
+	return co_gw_bin_recv(gw_bin, srv);
+}
+
+static int
+gw_bin_send(const struct co_gw_req *req, void *data)
+{
+	co_gw_t *gw = data;
+	tap_assert(gw);
+
+	return co_gw_recv(gw, req);
+}
+
+static void
+gw_bin_notify(void *data)
+{
+	(void)data;
+
+	nnotify++;
+}
+
+static void
+rpdo_ind(struct co_gw_ind_rpdo *ind, co_unsigned8_t n, co_unsigned16_t num)
+{
+	ind->size = CO_GW_IND_RPDO_SIZE + n * sizeof(*ind->val);
+	ind->srv = CO_GW_SRV_RPDO;
+	ind->net = 1;
+	ind->num = num;
+	ind->n = n;
+	for (co_unsigned8_t i = 0; i < n; i++)
+		ind->val[i] = (co_unsigned64_t)i + 1;
+}
@@ -0,0 +1,296 @@
+#include "test.h"
+#include <lely/co/gw.h>
+#include <lely/co/gw_txt.h>
+#include <lely/co/sdo.h>
+#include <lely/co/val.h>
+#include <lely/util/diag.h>
+#include <lely/util/time.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The number of requests in the generated script.
+#define NUM_REQ (64 * 1024)
+// The maximum length of a request in the generated script.
+#define MAX_LEN 48
+
+// Pairs of requests which are recognized by the fast path and equivalent
+// requests which are only recognized by the generic lexers (because they
+// contain octal numbers or explicit signs).
+static const char *const reqs[][2] = {
+	{ "[1] 2 r 0x1000 0 u32", "[1] 2 r 0x1000 00 u32" },
+	{ "[2] 1 3 w 0x2000 1 i16 -1234", "[2] 1 3 w 0x2000 1 i16 -02322" },
+	{ "[3] 5 write 0x2000 2 u64 0xFFFFFFFFFFFFFFFF",
+			"[3] 5 write 0x2000 2 u64 +18446744073709551615" },
+	{ "[ 4 ] READ 4096 0x1 U8", "[ 4 ] READ 4096 01 U8" },
+	{ "[5] 2 w 0x2000 3 i64 -9223372036854775808",
+			"[5] 2 w 0x2000 3 i64 -01000000000000000000000" },
+	{ "[6] 2 w 0x2000 4 b 1", "[6] 2 w 0x2000 4 b 01" },
+	{ "[7] 2 w 0x2000 5 i24 -8388608", "[7] 2 w 0x2000 5 i24 -040000000" },
+	{ "[8] 127 w 0x2000 6 u24 0xffffff # comment",
+			"[8] 127 w 0x2000 6 u24 077777777 # comment" }
+};
+
+#define NUM_REQS (sizeof(reqs) / sizeof(*reqs))
+
+// The last request received by the send function.
+static union {
+	struct co_gw_req req;
+	struct co_gw_req_sdo_up up;
+	struct co_gw_req_sdo_dn dn;
+	unsigned char buf[256];
+} last;
+// The number of requests received by the send function.
+static size_t nreq;
+
+// The last indication or confirmation received by the receive function.
+static char txt[256];
+
+static int send_func(const struct co_gw_req *req, void *data);
+static int recv_func(const char *txt, void *data);
+
+static int req_equal(const struct co_gw_req *a, const struct co_gw_req *b);
+static int con_sdo_up(co_gw_txt_t *gw, co_unsigned32_t seq,
+		co_unsigned16_t type, const void *val, const char *expected);
+
+static void bench_send(co_gw_txt_t *gw, const char *script, size_t n,
+		const char *name);
+static void bench_recv(co_gw_txt_t *gw);
+
+int
+main(void)
+{
+	tap_plan(10);
+
+	co_gw_txt_t *gw = co_gw_txt_create();
+	tap_assert(gw);
+	co_gw_txt_set_send_func(gw, &send_func, NULL);
+	co_gw_txt_set_recv_func(gw, &recv_func, NULL);
+
+	int ok = 1;
+	for (size_t i = 0; ok && i < NUM_REQS; i++) {
+		nreq = 0;
+		tap_assert(co_gw_txt_send(gw, reqs[i][0], NULL, NULL));
+		union {
+			struct co_gw_req req;
+			unsigned char buf[sizeof(last)];
+		} fast;
+		memcpy(&fast, &last, sizeof(last));
+		tap_assert(co_gw_txt_send(gw, reqs[i][1], NULL, NULL));
+		ok = nreq == 2 && !co_gw_txt_iec(gw)
+				&& req_equal(&fast.req, &last.req);
+		if (!ok)
+			tap_diag("request '%s' differs from '%s'", reqs[i][0],
+					reqs[i][1]);
+	}
+	tap_test(ok, "fast path is equivalent to the generic lexers");
+
+	// Disable the diagnostic messages generated by the generic lexers for
+	// the invalid requests below.
+	diag_set_handler(NULL, NULL);
+	diag_at_set_handler(NULL, NULL);
+
+	nreq = 0;
+	co_gw_txt_send(gw, "[9] 2 w 0x2000 0 u8 256", NULL, NULL);
+	tap_test(nreq == 1 && last.dn.len == 1 && last.dn.val[0] == 0xff,
+			"out-of-range value clamped by the generic lexers");
+
+	nreq = 0;
+	co_gw_txt_send(gw, "[10] 128 r 0x1000 0 u32", NULL, NULL);
+	tap_test(!nreq && co_gw_txt_iec(gw) == CO_GW_IEC_SYNTAX,
+			"invalid node-ID rejected");
+
+	// Build a script containing comments, empty lines and an invalid
+	// request.
+	char script[512] = "# script\n";
+	for (size_t i = 0; i < NUM_REQS; i++) {
+		strcat(script, reqs[i][i % 2]);
+		strcat(script, i == NUM_REQS / 2 ? "\r\n\n" : "\n");
+	}
+	strcat(script, "[11] 2 x 0x1000 0 u32\n[12] 2 r 0x1000 0 u32");
+	nreq = 0;
+	struct floc at = { "script", 1, 1 };
+	size_t chars = co_gw_txt_send_batch(gw, script, NULL, &at);
+	tap_test(chars == strlen(script) && nreq == NUM_REQS + 1
+					&& co_gw_txt_iec(gw) == CO_GW_IEC_SYNTAX
+					&& at.line == NUM_REQS + 4,
+			"batch of requests sent");
+
+	ok = con_sdo_up(gw, 1, CO_DEFTYPE_UNSIGNED8, &(co_unsigned8_t){ 5 },
+			"[1] 0x05");
+	ok = ok && con_sdo_up(gw, 2, CO_DEFTYPE_UNSIGNED24,
+				   &(co_unsigned24_t){ 0xabcde },
+				   "[2] 0x0abcde");
+	ok = ok && con_sdo_up(gw, 3, CO_DEFTYPE_UNSIGNED64,
+				   &(co_unsigned64_t){ UINT64_MAX },
+				   "[3] 0xffffffffffffffff");
+	tap_test(ok, "unsigned values formatted");
+
+	ok = con_sdo_up(gw, 4, CO_DEFTYPE_INTEGER16, &(co_integer16_t){ -1234 },
+			"[4] -1234");
+	ok = ok && con_sdo_up(gw, 5, CO_DEFTYPE_INTEGER64,
+				   &(co_integer64_t){ INT64_MIN },
+				   "[5] -9223372036854775808");
+	ok = ok && con_sdo_up(gw, 6, CO_DEFTYPE_BOOLEAN, &(co_boolean_t){ 1 },
+				   "[6] 1");
+	tap_test(ok, "signed and boolean values formatted");
+
+	struct co_gw_con con = { .size = sizeof(con),
+		.srv = CO_GW_SRV_SDO_DN,
+		.data = (void *)(uintptr_t)UINT32_MAX };
+	tap_test(!co_gw_txt_recv(gw, (struct co_gw_srv *)&con)
+					&& !strcmp(txt, "[4294967295] OK"),
+			"confirmation formatted");
+
+	// Generate a script of alternating 'SDO download' and 'SDO upload'
+	// requests, once in a form recognized by the fast path and once in a
+	// form which requires the generic lexers.
+	char *fast = malloc(NUM_REQ * MAX_LEN + 1);
+	tap_assert(fast);
+	char *slow = malloc(NUM_REQ * MAX_LEN + 1);
+	tap_assert(slow);
+	char *fp = fast;
+	char *sp = slow;
+	for (int i = 0; i < NUM_REQ; i++) {
+		unsigned node = i % 127 + 1;
+		unsigned subidx = i % 255 + 1;
+		if (i % 2) {
+			fp += sprintf(fp, "[%d] %u r 0x2000 %u u32\n", i,
+					node, subidx);
+			sp += sprintf(sp, "[%d] %u r 0x2000 0%o u32\n", i,
+					node, subidx);
+		} else {
+			fp += sprintf(fp, "[%d] %u w 0x2000 %u u32 0x%x\n", i,
+					node, subidx, i);
+			sp += sprintf(sp, "[%d] %u w 0x2000 0%o u32 0x%x\n",
+					i, node, subidx, i);
+		}
+	}
+	bench_send(gw, fast, fp - fast, "fast path");
+	bench_send(gw, slow, sp - slow, "generic lexers");
+	free(slow);
+	free(fast);
+
+	bench_recv(gw);
+
+	co_gw_txt_destroy(gw);
+
+	return 0;
+}
+
+static int
+send_func(const struct co_gw_req *req, void *data)
+{
+	(void)data;
+
+	tap_assert(req->size <= sizeof(last));
+	memcpy(&last, req, req->size);
+	nreq++;
+
+	return 0;
+}
+
+static int
+recv_func(const char *txt_, void *data)
+{
+	(void)data;
+
+	tap_assert(strlen(txt_) < sizeof(txt));
+	strcpy(txt, txt_);
+
+	return 0;
+}
+
+static int
+req_equal(const struct co_gw_req *a, const struct co_gw_req *b)
+{
+	if (a->srv != b->srv || a->data != b->data || a->size != b->size)
+		return 0;
+
+	if (a->srv == CO_GW_SRV_SDO_UP) {
+		const struct co_gw_req_sdo_up *x = (const void *)a;
+		const struct co_gw_req_sdo_up *y = (const void *)b;
+		return x->net == y->net && x->node == y->node
+				&& x->idx == y->idx && x->subidx == y->subidx
+				&& x->type == y->type;
+	} else {
+		const struct co_gw_req_sdo_dn *x = (const void *)a;
+		const struct co_gw_req_sdo_dn *y = (const void *)b;
+		return x->net == y->net && x->node == y->node
+				&& x->idx == y->idx && x->subidx == y->subidx
+				&& x->len == y->len
+				&& !memcmp(x->val, y->val, x->len);
+	}
+}
+
+static int
+con_sdo_up(co_gw_txt_t *gw, co_unsigned32_t seq, co_unsigned16_t type,
+		const void *val, const char *expected)
+{
+	union {
+		struct co_gw_con_sdo_up con;
+		unsigned char buf[CO_GW_CON_SDO_UP_SIZE + 8];
+	} u;
+	size_t n = co_val_write(type, val, NULL, NULL);
+	u.con = (struct co_gw_con_sdo_up){
+		.size = CO_GW_CON_SDO_UP_SIZE + n,
+		.srv = CO_GW_SRV_SDO_UP,
+		.data = (void *)(uintptr_t)seq,
+		.type = type,
+		.len = n
+	};
+	uint_least8_t *bp = u.buf + CO_GW_CON_SDO_UP_SIZE;
+	co_val_write(type, val, bp, bp + n);
+
+	if (co_gw_txt_recv(gw, (struct co_gw_srv *)&u.con) == -1)
+		return 0;
+	if (expected && strcmp(txt, expected)) {
+		tap_diag("expected '%s', got '%s'", expected, txt);
+		return 0;
+	}
+	return 1;
+}
+
+static void
+bench_send(co_gw_txt_t *gw, const char *script, size_t n, const char *name)
+{
+	nreq = 0;
+
+	struct timespec t1 = { 0, 0 };
+	timespec_get(&t1, TIME_UTC);
+	size_t chars = co_gw_txt_send_batch(gw, script, script + n, NULL);
+	struct timespec t2 = { 0, 0 };
+	timespec_get(&t2, TIME_UTC);
+
+	tap_assert(chars == n && nreq == NUM_REQ);
+
+	double ns = timespec_diff_nsec(&t2, &t1);
+	tap_pass("%s: %.1f ns per request, %.0f requests/s", name,
+			ns / NUM_REQ, 1e9 * NUM_REQ / ns);
+}
+
+static void
+bench_recv(co_gw_txt_t *gw)
+{
+	struct timespec t1 = { 0, 0 };
+	timespec_get(&t1, TIME_UTC);
+	for (int i = 0; i < NUM_REQ; i++) {
+		if (i % 2) {
+			co_unsigned32_t val = i;
+			con_sdo_up(gw, i, CO_DEFTYPE_UNSIGNED32, &val, NULL);
+		} else {
+			struct co_gw_con con = { .size = sizeof(con),
+				.srv = CO_GW_SRV_SDO_DN,
+				.data = (void *)(uintptr_t)i };
+			co_gw_txt_recv(gw, (struct co_gw_srv *)&con);
+		}
+	}
+	struct timespec t2 = { 0, 0 };
+	timespec_get(&t2, TIME_UTC);
+
+	double ns = timespec_diff_nsec(&t2, &t1);
+	tap_pass("formatter: %.1f ns per confirmation, %.0f confirmations/s",
+			ns / NUM_REQ, 1e9 * NUM_REQ / ns);
+}
@@ -0,0 +1,262 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/lss.h>
+#include <lely/co/nmt.h>
+#include <lely/util/time.h>
+
+#define NUM_SLAVES 4
+#define VENDOR_ID 0x00000360
+#define REVISION 0x00000003
+#define MAX_STEPS 100000
+// The response latency (in ms) of the slow slave, which exceeds the adaptive
+// timeout but not the LSS timeout.
+#define SLOW_DELAY 20
+#define MAX_SLOW 16
+
+static const struct {
+	co_unsigned32_t product_code;
+	co_unsigned32_t serial_nr;
+	// The node-ID expected to be assigned based on co-lss-discover.dcf.
+	co_unsigned8_t id;
+} slaves[NUM_SLAVES] = {
+	// clang-format off
+	{ 0x00000010, 0x00001001, 2 },
+	{ 0x00000010, 0x00001002, 3 },
+	{ 0x00000020, 0x00002001, 5 },
+	{ 0x00000020, 0x00002002, 4 }
+	// clang-format on
+};
+
+// The CAN network interfaces of the master and the slaves. Each node needs its
+// own interface, since only a single LSS service can process a CAN frame.
+static can_net_t *nets[1 + NUM_SLAVES];
+static struct co_test test;
+static struct timespec now;
+
+// The index of the slave whose frames are delayed by SLOW_DELAY, or -1.
+static int slow = -1;
+static struct {
+	struct can_msg msg;
+	struct timespec time;
+} slow_msgs[MAX_SLOW];
+static int nslow;
+
+// The number of times each slave was reported by the indication function.
+static int nind[NUM_SLAVES];
+
+static int ncon;
+static struct co_lss_discover_stats stats;
+
+co_unsigned8_t discover_ind(co_lss_t *lss, const struct co_id *id,
+		co_unsigned8_t nid, void *data);
+void discover_con(co_lss_t *lss, const struct co_lss_discover_stats *stats,
+		void *data);
+
+static int send_func(const struct can_msg *msg, void *data);
+static void run(co_lss_t *lss);
+
+int
+main(void)
+{
+	tap_plan(9);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	for (int i = 0; i < 1 + NUM_SLAVES; i++) {
+		nets[i] = can_net_create();
+		tap_assert(nets[i]);
+		if (!i)
+			co_test_init(&test, nets[i], 0);
+		// Replace the send function to deliver the CAN frames to all
+		// nodes in virtual time.
+		can_net_set_send_func(nets[i], &send_func, &nets[i]);
+		can_net_set_time(nets[i], &now);
+	}
+
+	co_dev_t *mdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-lss-discover.dcf");
+	tap_assert(mdev);
+	co_nmt_t *master = co_nmt_create(nets[0], mdev);
+	tap_assert(master);
+	co_nmt_set_timeout(master, 100);
+
+	// Create the unconfigured slaves. Note that the objects of a slave are
+	// restored on reset, so the identity has to be set before the NMT
+	// service is created.
+	co_dev_t *sdevs[NUM_SLAVES];
+	co_nmt_t *snmts[NUM_SLAVES];
+	for (int i = 0; i < NUM_SLAVES; i++) {
+		sdevs[i] = co_dev_create_from_dcf_file(
+				TEST_SRCDIR "/co-nmt-slave.dcf");
+		tap_assert(sdevs[i]);
+		co_dev_set_id(sdevs[i], 0xff);
+		co_dev_set_val_u32(sdevs[i], 0x1018, 0x02,
+				slaves[i].product_code);
+		co_dev_set_val_u32(
+				sdevs[i], 0x1018, 0x04, slaves[i].serial_nr);
+		snmts[i] = co_nmt_create(nets[1 + i], sdevs[i]);
+		tap_assert(snmts[i]);
+		tap_assert(!co_nmt_cs_ind(snmts[i], CO_NMT_CS_RESET_NODE));
+	}
+
+	tap_assert(!co_nmt_cs_ind(master, CO_NMT_CS_RESET_NODE));
+	co_lss_t *lss = co_nmt_get_lss(master);
+	tap_assert(lss);
+	run(lss);
+
+	// Identify the slaves without pruning or assigning node-IDs.
+	tap_test(!co_lss_discover_req(lss, 0, &discover_ind, &discover_con,
+				 NULL),
+			"LSS discovery started");
+	tap_test(co_lss_discover_req(lss, 0, NULL, NULL, NULL) == -1,
+			"LSS discovery rejected while busy");
+	run(lss);
+	int ok = ncon == 1 && stats.nfound == NUM_SLAVES && !stats.nconf;
+	for (int i = 0; i < NUM_SLAVES; i++)
+		ok = ok && nind[i] == 1;
+	tap_test(ok, "all slaves identified without pruning");
+	int nreq = stats.nreq;
+	tap_diag("%d requests in %d ms", stats.nreq,
+			(int)(stats.scan_time / 1000));
+
+	tap_test(stats.latency && stats.timeout < 1000 * 100,
+			"timeout adapted to a latency of %d us",
+			(int)stats.latency);
+
+	// A slave responding later than the adaptive timeout is still
+	// identified exactly once, and without identifying non-existent slaves.
+	slow = NUM_SLAVES - 1;
+	ncon = 0;
+	for (int i = 0; i < NUM_SLAVES; i++)
+		nind[i] = 0;
+	tap_assert(!co_lss_discover_req(lss, 0, &discover_ind, &discover_con,
+			NULL));
+	run(lss);
+	slow = -1;
+	ok = ncon == 1 && stats.nfound == NUM_SLAVES
+			&& stats.timeout == 1000 * 100;
+	for (int i = 0; i < NUM_SLAVES; i++)
+		ok = ok && nind[i] == 1;
+	tap_test(ok, "late responses detected");
+	tap_diag("%d requests in %d ms", stats.nreq,
+			(int)(stats.scan_time / 1000));
+
+	// Identify the slaves using the expected identities from the DCF and
+	// assign the suggested node-IDs.
+	ncon = 0;
+	tap_assert(!co_lss_discover_req(lss, 1, NULL, &discover_con, NULL));
+	run(lss);
+	tap_test(ncon == 1 && stats.nfound == NUM_SLAVES
+					&& stats.nconf == NUM_SLAVES,
+			"all slaves identified and configured with pruning");
+	tap_test(stats.nreq < nreq, "pruning reduced the number of requests");
+	tap_diag("%d requests in %d ms", stats.nreq,
+			(int)(stats.scan_time / 1000));
+
+	ok = 1;
+	for (int i = 0; i < NUM_SLAVES; i++)
+		ok = ok && co_nmt_get_id(snmts[i]) == slaves[i].id;
+	tap_test(ok, "node-IDs assigned based on the expected identities");
+
+	tap_test(stats.scan_time && stats.scan_time < stats.total_time,
+			"total time of %d ms reported",
+			(int)(stats.total_time / 1000));
+
+	for (int i = 0; i < NUM_SLAVES; i++) {
+		co_nmt_destroy(snmts[i]);
+		co_dev_destroy(sdevs[i]);
+	}
+	co_nmt_destroy(master);
+	co_dev_destroy(mdev);
+
+	co_test_fini(&test);
+	for (int i = 0; i < 1 + NUM_SLAVES; i++)
+		can_net_destroy(nets[i]);
+
+	return 0;
+}
+
+co_unsigned8_t
+discover_ind(co_lss_t *lss, const struct co_id *id, co_unsigned8_t nid,
+		void *data)
+{
+	(void)lss;
+	(void)data;
+
+	tap_assert(id);
+	for (int i = 0; i < NUM_SLAVES; i++) {
+		if (id->vendor_id == VENDOR_ID
+				&& id->product_code == slaves[i].product_code
+				&& id->revision == REVISION
+				&& id->serial_nr == slaves[i].serial_nr) {
+			tap_diag("slave %d identified (suggested node-ID %d)",
+					i, nid);
+			nind[i]++;
+		}
+	}
+
+	// Leave the slave unconfigured.
+	return 0xff;
+}
+
+void
+discover_con(co_lss_t *lss, const struct co_lss_discover_stats *stats_,
+		void *data)
+{
+	(void)lss;
+	(void)data;
+
+	tap_assert(stats_);
+	stats = *stats_;
+	ncon++;
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	can_net_t **net = data;
+	tap_assert(net);
+
+	if (slow >= 0 && net - nets == 1 + slow) {
+		tap_assert(nslow < MAX_SLOW);
+		slow_msgs[nslow].msg = *msg;
+		slow_msgs[nslow].time = now;
+		timespec_add_msec(&slow_msgs[nslow].time, SLOW_DELAY);
+		nslow++;
+		return 0;
+	}
+
+	return can_buf_write(&test.buf, msg, 1) ? 0 : -1;
+}
+
+static void
+run(co_lss_t *lss)
+{
+	// Deliver the queued frames with a latency of 1 ms until the LSS master
+	// and the network are idle.
+	for (int i = 0; i < MAX_STEPS
+			&& (!co_lss_is_idle(lss) || can_buf_size(&test.buf)
+					|| nslow);
+			i++) {
+		timespec_add_msec(&now, 1);
+		for (int j = 0; j < 1 + NUM_SLAVES; j++)
+			can_net_set_time(nets[j], &now);
+		// Queue the delayed frames of the slow slave once they are due.
+		while (nslow && timespec_cmp(&slow_msgs[0].time, &now) <= 0) {
+			can_buf_write(&test.buf, &slow_msgs[0].msg, 1);
+			for (int j = 1; j < nslow; j++)
+				slow_msgs[j - 1] = slow_msgs[j];
+			nslow--;
+		}
+		for (size_t n = can_buf_size(&test.buf); n; n--) {
+			struct can_msg msg = CAN_MSG_INIT;
+			if (can_buf_read(&test.buf, &msg, 1) != 1)
+				break;
+			for (int j = 0; j < 1 + NUM_SLAVES; j++)
+				can_net_recv(nets[j], &msg);
+		}
+	}
+}
@@ -0,0 +1,211 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/nmt.h>
+#include <lely/co/sdo.h>
+#include <lely/util/endian.h>
+#include <lely/util/time.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define SLAVE_ID 2
+#define SERIAL_NR 0x12345678
+#define CFG_DATE 0x00001a2b
+#define CFG_TIME 0x00c0ffee
+#define FILENAME "co-nmt-boot-cache.tmp"
+#define MAX_STEPS 1000
+
+static can_net_t *net;
+static struct co_test test;
+static struct timespec now;
+
+// The number of SDO upload requests for objects 1018 and 1020.
+static int n1018;
+static int n1020;
+
+static int nboot;
+static int nerror;
+
+void boot_ind(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es,
+		void *data);
+
+static int send_func(const struct can_msg *msg, void *data);
+static void run(void);
+static void reset(co_nmt_t *nmt);
+static void boot(co_nmt_t *nmt);
+
+int
+main(void)
+{
+	tap_plan(9);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	net = can_net_create();
+	tap_assert(net);
+	co_test_init(&test, net, 0);
+	// Replace the send function to keep track of the SDO requests, and to
+	// deliver the CAN frames in virtual time.
+	can_net_set_send_func(net, &send_func, &test);
+	can_net_set_time(net, &now);
+
+	co_dev_t *mdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-nmt-boot-cache.dcf");
+	tap_assert(mdev);
+	co_nmt_t *master = co_nmt_create(net, mdev);
+	tap_assert(master);
+	co_nmt_set_boot_ind(master, &boot_ind, NULL);
+	co_nmt_set_timeout(master, 100);
+
+	co_dev_t *sdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-nmt-boot-cache-slave.dcf");
+	tap_assert(sdev);
+	co_dev_set_id(sdev, SLAVE_ID);
+	co_dev_set_val_u32(sdev, 0x1018, 0x04, SERIAL_NR);
+	co_nmt_t *slave = co_nmt_create(net, sdev);
+	tap_assert(slave);
+	tap_assert(!co_nmt_cs_ind(slave, CO_NMT_CS_RESET_NODE));
+	run();
+
+	// Without the boot cache, the expected serial number and configuration
+	// are checked.
+	reset(master);
+	tap_test(nboot == 1 && !nerror && n1018 == 1 && n1020 == 2,
+			"slave booted without the boot cache");
+	tap_test(co_nmt_get_boot_rec(master, SLAVE_ID, NULL) == 0,
+			"no record without the boot cache");
+
+	co_nmt_set_boot_cache(master, 1);
+	reset(master);
+	struct co_nmt_boot_rec rec = CO_NMT_BOOT_REC_INIT;
+	tap_test(nboot == 1 && !nerror && n1018 == 1 && n1020 == 2,
+			"identity read on a boot cache miss");
+	tap_test(co_nmt_get_boot_rec(master, SLAVE_ID, &rec) == 1
+					&& rec.serial_nr == SERIAL_NR
+					&& rec.cfg_date == CFG_DATE
+					&& rec.cfg_time == CFG_TIME,
+			"successful boot recorded in the boot cache");
+
+	tap_assert(!co_nmt_save_boot_cache(master, FILENAME));
+	tap_assert(!co_nmt_set_boot_rec(master, SLAVE_ID, NULL));
+	tap_assert(!co_nmt_load_boot_cache(master, FILENAME));
+	remove(FILENAME);
+	struct co_nmt_boot_rec loaded = CO_NMT_BOOT_REC_INIT;
+	tap_test(co_nmt_get_boot_rec(master, SLAVE_ID, &loaded) == 1
+					&& !memcmp(&loaded, &rec, sizeof(rec)),
+			"boot cache stored and loaded");
+
+	// The configuration is still checked on a boot cache hit.
+	reset(master);
+	tap_test(nboot == 1 && !nerror && !n1018 && n1020 == 2,
+			"identity check skipped on a boot cache hit");
+
+	// A record that does not match the expected identity is not used.
+	rec.serial_nr = SERIAL_NR + 1;
+	tap_assert(!co_nmt_set_boot_rec(master, SLAVE_ID, &rec));
+	reset(master);
+	tap_test(nboot == 1 && !nerror && n1018 == 1 && n1020 == 2,
+			"identity checked after the expected identity changed");
+
+	// If the slave no longer has the recorded configuration (for example,
+	// after its stored parameters were restored to their defaults), the
+	// identity is checked before the configuration is updated.
+	tap_assert(!co_nmt_set_boot_rec(master, SLAVE_ID, &loaded));
+	reset(master);
+	tap_assert(co_dev_set_val_u32(sdev, 0x1020, 0x01, 0));
+	boot(master);
+	tap_test(nboot == 1 && !nerror && n1018 == 1 && n1020 == 1,
+			"identity checked after the configuration check failed");
+	tap_test(co_nmt_get_boot_rec(master, SLAVE_ID, &rec) == 1
+					&& !memcmp(&loaded, &rec, sizeof(rec)),
+			"updated configuration recorded in the boot cache");
+
+	co_nmt_destroy(slave);
+	co_dev_destroy(sdev);
+	co_nmt_destroy(master);
+	co_dev_destroy(mdev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+void
+boot_ind(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es,
+		void *data)
+{
+	(void)nmt;
+	(void)st;
+	(void)data;
+
+	tap_diag("slave %d finished booting with error status %c", id,
+			es ? es : '0');
+
+	nboot++;
+	if (es)
+		nerror++;
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	struct co_test *test = data;
+	tap_assert(test);
+
+	// Count the SDO 'initiate upload' requests.
+	if (msg->id == 0x600 + SLAVE_ID && msg->len == 8
+			&& (msg->data[0] & 0xe0) == 0x40) {
+		co_unsigned16_t idx = ldle_u16(msg->data + 1);
+		if (idx == 0x1018)
+			n1018++;
+		else if (idx == 0x1020)
+			n1020++;
+	}
+
+	return can_buf_write(&test->buf, msg, 1) ? 0 : -1;
+}
+
+static void
+run(void)
+{
+	// Deliver the queued frames with a latency of 1 ms until the network is
+	// idle.
+	for (int i = 0; i < MAX_STEPS && can_buf_size(&test.buf); i++) {
+		timespec_add_msec(&now, 1);
+		can_net_set_time(net, &now);
+		for (size_t n = can_buf_size(&test.buf); n; n--) {
+			struct can_msg msg = CAN_MSG_INIT;
+			if (can_buf_read(&test.buf, &msg, 1) != 1)
+				break;
+			can_net_recv(net, &msg);
+		}
+	}
+}
+
+static void
+reset(co_nmt_t *nmt)
+{
+	nboot = 0;
+	nerror = 0;
+	n1018 = 0;
+	n1020 = 0;
+
+	tap_assert(!co_nmt_cs_ind(nmt, CO_NMT_CS_RESET_NODE));
+	run();
+}
+
+static void
+boot(co_nmt_t *nmt)
+{
+	nboot = 0;
+	nerror = 0;
+	n1018 = 0;
+	n1020 = 0;
+
+	tap_assert(!co_nmt_boot_req(nmt, SLAVE_ID, 100));
+	run();
+}
@@ -0,0 +1,201 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/nmt.h>
+#include <lely/co/sdo.h>
+#include <lely/util/time.h>
+
+#define NUM_SLAVES 3
+#define MAX_STEPS 1000
+
+static can_net_t *net;
+static struct co_test test;
+static struct timespec now;
+
+// The number of slaves with an SDO request since the start of their 'boot
+// slave' process, and the maximum of that number.
+static int active[CO_NUM_NODES + 1];
+static int nactive;
+static int max_active;
+
+static int nboot;
+static int nerror;
+// The node-IDs of the slaves in the order in which they finished booting.
+static co_unsigned8_t booted[NUM_SLAVES];
+
+void boot_ind(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es,
+		void *data);
+
+static int send_func(const struct can_msg *msg, void *data);
+static void run(void);
+static void reset(co_nmt_t *nmt);
+
+int
+main(void)
+{
+	tap_plan(7);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	net = can_net_create();
+	tap_assert(net);
+	co_test_init(&test, net, 0);
+	// Replace the send function to keep track of the SDO requests, and to
+	// deliver the CAN frames in virtual time.
+	can_net_set_send_func(net, &send_func, &test);
+	can_net_set_time(net, &now);
+
+	co_dev_t *mdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-nmt-boot.dcf");
+	tap_assert(mdev);
+	co_nmt_t *master = co_nmt_create(net, mdev);
+	tap_assert(master);
+	co_nmt_set_boot_ind(master, &boot_ind, NULL);
+	co_nmt_set_timeout(master, 100);
+
+	co_dev_t *sdevs[NUM_SLAVES];
+	co_nmt_t *slaves[NUM_SLAVES];
+	for (int i = 0; i < NUM_SLAVES; i++) {
+		sdevs[i] = co_dev_create_from_dcf_file(
+				TEST_SRCDIR "/co-nmt-hb.dcf");
+		tap_assert(sdevs[i]);
+		co_dev_set_id(sdevs[i], i + 2);
+		slaves[i] = co_nmt_create(net, sdevs[i]);
+		tap_assert(slaves[i]);
+		tap_assert(!co_nmt_cs_ind(slaves[i], CO_NMT_CS_RESET_NODE));
+	}
+	run();
+
+	co_nmt_set_boot_max(master, 1);
+	tap_test(co_nmt_get_boot_max(master) == 1, "boot limit set");
+	reset(master);
+	tap_test(nboot == NUM_SLAVES && !nerror && max_active == 1,
+			"slaves booted one at a time");
+
+	struct co_nmt_boot_times times[NUM_SLAVES];
+	for (int i = 0; i < NUM_SLAVES; i++)
+		tap_assert(!co_nmt_get_boot_times(master, i + 2, &times[i]));
+	uint_least64_t queue[NUM_SLAVES];
+	for (int i = 0; i < NUM_SLAVES; i++)
+		queue[i] = times[i].phase[CO_NMT_BOOT_PHASE_QUEUE];
+	tap_test(!queue[0] && queue[1] && queue[2] > queue[1],
+			"queued slaves report the time spent waiting");
+
+	int ok = 1;
+	for (int i = 0; ok && i < NUM_SLAVES; i++) {
+		uint_least64_t sum = 0;
+		for (int j = 0; j < CO_NMT_BOOT_NUM_PHASE; j++)
+			sum += times[i].phase[j];
+		ok = times[i].attempts == 1
+				&& times[i].phase[CO_NMT_BOOT_PHASE_ID] > 0
+				&& sum == times[i].total;
+	}
+	tap_test(ok, "phase durations add up to the total boot time");
+
+	// Requests issued at the same time are started in the order in which
+	// they were submitted, not in the order of their node-IDs.
+	nboot = 0;
+	nerror = 0;
+	for (int i = NUM_SLAVES - 1; i >= 0; i--)
+		tap_assert(!co_nmt_boot_req(master, i + 2, 100));
+	run();
+	ok = nboot == NUM_SLAVES && !nerror;
+	for (int i = 0; ok && i < NUM_SLAVES; i++)
+		ok = booted[i] == NUM_SLAVES + 1 - i;
+	tap_test(ok, "queued slaves booted in the order of submission");
+
+	co_nmt_set_boot_max(master, 0);
+	reset(master);
+	tap_test(nboot == NUM_SLAVES && !nerror && max_active == NUM_SLAVES,
+			"slaves booted concurrently without a limit");
+
+	ok = 1;
+	for (int i = 0; ok && i < NUM_SLAVES; i++) {
+		tap_assert(!co_nmt_get_boot_times(master, i + 2, &times[i]));
+		ok = !times[i].phase[CO_NMT_BOOT_PHASE_QUEUE];
+	}
+	tap_test(ok, "no queueing without a limit");
+
+	for (int i = 0; i < NUM_SLAVES; i++) {
+		co_nmt_destroy(slaves[i]);
+		co_dev_destroy(sdevs[i]);
+	}
+	co_nmt_destroy(master);
+	co_dev_destroy(mdev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+void
+boot_ind(co_nmt_t *nmt, co_unsigned8_t id, co_unsigned8_t st, char es,
+		void *data)
+{
+	(void)nmt;
+	(void)st;
+	(void)data;
+
+	tap_diag("slave %d finished booting with error status %c", id,
+			es ? es : '0');
+
+	if (nboot < NUM_SLAVES)
+		booted[nboot] = id;
+	nboot++;
+	if (es)
+		nerror++;
+	if (active[id]) {
+		active[id] = 0;
+		nactive--;
+	}
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	struct co_test *test = data;
+	tap_assert(test);
+
+	// Count the slaves with an outstanding Client-SDO request.
+	if (msg->id > 0x600 && msg->id <= 0x67f) {
+		co_unsigned8_t id = msg->id - 0x600;
+		if (!active[id]) {
+			active[id] = 1;
+			if (++nactive > max_active)
+				max_active = nactive;
+		}
+	}
+
+	return can_buf_write(&test->buf, msg, 1) ? 0 : -1;
+}
+
+static void
+run(void)
+{
+	// Deliver the queued frames with a latency of 1 ms until the network is
+	// idle.
+	for (int i = 0; i < MAX_STEPS && can_buf_size(&test.buf); i++) {
+		timespec_add_msec(&now, 1);
+		can_net_set_time(net, &now);
+		for (size_t n = can_buf_size(&test.buf); n; n--) {
+			struct can_msg msg = CAN_MSG_INIT;
+			if (can_buf_read(&test.buf, &msg, 1) != 1)
+				break;
+			can_net_recv(net, &msg);
+		}
+	}
+}
+
+static void
+reset(co_nmt_t *nmt)
+{
+	nboot = 0;
+	nerror = 0;
+	max_active = 0;
+
+	tap_assert(!co_nmt_cs_ind(nmt, CO_NMT_CS_RESET_NODE));
+	run();
+}
@@ -0,0 +1,168 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/nmt.h>
+#include <lely/co/obj.h>
+#include <lely/co/sdo.h>
+#include <lely/util/time.h>
+
+#define MAX_EVENTS 16
+
+struct event {
+	co_unsigned8_t id;
+	int state;
+	int reason;
+};
+
+static struct event events[MAX_EVENTS];
+static int nevents;
+
+void hb_ind(co_nmt_t *nmt, co_unsigned8_t id, int state, int reason,
+		void *data);
+
+static void set_time(can_net_t *net, uint_least64_t ms);
+static void recv_hb(can_net_t *net, co_unsigned8_t id, co_unsigned8_t st);
+static co_unsigned32_t dn_1016(
+		co_dev_t *dev, co_unsigned8_t subidx, co_unsigned32_t val);
+static int check_event(int i, co_unsigned8_t id, int state, int reason);
+
+int
+main(void)
+{
+	tap_plan(8);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	can_net_t *net = can_net_create();
+	tap_assert(net);
+	struct co_test test;
+	co_test_init(&test, net, 0);
+	set_time(net, 0);
+
+	co_dev_t *dev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-nmt-hb.dcf");
+	tap_assert(dev);
+
+	co_nmt_t *nmt = co_nmt_create(net, dev);
+	tap_assert(nmt);
+	co_nmt_set_hb_ind(nmt, &hb_ind, NULL);
+	tap_assert(!co_nmt_cs_ind(nmt, CO_NMT_CS_RESET_NODE));
+
+	set_time(net, 1000);
+	tap_test(!nevents, "no heartbeat events before the first heartbeat");
+
+	for (co_unsigned8_t id = 2; id <= 4; id++)
+		recv_hb(net, id, CO_NMT_ST_START);
+	tap_test(nevents == 3
+					&& check_event(0, 2, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_STATE)
+					&& check_event(1, 3, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_STATE)
+					&& check_event(2, 4, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_STATE),
+			"state change reported for nodes 2, 3 and 4");
+
+	nevents = 0;
+	set_time(net, 1099);
+	tap_test(!nevents, "no heartbeat timeout before the deadline");
+	set_time(net, 1100);
+	tap_test(nevents == 1
+					&& check_event(0, 2, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_TIMEOUT),
+			"heartbeat timeout occurred for node 2");
+
+	nevents = 0;
+	set_time(net, 1250);
+	tap_test(nevents == 2
+					&& check_event(0, 3, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_TIMEOUT)
+					&& check_event(1, 4, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_TIMEOUT),
+			"heartbeat timeouts occurred in deadline order");
+
+	nevents = 0;
+	recv_hb(net, 2, CO_NMT_ST_START);
+	tap_test(nevents == 1
+					&& check_event(0, 2, CO_NMT_EC_RESOLVED,
+							CO_NMT_EC_TIMEOUT),
+			"heartbeat timeout resolved for node 2");
+
+	nevents = 0;
+	dn_1016(dev, 1, 0);
+	set_time(net, 2000);
+	tap_test(!nevents && dn_1016(dev, 4, 0x00030064) == CO_SDO_AC_PARAM,
+			"disabled consumer is silent, duplicates are refused");
+
+	// Move the consumer for node 3 to node 5.
+	dn_1016(dev, 2, 0x00050064);
+	recv_hb(net, 3, CO_NMT_ST_START);
+	recv_hb(net, 5, CO_NMT_ST_PREOP);
+	set_time(net, 2100);
+	tap_test(nevents == 2
+					&& check_event(0, 5, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_STATE)
+					&& check_event(1, 5, CO_NMT_EC_OCCURRED,
+							CO_NMT_EC_TIMEOUT),
+			"consumer moved from node 3 to node 5");
+
+	co_nmt_destroy(nmt);
+	co_dev_destroy(dev);
+
+	co_test_fini(&test);
+	can_net_destroy(net);
+
+	return 0;
+}
+
+void
+hb_ind(co_nmt_t *nmt, co_unsigned8_t id, int state, int reason, void *data)
+{
+	(void)nmt;
+	(void)data;
+
+	// clang-format off
+	tap_diag("heartbeat %s %s for node %d",
+			reason == CO_NMT_EC_TIMEOUT
+					? "timeout" : "state change",
+			state == CO_NMT_EC_OCCURRED ? "occurred" : "resolved",
+			id);
+	// clang-format on
+
+	if (nevents < MAX_EVENTS)
+		events[nevents++] = (struct event){ id, state, reason };
+}
+
+static void
+set_time(can_net_t *net, uint_least64_t ms)
+{
+	struct timespec tp = { 0, 0 };
+	timespec_add_msec(&tp, ms);
+	can_net_set_time(net, &tp);
+}
+
+static void
+recv_hb(can_net_t *net, co_unsigned8_t id, co_unsigned8_t st)
+{
+	struct can_msg msg = CAN_MSG_INIT;
+	msg.id = CO_NMT_EC_CANID(id);
+	msg.len = 1;
+	msg.data[0] = st;
+	can_net_recv(net, &msg);
+}
+
+static co_unsigned32_t
+dn_1016(co_dev_t *dev, co_unsigned8_t subidx, co_unsigned32_t val)
+{
+	co_sub_t *sub = co_dev_find_sub(dev, 0x1016, subidx);
+	tap_assert(sub);
+	return co_sub_dn_ind_val(sub, CO_DEFTYPE_UNSIGNED32, &val);
+}
+
+static int
+check_event(int i, co_unsigned8_t id, int state, int reason)
+{
+	return i < nevents && events[i].id == id && events[i].state == state
+			&& events[i].reason == reason;
+}
@@ -0,0 +1,206 @@
+#include "co-test.h"
+#include <lely/co/dcf.h>
+#include <lely/co/time.h>
+#include <lely/util/time.h>
+
+// The offset (in seconds) of the producer clock with respect to the consumer
+// (September 13, 2020).
+#define OFFSET 1600000000
+// The drift (in ppm) of the producer clock with respect to the consumer.
+#define DRIFT 200
+// The interval (in milliseconds) between successive time stamps.
+#define INTERVAL 100
+// The delay (in microseconds) between sending and receiving a CAN frame.
+#define LATENCY 3000
+// The duration (in microseconds) of a simulation step.
+#define STEP 100
+// The maximum number of CAN frames in transit.
+#define MAX_FRAMES 32
+
+// The CAN network interfaces of the producer and the consumer. Each has its own
+// clock.
+static can_net_t *pnet;
+static can_net_t *cnet;
+static struct co_test test;
+
+// The time (in nanoseconds) according to the consumer clock.
+static int_least64_t now;
+// The offset (in nanoseconds) added to the producer clock.
+static int_least64_t step;
+
+// The CAN frames in transit and the consumer time at which they arrive.
+static struct {
+	struct can_msg msg;
+	int_least64_t t;
+} frames[MAX_FRAMES];
+static int nframes;
+
+static co_time_t *prod;
+// A flag specifying whether the producer receives transmit confirmations.
+static int tx_con;
+
+static int send_func(const struct can_msg *msg, void *data);
+static void to_timespec(int_least64_t t, struct timespec *tp);
+static int_least64_t producer_time(int_least64_t t);
+static void run(int msec);
+static int_least64_t clock_error(co_time_t *cons, uint_least64_t *perr);
+
+int
+main(void)
+{
+	tap_plan(7);
+
+#if !LELY_NO_STDIO && !LELY_NO_DIAG
+	diag_set_handler(&co_test_diag_handler, NULL);
+	diag_at_set_handler(&co_test_diag_at_handler, NULL);
+#endif
+
+	pnet = can_net_create();
+	tap_assert(pnet);
+	can_net_set_send_func(pnet, &send_func, NULL);
+	cnet = can_net_create();
+	tap_assert(cnet);
+	co_test_init(&test, cnet, 0);
+	// Replace the send function to deliver the CAN frames with a fixed
+	// latency in virtual time.
+	can_net_set_send_func(cnet, &send_func, NULL);
+	run(0);
+
+	co_dev_t *pdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-time.dcf");
+	tap_assert(pdev);
+	prod = co_time_create(pnet, pdev);
+	tap_assert(prod);
+
+	co_dev_t *cdev = co_dev_create_from_dcf_file(
+			TEST_SRCDIR "/co-time.dcf");
+	tap_assert(cdev);
+	co_time_t *cons = co_time_create(cnet, cdev);
+	tap_assert(cons);
+	co_time_set_discipline(cons, 1);
+
+	struct timespec tp = { 0, 0 };
+	tap_test(co_time_get_clock(cons, NULL, &tp, NULL) == -1
+					&& get_errnum() == ERRNUM_AGAIN,
+			"clock not synchronized before receiving time stamps");
+
+	struct timespec interval = { 0, 1000000 * INTERVAL };
+	co_time_start_prod(prod, NULL, &interval);
+
+	// Without transmit confirmations, the latency shows up as an offset.
+	run(10000);
+	struct co_time_clock_stats stats = CO_TIME_CLOCK_STATS_INIT;
+	co_time_get_clock_stats(cons, &stats);
+	uint_least64_t err = 0;
+	int_least64_t error = clock_error(cons, &err);
+	tap_diag("error %d us (bound %d us), drift %d ppb",
+			(int)(error / 1000), (int)(err / 1000),
+			(int)stats.drift);
+	tap_test(stats.drift > (DRIFT - 20) * 1000
+					&& stats.drift < (DRIFT + 20) * 1000,
+			"drift estimated");
+	tap_test(error < -(LATENCY - 1000) * 1000,
+			"latency not compensated without transmit confirmations");
+
+	// Enable the transmit confirmations.
+	tx_con = 1;
+	run(10000);
+	co_time_get_clock_stats(prod, &stats);
+	tap_test(stats.txdelay > (LATENCY - 1) * 1000
+					&& stats.txdelay < (LATENCY + 1) * 1000,
+			"transmit delay estimated");
+	error = clock_error(cons, &err);
+	tap_diag("error %d us (bound %d us)", (int)(error / 1000),
+			(int)(err / 1000));
+	uint_least64_t abs_error = error < 0 ? -error : error;
+	tap_test(abs_error < 1000000 && abs_error <= err,
+			"disciplined clock within the error bound");
+
+	struct timespec local = { 0, 0 };
+	to_timespec(now + 1000000000, &local);
+	uint_least64_t err_later = 0;
+	tap_assert(!co_time_get_clock(cons, &local, &tp, &err_later));
+	tap_test(err_later > err,
+			"error bound grows with the extrapolation time");
+
+	// Step the producer clock.
+	step = 1000000000;
+	run(10000);
+	co_time_get_clock_stats(cons, &stats);
+	error = clock_error(cons, &err);
+	tap_test(stats.nstep == 1 && error > -1000000 && error < 1000000,
+			"filter restarted after a step of the producer clock");
+
+	co_time_destroy(cons);
+	co_dev_destroy(cdev);
+	co_time_destroy(prod);
+	co_dev_destroy(pdev);
+
+	co_test_fini(&test);
+	can_net_destroy(cnet);
+	can_net_destroy(pnet);
+
+	return 0;
+}
+
+static int
+send_func(const struct can_msg *msg, void *data)
+{
+	(void)data;
+
+	tap_assert(nframes < MAX_FRAMES);
+	frames[nframes].msg = *msg;
+	frames[nframes].t = now + LATENCY * 1000;
+	nframes++;
+
+	return 0;
+}
+
+static void
+to_timespec(int_least64_t t, struct timespec *tp)
+{
+	tp->tv_sec = (time_t)(t / 1000000000);
+	tp->tv_nsec = (long)(t % 1000000000);
+}
+
+static int_least64_t
+producer_time(int_least64_t t)
+{
+	return t + t / 1000000 * DRIFT + (int_least64_t)OFFSET * 1000000000
+			+ step;
+}
+
+static void
+run(int msec)
+{
+	for (int_least64_t end = now + (int_least64_t)msec * 1000000;
+			now <= end; now += STEP * 1000) {
+		struct timespec ptime = { 0, 0 };
+		to_timespec(producer_time(now), &ptime);
+		can_net_set_time(pnet, &ptime);
+		struct timespec ctime = { 0, 0 };
+		to_timespec(now, &ctime);
+		can_net_set_time(cnet, &ctime);
+
+		// Deliver the CAN frames that have arrived.
+		while (nframes && frames[0].t <= now) {
+			struct can_msg msg = frames[0].msg;
+			nframes--;
+			for (int i = 0; i < nframes; i++)
+				frames[i] = frames[i + 1];
+			if (tx_con)
+				co_time_tx_con(prod, &msg, &ptime);
+			can_net_recv(cnet, &msg);
+		}
+	}
+}
+
+static int_least64_t
+clock_error(co_time_t *cons, uint_least64_t *perr)
+{
+	struct timespec tp = { 0, 0 };
+	tap_assert(!co_time_get_clock(cons, NULL, &tp, perr));
+	struct timespec ptime = { 0, 0 };
+	can_net_get_time(pnet, &ptime);
+	return timespec_diff_nsec(&tp, &ptime);
+}
@@ -0,0 +1,107 @@
+#include "test.h"
+#include <lely/coapp/bus_runtime.hpp>
+#include <lely/io2/sys/io.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace lely::io;
+using namespace lely::canopen;
+
+// Runs a task on the event loop of the runtime and waits for it to complete.
+template <class F>
+static void
+run(BusRuntime& bus, F&& f) {
+  ::std::atomic<bool> done{false};
+  bus.GetExecutor().post([&]() {
+    f();
+    done = true;
+  });
+  while (!done) ::std::this_thread::yield();
+}
+
+int
+main() {
+  tap_plan(8);
+
+  IoGuard io_guard;
+  Context ctx;
+
+  // Pin the runtime to one of the CPUs this process is allowed to run on.
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  tap_assert(!sched_getaffinity(0, sizeof(cpuset), &cpuset));
+  int pin = 0;
+  while (!CPU_ISSET(pin, &cpuset)) pin++;
+
+  BusRuntimeAttributes attr;
+  attr.cpus = {pin};
+  attr.stack_size = 1024 * 1024;
+  attr.prefault_stack = 256 * 1024;
+  attr.latency_period = ::std::chrono::milliseconds(1);
+  BusRuntime bus(ctx, attr);
+
+  pthread_t thr{};
+  int cpu = -1;
+  run(bus, [&]() {
+    thr = pthread_self();
+    cpu = sched_getcpu();
+  });
+  tap_test(!pthread_equal(thr, pthread_self()),
+           "tasks run in the thread of the runtime");
+  tap_test(cpu == pin, "the thread is pinned to CPU %d", cpu);
+
+  ::std::this_thread::sleep_for(::std::chrono::milliseconds(50));
+  auto stats = bus.GetStats();
+  tap_test(stats.n > 0 && stats.min <= stats.max,
+           "%zu latency measurements (max %lld ns)", stats.n,
+           static_cast<long long>(stats.max.count()));
+
+  bus.ResetStats();
+  tap_test(bus.GetStats().n <= 1, "reset the latency statistics");
+
+  // A real-time scheduling policy requires privileges, which may not be
+  // available.
+  attr = BusRuntimeAttributes();
+  attr.policy = SCHED_FIFO;
+  attr.priority = 1;
+  try {
+    BusRuntime rt_bus(ctx, attr);
+    int policy = SCHED_OTHER;
+    run(rt_bus, [&]() {
+      sched_param param{};
+      pthread_getschedparam(pthread_self(), &policy, &param);
+    });
+    tap_test(policy == SCHED_FIFO, "the thread runs with SCHED_FIFO");
+  } catch (const ::std::system_error& e) {
+    tap_skip(0, "SCHED_FIFO is not permitted: %s", e.what());
+  }
+
+  try {
+    BusRuntime bad_bus(ctx, "lely-no-such-if");
+    tap_fail("opened a nonexistent CAN interface");
+  } catch (const ::std::system_error& e) {
+    tap_pass("a nonexistent CAN interface is rejected: %s", e.what());
+  }
+
+  attr = BusRuntimeAttributes();
+  attr.stack_size = 256 * 1024;
+  attr.prefault_stack = attr.stack_size;
+  try {
+    BusRuntime bad_bus(ctx, attr);
+    tap_fail("accepted a prefault size equal to the stack size");
+  } catch (const ::std::system_error& e) {
+    tap_test(e.code() == ::std::errc::invalid_argument,
+             "a prefault size equal to the stack size is rejected");
+  }
+
+  bus.Join();
+  bus.Join();
+  tap_pass("the runtime can be joined more than once");
+
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include "test.h"
+#include <lely/coapp/driver.hpp>
+#include <lely/ev/loop.hpp>
+#include <lely/io2/sys/clock.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/user/timer.hpp>
+#include <lely/io2/vcan.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+
+using namespace lely;
+using namespace lely::ev;
+using namespace lely::io;
+using namespace lely::canopen;
+
+#define NUM_CYCLE 100
+#define MAX_EVENT 16
+
+// The number of calls to the global operator new while counting is enabled.
+static bool count_alloc;
+static ::std::size_t nalloc;
+
+void*
+operator new(::std::size_t size) {
+  if (count_alloc) nalloc++;
+  void* ptr = ::std::malloc(size ? size : 1);
+  if (!ptr) throw ::std::bad_alloc();
+  return ptr;
+}
+
+// GCC does not recognize that the replacement operator new uses malloc().
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void
+operator delete(void* ptr) noexcept {
+  ::std::free(ptr);
+}
+
+void
+operator delete(void* ptr, ::std::size_t) noexcept {
+  ::std::free(ptr);
+}
+
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// The notifications delivered to the driver. The array is preallocated so
+// recording a notification does not allocate memory.
+enum class Type { RPDO_WRITE, HEARTBEAT, SYNC };
+
+struct Record {
+  Type type;
+  unsigned int value;
+};
+
+static Record records[MAX_EVENT];
+static int nrecord;
+
+static void
+record(Type type, unsigned int value) {
+  tap_assert(nrecord < MAX_EVENT);
+  records[nrecord++] = {type, value};
+}
+
+class MyMaster : public AsyncMaster {
+ public:
+  using AsyncMaster::AsyncMaster;
+
+  // Generates a burst of notifications for a driver, as the CANopen stack
+  // would. Consecutive SYNC notifications are coalesced and duplicate RPDO
+  // write notifications dropped, but neither may overtake the heartbeat event.
+  void
+  Burst(uint8_t id) {
+    ::std::lock_guard<util::BasicLockable> lock(*this);
+    OnSync(1, {});
+    OnSync(2, {});
+    OnRpdoWrite(id, 0x2000, 0);
+    OnRpdoWrite(id, 0x2000, 0);
+    OnRpdoWrite(id, 0x2001, 0);
+    OnHeartbeat(id, true);
+    OnSync(3, {});
+    OnRpdoWrite(id, 0x2000, 0);
+    OnSync(4, {});
+  }
+};
+
+class MyDriver : public BasicDriver {
+ public:
+  using BasicDriver::BasicDriver;
+
+ private:
+  void
+  OnRpdoWrite(uint16_t idx, uint8_t) noexcept override {
+    record(Type::RPDO_WRITE, idx);
+  }
+
+  void
+  OnHeartbeat(bool occurred) noexcept override {
+    record(Type::HEARTBEAT, occurred);
+  }
+
+  void
+  OnSync(uint8_t cnt, const time_point&) noexcept override {
+    record(Type::SYNC, cnt);
+  }
+};
+
+static bool
+check_burst() {
+  static const Record expected[] = {
+      {Type::SYNC, 2},      {Type::RPDO_WRITE, 0x2000},
+      {Type::RPDO_WRITE, 0x2001},
+      {Type::HEARTBEAT, 1}, {Type::SYNC, 3},
+      {Type::RPDO_WRITE, 0x2000},
+      {Type::SYNC, 4}};
+  const int n = sizeof(expected) / sizeof(*expected);
+  bool ok = nrecord == n;
+  for (int i = 0; ok && i < n; i++)
+    ok = records[i].type == expected[i].type &&
+         records[i].value == expected[i].value;
+  nrecord = 0;
+  return ok;
+}
+
+// Runs all pending driver tasks. The loop stops once it runs out of work, so it
+// has to be restarted every time.
+static ::std::size_t
+poll(Loop& loop) {
+  loop.restart();
+  return loop.poll();
+}
+
+int
+main() {
+  tap_plan(5);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop mloop;
+  VirtualCanController ctrl(clock_monotonic);
+  VirtualCanChannel chan(ctx, mloop.get_executor());
+  chan.open(ctrl);
+  UserTimer timer(ctx, mloop.get_executor());
+  MyMaster master(timer, chan, TEST_SRCDIR "/coapp-fiber-master.dcf", "", 1);
+
+  // The notifications are only delivered when the loop of the driver is
+  // polled.
+  Loop dloop;
+  ::std::unique_ptr<MyDriver> driver(
+      new MyDriver(dloop.get_executor(), master, 127));
+
+  master.Burst(127);
+  tap_test(!nrecord, "notifications are queued until the driver runs");
+  poll(dloop);
+  tap_test(check_burst(), "coalesced notifications are delivered in order");
+
+  // Once the mailbox has reached its steady-state size, queueing and
+  // delivering notifications does not allocate memory.
+  bool ok = true;
+  count_alloc = true;
+  for (int i = 0; ok && i < NUM_CYCLE; i++) {
+    master.Burst(127);
+    ok = poll(dloop) == 1 && check_burst();
+  }
+  count_alloc = false;
+  tap_test(ok && !nalloc, "%zu allocations in %d cycles", nalloc, NUM_CYCLE);
+
+  // Destroying a driver unregisters it and discards its pending notifications.
+  // The mailbox task is no longer pending either.
+  master.Burst(127);
+  driver.reset();
+  tap_test(!poll(dloop) && !nrecord,
+           "pending notifications discarded on driver removal");
+
+  // The mailbox is reused by the next driver for the same node.
+  driver.reset(new MyDriver(dloop.get_executor(), master, 127));
+  master.Burst(127);
+  poll(dloop);
+  tap_test(check_burst(), "notifications delivered to a new driver");
+
+  // Cancel the pending CAN frame read operations of the master.
+  ctx.shutdown();
+  poll(mloop);
+
+  return 0;
+}
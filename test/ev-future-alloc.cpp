@@ -0,0 +1,84 @@
+#include "test.h"
+#include <lely/ev/future.hpp>
+#include <lely/ev/thrd_loop.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#define NUM_OP 1024
+
+using namespace lely::ev;
+
+static ::std::size_t num_new;
+
+void*
+operator new(::std::size_t size) {
+  num_new++;
+  void* ptr = ::std::malloc(size ? size : 1);
+  if (!ptr) throw ::std::bad_alloc();
+  return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept {
+  ::std::free(ptr);
+}
+
+// Emulates an asynchronous SDO request followed by two continuations.
+static ::std::uint32_t
+chain(Executor exec, ::std::uint32_t value) {
+  Promise<::std::uint32_t> p;
+  auto f = p.get_future()
+               .then(exec,
+                     [](Future<::std::uint32_t> f) {
+                       return f.get().value() + 1;
+                     })
+               .then(exec, [](Future<::std::uint32_t, ::std::exception_ptr> f) {
+                 return f.get().value() * 2;
+               });
+  p.set(value);
+  ThreadLoop::run();
+  ThreadLoop::restart();
+  return f.get().value();
+}
+
+int
+main() {
+  tap_plan(6);
+
+  auto exec = ThreadLoop::get_executor();
+
+  ev_promise_stats stats = PromiseThread::get_stats();
+  ::std::size_t nalloc = stats.nalloc;
+  chain(exec, 0);
+  stats = PromiseThread::get_stats();
+  tap_test(stats.nalloc == nalloc + 3, "without cache: %zu promises allocated",
+           stats.nalloc - nalloc);
+
+  PromiseThread thrd;
+
+  // Warm up the cache.
+  chain(exec, 0);
+
+  stats = PromiseThread::get_stats();
+  nalloc = stats.nalloc;
+  ::std::size_t nreused = stats.nreused;
+  ::std::size_t n = num_new;
+
+  bool ok = true;
+  for (::std::uint32_t i = 0; i < NUM_OP; i++)
+    ok &= chain(exec, i) == 2 * (i + 1);
+  tap_test(ok, "all chains completed with the correct value");
+
+  stats = PromiseThread::get_stats();
+  tap_test(stats.nalloc == nalloc, "steady state: %zu promises allocated",
+           stats.nalloc - nalloc);
+  tap_test(stats.nreused == nreused + 3 * NUM_OP, "%zu promises reused",
+           stats.nreused - nreused);
+  tap_test(num_new == n, "steady state: %zu calls to operator new",
+           num_new - n);
+  tap_test(stats.nunused == 3, "%zu unused promises cached", stats.nunused);
+
+  return 0;
+}
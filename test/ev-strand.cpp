@@ -0,0 +1,88 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/ev/strand.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace lely::ev;
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define NUM_OP (128 * 1024)
+
+struct MyTask : ev_task {
+  ::std::size_t producer{0};
+  ::std::size_t seq{0};
+};
+
+::std::atomic_flag running = ATOMIC_FLAG_INIT;
+::std::atomic<bool> concurrent{false};
+::std::size_t next_seq[NUM_PRODUCERS];
+bool in_order = true;
+::std::size_t nop = 0;
+
+void
+func(ev_task* task) noexcept {
+  auto self = static_cast<MyTask*>(task);
+  // Tasks submitted to a strand never run concurrently.
+  if (running.test_and_set(::std::memory_order_acquire)) concurrent = true;
+  // Tasks submitted by the same producer run in FIFO order.
+  if (self->seq != next_seq[self->producer]++) in_order = false;
+  nop++;
+  running.clear(::std::memory_order_release);
+}
+
+int
+main() {
+  tap_plan(3);
+
+  Loop loop;
+  auto exec = loop.get_executor();
+  Strand strand(exec);
+
+  ::std::vector<MyTask> tasks(NUM_PRODUCERS * NUM_OP);
+  for (::std::size_t i = 0; i < NUM_PRODUCERS; i++) {
+    for (::std::size_t j = 0; j < NUM_OP; j++) {
+      auto& task = tasks[i * NUM_OP + j];
+      static_cast<ev_task&>(task) = EV_TASK_INIT(nullptr, &func);
+      task.producer = i;
+      task.seq = j;
+    }
+  }
+
+  // Prevent the consumers from returning before the producers are done.
+  exec.on_task_init();
+
+  auto t1 = ::std::chrono::high_resolution_clock::now();
+
+  ::std::vector<::std::thread> consumers;
+  for (int i = 0; i < NUM_CONSUMERS; i++)
+    consumers.emplace_back([&]() { loop.run(); });
+
+  ::std::vector<::std::thread> producers;
+  for (::std::size_t i = 0; i < NUM_PRODUCERS; i++) {
+    producers.emplace_back([&, i]() {
+      for (::std::size_t j = 0; j < NUM_OP; j++)
+        strand.post(tasks[i * NUM_OP + j]);
+    });
+  }
+
+  for (auto& thr : producers) thr.join();
+  exec.on_task_fini();
+  for (auto& thr : consumers) thr.join();
+
+  auto t2 = ::std::chrono::high_resolution_clock::now();
+
+  tap_test(nop == NUM_PRODUCERS * NUM_OP);
+  tap_test(!concurrent);
+  tap_test(in_order);
+
+  auto ns = ::std::chrono::nanoseconds(t2 - t1).count();
+  tap_diag("%d producers, %d consumers: %f ns per op", NUM_PRODUCERS,
+           NUM_CONSUMERS, double(ns) / nop);
+
+  return 0;
+}
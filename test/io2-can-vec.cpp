@@ -0,0 +1,149 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/io2/sys/clock.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/vcan.hpp>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define NUM_MSG 16
+
+static ::std::size_t nreadv;
+static ::std::size_t nwritev;
+
+static void
+readv_func(ev_task*) noexcept {
+  nreadv++;
+}
+
+static void
+writev_func(ev_task*) noexcept {
+  nwritev++;
+}
+
+// Runs all pending tasks. The loop stops once it runs out of work, so it has to
+// be restarted every time.
+static void
+poll(Loop& loop) {
+  loop.restart();
+  loop.poll();
+}
+
+// A CAN channel implemented before vectored operations were added to the
+// interface. Only the device is forwarded to another channel.
+struct LegacyChannel {
+  const io_can_chan_vtbl* vptr;
+  io_can_chan_t* chan;
+};
+
+static io_dev_t*
+legacy_get_dev(const io_can_chan_t* chan) noexcept {
+  return io_can_chan_get_dev(
+      reinterpret_cast<const LegacyChannel*>(chan)->chan);
+}
+
+// The vectored operations are left NULL, as they would be in an initializer
+// written for the old interface.
+static const io_can_chan_vtbl legacy_vtbl = {
+    &legacy_get_dev, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr};
+
+static bool
+check_msgs(const can_msg* msgs, ::std::size_t first, ::std::size_t n) {
+  for (::std::size_t i = 0; i < n; i++) {
+    if (msgs[i].id != first + i) return false;
+  }
+  return true;
+}
+
+int
+main() {
+  tap_plan(10);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  VirtualCanController ctrl(clock_monotonic);
+  VirtualCanChannel chan1(ctx, loop.get_executor());
+  VirtualCanChannel chan2(ctx, loop.get_executor());
+
+  chan1.open(ctrl);
+  chan2.open(ctrl);
+
+  can_msg txmsgs[NUM_MSG];
+  for (int i = 0; i < NUM_MSG; i++) {
+    txmsgs[i] = CAN_MSG_INIT;
+    txmsgs[i].id = i;
+  }
+  can_msg rxmsgs[NUM_MSG];
+  timespec rxtps[NUM_MSG];
+
+  // A vectored read does not complete until at least one frame is available.
+  io_can_chan_readv readv = IO_CAN_CHAN_READV_INIT(rxmsgs, rxtps, NUM_MSG / 2,
+                                                   nullptr, &readv_func);
+  chan2.submit_readv(readv);
+  poll(loop);
+  tap_test(!nreadv, "a vectored read waits for a CAN frame");
+
+  // Write all frames with a single operation.
+  io_can_chan_writev writev =
+      IO_CAN_CHAN_WRITEV_INIT(txmsgs, NUM_MSG, nullptr, &writev_func);
+  chan1.submit_writev(writev);
+  poll(loop);
+  tap_test(nwritev == 1 && writev.r.n == NUM_MSG && !writev.r.errc,
+           "a vectored write wrote %zu frames", writev.r.n);
+
+  // The pending read completes with as many frames as fit.
+  tap_test(nreadv == 1 && readv.r.n == NUM_MSG / 2 && !readv.r.errc &&
+               check_msgs(rxmsgs, 0, NUM_MSG / 2),
+           "a vectored read received %zu frames", readv.r.n);
+
+  // The remaining frames are read in one go.
+  readv.n = NUM_MSG;
+  chan2.submit_readv(readv);
+  poll(loop);
+  tap_test(nreadv == 2 && readv.r.n == NUM_MSG / 2 &&
+               check_msgs(rxmsgs, NUM_MSG / 2, NUM_MSG / 2),
+           "a vectored read received the remaining %zu frames", readv.r.n);
+
+  // Single and vectored reads complete in the order they were submitted.
+  chan1.write(txmsgs[0], 0);
+  chan1.write(txmsgs[1], 0);
+  can_msg msg = CAN_MSG_INIT;
+  int result = -1;
+  chan2.submit_read(&msg, nullptr, nullptr,
+                    [&](int result_, ::std::error_code) { result = result_; });
+  chan2.submit_readv(readv);
+  poll(loop);
+  tap_test(result == 1 && msg.id == 0 && nreadv == 3 && readv.r.n == 1 &&
+               rxmsgs[0].id == 1,
+           "single and vectored reads are completed in order");
+
+  // A vectored read can be canceled.
+  chan2.submit_readv(readv);
+  tap_test(chan2.cancel_readv(readv), "cancel a vectored read");
+  poll(loop);
+  tap_test(nreadv == 4 && !readv.r.n &&
+           readv.r.errc == errnum2c(ERRNUM_CANCELED));
+
+  // Channels that do not provide vectored operations report them as not
+  // supported.
+  LegacyChannel legacy = {&legacy_vtbl, chan2};
+  io_can_chan_t* legacy_chan = &legacy.vptr;
+  io_can_chan_submit_readv(legacy_chan, &readv);
+  poll(loop);
+  tap_test(nreadv == 5 && readv.r.errc == errnum2c(ERRNUM_NOTSUP),
+           "vectored read not supported");
+  io_can_chan_submit_writev(legacy_chan, &writev);
+  poll(loop);
+  tap_test(nwritev == 2 && writev.r.errc == errnum2c(ERRNUM_NOTSUP),
+           "vectored write not supported");
+
+  chan1.close();
+  chan2.close();
+  poll(loop);
+  tap_test(loop.poll() == 0);
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/io2/linux/can.hpp>
+#include <lely/io2/posix/poll.hpp>
+#include <lely/io2/sys/io.hpp>
+
+#include <cerrno>
+
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace lely;
+using namespace lely::ev;
+using namespace lely::io;
+
+#define NUM_MSG 8
+#define NUM_SENT 3
+
+// While set, sendmsg() fails with EAGAIN once NUM_SENT frames have been sent,
+// as if the send buffer of the socket were full.
+static bool block;
+static int nsent;
+
+// Replaces the C library function used by the CAN channel, so a partial
+// vectored write can be forced.
+extern "C" ssize_t
+sendmsg(int fd, const msghdr* msg, int flags) {
+  if (block && nsent >= NUM_SENT) {
+    errno = EAGAIN;
+    return -1;
+  }
+  ssize_t result = syscall(SYS_sendmsg, fd, msg, flags);
+  if (result > 0) nsent++;
+  return result;
+}
+
+static ::std::size_t nwritev;
+
+static void
+writev_func(ev_task*) noexcept {
+  nwritev++;
+}
+
+int
+main() {
+  IoGuard io_guard;
+  Context ctx;
+  io::Poll poll(ctx);
+  Loop loop(poll.get_poll());
+
+  // The test requires a virtual CAN interface, which has to be created (and
+  // brought up) by the user.
+  if (!if_nametoindex("vcan0")) {
+    tap_plan(0, "vcan0 is not available");
+    return 0;
+  }
+  tap_plan(2);
+
+  CanController ctrl("vcan0");
+
+  // A channel waiting for write confirmations.
+  CanChannel chan(poll, loop.get_executor(), 0, true);
+  chan.open(ctrl);
+
+  can_msg txmsgs[NUM_MSG];
+  for (int i = 0; i < NUM_MSG; i++) {
+    txmsgs[i] = CAN_MSG_INIT;
+    txmsgs[i].id = i;
+  }
+
+  // A pending read keeps the channel receiving frames, including the
+  // confirmations of the frames written so far.
+  can_msg msg = CAN_MSG_INIT;
+  chan.submit_read(&msg, nullptr, nullptr, [](int, ::std::error_code) {});
+
+  // Only the first frames of the vectored write are written before it would
+  // block. Their confirmations are received before the write is resumed.
+  block = true;
+  io_can_chan_writev writev =
+      IO_CAN_CHAN_WRITEV_INIT(txmsgs, NUM_MSG, nullptr, &writev_func);
+  chan.submit_writev(writev);
+  loop.restart();
+  loop.run_for(::std::chrono::milliseconds(100));
+  tap_test(!nwritev && writev.r.n == NUM_SENT,
+           "a partial vectored write wrote %zu frames", writev.r.n);
+
+  // Once resumed, the write completes when the remaining frames have been
+  // written and confirmed.
+  block = false;
+  loop.restart();
+  loop.run_for(::std::chrono::milliseconds(100));
+  tap_test(nwritev == 1 && writev.r.n == NUM_MSG && !writev.r.errc,
+           "a resumed vectored write wrote %zu frames", writev.r.n);
+
+  chan.close();
+  loop.restart();
+  loop.poll();
+
+  return 0;
+}
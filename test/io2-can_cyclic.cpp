@@ -0,0 +1,153 @@
+#include "test.h"
+#include <lely/can/net.hpp>
+#include <lely/co/dcf.h>
+#include <lely/co/sync.h>
+#include <lely/ev/loop.hpp>
+#include <lely/io2/can_cyclic.hpp>
+#include <lely/io2/can_net.hpp>
+#include <lely/io2/user/can.hpp>
+#include <lely/io2/vclock.hpp>
+#include <lely/util/time.h>
+
+#include <vector>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define NUM_SYNC 8
+// The communication cycle period, in microseconds, as specified in co-sync.dcf.
+#define SYNC_PERIOD 100000
+#define SYNC_MAX_CNT 4
+
+struct Frame {
+  can_msg msg;
+  timespec tp;
+};
+
+static VirtualClock* clock_;
+static ::std::vector<Frame> written;
+static ::std::size_t nind;
+
+static int
+write_func(const can_msg* msg, int, void*) noexcept {
+  timespec tp = {0, 0};
+  io_clock_gettime(*clock_, &tp);
+  written.push_back(Frame{*msg, tp});
+  return 0;
+}
+
+// Forwards the SYNC schedule to the cyclic transmitter.
+static void
+sync_sched(co_sync_t*, const timespec* start, const timespec* interval,
+           void* data) noexcept {
+  auto cyc = static_cast<io_can_cyclic_t*>(data);
+  if (start && interval)
+    io_can_cyclic_start(cyc, start, interval);
+  else
+    io_can_cyclic_stop(cyc);
+}
+
+struct SyncContext {
+  io_can_net_t* net;
+  co_sync_t* sync;
+};
+
+static void
+stage_func(can_msg* msg, void* arg) noexcept {
+  auto ctx = static_cast<SyncContext*>(arg);
+  io_can_net_lock(ctx->net);
+  co_sync_stage(ctx->sync, msg);
+  io_can_net_unlock(ctx->net);
+}
+
+static void
+on_write_func(const can_msg* msg, const timespec*, int errc,
+              void* arg) noexcept {
+  auto ctx = static_cast<SyncContext*>(arg);
+  if (errc) return;
+  io_can_net_lock(ctx->net);
+  co_sync_sent(ctx->sync, msg);
+  io_can_net_unlock(ctx->net);
+}
+
+static void
+sync_ind(co_sync_t*, co_unsigned8_t, void*) noexcept {
+  nind++;
+}
+
+int
+main() {
+  tap_plan(5);
+
+  Context ctx;
+  Loop loop;
+  VirtualClock clock;
+  clock_ = &clock;
+  VirtualTimer net_timer(clock, ctx, loop.get_executor());
+  VirtualTimer cyc_timer(clock, ctx, loop.get_executor());
+  UserCanChannel chan(ctx, loop.get_executor(), CanBusFlag::NONE, 0, 0,
+                      &write_func);
+
+  CanNet net(net_timer, chan, 0, -1);
+  CanCyclic cyc(cyc_timer, chan);
+
+  co_dev_t* dev = co_dev_create_from_dcf_file(TEST_SRCDIR "/co-sync.dcf");
+  tap_assert(dev);
+
+  io_can_net_lock(net);
+  co_sync_t* sync = co_sync_create(
+      reinterpret_cast<lely::CANNet*>(io_can_net_get_net(net)), dev);
+  tap_assert(sync);
+  co_sync_set_ind(sync, &sync_ind, nullptr);
+  SyncContext sync_ctx{net, sync};
+  cyc.set_func(&stage_func, &sync_ctx);
+  cyc.set_on_write_func(&on_write_func, &sync_ctx);
+  // Let the cyclic transmitter send the SYNC messages instead of the CAN
+  // network interface.
+  co_sync_set_sched(sync, &sync_sched, static_cast<io_can_cyclic_t*>(cyc));
+  io_can_net_unlock(net);
+
+  net.start();
+
+  timespec end = {0, 0};
+  timespec_add_usec(&end, NUM_SYNC * SYNC_PERIOD);
+  ev_loop_t* loops[] = {loop};
+  io_vclock_run(clock, loops, 1, &end);
+
+  bool ok = written.size() == NUM_SYNC;
+  for (::std::size_t i = 0; ok && i < written.size(); i++) {
+    timespec tp = {0, 0};
+    timespec_add_usec(&tp, (i + 1) * SYNC_PERIOD);
+    ok = written[i].msg.id == 0x80 && !timespec_cmp(&written[i].tp, &tp);
+  }
+  tap_test(ok, "%zu SYNC messages were written on time", written.size());
+
+  ok = true;
+  for (::std::size_t i = 0; ok && i < written.size(); i++)
+    ok = written[i].msg.len == 1 &&
+         written[i].msg.data[0] == i % SYNC_MAX_CNT + 1;
+  tap_test(ok, "the SYNC counter was incremented every cycle");
+
+  tap_test(nind == NUM_SYNC, "the SYNC indication function was invoked");
+
+  auto stats = cyc.get_stats();
+  tap_test(stats.nwrite == NUM_SYNC && !stats.nmissed && !stats.max &&
+               stats.hist[0] == NUM_SYNC,
+           "all SYNC messages have a latency below 1 us");
+
+  // Stopping the producer stops the cyclic transmitter.
+  io_can_net_lock(net);
+  co_sync_stop(sync);
+  io_can_net_unlock(net);
+  written.clear();
+  timespec_add_usec(&end, NUM_SYNC * SYNC_PERIOD);
+  io_vclock_run(clock, loops, 1, &end);
+  tap_test(written.empty(), "no SYNC messages after the producer stopped");
+
+  io_can_net_lock(net);
+  co_sync_destroy(sync);
+  io_can_net_unlock(net);
+  co_dev_destroy(dev);
+
+  return 0;
+}
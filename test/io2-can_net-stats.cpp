@@ -0,0 +1,127 @@
+#include "test.h"
+#include <lely/can/net.hpp>
+#include <lely/ev/loop.hpp>
+#include <lely/io2/can_net.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/user/can.hpp>
+#include <lely/io2/vclock.hpp>
+#include <lely/util/time.h>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define NUM_MSG 4
+// The time (in microseconds) between queueing the frames and the completion of
+// the write operations.
+#define TX_DELAY 100
+
+static int
+write_func(const can_msg*, int, void*) noexcept {
+  return 0;
+}
+
+// The number of write confirmations and the time of the last one.
+static int nwrite;
+static timespec write_time;
+
+static void
+on_write(const can_msg*, const timespec* tp, void*) noexcept {
+  nwrite++;
+  write_time = *tp;
+}
+
+static void
+poll(Loop& loop) {
+  loop.restart();
+  loop.poll();
+}
+
+static can_msg
+make_msg(uint_least32_t id) {
+  can_msg msg = CAN_MSG_INIT;
+  msg.id = id;
+  msg.len = 2;
+  return msg;
+}
+
+// Returns the index of the only non-empty bin of a histogram, or -1 if the
+// histogram does not contain exactly <b>n</b> samples in a single bin.
+static int
+find_bin(const uint_least64_t* hist, uint_least64_t n) {
+  int bin = -1;
+  for (int i = 0; i < IO_CAN_NET_STATS_NBIN; i++) {
+    if (!hist[i]) continue;
+    if (bin != -1 || hist[i] != n) return -1;
+    bin = i;
+  }
+  return bin;
+}
+
+int
+main() {
+  tap_plan(8);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  VirtualClock clock;
+  VirtualTimer timer(clock, ctx, loop.get_executor());
+  UserCanChannel chan(ctx, loop.get_executor(), CanBusFlag::NONE, 0, 0,
+                      &write_func);
+  CanNet net(timer, chan, 0, -1);
+  net.set_on_write_func(&on_write);
+  net.start();
+  poll(loop);
+
+  // Queue a few frames and let the write operations complete later.
+  can_msg msg = make_msg(0x100);
+  io_can_net_lock(net);
+  for (int i = 0; i < NUM_MSG; i++)
+    reinterpret_cast<lely::CANNet*>(io_can_net_get_net(net))->send(msg);
+  io_can_net_unlock(net);
+  timespec end = {0, 0};
+  timespec_add_usec(&end, TX_DELAY);
+  clock.advance(&end);
+  poll(loop);
+
+  auto stats = net.get_stats();
+  int bits = can_msg_bits(&msg, CAN_MSG_BITS_MODE_NO_STUFF);
+  tap_test(stats.tx_frames == NUM_MSG && stats.tx_bytes == NUM_MSG * msg.len &&
+               stats.tx_bits == static_cast<uint_least64_t>(NUM_MSG * bits),
+           "%d frames were written", static_cast<int>(stats.tx_frames));
+  tap_test(nwrite == NUM_MSG && !timespec_cmp(&write_time, &end),
+           "a write confirmation was received for each frame");
+  // The first frame is written immediately, so it is never queued.
+  tap_test(stats.tx_hwm == NUM_MSG - 1, "the transmit queue high-water mark");
+
+  int bin = find_bin(stats.tx_latency, NUM_MSG);
+  tap_test(bin != -1 && io_can_net_stats_bin_min(bin) <= TX_DELAY &&
+               io_can_net_stats_bin_min(bin + 1) > TX_DELAY,
+           "the write latency is in bin %d (>= %d us)", bin,
+           static_cast<int>(io_can_net_stats_bin_min(bin)));
+
+  // Receive a frame.
+  chan.on_read(&msg);
+  poll(loop);
+  stats = net.get_stats();
+  tap_test(stats.rx_frames == 1 && stats.rx_bytes == msg.len &&
+               stats.rx_bits == static_cast<uint_least64_t>(bits),
+           "a frame was received");
+  // Since the virtual clock does not advance during dispatch, the latency is
+  // 0.
+  tap_test(find_bin(stats.rx_latency, 1) == 0, "the dispatch latency");
+
+  tap_test(io_can_net_stats_bin_min(3) == 3 &&
+               io_can_net_stats_bin_min(4) == 4 &&
+               io_can_net_stats_bin_min(11) == 14 &&
+               io_can_net_stats_bin_min(12) == 16,
+           "the histogram bins are log-linear");
+
+  net.reset_stats();
+  stats = net.get_stats();
+  tap_test(!stats.tx_frames && !stats.rx_frames && !stats.tx_hwm &&
+               find_bin(stats.tx_latency, 0) == -1,
+           "reset the statistics");
+
+  return 0;
+}
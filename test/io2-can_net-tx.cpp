@@ -0,0 +1,124 @@
+#include "test.h"
+#include <lely/can/net.hpp>
+#include <lely/ev/loop.hpp>
+#include <lely/io2/can_net.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/user/can.hpp>
+#include <lely/io2/vclock.hpp>
+
+#include <vector>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define SYNC_ID 0x080
+
+static ::std::vector<can_msg> written;
+
+static int
+write_func(const can_msg* msg, int, void*) noexcept {
+  written.push_back(*msg);
+  return 0;
+}
+
+static int
+txclass_func(const can_msg* msg, void*) noexcept {
+  return msg->id == SYNC_ID ? 0 : 1;
+}
+
+// Queues a frame for transmission.
+static void
+send(io_can_net_t* net, uint_least32_t id, uint_least8_t flags = 0,
+     uint_least8_t data = 0) {
+  can_msg msg = CAN_MSG_INIT;
+  msg.id = id;
+  msg.flags = flags;
+  msg.len = 1;
+  msg.data[0] = data;
+  io_can_net_lock(net);
+  reinterpret_cast<lely::CANNet*>(io_can_net_get_net(net))->send(msg);
+  io_can_net_unlock(net);
+}
+
+static void
+poll(Loop& loop) {
+  loop.restart();
+  loop.poll();
+}
+
+// Checks that the frames after the first one (which is written as soon as it is
+// queued) were written in the expected order.
+static bool
+check_order(const ::std::vector<uint_least32_t>& ids) {
+  bool ok = written.size() == ids.size() + 1;
+  for (::std::size_t i = 0; ok && i < ids.size(); i++)
+    ok = written[i + 1].id == ids[i];
+  written.clear();
+  return ok;
+}
+
+int
+main() {
+  tap_plan(6);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  VirtualClock clock;
+  VirtualTimer timer(clock, ctx, loop.get_executor());
+  UserCanChannel chan(ctx, loop.get_executor(), CanBusFlag::NONE, 0, 0,
+                      &write_func);
+  CanNet net(timer, chan, 0, -1);
+  net.start();
+
+  // By default, frames are sent in the order in which they were queued.
+  send(net, 0x700);
+  send(net, 0x300);
+  send(net, 0x100);
+  send(net, 0x200);
+  poll(loop);
+  tap_test(check_order({0x300, 0x100, 0x200}), "frames are sent in order");
+
+  // With identifier ordering, frames are sent as if they won arbitration.
+  net.set_txprio(true);
+  send(net, 0x700);
+  send(net, 0x300);
+  send(net, 0x100 << 18, CAN_FLAG_IDE);
+  send(net, 0x100, CAN_FLAG_RTR);
+  send(net, 0x100);
+  send(net, SYNC_ID);
+  poll(loop);
+  bool ok = written.size() == 6 && !(written[2].flags & CAN_FLAG_RTR);
+  tap_test(ok && check_order({SYNC_ID, 0x100, 0x100, 0x100 << 18, 0x300}),
+           "frames are sent in order of priority");
+
+  // Frames with the same identifier remain in order.
+  send(net, 0x700);
+  for (int i = 0; i < 4; i++) send(net, 0x600, 0, i);
+  send(net, 0x580);
+  poll(loop);
+  ok = written.size() == 6 && written[1].id == 0x580;
+  for (int i = 0; ok && i < 4; i++) ok = written[i + 2].data[0] == i;
+  written.clear();
+  tap_test(ok, "frames with the same identifier are sent in order");
+  net.set_txprio(false);
+
+  // Traffic classes take precedence over the order of the frames, and each
+  // class can be limited.
+  net.set_txclass_func(&txclass_func);
+  net.set_txdepth(1, 2);
+  send(net, 0x700);
+  send(net, 0x181);
+  send(net, 0x182);
+  send(net, 0x183);
+  send(net, SYNC_ID);
+  poll(loop);
+  tap_test(check_order({SYNC_ID, 0x181, 0x182}),
+           "high-priority frames overtake low-priority frames");
+  tap_test(net.get_txdropped(1) == 1 && !net.get_txdropped(0),
+           "the low-priority class dropped %zu frame", net.get_txdropped(1));
+
+  tap_test(loop.poll() == 0);
+
+  return 0;
+}
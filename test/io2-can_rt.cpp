@@ -8,10 +8,20 @@ using namespace lely::ev;
 using namespace lely::io;
 
 #define NUM_OP 4
+#define NUM_SKIP 8
+
+static void
+on_read(UserCanChannel& chan, uint_least32_t id,
+        uint_least8_t flags = 0) {
+  can_msg msg CAN_MSG_INIT;
+  msg.id = id;
+  msg.flags = flags;
+  chan.on_read(&msg);
+}
 
 int
 main() {
-  tap_plan(NUM_OP + 1);
+  tap_plan(NUM_OP + 7);
 
   IoGuard io_guard;
   Context ctx;
@@ -25,11 +35,52 @@ main() {
                            if (!ec) tap_test(msg->id == i, "%03x", i);
                          });
 
-  for (uint_least32_t i = 0; i < NUM_OP; i++) {
-    can_msg msg CAN_MSG_INIT;
-    msg.id = i;
-    chan.on_read(&msg);
-  }
+  // The frames preceding this one are discarded in a single burst.
+  rt.submit_read_frame(0x400, CanFlag::NONE,
+                       [](const can_msg* msg, ::std::error_code ec) {
+                         tap_test(!ec && msg->id == 0x400,
+                                  "skipped %d unmatched frames", NUM_SKIP);
+                       });
+
+  rt.submit_read_frame(0x1234567, CanFlag::IDE,
+                       [](const can_msg* msg, ::std::error_code ec) {
+                         tap_test(!ec && msg->id == 0x1234567 &&
+                                      (msg->flags & CAN_FLAG_IDE),
+                                  "extended identifier");
+                       });
+
+  io_can_rt_read_filter mask_filter = IO_CAN_RT_READ_FILTER_INIT(
+      0x180, 0x180, 0x780, 0, [](ev_task* task) noexcept {
+        auto read = io_can_rt_read_filter_from_task(task);
+        tap_test(read->r.msg && read->r.msg->id == 0x185, "acceptance mask");
+      });
+  rt.submit_read_filter(mask_filter);
+
+  io_can_rt_read_filter range_filter = IO_CAN_RT_READ_FILTER_INIT(
+      0x700, 0x77f, CAN_MASK_EID, 0, [](ev_task* task) noexcept {
+        auto read = io_can_rt_read_filter_from_task(task);
+        tap_test(read->r.msg && read->r.msg->id == 0x701, "identifier range");
+      });
+  rt.submit_read_filter(range_filter);
+
+  // A read operation resubmitted from a completion task receives the next
+  // frame, even if it was already buffered by the channel.
+  int n = 0;
+  CanRouterReadFrame resubmit(
+      0x300, CanFlag::NONE, [&](const can_msg* msg, ::std::error_code ec) {
+        tap_test(!ec && msg->id == 0x300, "frame %d", n);
+        if (!n++) rt.submit_read_frame(resubmit);
+      });
+  rt.submit_read_frame(resubmit);
+
+  for (uint_least32_t i = 0; i < NUM_OP; i++) on_read(chan, i);
+  for (uint_least32_t i = 0; i < NUM_SKIP; i++) on_read(chan, 0x10 + i);
+  on_read(chan, 0x400);
+  on_read(chan, 0x1234567, CAN_FLAG_IDE);
+  on_read(chan, 0x185);
+  on_read(chan, 0x701);
+  on_read(chan, 0x300);
+  on_read(chan, 0x300);
 
   loop.run();
   tap_test(loop.stopped());
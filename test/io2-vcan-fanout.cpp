@@ -0,0 +1,87 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/io2/sys/clock.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/vcan.hpp>
+
+#include <chrono>
+#include <vector>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define NUM_CHAN 128
+#define NUM_MSG 64
+#define NUM_SLOW 4
+#define NUM_ITER 10000
+
+static bool
+read_all(CanChannelBase& chan, ::std::size_t first, ::std::size_t n) {
+  for (::std::size_t i = first; i < first + n; i++) {
+    can_msg msg = CAN_MSG_INIT;
+    ::std::error_code ec;
+    if (chan.read(&msg, nullptr, nullptr, 0, ec) != 1 || msg.id != i)
+      return false;
+  }
+  // The receive queue is now empty.
+  ::std::error_code ec;
+  return chan.read(nullptr, nullptr, nullptr, 0, ec) == -1 &&
+         ec == ::std::errc::resource_unavailable_try_again;
+}
+
+int
+main() {
+  tap_plan(6);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  VirtualCanController ctrl(clock_monotonic);
+
+  ::std::vector<VirtualCanChannel> chan;
+  chan.reserve(NUM_CHAN);
+  for (int i = 0; i < NUM_CHAN; i++) {
+    chan.emplace_back(ctx, loop.get_executor());
+    chan.back().open(ctrl);
+  }
+  VirtualCanChannel slow(ctx, loop.get_executor(), NUM_SLOW);
+  slow.open(ctrl);
+
+  // Send frames from the first channel. Writes never block on the other
+  // channels, not even the slow one.
+  for (int i = 0; i < NUM_MSG; i++) {
+    can_msg msg = CAN_MSG_INIT;
+    msg.id = i;
+    chan[0].write(msg, 0);
+  }
+
+  bool ok = read_all(chan[0], 0, 0);
+  tap_test(ok, "a channel does not receive its own frames");
+
+  for (int i = 1; ok && i < NUM_CHAN; i++) ok = read_all(chan[i], 0, NUM_MSG);
+  tap_test(ok, "all channels received all frames, in order");
+
+  ok = read_all(slow, NUM_MSG - NUM_SLOW, NUM_SLOW);
+  tap_test(ok, "the slow channel received the last %d frames", NUM_SLOW);
+  tap_test(slow.get_ndropped() == NUM_MSG - NUM_SLOW && !chan[1].get_ndropped(),
+           "the slow channel dropped %zu frames", slow.get_ndropped());
+
+  // Measure the cost of writing a frame to all channels.
+  auto t1 = ::std::chrono::steady_clock::now();
+  for (int i = 0; i < NUM_ITER; i++) {
+    can_msg msg = CAN_MSG_INIT;
+    msg.id = i & CAN_MASK_BID;
+    ctrl.write(msg, 0);
+  }
+  auto t2 = ::std::chrono::steady_clock::now();
+  tap_pass("writing a frame to %d channels took %.0f ns", NUM_CHAN + 1,
+           ::std::chrono::duration<double, ::std::nano>(t2 - t1).count() /
+               NUM_ITER);
+
+  for (auto& c : chan) c.close();
+  slow.close();
+  loop.poll();
+  tap_test(loop.poll() == 0);
+
+  return 0;
+}
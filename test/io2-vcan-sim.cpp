@@ -0,0 +1,105 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/user/timer.hpp>
+#include <lely/io2/vcan.hpp>
+#include <lely/util/time.h>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define BITRATE 500000
+
+static uint_least64_t
+duration(const can_msg& msg) {
+  int bits = can_msg_bits(&msg, CAN_MSG_BITS_MODE_EXACT);
+  return (static_cast<uint_least64_t>(bits) * 1000000000u + BITRATE - 1) /
+         BITRATE;
+}
+
+int
+main() {
+  tap_plan(13);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  UserTimer timer(ctx, loop.get_executor());
+  auto clock = io_timer_get_clock(timer);
+
+  timespec now = {0, 0};
+  io_clock_settime(clock, &now);
+
+  VirtualCanController ctrl(clock, CanBusFlag::NONE, BITRATE);
+  VirtualCanChannel chan(ctx, loop.get_executor());
+  chan.open(ctrl);
+
+  ctrl.enable_sim(2);
+
+  can_msg msg[4] = {CAN_MSG_INIT, CAN_MSG_INIT, CAN_MSG_INIT, CAN_MSG_INIT};
+  msg[0].id = 0x700;
+  msg[0].len = 1;
+  msg[1].id = 0x200;
+  msg[1].len = 8;
+  msg[2].id = 0x100;
+  msg[2].len = 8;
+  msg[3].id = 0x080;
+
+  // The first frame is transmitted immediately; the others have to wait.
+  for (int i = 0; i < 3; i++) ctrl.write(msg[i], 0);
+  ::std::error_code ec;
+  ctrl.write(msg[3], 0, ec);
+  tap_test(ec == ::std::errc::resource_unavailable_try_again,
+           "transmission queue full");
+
+  timespec next = {0, 0};
+  tap_test(ctrl.sim_flush(&next), "frames pending");
+  tap_test(timespec_diff_nsec(&next, &now) ==
+               static_cast<int_least64_t>(duration(msg[0])),
+           "first frame completes after %llu ns",
+           static_cast<unsigned long long>(duration(msg[0])));
+
+  can_msg rx = CAN_MSG_INIT;
+  can_err err = CAN_ERR_INIT;
+  timespec ts = {0, 0};
+  tap_test(io_can_chan_read(chan, &rx, &err, &ts, 0) == -1,
+           "no frame delivered before the end of transmission");
+
+  now = {1, 0};
+  io_clock_settime(clock, &now);
+  tap_test(!ctrl.sim_flush(), "all frames transmitted");
+
+  // The frames are received in order of arbitration.
+  uint_least32_t order[3] = {0x700, 0x100, 0x200};
+  timespec end = {0, 0};
+  for (int i = 0; i < 3; i++) {
+    const can_msg& m = msg[i == 0 ? 0 : (i == 1 ? 2 : 1)];
+    timespec_add_nsec(&end, duration(m));
+    int result = io_can_chan_read(chan, &rx, &err, &ts, 0);
+    tap_test(result == 1 && rx.id == order[i] && !timespec_cmp(&ts, &end),
+             "frame 0x%03x received at %ld.%09ld s", order[i],
+             static_cast<long>(ts.tv_sec), ts.tv_nsec);
+  }
+
+  auto stats = ctrl.get_sim_stats();
+  uint_least64_t busy = duration(msg[0]) + duration(msg[1]) + duration(msg[2]);
+  tap_test(stats.nframes == 3 && !stats.npending && !stats.ndropped,
+           "3 frames transmitted");
+  tap_test(stats.busy_nsec == busy && stats.elapsed_nsec == 1000000000u,
+           "bus load: %.3f%%", 100.0 * stats.busy_nsec / stats.elapsed_nsec);
+  auto id_stats = ctrl.get_sim_id_stats(0x200);
+  tap_test(id_stats.nframes == 1 &&
+               id_stats.max_delay_nsec == duration(msg[0]) + duration(msg[2]),
+           "frame 0x200 queued for %llu ns",
+           static_cast<unsigned long long>(id_stats.max_delay_nsec));
+  tap_test(stats.max_delay_nsec == id_stats.max_delay_nsec,
+           "maximum queueing delay");
+
+  // Queued frames are delivered immediately once the simulation is disabled.
+  ctrl.write(msg[3], 0);
+  ctrl.disable_sim();
+  tap_test(io_can_chan_read(chan, &rx, &err, &ts, 0) == 1 && rx.id == 0x080,
+           "frame delivered after disabling the simulation");
+
+  return 0;
+}
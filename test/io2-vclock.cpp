@@ -0,0 +1,113 @@
+#include "test.h"
+#include <lely/ev/loop.hpp>
+#include <lely/io2/sys/io.hpp>
+#include <lely/io2/vcan.hpp>
+#include <lely/io2/vclock.hpp>
+#include <lely/util/time.h>
+
+#include <chrono>
+
+using namespace lely::ev;
+using namespace lely::io;
+
+#define BITRATE 500000
+#define PERIOD 100000000
+#define DURATION 600
+
+static io_clock_t* clock_;
+static io_timer_t* timer_;
+static io_can_chan_t* tx_;
+static io_can_chan_t* rx_;
+
+static can_msg msg = CAN_MSG_INIT;
+static timespec ts = {0, 0};
+static ::std::size_t nsync;
+static ::std::size_t nrecv;
+static bool ok = true;
+
+static void
+wait_func(ev_task* task) noexcept {
+  auto wait = io_timer_wait_from_task(task);
+  if (wait->r.result == -1) return;
+  nsync++;
+  // Send a SYNC message every period.
+  can_msg sync = CAN_MSG_INIT;
+  sync.id = 0x80;
+  ok &= !io_can_chan_write(tx_, &sync, 0);
+  io_timer_submit_wait(timer_, wait);
+}
+
+static void
+read_func(ev_task* task) noexcept {
+  auto read = io_can_chan_read_from_task(task);
+  if (read->r.result != 1) return;
+  nrecv++;
+  // Each frame is received at the end of its transmission, right after the
+  // timer expired.
+  timespec now = {0, 0};
+  io_clock_gettime(clock_, &now);
+  ok &= !timespec_cmp(&ts, &now);
+  ok &= ts.tv_nsec % PERIOD > 0 && ts.tv_nsec % PERIOD < 1000000;
+  io_can_chan_submit_read(rx_, read);
+}
+
+int
+main() {
+  tap_plan(5);
+
+  IoGuard io_guard;
+  Context ctx;
+  Loop loop;
+  VirtualClock clock;
+  clock_ = clock;
+
+  VirtualTimer timer(clock, ctx, loop.get_executor());
+  timer_ = timer;
+
+  VirtualCanController ctrl(clock, CanBusFlag::NONE, BITRATE);
+  ctrl.enable_sim();
+  clock.insert(ctrl);
+
+  VirtualCanChannel tx(ctx, loop.get_executor());
+  tx.open(ctrl);
+  tx_ = tx;
+  VirtualCanChannel rx(ctx, loop.get_executor());
+  rx.open(ctrl);
+  rx_ = rx;
+
+  timer.settime(::std::chrono::nanoseconds(PERIOD),
+                ::std::chrono::nanoseconds(PERIOD));
+
+  io_timer_wait wait = IO_TIMER_WAIT_INIT(loop.get_executor(), &wait_func);
+  io_timer_submit_wait(timer, &wait);
+
+  struct io_can_chan_read read = IO_CAN_CHAN_READ_INIT(
+      &msg, nullptr, &ts, loop.get_executor(), &read_func);
+  io_can_chan_submit_read(rx, &read);
+
+  // Run the simulation for 10 minutes of virtual time.
+  timespec end = {DURATION, 0};
+  ev_loop_t* loops[] = {loop};
+  auto t1 = ::std::chrono::steady_clock::now();
+  clock.run(loops, 1, &end);
+  auto t2 = ::std::chrono::steady_clock::now();
+
+  auto now = clock.gettime();
+  tap_test(now.time_since_epoch() == ::std::chrono::seconds(DURATION),
+           "the simulation ended at %d s", DURATION);
+  tap_test(nsync == DURATION * (1000000000 / PERIOD), "%zu SYNC messages sent",
+           nsync);
+  // The last SYNC message is still on the bus.
+  tap_test(nrecv == nsync - 1, "%zu SYNC messages received", nrecv);
+  tap_test(ok, "all frames received at the end of their transmission");
+  tap_pass("%d s of virtual time took %.3f s",
+           DURATION, ::std::chrono::duration<double>(t2 - t1).count());
+
+  timer.settime(::std::chrono::nanoseconds(0));
+  tx.close();
+  rx.close();
+  clock.remove(ctrl);
+  loop.poll();
+
+  return 0;
+}
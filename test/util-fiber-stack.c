@@ -0,0 +1,76 @@
+#include "test.h"
+#include <lely/util/fiber.h>
+
+#define NUM_FIBER 8
+#define STACK_SIZE 65536
+#define STACK_USAGE 16384
+#define HUGE_STACK_SIZE (4 * 1024 * 1024)
+
+static fiber_t *
+func(fiber_t *fiber, void *arg)
+{
+	(void)arg;
+
+	// Touch part of the stack.
+	volatile char buf[STACK_USAGE];
+	for (size_t i = 0; i < sizeof(buf); i++)
+		buf[i] = 0;
+
+	return fiber;
+}
+
+int
+main(void)
+{
+	tap_plan(8);
+
+	fiber_thrd_init(0);
+
+	tap_test(!fiber_stack_pool_init(NUM_FIBER, 0));
+
+	fiber_t *fibers[NUM_FIBER];
+	for (int j = 0; j < 2; j++) {
+		for (int i = 0; i < NUM_FIBER; i++)
+			fibers[i] = fiber_create(&func, NULL, FIBER_GUARD_STACK,
+					0, STACK_SIZE);
+		for (int i = 0; i < NUM_FIBER; i++)
+			fiber_resume(fibers[i]);
+		for (int i = 0; i < NUM_FIBER; i++)
+			fiber_destroy(fibers[i]);
+	}
+
+	struct fiber_stack_stats stats;
+	fiber_stack_get_stats(&stats);
+	tap_test(stats.ncreated == 2 * NUM_FIBER, "created %zu fibers",
+			stats.ncreated);
+	tap_test(stats.nreused == NUM_FIBER, "reused %zu stacks",
+			stats.nreused);
+	tap_test(stats.nunused == NUM_FIBER && stats.nstacks == NUM_FIBER,
+			"%zu unused stacks", stats.nunused);
+#if __linux__
+	tap_test(stats.peak_usage >= STACK_USAGE, "peak usage %zu bytes",
+			stats.peak_usage);
+#else
+	tap_skip("peak usage not supported");
+#endif
+
+	// A stack requesting huge pages is used like any other, and only the
+	// part of the stack in use is counted.
+	tap_test(!fiber_stack_pool_init(NUM_FIBER, FIBER_STACK_HUGE_PAGES));
+	fiber_t *fiber = fiber_create(
+			&func, NULL, FIBER_GUARD_STACK, 0, HUGE_STACK_SIZE);
+	tap_assert(fiber);
+	fiber_resume(fiber);
+	fiber_destroy(fiber);
+	fiber_stack_get_stats(&stats);
+	tap_test(stats.peak_usage < HUGE_STACK_SIZE, "peak usage %zu bytes",
+			stats.peak_usage);
+
+	fiber_stack_pool_fini();
+	fiber_stack_get_stats(&stats);
+	tap_test(!stats.nunused && !stats.nstacks);
+
+	fiber_thrd_fini();
+
+	return 0;
+}
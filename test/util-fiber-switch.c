@@ -0,0 +1,154 @@
+#include "test.h"
+#include <lely/util/fiber.h>
+#include <lely/util/time.h>
+
+#include <fenv.h>
+#include <time.h>
+
+#define NUM_OP (1024 * 1024)
+
+#if !_WIN32 && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) \
+		&& (defined(__x86_64__) || defined(__aarch64__))
+// The assembly context switch preserves the floating-point control state even
+// without FIBER_SAVE_FENV.
+#define FENV_SAVED(flags) ((void)(flags), 1)
+#else
+#define FENV_SAVED(flags) ((flags)&FIBER_SAVE_FENV)
+#endif
+
+// The values kept alive across a context switch by the calling thread and the
+// fiber, respectively.
+static const volatile unsigned long ivals[2][10] = {
+	{ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 },
+	{ 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 }
+};
+static const volatile double dvals[2][8] = {
+	{ 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5 },
+	{ 8.5, 9.5, 10.5, 11.5, 12.5, 13.5, 14.5, 15.5 }
+};
+
+struct check {
+	int flags;
+	int ok;
+};
+
+static fiber_t *
+func(fiber_t *fiber, void *arg)
+{
+	int *n = arg;
+
+	while (++*n < NUM_OP)
+		fiber = fiber_resume(fiber);
+
+	return fiber;
+}
+
+// Loads enough values into local variables to occupy all callee-saved integer
+// and floating-point registers, resumes the fiber and checks that the values,
+// and the rounding mode, have survived the context switch.
+static __attribute__((noinline)) int
+resume_and_check(fiber_t **pfiber, int i, int flags)
+{
+	const volatile unsigned long *iv = ivals[i];
+	unsigned long i0 = iv[0], i1 = iv[1], i2 = iv[2], i3 = iv[3];
+	unsigned long i4 = iv[4], i5 = iv[5], i6 = iv[6], i7 = iv[7];
+	unsigned long i8 = iv[8], i9 = iv[9];
+	const volatile double *dv = dvals[i];
+	double d0 = dv[0], d1 = dv[1], d2 = dv[2], d3 = dv[3];
+	double d4 = dv[4], d5 = dv[5], d6 = dv[6], d7 = dv[7];
+	volatile double one = 1, three = 3;
+	int round = fegetround();
+	double q = one / three;
+
+	*pfiber = fiber_resume(*pfiber);
+
+	int ok = i0 == iv[0] && i1 == iv[1] && i2 == iv[2] && i3 == iv[3]
+			&& i4 == iv[4] && i5 == iv[5] && i6 == iv[6]
+			&& i7 == iv[7] && i8 == iv[8] && i9 == iv[9];
+	ok = ok && d0 == dv[0] && d1 == dv[1] && d2 == dv[2] && d3 == dv[3]
+			&& d4 == dv[4] && d5 == dv[5] && d6 == dv[6]
+			&& d7 == dv[7];
+	// Check both the rounding mode reported by the C library and the one
+	// used by the hardware.
+	if (FENV_SAVED(flags))
+		ok = ok && fegetround() == round && one / three == q;
+	return ok;
+}
+
+static fiber_t *
+check_func(fiber_t *fiber, void *arg)
+{
+	struct check *check = arg;
+
+	// Use a different rounding mode than the calling thread.
+	fesetround(FE_UPWARD);
+	check->ok = resume_and_check(&fiber, 1, check->flags);
+
+	return fiber;
+}
+
+static void
+test_switch(int flags, const char *name)
+{
+	fiber_thrd_init(flags);
+
+	struct check check = { flags, 0 };
+	fiber_t *fiber = fiber_create(&check_func, &check, flags, 0, 0);
+	tap_assert(fiber);
+
+	fesetround(FE_DOWNWARD);
+	fiber_t *next = fiber;
+	int ok = resume_and_check(&next, 0, flags);
+	// Let the fiber check its own state and terminate.
+	fiber_resume(fiber);
+	fesetround(FE_TONEAREST);
+
+	fiber_destroy(fiber);
+
+	fiber_thrd_fini();
+
+	tap_test(ok && check.ok, "%s: registers and rounding mode preserved",
+			name);
+}
+
+static void
+bench(int flags, const char *name)
+{
+	fiber_thrd_init(flags);
+
+	int n = 0;
+	fiber_t *fiber = fiber_create(&func, &n, flags, 0, 0);
+	tap_assert(fiber);
+
+	struct timespec t1 = { 0, 0 };
+	timespec_get(&t1, TIME_UTC);
+	while (n < NUM_OP)
+		fiber_resume(fiber);
+	struct timespec t2 = { 0, 0 };
+	timespec_get(&t2, TIME_UTC);
+
+	fiber_destroy(fiber);
+
+	fiber_thrd_fini();
+
+	// Each iteration consists of two context switches.
+	double ns = timespec_diff_nsec(&t2, &t1);
+	tap_pass("%s: %.1f ns per switch, %.0f switches/s", name,
+			ns / (2 * NUM_OP), 2e9 * NUM_OP / ns);
+}
+
+int
+main(void)
+{
+	tap_plan(6);
+
+	test_switch(0, "no flags");
+	test_switch(FIBER_SAVE_ERROR, "save error");
+	test_switch(FIBER_SAVE_ALL, "save all");
+
+	bench(0, "no flags");
+	bench(FIBER_SAVE_ERROR, "save error");
+	bench(FIBER_SAVE_ALL, "save all");
+
+	return 0;
+}
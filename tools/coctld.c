@@ -0,0 +1,1726 @@
+/**@file
+ * This file contains the CANopen control daemon, a multi-bus, multi-client
+ * variant of the CANopen control tool (a CiA 309-3 gateway).
+ *
+ * Each CAN network is served by a dedicated thread running its own event loop,
+ * CAN channel, NMT service and gateway. The main thread accepts client
+ * connections on a UNIX domain socket and parses the ASCII gateway requests.
+ * Requests are forwarded to the network threads, and confirmations and
+ * indications are returned, through lock-free single-producer, single-consumer
+ * ring buffers (see <lely/co/gw_bin.h>). Clients can pipeline requests; the
+ * confirmations are matched to the requests by their sequence numbers.
+ *
+ * @copyright 2021 Lely Industries N.V.
+ *
+ * @author J. S. Seldenthuis <jseldenthuis@lely.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <lely/can/err.h>
+#include <lely/co/dcf.h>
+#include <lely/co/gw_bin.h>
+#include <lely/co/gw_txt.h>
+#include <lely/co/nmt.h>
+#include <lely/ev/exec.h>
+#include <lely/ev/loop.h>
+#include <lely/io2/can_net.h>
+#include <lely/io2/ctx.h>
+#include <lely/io2/linux/can.h>
+#include <lely/io2/posix/poll.h>
+#include <lely/io2/sys/io.h>
+#include <lely/io2/sys/sigset.h>
+#include <lely/io2/sys/timer.h>
+#include <lely/libc/stdatomic.h>
+#include <lely/libc/threads.h>
+#include <lely/libc/unistd.h>
+#include <lely/util/daemon.h>
+#include <lely/util/diag.h>
+#include <lely/util/errnum.h>
+#include <lely/util/lex.h>
+#include <lely/util/sllist.h>
+#include <lely/util/util.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// clang-format off
+#define HELP \
+	"Arguments: [options...] [<CAN interface> <EDS/DCF filename>]...\n" \
+	"Options:\n" \
+	"  -D, --no-daemon       Do not run as daemon\n" \
+	"  -h, --help            Display this information\n" \
+	"  -m <mode>, --mode=<mode>\n" \
+	"                        Create the socket with the (octal) file mode\n" \
+	"                        <mode> (default: 0660)\n" \
+	"  -s <path>, --socket=<path>\n" \
+	"                        Accept clients on the UNIX domain socket <path>\n" \
+	"                        (default: " COCTLD_SOCKET ")\n" \
+	"  -w <n>, --window=<n>  Accept at most <n> pending requests per client\n" \
+	"                        (default: 64)\n" \
+	"Clients send one request per line, prefixed with its sequence number,\n" \
+	"e.g., \"[1] 1 2 r 0x1000 0 u32\"."
+// clang-format on
+
+#define FLAG_HELP 0x01
+#define FLAG_NO_DAEMON 0x02
+
+// The default file mode of the socket. Anyone who can connect to the socket
+// can access every CANopen network, so only the owner and group are allowed.
+#define MODE 0660
+
+// The default maximum number of pending requests per client.
+#define WINDOW 64
+
+// The maximum number of simultaneous client connections.
+#define MAX_CLIENTS 64
+
+// The maximum length (in bytes) of a request.
+#define MAX_LINE (64 * 1024)
+
+// The maximum number of bytes buffered for a client before the connection is
+// closed.
+#define MAX_OUTPUT (1024 * 1024)
+
+// The minimum number of bytes read from a client socket at once.
+#define READ_SIZE 4096
+
+// The size (in bytes) of the request ring buffer of each CAN network.
+#define REQ_RING_SIZE (64 * 1024)
+
+// The size (in bytes) of the confirmation and indication ring buffer of each
+// CAN network.
+#define IND_RING_SIZE (1024 * 1024)
+
+/// A dynamically allocated character buffer.
+struct buf {
+	char *begin;
+	size_t len;
+	size_t size;
+};
+
+/// A CAN network served by a dedicated thread.
+struct bus {
+	const char *can_path;
+	const char *dcf_path;
+	ev_loop_t *loop;
+	io_poll_t *poll;
+	io_timer_t *timer;
+	io_can_ctrl_t *ctrl;
+	io_can_chan_t *chan;
+	io_can_net_t *net;
+	co_dev_t *dev;
+	co_nmt_t *nmt;
+	co_gw_t *gw;
+	/// The requests written by the main thread.
+	struct co_gw_bin_ring *req;
+	/// The confirmations and indications written by the network thread.
+	struct co_gw_bin_ring *ind;
+	co_gw_bin_t *bin;
+	/// The eventfd used to signal the network thread of new requests.
+	int efd;
+	struct io_poll_watch watch;
+	/// A flag indicating whether the main thread has been signaled.
+	atomic_int signaled;
+	/// The confirmations that did not fit in #ind (only used by the network
+	/// thread).
+	struct sllist cons;
+	/// A flag indicating whether #cons is not empty, in which case the main
+	/// thread signals the network thread after emptying #ind.
+	atomic_int backlog;
+	/// The requests that did not fit in #req (only used by the main
+	/// thread).
+	struct sllist queue;
+	/// A flag indicating whether requests were written to #req since the
+	/// network thread was last signaled (only used by the main thread).
+	int dirty;
+	thrd_t thr;
+};
+
+/// A request waiting for room in the request ring buffer of a CAN network.
+struct bus_req {
+	struct slnode node;
+	struct co_gw_req req;
+};
+
+/// A confirmation waiting for room in the ring buffer of a CAN network.
+struct bus_con {
+	struct slnode node;
+	struct co_gw_srv srv;
+};
+
+/// A request forwarded to a CAN network on behalf of a client.
+struct slot {
+	struct client *cli;
+	/// The user-specified data (i.e., the sequence number) of the request.
+	void *data;
+	struct slot *next;
+};
+
+/// A client connection.
+struct client {
+	int fd;
+	struct io_poll_watch watch;
+	/// The I/O events for which #fd is being monitored.
+	int events;
+	co_gw_txt_t *gw;
+	/// The default network-ID of this client.
+	co_unsigned16_t def;
+	struct buf in;
+	struct buf out;
+	/// A flag indicating whether the client has closed the connection.
+	int eof;
+	/// A flag indicating whether #out has exceeded #MAX_OUTPUT.
+	int overflow;
+	/// A flag indicating whether the gateway sent the last parsed request.
+	int sent;
+	/// The number of requests forwarded to a CAN network.
+	size_t pending;
+	/// The array of #window request slots.
+	struct slot *slots;
+	/// The list of free request slots.
+	struct slot *free;
+};
+
+int daemon_init(int argc, char *argv[]);
+void daemon_main(void);
+void daemon_fini(void);
+void daemon_handler(int sig, void *handle);
+
+void add_arg(const char *arg);
+
+void sig_wait_func(struct ev_task *task);
+
+int buf_reserve(struct buf *buf, size_t n);
+int buf_append(struct buf *buf, const char *s, size_t n);
+
+int efd_signal(int fd);
+void efd_clear(int fd);
+
+int bus_init(struct bus *bus, co_unsigned16_t id);
+void bus_fini(struct bus *bus);
+int bus_thrd_start(void *arg);
+void bus_watch_func(struct io_poll_watch *watch, int events);
+int bus_bin_send(const struct co_gw_req *req, void *data);
+void bus_bin_notify(void *data);
+int bus_gw_send(const struct co_gw_srv *srv, void *data);
+int bus_gw_con(struct bus *bus, const struct co_gw_srv *srv);
+void bus_gw_flush(struct bus *bus);
+void bus_gw_rate(co_unsigned16_t id, co_unsigned16_t rate, void *data);
+void bus_on_can_state(int new_state, int old_state, void *arg);
+
+int bus_post(struct bus *bus, const struct co_gw_req *req);
+void bus_flush(struct bus *bus);
+void bus_recv(const struct co_gw_srv *srv);
+
+void sfd_watch_func(struct io_poll_watch *watch, int events);
+void efd_watch_func(struct io_poll_watch *watch, int events);
+
+struct client *client_create(int fd);
+void client_destroy(struct client *cli);
+void client_close(struct client *cli);
+void client_watch_func(struct io_poll_watch *watch, int events);
+int client_read(struct client *cli);
+void client_parse(struct client *cli);
+int client_write(struct client *cli);
+void client_update(struct client *cli);
+int client_post(struct client *cli, struct co_gw_req *req, co_unsigned16_t id);
+int client_con(struct client *cli, const struct co_gw_req *req, int iec);
+void client_err(struct client *cli, const char *begin, const char *end,
+		int iec);
+int client_gw_txt_recv(const char *txt, void *data);
+int client_gw_txt_send(const struct co_gw_req *req, void *data);
+
+int ind_gw_txt_recv(const char *txt, void *data);
+
+int is_ind(int srv);
+
+// Checks if a server is listening on a UNIX domain socket. Returns 1 if a
+// connection was accepted, 0 if it was refused (i.e., the socket is stale), and
+// -1 if the state of the socket could not be determined.
+int sock_probe(const struct sockaddr_un *addr);
+
+int flags;
+const char *path = COCTLD_SOCKET;
+mode_t mode = MODE;
+size_t window = WINDOW;
+
+io_ctx_t *ctx;
+
+struct bus buses[CO_GW_NUM_NET];
+co_unsigned16_t num_bus;
+
+io_poll_t *poll;
+ev_loop_t *loop;
+io_sigset_t *sig_set;
+struct io_sigset_wait sig_wait;
+
+int sfd = -1;
+struct io_poll_watch sfd_watch = IO_POLL_WATCH_INIT(&sfd_watch_func);
+
+int efd = -1;
+struct io_poll_watch efd_watch = IO_POLL_WATCH_INIT(&efd_watch_func);
+
+struct client *clients[MAX_CLIENTS];
+
+// The text gateway used to format indications once for all clients.
+co_gw_txt_t *ind_gw;
+struct buf ind_txt;
+
+// The buffer used to modify requests before they are forwarded.
+struct co_gw_req *req_buf;
+size_t req_size;
+
+int
+main(int argc, char *argv[])
+{
+	argv[0] = (char *)cmdname(argv[0]);
+	diag_set_handler(&cmd_diag_handler, argv[0]);
+
+	opterr = 0;
+	optind = 1;
+	while (optind < argc) {
+		char *arg = argv[optind];
+		if (*arg != '-') {
+			optind++;
+		} else if (*++arg == '-') {
+			optind++;
+			if (!*++arg)
+				break;
+			if (!strcmp(arg, "help")) {
+				flags |= FLAG_HELP;
+			} else if (!strcmp(arg, "no-daemon")) {
+				flags |= FLAG_NO_DAEMON;
+			}
+		} else {
+			int c = getopt(argc, argv, ":Dhm:s:w:");
+			if (c == -1)
+				break;
+			switch (c) {
+			case ':':
+			case '?': break;
+			case 'D': flags |= FLAG_NO_DAEMON; break;
+			case 'h': flags |= FLAG_HELP; break;
+			}
+		}
+	}
+
+	if (flags & FLAG_HELP) {
+		diag(DIAG_INFO, 0, "%s", HELP);
+		return EXIT_SUCCESS;
+	}
+
+	if (flags & FLAG_NO_DAEMON) {
+		if (daemon_init(argc, argv))
+			return EXIT_FAILURE;
+		daemon_main();
+		daemon_fini();
+		return EXIT_SUCCESS;
+	} else {
+		// clang-format off
+		return daemon_start(argv[0], &daemon_init, &daemon_main,
+				&daemon_fini, argc, argv)
+				? EXIT_FAILURE : EXIT_SUCCESS;
+		// clang-format on
+	}
+}
+
+int
+daemon_init(int argc, char *argv[])
+{
+	opterr = 0;
+	optind = 1;
+	while (optind < argc) {
+		char *arg = argv[optind];
+		if (*arg != '-') {
+			optind++;
+			add_arg(arg);
+		} else if (*++arg == '-') {
+			optind++;
+			if (!*++arg)
+				break;
+			if (!strcmp(arg, "help")) {
+			} else if (!strcmp(arg, "no-daemon")) {
+			} else if (!strncmp(arg, "mode=", 5)) {
+				mode = strtoul(arg + 5, NULL, 8);
+			} else if (!strncmp(arg, "socket=", 7)) {
+				path = arg + 7;
+			} else if (!strncmp(arg, "window=", 7)) {
+				window = strtoul(arg + 7, NULL, 0);
+			} else {
+				diag(DIAG_ERROR, 0, "illegal option -- %s",
+						arg);
+			}
+		} else {
+			int c = getopt(argc, argv, ":Dhm:s:w:");
+			if (c == -1)
+				break;
+			switch (c) {
+			case ':':
+				diag(DIAG_ERROR, 0,
+						"option requires an argument -- %c",
+						optopt);
+				break;
+			case '?':
+				diag(DIAG_ERROR, 0, "illegal option -- %c",
+						optopt);
+				break;
+			case 'D': break;
+			case 'h': break;
+			case 'm': mode = strtoul(optarg, NULL, 8); break;
+			case 's': path = optarg; break;
+			case 'w': window = strtoul(optarg, NULL, 0); break;
+			}
+		}
+	}
+	for (; optind < argc; optind++)
+		add_arg(argv[optind]);
+
+	if (num_bus < CO_GW_NUM_NET && buses[num_bus].can_path) {
+		diag(DIAG_ERROR, 0, "no EDS/DCF file specified for %s",
+				buses[num_bus].can_path);
+		goto error_arg;
+	}
+
+	if (!num_bus) {
+		diag(DIAG_ERROR, 0, "no CANopen networks specified");
+		goto error_arg;
+	}
+
+	if (!window) {
+		diag(DIAG_ERROR, 0, "the request window cannot be empty");
+		goto error_arg;
+	}
+
+	if (mode & ~(mode_t)0777) {
+		diag(DIAG_ERROR, 0, "invalid socket file mode %o", mode);
+		goto error_arg;
+	}
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		diag(DIAG_ERROR, 0, "socket path %s is too long", path);
+		goto error_arg;
+	}
+	strcpy(addr.sun_path, path);
+
+	if (io_init() == -1) {
+		diag(DIAG_ERROR, get_errc(),
+				"unable to initialize I/O library");
+		goto error_io_init;
+	}
+
+	ctx = io_ctx_create();
+	if (!ctx) {
+		diag(DIAG_ERROR, get_errc(), "unable to create I/O context");
+		goto error_create_ctx;
+	}
+
+	poll = io_poll_create(ctx, 0);
+	if (!poll) {
+		diag(DIAG_ERROR, get_errc(),
+				"unable to create I/O polling interface");
+		goto error_create_poll;
+	}
+
+	loop = ev_loop_create(io_poll_get_poll(poll), 1, 0);
+	if (!loop) {
+		diag(DIAG_ERROR, get_errc(), "unable to create event loop");
+		goto error_create_loop;
+	}
+	ev_exec_t *exec = ev_loop_get_exec(loop);
+	// Keep the event loop running until it is explicitly stopped.
+	ev_exec_on_task_init(exec);
+
+	sig_set = io_sigset_create(poll, exec);
+	if (!sig_set) {
+		diag(DIAG_ERROR, get_errc(), "unable to create signal handler");
+		goto error_create_sigset;
+	}
+	io_sigset_insert(sig_set, SIGINT);
+	io_sigset_insert(sig_set, SIGTERM);
+	sig_wait = (struct io_sigset_wait)IO_SIGSET_WAIT_INIT(
+			exec, &sig_wait_func);
+	io_sigset_submit_wait(sig_set, &sig_wait);
+
+	efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (efd == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to create eventfd");
+		goto error_efd;
+	}
+	if (io_poll_watch(poll, efd, IO_EVENT_IN, &efd_watch) == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to watch eventfd");
+		goto error_watch_efd;
+	}
+
+	ind_gw = co_gw_txt_create();
+	if (!ind_gw) {
+		diag(DIAG_ERROR, get_errc(), "unable to create gateway");
+		goto error_create_ind_gw;
+	}
+	co_gw_txt_set_recv_func(ind_gw, &ind_gw_txt_recv, NULL);
+
+	co_unsigned16_t id = 1;
+	for (; id <= num_bus; id++) {
+		if (bus_init(&buses[id - 1], id) == -1) {
+			// Clean up the partially initialized network.
+			id++;
+			goto error_bus;
+		}
+	}
+
+	sfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sfd == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to create socket");
+		goto error_socket;
+	}
+	// Remove a stale socket left behind by a previous instance, but do not
+	// take over the socket of an instance that is still running.
+	struct stat st;
+	if (!lstat(path, &st) && S_ISSOCK(st.st_mode)) {
+		switch (sock_probe(&addr)) {
+		case 0: unlink(path); break;
+		case 1:
+			diag(DIAG_ERROR, 0, "%s is in use by another instance",
+					path);
+			goto error_bind;
+		}
+	}
+	// daemon_start() clears the file mode creation mask, so set it
+	// explicitly to create the socket with the requested file mode.
+	mode_t mask = umask(~mode & 0777);
+	int result = bind(sfd, (const struct sockaddr *)&addr, sizeof(addr));
+	int errsv = errno;
+	umask(mask);
+	if (result == -1) {
+		diag(DIAG_ERROR, errno2c(errsv), "unable to bind socket to %s",
+				path);
+		goto error_bind;
+	}
+	if (listen(sfd, SOMAXCONN) == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to listen on %s",
+				path);
+		goto error_listen;
+	}
+	if (io_poll_watch(poll, sfd, IO_EVENT_IN, &sfd_watch) == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to watch socket");
+		goto error_watch_sfd;
+	}
+
+	daemon_set_handler(&daemon_handler, NULL);
+
+	return 0;
+
+error_watch_sfd:
+error_listen:
+	unlink(path);
+error_bind:
+	close(sfd);
+	sfd = -1;
+error_socket:
+error_bus:
+	io_ctx_shutdown(ctx);
+	while (--id)
+		bus_fini(&buses[id - 1]);
+	co_gw_txt_destroy(ind_gw);
+	ind_gw = NULL;
+error_create_ind_gw:
+error_watch_efd:
+	close(efd);
+	efd = -1;
+error_efd:
+error_create_sigset:
+	io_ctx_shutdown(ctx);
+	ev_exec_on_task_fini(exec);
+	ev_loop_restart(loop);
+	ev_loop_poll(loop);
+	io_sigset_destroy(sig_set);
+	sig_set = NULL;
+	ev_loop_destroy(loop);
+	loop = NULL;
+error_create_loop:
+	io_poll_destroy(poll);
+	poll = NULL;
+error_create_poll:
+	io_ctx_destroy(ctx);
+	ctx = NULL;
+error_create_ctx:
+	io_fini();
+error_io_init:
+error_arg:
+	return -1;
+}
+
+void
+daemon_main(void)
+{
+	co_unsigned16_t id = 1;
+	for (; id <= num_bus; id++) {
+		io_can_net_start(buses[id - 1].net);
+		// clang-format off
+		if (thrd_create(&buses[id - 1].thr, &bus_thrd_start,
+				&buses[id - 1]) != thrd_success) {
+			// clang-format on
+			diag(DIAG_ERROR, 0, "unable to create thread");
+			break;
+		}
+	}
+
+	// Serve the clients until we receive a stop signal.
+	if (id > num_bus)
+		ev_loop_run(loop);
+
+	while (--id) {
+		ev_loop_stop(buses[id - 1].loop);
+		thrd_join(buses[id - 1].thr, NULL);
+	}
+}
+
+void
+daemon_fini(void)
+{
+	for (size_t i = 0; i < MAX_CLIENTS; i++) {
+		if (clients[i]) {
+			if (clients[i]->fd != -1)
+				close(clients[i]->fd);
+			client_destroy(clients[i]);
+		}
+	}
+
+	unlink(path);
+	close(sfd);
+	sfd = -1;
+
+	// Cancel all pending I/O operations, so the event loops can run the
+	// completion tasks before the I/O objects are destroyed.
+	io_ctx_shutdown(ctx);
+	for (co_unsigned16_t id = 1; id <= num_bus; id++)
+		bus_fini(&buses[id - 1]);
+
+	co_gw_txt_destroy(ind_gw);
+	ind_gw = NULL;
+	free(ind_txt.begin);
+	ind_txt = (struct buf){ NULL, 0, 0 };
+
+	free(req_buf);
+	req_buf = NULL;
+	req_size = 0;
+
+	close(efd);
+	efd = -1;
+
+	ev_exec_on_task_fini(ev_loop_get_exec(loop));
+	ev_loop_restart(loop);
+	ev_loop_poll(loop);
+	io_sigset_destroy(sig_set);
+	sig_set = NULL;
+
+	ev_loop_destroy(loop);
+	loop = NULL;
+
+	io_poll_destroy(poll);
+	poll = NULL;
+
+	io_ctx_destroy(ctx);
+	ctx = NULL;
+
+	io_fini();
+}
+
+void
+daemon_handler(int sig, void *handle)
+{
+	switch (sig) {
+	case DAEMON_STOP: ev_loop_stop(loop); break;
+	default: default_daemon_handler(sig, handle); break;
+	}
+}
+
+void
+add_arg(const char *arg)
+{
+	assert(arg);
+
+	// The arguments are pairs of CAN interfaces and EDS/DCF filenames.
+	if (num_bus >= CO_GW_NUM_NET) {
+		diag(DIAG_ERROR, 0, "at most %d CAN networks are supported",
+				CO_GW_NUM_NET);
+	} else if (!buses[num_bus].can_path) {
+		buses[num_bus].can_path = arg;
+	} else {
+		buses[num_bus++].dcf_path = arg;
+	}
+}
+
+void
+sig_wait_func(struct ev_task *task)
+{
+	struct io_sigset_wait *wait = io_sigset_wait_from_task(task);
+
+	// A signal number of 0 indicates the wait operation was canceled.
+	if (wait->signo)
+		ev_loop_stop(loop);
+}
+
+int
+buf_reserve(struct buf *buf, size_t n)
+{
+	assert(buf);
+
+	if (buf->size - buf->len >= n)
+		return 0;
+
+	size_t size = MAX(buf->size * 2, buf->len + n);
+	char *begin = realloc(buf->begin, size);
+	if (!begin)
+		return -1;
+	buf->begin = begin;
+	buf->size = size;
+
+	return 0;
+}
+
+int
+buf_append(struct buf *buf, const char *s, size_t n)
+{
+	assert(buf);
+	assert(s || !n);
+
+	if (buf_reserve(buf, n) == -1)
+		return -1;
+	memcpy(buf->begin + buf->len, s, n);
+	buf->len += n;
+
+	return 0;
+}
+
+int
+efd_signal(int fd)
+{
+	uint64_t value = 1;
+	ssize_t result;
+	do
+		result = write(fd, &value, sizeof(value));
+	while (result == -1 && errno == EINTR);
+	// The eventfd cannot overflow in practice, and if the counter is
+	// saturated, the reader will be woken up anyway.
+	return result == (ssize_t)sizeof(value) || errno == EAGAIN ? 0 : -1;
+}
+
+void
+efd_clear(int fd)
+{
+	uint64_t value = 0;
+	ssize_t result;
+	do
+		result = read(fd, &value, sizeof(value));
+	while (result == -1 && errno == EINTR);
+}
+
+int
+bus_init(struct bus *bus, co_unsigned16_t id)
+{
+	assert(bus);
+
+	bus->efd = -1;
+	atomic_init(&bus->signaled, 0);
+	sllist_init(&bus->cons);
+	atomic_init(&bus->backlog, 0);
+	sllist_init(&bus->queue);
+	bus->dirty = 0;
+
+	bus->poll = io_poll_create(ctx, 0);
+	if (!bus->poll) {
+		diag(DIAG_ERROR, get_errc(),
+				"unable to create I/O polling interface");
+		goto error;
+	}
+
+	bus->loop = ev_loop_create(io_poll_get_poll(bus->poll), 1, 0);
+	if (!bus->loop) {
+		diag(DIAG_ERROR, get_errc(), "unable to create event loop");
+		goto error;
+	}
+	ev_exec_t *exec = ev_loop_get_exec(bus->loop);
+	// Keep the event loop running until it is explicitly stopped.
+	ev_exec_on_task_init(exec);
+
+	bus->timer = io_timer_create(bus->poll, exec, CLOCK_REALTIME);
+	if (!bus->timer) {
+		diag(DIAG_ERROR, get_errc(), "unable to create timer");
+		goto error;
+	}
+
+	bus->ctrl = io_can_ctrl_create_from_name(bus->can_path, 0);
+	if (!bus->ctrl) {
+		diag(DIAG_ERROR, get_errc(), "%s is not a suitable CAN device",
+				bus->can_path);
+		goto error;
+	}
+
+	bus->chan = io_can_chan_create(bus->poll, exec, 0, 0);
+	if (!bus->chan) {
+		diag(DIAG_ERROR, get_errc(), "unable to create CAN channel");
+		goto error;
+	}
+	if (io_can_chan_open(bus->chan, bus->ctrl, IO_CAN_BUS_FLAG_ERR)
+			== -1) {
+		diag(DIAG_ERROR, get_errc(), "unable to open %s",
+				bus->can_path);
+		goto error;
+	}
+
+	bus->net = io_can_net_create(exec, bus->timer, bus->chan, 0, 0);
+	if (!bus->net) {
+		diag(DIAG_ERROR, get_errc(),
+				"unable to create CAN network interface");
+		goto error;
+	}
+	io_can_net_set_on_can_state_func(bus->net, &bus_on_can_state, bus);
+
+	// Load the EDS/DCF from file.
+	bus->dev = co_dev_create_from_dcf_file(bus->dcf_path);
+	if (!bus->dev)
+		goto error;
+
+	// Create the NMT service.
+	io_can_net_lock(bus->net);
+	bus->nmt = co_nmt_create(io_can_net_get_net(bus->net), bus->dev);
+	io_can_net_unlock(bus->net);
+	if (!bus->nmt) {
+		diag(DIAG_ERROR, get_errc(), "unable to create NMT service");
+		goto error;
+	}
+
+	// Each network has its own gateway, so requests for different networks
+	// can be processed concurrently.
+	bus->gw = co_gw_create();
+	if (!bus->gw) {
+		diag(DIAG_ERROR, get_errc(), "unable to create gateway");
+		goto error;
+	}
+	if (co_gw_init_net(bus->gw, id, bus->nmt) == -1) {
+		diag(DIAG_ERROR, get_errc(),
+				"unable to initialize CANopen network");
+		goto error;
+	}
+	co_gw_set_send_func(bus->gw, &bus_gw_send, bus);
+	co_gw_set_rate_func(bus->gw, &bus_gw_rate, bus);
+
+	bus->req = co_gw_bin_ring_create(REQ_RING_SIZE);
+	bus->ind = co_gw_bin_ring_create(IND_RING_SIZE);
+	if (!bus->req || !bus->ind) {
+		diag(DIAG_ERROR, get_errc(), "unable to create ring buffer");
+		goto error;
+	}
+
+	bus->bin = co_gw_bin_create(bus->req, bus->ind);
+	if (!bus->bin) {
+		diag(DIAG_ERROR, get_errc(), "unable to create gateway");
+		goto error;
+	}
+	co_gw_bin_set_send_func(bus->bin, &bus_bin_send, bus);
+	co_gw_bin_set_notify_func(bus->bin, &bus_bin_notify, bus);
+	// Notify the main thread of every indication; the wake-ups are
+	// coalesced by bus_bin_notify().
+	co_gw_bin_set_batch(bus->bin, 1);
+
+	bus->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (bus->efd == -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to create eventfd");
+		goto error;
+	}
+	bus->watch = (struct io_poll_watch)IO_POLL_WATCH_INIT(&bus_watch_func);
+	if (io_poll_watch(bus->poll, bus->efd, IO_EVENT_IN, &bus->watch)
+			== -1) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to watch eventfd");
+		goto error;
+	}
+
+	return 0;
+
+error:
+	return -1;
+}
+
+void
+bus_fini(struct bus *bus)
+{
+	assert(bus);
+
+	if (bus->loop) {
+		// Allow the event loop to stop once the (canceled) operations
+		// have completed.
+		ev_exec_on_task_fini(ev_loop_get_exec(bus->loop));
+		ev_loop_restart(bus->loop);
+		ev_loop_poll(bus->loop);
+	}
+
+	struct slnode *node;
+	while ((node = sllist_pop_front(&bus->queue)))
+		free(structof(node, struct bus_req, node));
+	while ((node = sllist_pop_front(&bus->cons)))
+		free(structof(node, struct bus_con, node));
+
+	if (bus->efd != -1) {
+		close(bus->efd);
+		bus->efd = -1;
+	}
+
+	co_gw_bin_destroy(bus->bin);
+	bus->bin = NULL;
+	co_gw_bin_ring_destroy(bus->ind);
+	bus->ind = NULL;
+	co_gw_bin_ring_destroy(bus->req);
+	bus->req = NULL;
+
+	co_gw_destroy(bus->gw);
+	bus->gw = NULL;
+	co_nmt_destroy(bus->nmt);
+	bus->nmt = NULL;
+	co_dev_destroy(bus->dev);
+	bus->dev = NULL;
+
+	io_can_net_destroy(bus->net);
+	bus->net = NULL;
+	io_can_chan_destroy(bus->chan);
+	bus->chan = NULL;
+	io_can_ctrl_destroy(bus->ctrl);
+	bus->ctrl = NULL;
+	io_timer_destroy(bus->timer);
+	bus->timer = NULL;
+
+	ev_loop_destroy(bus->loop);
+	bus->loop = NULL;
+	io_poll_destroy(bus->poll);
+	bus->poll = NULL;
+}
+
+int
+bus_thrd_start(void *arg)
+{
+	struct bus *bus = arg;
+	assert(bus);
+
+	ev_loop_run(bus->loop);
+
+	return 0;
+}
+
+void
+bus_watch_func(struct io_poll_watch *watch, int events)
+{
+	assert(watch);
+	struct bus *bus = structof(watch, struct bus, watch);
+	(void)events;
+
+	// Clear the eventfd before processing the requests, so a request
+	// written afterwards generates a new event.
+	efd_clear(bus->efd);
+
+	io_can_net_lock(bus->net);
+	io_can_net_set_time(bus->net);
+	// Deliver the pending confirmations before new requests generate more.
+	bus_gw_flush(bus);
+	co_gw_bin_send(bus->bin);
+	io_can_net_unlock(bus->net);
+
+	io_poll_watch(bus->poll, bus->efd, IO_EVENT_IN, &bus->watch);
+}
+
+int
+bus_bin_send(const struct co_gw_req *req, void *data)
+{
+	struct bus *bus = data;
+	assert(bus);
+
+	return co_gw_recv(bus->gw, req);
+}
+
+void
+bus_bin_notify(void *data)
+{
+	struct bus *bus = data;
+	assert(bus);
+
+	// Only wake up the main thread if it has not been signaled since it
+	// last emptied the ring buffer.
+	if (!atomic_exchange(&bus->signaled, 1))
+		efd_signal(efd);
+}
+
+int
+bus_gw_send(const struct co_gw_srv *srv, void *data)
+{
+	struct bus *bus = data;
+	assert(bus);
+	assert(srv);
+
+	// Confirmations are never dropped, since a client waits for each of
+	// them.
+	if (!is_ind(srv->srv))
+		return bus_gw_con(bus, srv);
+
+	// Drop indications while confirmations are waiting for room, so they
+	// cannot overtake those confirmations.
+	if (!sllist_empty(&bus->cons) || co_gw_bin_recv(bus->bin, srv) == -1) {
+		diag(DIAG_WARNING, 0, "indication lost on %s", bus->can_path);
+		return -1;
+	}
+	return 0;
+}
+
+int
+bus_gw_con(struct bus *bus, const struct co_gw_srv *srv)
+{
+	assert(bus);
+	assert(srv);
+
+	if (sllist_empty(&bus->cons)) {
+		if (!co_gw_bin_ring_write(bus->ind, srv)) {
+			bus_bin_notify(bus);
+			return 0;
+		}
+		if (get_errnum() != ERRNUM_AGAIN) {
+			diag(DIAG_ERROR, get_errc(),
+					"confirmation lost on %s",
+					bus->can_path);
+			return -1;
+		}
+	}
+
+	struct bus_con *con = malloc(offsetof(struct bus_con, srv) + srv->size);
+	if (!con) {
+		diag(DIAG_ERROR, errno2c(errno), "confirmation lost on %s",
+				bus->can_path);
+		return -1;
+	}
+	memcpy(&con->srv, srv, srv->size);
+	sllist_push_back(&bus->cons, &con->node);
+	bus_gw_flush(bus);
+
+	return 0;
+}
+
+void
+bus_gw_flush(struct bus *bus)
+{
+	assert(bus);
+
+	for (;;) {
+		struct slnode *node;
+		while ((node = sllist_first(&bus->cons))) {
+			struct bus_con *con =
+					structof(node, struct bus_con, node);
+			if (co_gw_bin_ring_write(bus->ind, &con->srv))
+				break;
+			sllist_pop_front(&bus->cons);
+			free(con);
+			bus_bin_notify(bus);
+		}
+		if (sllist_empty(&bus->cons))
+			break;
+		// Ask the main thread to signal us once it has emptied the
+		// ring buffer. If the flag was not yet set, try again, since
+		// the main thread may have emptied the buffer before it could
+		// see the flag.
+		if (atomic_exchange(&bus->backlog, 1))
+			break;
+	}
+}
+
+void
+bus_gw_rate(co_unsigned16_t id, co_unsigned16_t rate, void *data)
+{
+	struct bus *bus = data;
+	assert(bus);
+	(void)id;
+
+	if (!rate)
+		return;
+
+	// Check if the bitrate is already correct before changing it.
+	int bitrate = 0;
+	if (io_can_ctrl_get_bitrate(bus->ctrl, &bitrate, NULL) == -1) {
+		// Abort on error. If getting the bitrate fails, setting it will
+		// most likely fail as well, which could leave the network
+		// interface down.
+		diag(DIAG_ERROR, 0, "unable to get bitrate of %s",
+				bus->can_path);
+		return;
+	}
+	// Only set the bitrate if the current bitrate is different.
+	if (bitrate == rate * 1000)
+		return;
+	bitrate = rate * 1000;
+	if (io_can_ctrl_set_bitrate(bus->ctrl, bitrate, 0) == -1)
+		diag(DIAG_ERROR, 0, "unable to set bitrate of %s to %d bit/s",
+				bus->can_path, bitrate);
+}
+
+void
+bus_on_can_state(int new_state, int old_state, void *arg)
+{
+	struct bus *bus = arg;
+	assert(bus);
+
+	if (old_state == CAN_STATE_BUSOFF)
+		// Recovered from bus off.
+		co_nmt_on_err(bus->nmt, 0x8140, 0x10, NULL);
+	else if (new_state == CAN_STATE_PASSIVE)
+		// CAN in error passive mode.
+		co_nmt_on_err(bus->nmt, 0x8120, 0x10, NULL);
+}
+
+int
+bus_post(struct bus *bus, const struct co_gw_req *req)
+{
+	assert(bus);
+	assert(req);
+
+	// Preserve the order of the requests by queueing this one if earlier
+	// requests are still waiting for room in the ring buffer.
+	if (sllist_empty(&bus->queue)) {
+		if (!co_gw_bin_ring_write(bus->req,
+				    (const struct co_gw_srv *)req)) {
+			bus->dirty = 1;
+			return 0;
+		}
+		if (get_errnum() != ERRNUM_AGAIN)
+			return -1;
+	}
+
+	struct bus_req *breq =
+			malloc(offsetof(struct bus_req, req) + req->size);
+	if (!breq)
+		return -1;
+	memcpy(&breq->req, req, req->size);
+	sllist_push_back(&bus->queue, &breq->node);
+
+	return 0;
+}
+
+void
+bus_flush(struct bus *bus)
+{
+	assert(bus);
+
+	struct slnode *node;
+	while ((node = sllist_first(&bus->queue))) {
+		struct bus_req *breq = structof(node, struct bus_req, node);
+		if (co_gw_bin_ring_write(bus->req,
+				    (const struct co_gw_srv *)&breq->req))
+			break;
+		bus->dirty = 1;
+		sllist_pop_front(&bus->queue);
+		free(breq);
+	}
+}
+
+void
+bus_recv(const struct co_gw_srv *srv)
+{
+	assert(srv);
+
+	if (is_ind(srv->srv)) {
+		// Format the indication once and copy the text to all clients.
+		ind_txt.len = 0;
+		co_gw_txt_recv(ind_gw, srv);
+		for (size_t i = 0; i < MAX_CLIENTS; i++) {
+			struct client *cli = clients[i];
+			if (!cli || cli->fd == -1 || cli->overflow)
+				continue;
+			if (cli->out.len + ind_txt.len > MAX_OUTPUT
+					|| buf_append(&cli->out, ind_txt.begin,
+							   ind_txt.len)
+							== -1)
+				cli->overflow = 1;
+		}
+		return;
+	}
+
+	if (srv->size < sizeof(struct co_gw_con))
+		return;
+	// The record belongs to the consumer until it is removed from the ring
+	// buffer, so it is safe to restore the user-specified data in place.
+	struct co_gw_con *con = (struct co_gw_con *)srv;
+	struct slot *slot = con->data;
+	// Only the last network reports the result of a request forwarded to
+	// all networks.
+	if (!slot)
+		return;
+	con->data = slot->data;
+
+	struct client *cli = slot->cli;
+	assert(cli);
+	slot->cli = NULL;
+	slot->next = cli->free;
+	cli->free = slot;
+	assert(cli->pending);
+	cli->pending--;
+
+	if (cli->fd != -1)
+		co_gw_txt_recv(cli->gw, srv);
+	else if (!cli->pending)
+		client_destroy(cli);
+}
+
+void
+sfd_watch_func(struct io_poll_watch *watch, int events)
+{
+	(void)watch;
+	(void)events;
+
+	for (;;) {
+		int fd = accept4(sfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				diag(DIAG_WARNING, errno2c(errno),
+						"unable to accept connection");
+			break;
+		}
+		if (!client_create(fd))
+			close(fd);
+	}
+
+	io_poll_watch(poll, sfd, IO_EVENT_IN, &sfd_watch);
+}
+
+void
+efd_watch_func(struct io_poll_watch *watch, int events)
+{
+	(void)watch;
+	(void)events;
+
+	efd_clear(efd);
+
+	for (co_unsigned16_t id = 1; id <= num_bus; id++) {
+		struct bus *b = &buses[id - 1];
+		// Clear the flag before emptying the ring buffer, so a record
+		// written afterwards generates a new event.
+		atomic_store(&b->signaled, 0);
+		const struct co_gw_srv *srv;
+		while ((srv = co_gw_bin_ring_peek(b->ind))) {
+			bus_recv(srv);
+			co_gw_bin_ring_pop(b->ind);
+		}
+		// Let the network thread deliver the confirmations that did not
+		// fit.
+		if (atomic_exchange(&b->backlog, 0))
+			efd_signal(b->efd);
+		bus_flush(b);
+	}
+
+	// Now that requests have completed, the clients may have room for new
+	// requests and have output to send.
+	for (size_t i = 0; i < MAX_CLIENTS; i++) {
+		struct client *cli = clients[i];
+		if (!cli || cli->fd == -1)
+			continue;
+		client_parse(cli);
+		if (client_write(cli) == -1)
+			client_close(cli);
+		else
+			client_update(cli);
+	}
+
+	for (co_unsigned16_t id = 1; id <= num_bus; id++) {
+		struct bus *b = &buses[id - 1];
+		if (b->dirty) {
+			b->dirty = 0;
+			efd_signal(b->efd);
+		}
+	}
+
+	io_poll_watch(poll, efd, IO_EVENT_IN, &efd_watch);
+}
+
+struct client *
+client_create(int fd)
+{
+	size_t i = 0;
+	while (i < MAX_CLIENTS && clients[i])
+		i++;
+	if (i == MAX_CLIENTS) {
+		diag(DIAG_WARNING, 0, "at most %d clients are supported",
+				MAX_CLIENTS);
+		goto error_clients;
+	}
+
+	struct client *cli = malloc(sizeof(*cli));
+	if (!cli) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to create client");
+		goto error_alloc_cli;
+	}
+
+	cli->slots = calloc(window, sizeof(*cli->slots));
+	if (!cli->slots) {
+		diag(DIAG_ERROR, errno2c(errno), "unable to create client");
+		goto error_alloc_slots;
+	}
+	cli->free = NULL;
+	for (size_t j = window; j; j--) {
+		cli->slots[j - 1].next = cli->free;
+		cli->free = &cli->slots[j - 1];
+	}
+
+	cli->gw = co_gw_txt_create();
+	if (!cli->gw) {
+		diag(DIAG_ERROR, get_errc(), "unable to create gateway");
+		goto error_create_gw;
+	}
+	co_gw_txt_set_recv_func(cli->gw, &client_gw_txt_recv, cli);
+	co_gw_txt_set_send_func(cli->gw, &client_gw_txt_send, cli);
+
+	cli->fd = fd;
+	cli->watch = (struct io_poll_watch)IO_POLL_WATCH_INIT(
+			&client_watch_func);
+	cli->events = 0;
+	cli->def = 0;
+	cli->in = (struct buf){ NULL, 0, 0 };
+	cli->out = (struct buf){ NULL, 0, 0 };
+	cli->eof = 0;
+	cli->overflow = 0;
+	cli->sent = 0;
+	cli->pending = 0;
+
+	clients[i] = cli;
+	client_update(cli);
+
+	return cli;
+
+error_create_gw:
+	free(cli->slots);
+error_alloc_slots:
+	free(cli);
+error_alloc_cli:
+error_clients:
+	return NULL;
+}
+
+void
+client_destroy(struct client *cli)
+{
+	assert(cli);
+
+	for (size_t i = 0; i < MAX_CLIENTS; i++) {
+		if (clients[i] == cli)
+			clients[i] = NULL;
+	}
+
+	free(cli->out.begin);
+	free(cli->in.begin);
+	co_gw_txt_destroy(cli->gw);
+	free(cli->slots);
+	free(cli);
+}
+
+void
+client_close(struct client *cli)
+{
+	assert(cli);
+	assert(cli->fd != -1);
+
+	// A watch remains registered after an event is reported, so it has to
+	// be removed explicitly.
+	io_poll_watch(poll, cli->fd, 0, &cli->watch);
+	cli->events = 0;
+	close(cli->fd);
+	cli->fd = -1;
+
+	// Keep the client around until all pending requests have completed,
+	// since the confirmations refer to its slots.
+	if (!cli->pending)
+		client_destroy(cli);
+}
+
+void
+client_watch_func(struct io_poll_watch *watch, int events)
+{
+	assert(watch);
+	struct client *cli = structof(watch, struct client, watch);
+
+	// The file descriptor is no longer being monitored after an event is
+	// reported.
+	cli->events = 0;
+
+	if ((events & IO_EVENT_OUT) && client_write(cli) == -1)
+		goto error;
+
+	if ((events & ~IO_EVENT_OUT) && client_read(cli) == -1)
+		goto error;
+
+	client_parse(cli);
+	if (client_write(cli) == -1)
+		goto error;
+	client_update(cli);
+
+	for (co_unsigned16_t id = 1; id <= num_bus; id++) {
+		struct bus *b = &buses[id - 1];
+		if (b->dirty) {
+			b->dirty = 0;
+			efd_signal(b->efd);
+		}
+	}
+
+	return;
+
+error:
+	client_close(cli);
+}
+
+int
+client_read(struct client *cli)
+{
+	assert(cli);
+
+	if (buf_reserve(&cli->in, READ_SIZE) == -1)
+		return -1;
+
+	ssize_t result;
+	do
+		result = recv(cli->fd, cli->in.begin + cli->in.len,
+				cli->in.size - cli->in.len, 0);
+	while (result == -1 && errno == EINTR);
+	if (result == -1)
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+
+	if (!result)
+		cli->eof = 1;
+	cli->in.len += result;
+
+	return 0;
+}
+
+void
+client_parse(struct client *cli)
+{
+	assert(cli);
+
+	char *cp = cli->in.begin;
+	char *end = cp + cli->in.len;
+	// Process the requests as they arrive, without waiting for the previous
+	// requests to complete, until the request window is full.
+	while (cp < end && cli->pending < window && !cli->overflow) {
+		// Only parse complete lines, unless the client has closed the
+		// connection.
+		char *eol = memchr(cp, '\n', end - cp);
+		if (eol)
+			eol++;
+		else if (cli->eof)
+			eol = end;
+		else
+			break;
+		// Clear the internal error code, since it is also set by error
+		// confirmations.
+		co_gw_txt_iec(cli->gw);
+		cli->sent = 0;
+		size_t chars = co_gw_txt_send(cli->gw, cp, eol, NULL);
+		int iec = co_gw_txt_iec(cli->gw);
+		if (iec && !cli->sent)
+			client_err(cli, cp, eol, iec);
+		cp = chars ? cp + chars : eol;
+	}
+
+	cli->in.len = end - cp;
+	if (cli->in.len && cp != cli->in.begin)
+		memmove(cli->in.begin, cp, cli->in.len);
+}
+
+int
+client_write(struct client *cli)
+{
+	assert(cli);
+
+	size_t n = 0;
+	while (n < cli->out.len) {
+		ssize_t result = send(cli->fd, cli->out.begin + n,
+				cli->out.len - n, MSG_NOSIGNAL);
+		if (result == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return -1;
+		}
+		n += result;
+	}
+
+	cli->out.len -= n;
+	if (cli->out.len && n)
+		memmove(cli->out.begin, cli->out.begin + n, cli->out.len);
+
+	return 0;
+}
+
+void
+client_update(struct client *cli)
+{
+	assert(cli);
+	assert(cli->fd != -1);
+
+	if (cli->overflow) {
+		diag(DIAG_WARNING, 0,
+				"closing connection of unresponsive client");
+		client_close(cli);
+		return;
+	}
+
+	if (cli->eof && !cli->in.len && !cli->pending && !cli->out.len) {
+		client_close(cli);
+		return;
+	}
+
+	if (cli->in.len >= MAX_LINE && !memchr(cli->in.begin, '\n', MAX_LINE)) {
+		diag(DIAG_WARNING, 0, "closing connection: request too long");
+		client_close(cli);
+		return;
+	}
+
+	// Stop reading requests while the request window is full, so the
+	// client is throttled by the socket buffer.
+	int events = 0;
+	if (!cli->eof && cli->pending < window)
+		events |= IO_EVENT_IN;
+	if (cli->out.len)
+		events |= IO_EVENT_OUT;
+
+	if (events != cli->events) {
+		if (io_poll_watch(poll, cli->fd, events, &cli->watch) == -1) {
+			diag(DIAG_WARNING, errno2c(errno),
+					"unable to watch client connection");
+			client_close(cli);
+			return;
+		}
+		cli->events = events;
+	}
+}
+
+int
+client_post(struct client *cli, struct co_gw_req *req, co_unsigned16_t id)
+{
+	assert(cli);
+	assert(req);
+	assert(id <= num_bus);
+
+	struct slot *slot = cli->free;
+	assert(slot);
+
+	void *data = req->data;
+	int result = 0;
+	if (!id) {
+		// Forward the request to all networks, but only keep the
+		// confirmation of the last. The slot is only handed out once
+		// the request has been posted to all other networks, so it is
+		// never referenced if the request fails.
+		req->data = NULL;
+		for (id = 1; !result && id < num_bus; id++)
+			result = bus_post(&buses[id - 1], req);
+		id = num_bus;
+	}
+	req->data = slot;
+	if (!result)
+		result = bus_post(&buses[id - 1], req);
+	req->data = data;
+	if (result == -1)
+		return client_con(cli, req, CO_GW_IEC_NO_MEM);
+
+	cli->free = slot->next;
+	slot->cli = cli;
+	slot->data = data;
+	slot->next = NULL;
+	cli->pending++;
+
+	return 0;
+}
+
+int
+client_con(struct client *cli, const struct co_gw_req *req, int iec)
+{
+	assert(cli);
+	assert(req);
+
+	struct co_gw_con con = { .size = sizeof(con),
+		.srv = req->srv,
+		.data = req->data,
+		.iec = iec,
+		.ac = 0 };
+	// The request is completed even if the confirmation cannot be
+	// delivered, so always report success to the text gateway.
+	co_gw_txt_recv(cli->gw, (struct co_gw_srv *)&con);
+	return 0;
+}
+
+void
+client_err(struct client *cli, const char *begin, const char *end, int iec)
+{
+	assert(cli);
+
+	// The request could not be parsed, so the gateway did not send it. Try
+	// to recover the sequence number, so the client, which may be waiting
+	// for this confirmation, receives an error response.
+	const char *cp = begin;
+	cp += lex_ctype(&isblank, cp, end, NULL);
+	size_t chars = lex_char('[', cp, end, NULL);
+	if (!chars)
+		return;
+	cp += chars;
+	cp += lex_ctype(&isblank, cp, end, NULL);
+	co_unsigned32_t seq = 0;
+	if (!lex_c99_u32(cp, end, NULL, &seq))
+		return;
+
+	struct co_gw_req req = { .size = sizeof(req),
+		.srv = CO_GW_SRV_SET_CMD_SIZE,
+		.data = (void *)(uintptr_t)seq };
+	client_con(cli, &req, iec);
+}
+
+int
+client_gw_txt_recv(const char *txt, void *data)
+{
+	struct client *cli = data;
+	assert(cli);
+	assert(txt);
+
+	if (cli->overflow)
+		return -1;
+
+	size_t n = strlen(txt);
+	if (cli->out.len + n + 1 > MAX_OUTPUT
+			|| buf_append(&cli->out, txt, n) == -1
+			|| buf_append(&cli->out, "\n", 1) == -1) {
+		cli->overflow = 1;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+client_gw_txt_send(const struct co_gw_req *req, void *data)
+{
+	struct client *cli = data;
+	assert(cli);
+	assert(req);
+
+	cli->sent = 1;
+
+	// Requests larger than half the ring buffer may never fit.
+	if (req->size > REQ_RING_SIZE / 2)
+		return client_con(cli, req, CO_GW_IEC_NO_MEM);
+
+	// Copy the request, so it can be modified before it is forwarded.
+	if (req->size > req_size) {
+		struct co_gw_req *buf = realloc(req_buf, req->size);
+		if (!buf)
+			return client_con(cli, req, CO_GW_IEC_NO_MEM);
+		req_buf = buf;
+		req_size = req->size;
+	}
+	memcpy(req_buf, req, req->size);
+
+	switch (req->srv) {
+	case CO_GW_SRV_SET_NET: {
+		// Each client has its own default network.
+		const struct co_gw_req_net *par = (const void *)req;
+		if (par->net > num_bus)
+			return client_con(cli, req, CO_GW_IEC_BAD_NET);
+		cli->def = par->net;
+		return client_con(cli, req, 0);
+	}
+	case CO_GW_SRV_SET_CMD_TIMEOUT:
+		// The command time-out applies to all networks.
+		return client_post(cli, req_buf, 0);
+	case CO_GW_SRV_SET_CMD_SIZE:
+		// All gateways respond identically to this request.
+		return client_post(cli, req_buf, 1);
+	default: {
+		// All other requests contain a network-ID. Since the gateways
+		// of the networks do not have a default network, replace a
+		// network-ID of 0 by the default network of the client.
+		if (req->size < sizeof(struct co_gw_req_net))
+			return client_con(cli, req, CO_GW_IEC_BAD_SRV);
+		struct co_gw_req_net *par = (struct co_gw_req_net *)req_buf;
+		if (!par->net)
+			par->net = cli->def;
+		if (!par->net)
+			return client_con(cli, req, CO_GW_IEC_NO_DEF_NET);
+		if (par->net > num_bus)
+			return client_con(cli, req, CO_GW_IEC_BAD_NET);
+		return client_post(cli, req_buf, par->net);
+	}
+	}
+}
+
+int
+ind_gw_txt_recv(const char *txt, void *data)
+{
+	assert(txt);
+	(void)data;
+
+	if (buf_append(&ind_txt, txt, strlen(txt)) == -1
+			|| buf_append(&ind_txt, "\n", 1) == -1)
+		return -1;
+
+	return 0;
+}
+
+int
+is_ind(int srv)
+{
+	switch (srv) {
+	case CO_GW_SRV_RPDO:
+	case CO_GW_SRV_EC:
+	case CO_GW_SRV_EMCY:
+	case CO_GW_SRV_SDO:
+	case CO_GW_SRV__SYNC:
+	case CO_GW_SRV__TIME:
+	case CO_GW_SRV__BOOT: return 1;
+	default: return 0;
+	}
+}
+
+int
+sock_probe(const struct sockaddr_un *addr)
+{
+	assert(addr);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return -1;
+	int result = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+	int errsv = errno;
+	close(fd);
+	if (!result)
+		return 1;
+	errno = errsv;
+	return errsv == ECONNREFUSED ? 0 : -1;
+}